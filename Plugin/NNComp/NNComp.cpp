@@ -3,6 +3,7 @@
 #include "IControls.h"
 #include "IPlugPaths.h"
 #include "IVMeterControl.h"
+#include <chrono>
 
 
 NNComp::NNComp(const InstanceInfo& info)
@@ -39,7 +40,10 @@ NNComp::NNComp(const InstanceInfo& info)
                              "rnn-4-2",
                              "rnn-2-4"
                              );
-  GetParam(kBypass)->InitBool("Bypass", true);
+  GetParam(kBypass)->InitBool("Bypass", false);
+  GetParam(kAsync)->InitBool("Async", false);
+  GetParam(kEco)->InitBool("Eco", false);
+  GetParam(kMulticore)->InitBool("Multicore", false);
 
 #if IPLUG_EDITOR // http://bit.ly/2S64BDd
   mMakeGraphicsFunc = [&]() {
@@ -79,6 +83,9 @@ NNComp::NNComp(const InstanceInfo& info)
     pGraphics->AttachControl(new ITextControl(bDropDown.GetHShifted(-130.).GetHPadded(25.), "Pick your network architecture: ",IText(12., IColor(255,203,201,201), "Inter-Regular")));
     pGraphics->AttachControl(new GrMeterControl(bGRMeter), kCtrlGrMeter);
     pGraphics->AttachControl(new ITextControl(bGRMeter.GetHShifted(-150.), "Gain Reduction: ", IText(12., IColor(255,203,201,201), "Inter-Regular")));
+    pGraphics->AttachControl(new ITextControl(bGRMeter.GetVShifted(20.).GetHPadded(75.), "", IText(12., IColor(255,203,201,201), "Inter-Regular")), kCtrlEco);
+    pGraphics->AttachControl(new ITextControl(bGRMeter.GetVShifted(40.).GetHPadded(75.), "", IText(12., IColor(255,203,201,201), "Inter-Regular")), kCtrlResets);
+    pGraphics->AttachControl(new ITextControl(bGRMeter.GetVShifted(60.).GetHPadded(75.), "", IText(12., IColor(255,203,201,201), "Inter-Regular")), kCtrlAsync);
     
   };
 #endif
@@ -92,6 +99,58 @@ void NNComp::OnIdle()
   outSender.TransmitData(*this);
   grSender.TransmitData(*this);
   nnSender.TransmitData(*this);
+  
+#if IPLUG_EDITOR
+  //Show the model eco mode is running and how often the deadline was missed
+  const int model = governor.IsEnabled() ? governor.GetModel(GetParam(kModel)->Int()) : -1;
+  const int overruns = governor.GetOverrunCount();
+  if(GetUI() && (model != ecoModel || overruns != ecoOverruns))
+  {
+    char str[64] = "";
+    if(model >= 0)
+    {
+      snprintf(str, sizeof(str), "Eco: %s, %i overruns", NN<sample>::GetModelName(model), overruns);
+    }
+    if(auto* pText = GetUI()->GetControlWithTag(kCtrlEco))
+    {
+      pText->As<ITextControl>()->SetStr(str);
+      pText->SetDirty(false);
+    }
+    ecoModel = model;
+    ecoOverruns = overruns;
+  }
+  
+  //Show how often a model was recovered from NaN/Inf state
+  const int resets = processor.GetStateResetCount() + (asyncProcessor ? asyncProcessor->GetStateResetCount() : 0);
+  if(GetUI() && resets != stateResets)
+  {
+    char str[64];
+    snprintf(str, sizeof(str), "Model state resets: %i", resets);
+    if(auto* pText = GetUI()->GetControlWithTag(kCtrlResets))
+    {
+      pText->As<ITextControl>()->SetStr(str);
+      pText->SetDirty(false);
+    }
+    stateResets = resets;
+  }
+  
+  //Show how often the async worker missed a block
+  const int asyncUnderruns = asyncProcessor ? asyncProcessor->GetUnderrunCount() : -1;
+  if(GetUI() && asyncUnderruns != underruns)
+  {
+    char str[64] = "";
+    if(asyncUnderruns >= 0)
+    {
+      snprintf(str, sizeof(str), "Async underruns: %i", asyncUnderruns);
+    }
+    if(auto* pText = GetUI()->GetControlWithTag(kCtrlAsync))
+    {
+      pText->As<ITextControl>()->SetStr(str);
+      pText->SetDirty(false);
+    }
+    underruns = asyncUnderruns;
+  }
+#endif
 }
 
 void NNComp::OnReset()
@@ -100,46 +159,111 @@ void NNComp::OnReset()
   outSender.Reset(GetSampleRate());
   grSender.Reset(GetSampleRate());
   
-  gr.SetFrameLength(GetBlockSize());
+  //Models run at 48 kHz, other host rates are resampled around them
+  const int crossfade = static_cast<int>(0.01 * RateAdapter<sample, 2>::kModelRate);
+  rateAdapter.Prepare(GetSampleRate(), GetBlockSize());
+  processor.SetCrossfadeLength(crossfade);
+  processor.SetSilenceGate(true);
+  
+  //Multicore runs the channels on the process-wide pool, inline when it is busy. Only worth
+  //it for models that take longer per block than a parked worker takes to wake up. Switching
+  //it on during playback takes effect at the next reset.
+  asyncProcessor.reset();
+  processor.SetPool(nullptr);
+  pool = GetParam(kMulticore)->Bool() ? RealtimePool::Acquire() : nullptr;
   
+  //Async mode runs one prepared block behind the host. Its processor and worker thread only
+  //exist while it is on; switching it on during playback takes effect at the next reset,
+  //which hosts do when the latency changes.
+  if(GetParam(kAsync)->Bool())
+  {
+    asyncProcessor = std::make_unique<AsyncProcessor<sample, 2>>();
+    asyncProcessor->GetProcessor().SetCrossfadeLength(crossfade);
+    asyncProcessor->GetProcessor().SetSilenceGate(true);
+    asyncProcessor->GetProcessor().SetPool(pool.get());
+    asyncProcessor->Prepare(GetBlockSize(), GetSampleRate());
+  }
+  asyncActive = false;
+  governor.Reset(GetSampleRate());
+  SetLatency(GetParam(kAsync)->Bool() ? GetAsyncLatency() : rateAdapter.GetLatency());
+}
+
+void NNComp::OnParamChange(int paramIdx)
+{
+  if(paramIdx == kAsync)
+  {
+    SetLatency(GetParam(kAsync)->Bool() ? GetAsyncLatency() : rateAdapter.GetLatency());
+  }
+}
+
+int NNComp::GetAsyncLatency() const
+{
+  //One block plus the same resampling as the synchronous path, see AsyncProcessor::Prepare()
+  return asyncProcessor ? asyncProcessor->GetLatency() : GetBlockSize() + rateAdapter.GetLatency();
 }
 
 void NNComp::ProcessBlock(sample** inputs, sample** outputs, int nFrames)
 {
-  const double inGain = DBToAmp(GetParam(kGain)->Value());
-  const double outGain = DBToAmp(GetParam(kOutGain)->Value());
   const int nChans = NOutChansConnected();
-  const int model = GetParam(kModel)->Int();
+  const bool async = GetParam(kAsync)->Bool() && asyncProcessor;
+  governor.SetEnabled(GetParam(kEco)->Bool() && !async);
+  const int model = governor.GetModel(GetParam(kModel)->Int());
+  const auto start = std::chrono::steady_clock::now();
+  const int blockSize = async ? asyncProcessor->GetMaxBlockSize() : rateAdapter.GetMaxBlockSize();
   
-  //Iterate over buffer
-  for (int s = 0; s < nFrames; s++) {
-    //Set GR to 0
-    gr.GetBuffer()[0][s] = 0.0;
+  if(async)
+  {
+    //Drop output left over from the last time async mode was used
+    if(!asyncActive)
+    {
+      asyncProcessor->Restart();
+    }
+    asyncProcessor->SetInputGain(DBToAmp(GetParam(kGain)->Value()));
+    asyncProcessor->SetOutputGain(DBToAmp(GetParam(kOutGain)->Value()));
+    asyncProcessor->SetModel(model);
+    asyncProcessor->SetBypass(GetParam(kBypass)->Bool());
+  }
+  else
+  {
+    processor.SetInputGain(DBToAmp(GetParam(kGain)->Value()));
+    processor.SetOutputGain(DBToAmp(GetParam(kOutGain)->Value()));
+    processor.SetModel(model);
+    processor.SetBypass(GetParam(kBypass)->Bool());
+    processor.SetPool(GetParam(kMulticore)->Bool() ? pool.get() : nullptr);
+  }
+  asyncActive = async;
+  
+  //Hosts may send blocks larger than announced, process in prepared sized chunks
+  for (int s = 0; s < nFrames; s += blockSize) {
+    const int n = std::min(blockSize, nFrames - s);
+    sample* in[2] = {inputs[0] + s, inputs[1] + s};
+    sample* out[2] = {outputs[0] + s, outputs[1] + s};
     
-    for (int c = 0; c < nChans; c++) {
-      //apply NN
-      inputs[c][s] *= inGain;
-      if(c == 0) {
-        nnL.ProcessSample(&inputs[c][s], &outputs[c][s], model);
-      } else if(c == 1) {
-        nnR.ProcessSample(&inputs[c][s], &outputs[c][s], model);
-      }
+    if(async)
+    {
+      asyncProcessor->Process(in, out, nChans, n);
       
-      //Set gr value
-      if(c < 2)
-      {
-        gr.GetBuffer()[c][s] = std::abs(inputs[c][s]) - std::abs(outputs[c][s]);
-      }
+      //Send values to meters
+      inSender.ProcessBlock(asyncProcessor->GetInputBuffer(), n, kCtrlInMeter);
+      outSender.ProcessBlock(out, n, kCtrlOutMeter);
+      grSender.ProcessBlock(asyncProcessor->GetGrBuffer(), n, kCtrlGrMeter);
+    }
+    else
+    {
+      rateAdapter.Process(in, out, nChans, n);
       
-      //Apply out gain
-      outputs[c][s] *= outGain;
+      //Send values to meters
+      inSender.ProcessBlock(processor.IsBypassed() ? in : rateAdapter.GetInputBuffer(), n, kCtrlInMeter);
+      outSender.ProcessBlock(out, n, kCtrlOutMeter);
+      grSender.ProcessBlock(rateAdapter.GetGrBuffer(), n, kCtrlGrMeter);
     }
   }
   
-  //Send values to meters
-  inSender.ProcessBlock(inputs, nFrames, kCtrlInMeter);
-  outSender.ProcessBlock(outputs, nFrames, kCtrlOutMeter);
-  grSender.ProcessBlock(gr.GetBuffer(), nFrames, kCtrlGrMeter);
-  nnSender.ProcessWeights(nnL, kCtrlNN, model);
+  //The async worker owns its model state, the weight display holds while it runs
+  if(!async)
+  {
+    governor.Update(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), nFrames, GetParam(kModel)->Int());
+    nnSender.ProcessWeights(processor.GetNetwork(0), kCtrlNN, model);
+  }
 }
 #endif
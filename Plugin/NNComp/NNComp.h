@@ -7,7 +7,11 @@
 #include "NetworkControl.h"
 #include "dsp.h"
 #include "WeightSender.h"
-#include "AudioBuffer.h"
+#include "NNProcessor.h"
+#include "AsyncProcessor.h"
+#include "RealtimePool.h"
+#include "CpuGovernor.h"
+#include "Resampler.h"
 
 const int kNumPresets = 1;
 
@@ -17,6 +21,9 @@ enum EParams
   kOutGain,
   kModel,
   kBypass,
+  kAsync,
+  kEco,
+  kMulticore,
   kNumParams
 };
 
@@ -26,6 +33,9 @@ enum EControlTags
   kCtrlOutMeter,
   kCtrlGrMeter,
   kCtrlNN,
+  kCtrlEco,
+  kCtrlResets,
+  kCtrlAsync,
   kCtrlTags
 };
 
@@ -42,17 +52,27 @@ public:
   void OnIdle() override;
   void OnReset() override;
   void ProcessBlock(sample** inputs, sample** outputs, int nFrames) override;
+  void OnParamChange(int paramIdx) override;
   
 private:
+  int GetAsyncLatency() const;
+  
+
   MeterSender<2> inSender {5., 0., 0.3, 0.5};
   MeterSender<2> outSender {5., 0., 0.3, 0.5};
   MeterSender<2> grSender {5., 0.1, 0.5, 0.5};
   WeightSender<32, 4> nnSender;
   
-  NN<sample> nnL;
-  NN<sample> nnR;
-  
-  CustomAudioBuffer<sample, 2> gr;
+  std::shared_ptr<RealtimePool> pool; //Shared by all instances, outlives the processors, only while kMulticore is on
+  NNProcessor<sample, 2> processor;
+  RateAdapter<sample, 2> rateAdapter {processor}; //Runs processor at 48 kHz
+  std::unique_ptr<AsyncProcessor<sample, 2>> asyncProcessor; //Inference on a worker thread, one block of latency, only while kAsync is on
+  bool asyncActive = false;
+  CpuGovernor governor; //Eco mode, synchronous processing only
+  int ecoModel = -2;
+  int ecoOverruns = -1;
+  int stateResets = 0;
+  int underruns = -1;
   
 #endif
 };
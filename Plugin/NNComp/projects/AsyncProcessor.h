@@ -0,0 +1,340 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include "NNProcessor.h"
+#include "Resampler.h"
+#include "SpscRing.h"
+#include "RealtimeThread.h"
+
+/**
+ * Runs an NNProcessor on a dedicated worker thread, one block behind the host.
+ * Process() only copies the input into a lock-free ring, queues a job and reads back output
+ * that the worker computed from an earlier block. The output ring starts with latency
+ * frames of silence, so as long as the worker finishes a block before the next callback the
+ * output is the processed input delayed by exactly GetLatency() frames, which the host
+ * compensates.
+ * If the worker falls behind the missing frames are output as silence and later discarded
+ * to keep the delay fixed. A block dropped because the worker is far behind never produces
+ * output, so its frames are output as silence in its place. GetUnderrunCount() counts both.
+ * The worker spins for a short while after each job and then parks on a semaphore. Process()
+ * only posts it when the worker is parked, so while the worker keeps up the audio thread
+ * makes no system calls.
+ * Channels above MAX_CHANS output silence.
+ * T - Sample type
+ * MAX_CHANS - Maximum number of channels run through a model
+ */
+template<typename T, int MAX_CHANS = 2>
+class AsyncProcessor
+{
+public:
+  AsyncProcessor() = default;
+
+  ~AsyncProcessor()
+  {
+    Stop();
+  }
+
+  AsyncProcessor(const AsyncProcessor&) = delete;
+  AsyncProcessor& operator=(const AsyncProcessor&) = delete;
+
+  /**
+   * Stop the worker, size the rings for blocks of up to maxBlockSize frames and restart.
+   * The latency is maxBlockSize plus the resampling delay at host rates other than 48 kHz.
+   * Not realtime safe.
+   */
+  void Prepare(int maxBlockSize, double sampleRate = RateAdapter<T, MAX_CHANS>::kModelRate)
+  {
+    Stop();
+
+    maxBlock = std::max(1, maxBlockSize);
+    adapter.Prepare(sampleRate, maxBlock);
+    latency = maxBlock + adapter.GetLatency();
+    scratch.SetFrameLength(maxBlock);
+    meters.SetFrameLength(maxBlock);
+
+    inputRing = std::make_unique<SpscRing<Frame>>(4 * static_cast<size_t>(maxBlock));
+    outputRing = std::make_unique<SpscRing<OutFrame>>(latency + 4 * static_cast<size_t>(maxBlock));
+    jobRing = std::make_unique<SpscRing<Job>>(64);
+
+    //Prime the output with one block
+    for(int i = 0; i < maxBlock; i++)
+    {
+      outputRing->Push(OutFrame {});
+    }
+    debt = 0;
+    pad = 0;
+
+    running = true;
+    worker = std::thread([this]() { WorkerLoop(); });
+  }
+
+  /**
+   * Join the worker. Not realtime safe.
+   */
+  void Stop()
+  {
+    if(!worker.joinable()) return;
+    running = false;
+    wake.Post();
+    worker.join();
+  }
+
+  /**
+   * Delay in frames between input and output
+   */
+  int GetLatency() const { return latency; }
+
+  int GetMaxBlockSize() const { return maxBlock; }
+
+  /**
+   * Number of times the worker missed a block, for diagnostics
+   */
+  int GetUnderrunCount() const { return underruns.load(std::memory_order_relaxed); }
+
+  /**
+   * Number of NaN/Inf state resets of the worker's models, reads only atomics so it is safe
+   * to call while the worker runs
+   */
+  int GetStateResetCount() const { return processor.GetStateResetCount(); }
+
+  //Parameters are handed to the worker with the next block
+
+  void SetInputGain(T gain) { params.inGain = gain; }
+  void SetOutputGain(T gain) { params.outGain = gain; }
+  void SetModel(int idx) { params.model = idx; }
+  void SetBypass(bool bypass) { params.bypass = bypass; }
+
+  /**
+   * Only call before Prepare() or between Stop() and Prepare()
+   */
+  NNProcessor<T, MAX_CHANS>& GetProcessor() { return processor; }
+
+  /**
+   * Discard queued output and reset the model state, eg. when switching into async mode
+   * after a pause. The delay stays the same.
+   */
+  void Restart()
+  {
+    const size_t n = outputRing->ReadAvailable();
+    outputRing->Consume(n);
+    pad += static_cast<long>(n);
+    params.reset = true;
+  }
+
+  /**
+   * Hand nFrames (<= max block size) to the worker and output the frames from latency
+   * frames ago. Lock and allocation free.
+   */
+  void Process(const T* const* inputs, T* const* outputs, int nChans, int nFrames)
+  {
+    const int nModelChans = std::min(nChans, MAX_CHANS);
+    nFrames = std::min(nFrames, maxBlock);
+
+    //Queue the input, dropped if the worker is far behind
+    if(inputRing->WriteAvailable() >= static_cast<size_t>(nFrames) && jobRing->WriteAvailable() > 0)
+    {
+      for(int s = 0; s < nFrames; s++)
+      {
+        Frame& f = inputRing->WriteSlot(s);
+        for(int c = 0; c < nModelChans; c++) f[c] = inputs[c][s];
+        for(int c = nModelChans; c < MAX_CHANS; c++) f[c] = T(0);
+      }
+      inputRing->Publish(nFrames);
+
+      Job& job = jobRing->WriteSlot(0);
+      job = params;
+      job.nChans = nModelChans;
+      job.nFrames = nFrames;
+      jobRing->Publish(1);
+      params.reset = false;
+
+      //Pairs with the fence in WaitForJob(): either the worker sees the job or we see it parked
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if(parked.load(std::memory_order_relaxed)) wake.Post();
+    }
+    else
+    {
+      //The block never reaches the output ring, output silence for it so the delay stays fixed
+      pad += nFrames;
+      underruns.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    //Read the output
+    T** meter = meters.GetBuffer();
+    int s = 0;
+    for(; s < nFrames && pad > 0; s++, pad--)
+    {
+      WriteSilence(outputs, meter, nChans, s);
+    }
+
+    size_t available = outputRing->ReadAvailable();
+    if(debt > 0)
+    {
+      const size_t skip = std::min<size_t>(available, static_cast<size_t>(debt));
+      outputRing->Consume(skip);
+      debt -= static_cast<long>(skip);
+      available -= skip;
+    }
+
+    const int n = static_cast<int>(std::min<size_t>(available, static_cast<size_t>(nFrames - s)));
+    for(int i = 0; i < n; i++, s++)
+    {
+      const OutFrame& f = outputRing->ReadSlot(i);
+      for(int c = 0; c < nModelChans; c++) outputs[c][s] = f[c];
+      for(int c = nModelChans; c < nChans; c++) outputs[c][s] = T(0);
+      for(int c = 0; c < MAX_CHANS; c++)
+      {
+        meter[c][s] = f[MAX_CHANS + c];
+        meter[2 * MAX_CHANS + c][s] = f[2 * MAX_CHANS + c];
+      }
+    }
+    outputRing->Consume(n);
+
+    if(s < nFrames)
+    {
+      debt += nFrames - s;
+      underruns.fetch_add(1, std::memory_order_relaxed);
+      for(; s < nFrames; s++)
+      {
+        WriteSilence(outputs, meter, nChans, s);
+      }
+    }
+  }
+
+  /**
+   * Gain-scaled input matching the last output block, MAX_CHANS channels
+   */
+  T** GetInputBuffer() { return meters.GetBuffer(); }
+
+  /**
+   * Gain reduction matching the last output block, MAX_CHANS channels
+   */
+  T** GetGrBuffer() { return meters.GetBuffer() + 2 * MAX_CHANS; }
+
+private:
+  using Frame = std::array<T, MAX_CHANS>;
+  using OutFrame = std::array<T, 3 * MAX_CHANS>; //Output, gained input, gain reduction
+
+  struct Job
+  {
+    T inGain = 1;
+    T outGain = 1;
+    int model = 0;
+    bool bypass = false;
+    bool reset = false;
+    int nChans = 0;
+    int nFrames = 0;
+  };
+
+  void WriteSilence(T* const* outputs, T** meter, int nChans, int s)
+  {
+    for(int c = 0; c < nChans; c++) outputs[c][s] = T(0);
+    for(int c = 0; c < MAX_CHANS; c++)
+    {
+      meter[c][s] = T(0);
+      meter[2 * MAX_CHANS + c][s] = T(0);
+    }
+  }
+
+  /**
+   * Wait for a job: spin for kSpinUs, then park until Process() or Stop() posts
+   */
+  bool WaitForJob()
+  {
+    const auto spinEnd = std::chrono::steady_clock::now() + std::chrono::microseconds(kSpinUs);
+    while(jobRing->ReadAvailable() == 0)
+    {
+      if(!running) return false;
+      if(std::chrono::steady_clock::now() < spinEnd)
+      {
+        SpinPause();
+        continue;
+      }
+
+      parked.store(true, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if(jobRing->ReadAvailable() == 0 && running) wake.Wait();
+      parked.store(false, std::memory_order_relaxed);
+    }
+    return running;
+  }
+
+  void WorkerLoop()
+  {
+    SetRealtimePriority();
+    ScopedDenormalGuard denormalGuard;
+    T** buf = scratch.GetBuffer();
+
+    while(WaitForJob())
+    {
+      const Job job = jobRing->ReadSlot(0);
+      jobRing->Consume(1);
+
+      if(job.reset) processor.Reset();
+      processor.SetInputGain(job.inGain);
+      processor.SetOutputGain(job.outGain);
+      processor.SetModel(job.model);
+      processor.SetBypass(job.bypass);
+
+      //De-interleave the input, the producer published all frames before the job
+      for(int s = 0; s < job.nFrames; s++)
+      {
+        const Frame& f = inputRing->ReadSlot(s);
+        for(int c = 0; c < MAX_CHANS; c++) buf[c][s] = f[c];
+      }
+      inputRing->Consume(job.nFrames);
+
+      adapter.Process(buf, buf + MAX_CHANS, job.nChans, job.nFrames);
+
+      //Wait for room, only if the audio thread stopped reading
+      while(outputRing->WriteAvailable() < static_cast<size_t>(job.nFrames))
+      {
+        if(!running) return;
+        std::this_thread::yield();
+      }
+
+      const bool bypassed = processor.IsBypassed();
+      T** in = bypassed ? buf : adapter.GetInputBuffer();
+      T** gr = adapter.GetGrBuffer();
+      for(int s = 0; s < job.nFrames; s++)
+      {
+        OutFrame& f = outputRing->WriteSlot(s);
+        for(int c = 0; c < MAX_CHANS; c++)
+        {
+          f[c] = buf[MAX_CHANS + c][s];
+          f[MAX_CHANS + c] = in[c][s];
+          f[2 * MAX_CHANS + c] = bypassed ? T(0) : gr[c][s];
+        }
+      }
+      outputRing->Publish(job.nFrames);
+    }
+  }
+
+  static constexpr int kSpinUs = 50; //Covers back to back blocks without parking
+
+  NNProcessor<T, MAX_CHANS> processor;
+  RateAdapter<T, MAX_CHANS> adapter {processor};
+  CustomAudioBuffer<T, 2 * MAX_CHANS> scratch; //Worker input and output
+  CustomAudioBuffer<T, 3 * MAX_CHANS> meters;  //Audio thread, same layout as NNProcessor
+
+  std::unique_ptr<SpscRing<Frame>> inputRing;
+  std::unique_ptr<SpscRing<OutFrame>> outputRing;
+  std::unique_ptr<SpscRing<Job>> jobRing;
+
+  std::thread worker;
+  Semaphore wake;
+  std::atomic<bool> parked {false};
+  std::atomic<bool> running {false};
+  std::atomic<int> underruns {0};
+
+  //Audio thread only
+  Job params;
+  long debt = 0; //Frames output as silence whose computed output must be discarded
+  long pad = 0;  //Frames to output as silence before reading the ring
+  int maxBlock = 0;
+  int latency = 0;
+};
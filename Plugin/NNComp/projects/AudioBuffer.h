@@ -1,34 +1,67 @@
 #pragma once
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
 /*
- Very simple class to handle an audio buffer
+ Very simple class to handle an audio buffer.
+ Channels are stored one after another (SoA) in a single allocation and each
+ channel starts on a 64 byte boundary so they can be used with aligned SIMD loads.
  */
 template<typename T, int nChans>
 class CustomAudioBuffer
 {
 public:
+  static constexpr int kAlignment = 64;
+
   CustomAudioBuffer()
   {
   }
-  
+
+  /**
+   * Allocate space for length frames per channel. Not realtime safe.
+   */
   void SetFrameLength(int length)
   {
-    //resize buffer
-    buffer.resize(length * nChans);
-    
+    //Round each channel up to a whole number of cache lines
+    const int perLine = kAlignment / sizeof(T);
+    stride = ((length + perLine - 1) / perLine) * perLine;
+    frameLength = length;
+
+    //resize buffer, leaving room to align the first channel
+    buffer.assign(stride * nChans + perLine, T(0));
+
     //Reset pointers
-    ptrs.clear();
+    const std::uintptr_t addr = reinterpret_cast<std::uintptr_t>(buffer.data());
+    const std::uintptr_t offset = (kAlignment - (addr % kAlignment)) % kAlignment;
+    T* base = buffer.data() + offset / sizeof(T);
     for(int i = 0; i < nChans; i++)
     {
-      ptrs.push_back(&buffer[i * nChans]);
+      ptrs[i] = base + i * stride;
     }
   }
-  
+
+  /**
+   * Zero all channels
+   */
+  void Clear()
+  {
+    std::fill(buffer.begin(), buffer.end(), T(0));
+  }
+
   T** GetBuffer()
   {
-    return &ptrs[0];
+    return ptrs.data();
+  }
+
+  int GetFrameLength() const
+  {
+    return frameLength;
   }
-  
+
 private:
-  std::vector<T*> ptrs;
+  std::array<T*, nChans> ptrs {};
   std::vector<T> buffer;
+  int stride = 0;
+  int frameLength = 0;
 };
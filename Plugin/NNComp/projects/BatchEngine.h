@@ -0,0 +1,360 @@
+#pragma once
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "Eigen/Dense"
+#include "Wavefront.h"
+#include "SpscRing.h"
+#include "Denormals.h"
+
+/**
+ * Batched inference of many independent streams through one model.
+ * With one model instance per stream every time step is a set of h x h matrix-vector
+ * products, which are bound by loading the weights. Here the streams share one copy of the
+ * weights and their states are the columns of an h x N matrix, so each time step becomes a
+ * few matrix-matrix products over all streams. The gate weights of a layer are stacked
+ * (i, f, g, o for lstm, r, z, n for gru) so one product computes every gate.
+ * Outputs match per-stream apply_model to rounding; the stacked sums are evaluated in a
+ * different order.
+ *
+ * Streams are added, reset and removed from a control thread through a lock-free command
+ * queue which the audio thread drains at the start of Process(), so neither side waits.
+ * Active streams are kept packed in the leftmost columns; removing a stream moves the last
+ * column into its place. Allocation only happens in the constructor.
+ */
+
+/**
+ * Sigmoid of every coefficient of an Eigen array expression
+ */
+template<typename A>
+inline auto SigmoidArray(const A& a)
+{
+  using T = typename A::Scalar;
+  return (T(1) + (-a).exp()).inverse();
+}
+
+template<typename Layer>
+struct BatchLayer;
+
+template<typename T, int h, int d>
+struct BatchLayer<LstmLayer<T, h, d>>
+{
+  void Init(const LstmLayer<T, h, d>& l, int capacity)
+  {
+    Wx << l.Wii, l.Wif, l.Wig, l.Wio;
+    Wh << l.Whi, l.Whf, l.Whg, l.Who;
+    b << l.bii + l.bhi, l.bif + l.bhf, l.big + l.bhg, l.bio + l.bho;
+    G.resize(4 * h, capacity);
+    H.setZero(h, capacity);
+    C.setZero(h, capacity);
+  }
+
+  template<typename X>
+  void Step(const X& x, int n)
+  {
+    auto g = G.leftCols(n);
+    g.noalias() = Wx * x;
+    g.noalias() += Wh * H.leftCols(n);
+    g.colwise() += b;
+
+    const auto it = SigmoidArray(g.template middleRows<h>(0).array());
+    const auto ft = SigmoidArray(g.template middleRows<h>(h).array());
+    const auto gt = g.template middleRows<h>(2 * h).array().tanh();
+    const auto ot = SigmoidArray(g.template middleRows<h>(3 * h).array());
+    C.leftCols(n).array() = ft * C.leftCols(n).array() + it * gt;
+    H.leftCols(n).array() = ot * C.leftCols(n).array().tanh();
+  }
+
+  void MoveColumn(int from, int to)
+  {
+    H.col(to) = H.col(from);
+    C.col(to) = C.col(from);
+  }
+
+  void ResetColumn(int c)
+  {
+    H.col(c).setZero();
+    C.col(c).setZero();
+  }
+
+  Eigen::Matrix<T, 4 * h, d> Wx;
+  Eigen::Matrix<T, 4 * h, h> Wh;
+  Eigen::Vector<T, 4 * h> b;
+  Eigen::Matrix<T, 4 * h, Eigen::Dynamic> G;
+  Eigen::Matrix<T, h, Eigen::Dynamic> H;
+  Eigen::Matrix<T, h, Eigen::Dynamic> C;
+};
+
+template<typename T, int h, int d>
+struct BatchLayer<GruLayer<T, h, d>>
+{
+  void Init(const GruLayer<T, h, d>& l, int capacity)
+  {
+    Wx << l.Wir, l.Wiz, l.Win;
+    Wh << l.Whr, l.Whz, l.Whn;
+    bx << l.bir, l.biz, l.bin;
+    bh << l.bhr, l.bhz, l.bhn;
+    Gx.resize(3 * h, capacity);
+    Gh.resize(3 * h, capacity);
+    H.setZero(h, capacity);
+  }
+
+  template<typename X>
+  void Step(const X& x, int n)
+  {
+    auto gx = Gx.leftCols(n);
+    auto gh = Gh.leftCols(n);
+    gx.noalias() = Wx * x;
+    gx.colwise() += bx;
+    gh.noalias() = Wh * H.leftCols(n);
+    gh.colwise() += bh;
+
+    const auto rt = SigmoidArray(gx.template middleRows<h>(0).array() + gh.template middleRows<h>(0).array());
+    const auto zt = SigmoidArray(gx.template middleRows<h>(h).array() + gh.template middleRows<h>(h).array());
+    const auto nt = (gx.template middleRows<h>(2 * h).array() + rt * gh.template middleRows<h>(2 * h).array()).tanh();
+    H.leftCols(n).array() = (T(1) - zt) * nt + zt * H.leftCols(n).array();
+  }
+
+  void MoveColumn(int from, int to) { H.col(to) = H.col(from); }
+
+  void ResetColumn(int c) { H.col(c).setZero(); }
+
+  Eigen::Matrix<T, 3 * h, d> Wx;
+  Eigen::Matrix<T, 3 * h, h> Wh;
+  Eigen::Vector<T, 3 * h> bx;
+  Eigen::Vector<T, 3 * h> bh;
+  Eigen::Matrix<T, 3 * h, Eigen::Dynamic> Gx;
+  Eigen::Matrix<T, 3 * h, Eigen::Dynamic> Gh;
+  Eigen::Matrix<T, h, Eigen::Dynamic> H;
+};
+
+template<typename T, int h, int d>
+struct BatchLayer<RnnLayer<T, h, d>>
+{
+  void Init(const RnnLayer<T, h, d>& l, int capacity)
+  {
+    Wx = l.Wih;
+    Wh = l.Whh;
+    b = l.bih + l.bhh;
+    G.resize(h, capacity);
+    H.setZero(h, capacity);
+  }
+
+  template<typename X>
+  void Step(const X& x, int n)
+  {
+    auto g = G.leftCols(n);
+    g.noalias() = Wx * x;
+    g.noalias() += Wh * H.leftCols(n);
+    g.colwise() += b;
+    H.leftCols(n).array() = g.array().tanh();
+  }
+
+  void MoveColumn(int from, int to) { H.col(to) = H.col(from); }
+
+  void ResetColumn(int c) { H.col(c).setZero(); }
+
+  Eigen::Matrix<T, h, d> Wx;
+  Eigen::Matrix<T, h, h> Wh;
+  Eigen::Vector<T, h> b;
+  Eigen::Matrix<T, h, Eigen::Dynamic> G;
+  Eigen::Matrix<T, h, Eigen::Dynamic> H;
+};
+
+/**
+ * Runs up to maxStreams streams through a generated model class M.
+ * Large, allocate on the heap.
+ *
+ * BatchEngine<Lstm_16_2<float>> engine(model, 64);
+ * const int id = engine.AddStream();            //control thread
+ * engine.Process(inputs, outputs, nFrames);     //audio thread, buffers indexed by stream id
+ * engine.RemoveStream(id);                      //control thread
+ */
+template<typename M>
+class BatchEngine
+{
+public:
+  using T = std::decay_t<decltype(std::declval<M&>().f.y)>;
+  static constexpr int h = M::h;
+  static constexpr int L = M::layers;
+
+  BatchEngine(const M& model, const int maxStreams)
+  : capacity(maxStreams)
+  , commands(4 * static_cast<size_t>(maxStreams))
+  , idUsed(maxStreams, false)
+  , slotOf(maxStreams, -1)
+  , colOf(maxStreams, -1)
+  {
+    InitLayers<0>(model);
+    A = model.f.A.transpose();
+    bOut = model.f.b(0);
+    X.resize(1, capacity);
+    Y.resize(1, capacity);
+  }
+
+  BatchEngine(const BatchEngine&) = delete;
+  BatchEngine& operator=(const BatchEngine&) = delete;
+
+  int GetMaxStreams() const { return capacity; }
+
+  //Control thread
+
+  /**
+   * Reserve a stream id and queue its activation with a zero state, -1 if none is free
+   */
+  int AddStream()
+  {
+    for(int id = 0; id < capacity; id++)
+    {
+      if(!idUsed[id])
+      {
+        if(!commands.Push({Command::Add, id})) return -1;
+        idUsed[id] = true;
+        return id;
+      }
+    }
+    return -1;
+  }
+
+  /**
+   * Queue removal of a stream, its id may be reused straight away
+   */
+  bool RemoveStream(const int id)
+  {
+    if(id < 0 || id >= capacity || !idUsed[id] || !commands.Push({Command::Remove, id})) return false;
+    idUsed[id] = false;
+    return true;
+  }
+
+  /**
+   * Queue a return of a stream to the zero state
+   */
+  bool ResetStream(const int id)
+  {
+    if(id < 0 || id >= capacity || !idUsed[id]) return false;
+    return commands.Push({Command::Reset, id});
+  }
+
+  //Audio thread
+
+  /**
+   * Number of streams processed by the next Process() call, after pending commands
+   */
+  int GetNumActive() const { return nActive; }
+
+  /**
+   * Process nFrames of every active stream. inputs and outputs are indexed by stream id,
+   * entries of inactive ids are not touched.
+   */
+  void Process(const T* const* inputs, T* const* outputs, const int nFrames)
+  {
+    ApplyCommands();
+
+    const int n = nActive;
+    if(n == 0) return;
+
+    ScopedDenormalGuard denormalGuard;
+    auto top = std::get<L - 1>(layers).H.leftCols(n);
+    auto y = Y.leftCols(n);
+
+    for(int t = 0; t < nFrames; t++)
+    {
+      for(int c = 0; c < n; c++)
+      {
+        X(0, c) = inputs[slotOf[c]][t];
+      }
+
+      StepLayers<0>(n);
+
+      y.noalias() = A * top;
+      y.array() = (y.array() + bOut).tanh();
+      for(int c = 0; c < n; c++)
+      {
+        outputs[slotOf[c]][t] = y(0, c);
+      }
+    }
+  }
+
+private:
+  struct Command
+  {
+    enum Type {Add, Remove, Reset} type;
+    int id;
+  };
+
+  template<int... I>
+  static auto MakeLayers(std::integer_sequence<int, I...>)
+    -> std::tuple<BatchLayer<std::decay_t<decltype(GetLayer<I>(std::declval<M&>()))>>...>;
+
+  using Layers = decltype(MakeLayers(std::make_integer_sequence<int, L>()));
+
+  template<int j>
+  void InitLayers(const M& model)
+  {
+    std::get<j>(layers).Init(GetLayer<j>(model), capacity);
+    if constexpr (j + 1 < L) InitLayers<j + 1>(model);
+  }
+
+  template<int j>
+  void StepLayers(const int n)
+  {
+    if constexpr (j == 0) std::get<0>(layers).Step(X.leftCols(n), n);
+    else std::get<j>(layers).Step(std::get<j - 1>(layers).H.leftCols(n), n);
+    if constexpr (j + 1 < L) StepLayers<j + 1>(n);
+  }
+
+  template<typename F>
+  void ForEachBatchLayer(F&& f)
+  {
+    std::apply([&](auto&... l) { (f(l), ...); }, layers);
+  }
+
+  void ApplyCommands()
+  {
+    Command cmd;
+    while(commands.Pop(cmd))
+    {
+      const int id = cmd.id;
+      if(cmd.type == Command::Add && colOf[id] < 0)
+      {
+        const int c = nActive++;
+        slotOf[c] = id;
+        colOf[id] = c;
+        ForEachBatchLayer([c](auto& l) { l.ResetColumn(c); });
+      }
+      else if(cmd.type == Command::Remove && colOf[id] >= 0)
+      {
+        //Keep the active columns packed
+        const int c = colOf[id];
+        const int last = --nActive;
+        if(c != last)
+        {
+          ForEachBatchLayer([c, last](auto& l) { l.MoveColumn(last, c); });
+          slotOf[c] = slotOf[last];
+          colOf[slotOf[c]] = c;
+        }
+        colOf[id] = -1;
+        slotOf[last] = -1;
+      }
+      else if(cmd.type == Command::Reset && colOf[id] >= 0)
+      {
+        const int c = colOf[id];
+        ForEachBatchLayer([c](auto& l) { l.ResetColumn(c); });
+      }
+    }
+  }
+
+  const int capacity;
+  Layers layers;
+  Eigen::Matrix<T, 1, h> A;
+  T bOut = 0;
+  Eigen::Matrix<T, 1, Eigen::Dynamic> X;
+  Eigen::Matrix<T, 1, Eigen::Dynamic> Y;
+
+  SpscRing<Command> commands;
+  std::vector<bool> idUsed;  //Control thread only
+  std::vector<int> slotOf;   //Stream id of each active column, audio thread only
+  std::vector<int> colOf;    //Column of each stream id or -1, audio thread only
+  int nActive = 0;
+};
@@ -0,0 +1,243 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "Eigen/Dense"
+#include "layers.h"
+#include "ModelState.h"
+#include "Wavefront.h"
+
+/**
+ * Activation statistics for quantization, only available in calibration builds.
+ * Define NNCOMP_CALIBRATION for the whole program (layers.h includes this file then) and run a
+ * model on representative audio with CalibrationRecorder::Run. Every step of every layer
+ * reports its gate pre-activations, ct and ht, the output layer its pre-activation and output.
+ * The recorder keeps the per-unit minimum and maximum and a histogram of every unit over its
+ * own range, and writes them as JSON for a quantizer. Without NNCOMP_CALIBRATION the layer
+ * hooks expand to nothing and this header cannot be included.
+ */
+
+#if !defined(NNCOMP_CALIBRATION)
+#error "Calibration.h needs NNCOMP_CALIBRATION, which is never defined in release builds"
+#endif
+
+/**
+ * Per-unit range and histogram of one recorded vector
+ */
+struct CalibrationTensor
+{
+  int layer = 0; //-1 for the model input, layers for the output layer
+  std::string name;
+  Eigen::ArrayXd min;
+  Eigen::ArrayXd max;
+  Eigen::Array<long, Eigen::Dynamic, Eigen::Dynamic> histogram; //units x bins
+};
+
+class CalibrationRecorder
+{
+public:
+  static constexpr int kDefaultBins = 128;
+
+  explicit CalibrationRecorder(int nBins = kDefaultBins)
+  : bins(std::max(1, nBins))
+  {
+  }
+
+  /**
+   * Run model m over x twice from its initial state, first recording the ranges and then the
+   * histograms within them. Replaces what was recorded before. Leaves m in its initial state.
+   */
+  template<typename M, typename T>
+  void Run(M& m, const T* x, int nFrames)
+  {
+    tensors.clear();
+    layerTypes.assign(M::layers + 1, "");
+    layerAddress.clear();
+    ForEachLayer(m, [&](auto& l) { layerAddress.push_back(&l); });
+    layerAddress.push_back(&m.f);
+    samples = nFrames;
+
+    CalibrationRecorder* prev = Active();
+    Active() = this;
+    std::vector<T> y(std::max(1, nFrames));
+    for(pass = 0; pass < 2; pass++)
+    {
+      ResetState(m);
+      ApplyModelWavefront(m, x, y.data(), nFrames);
+      for(int s = 0; s < nFrames; s++) Add(-1, "input", Eigen::Matrix<double, 1, 1>(double(x[s])));
+    }
+    Active() = prev;
+    ResetState(m);
+  }
+
+  /**
+   * Write the recorded statistics as JSON
+   */
+  bool Write(const std::string& path, const std::string& modelName, std::string& error) const
+  {
+    FILE* file = fopen(path.c_str(), "w");
+    if(!file)
+    {
+      error = "cannot open " + path;
+      return false;
+    }
+
+    fprintf(file, "{\n  \"model\": \"%s\",\n  \"samples\": %ld,\n  \"bins\": %d,\n  \"layers\": [", modelName.c_str(), samples, bins);
+    for(size_t j = 0; j < layerTypes.size(); j++) fprintf(file, "%s\"%s\"", j ? ", " : "", layerTypes[j].c_str());
+    fprintf(file, "],\n  \"tensors\": [\n");
+    for(size_t k = 0; k < tensors.size(); k++)
+    {
+      const CalibrationTensor& t = tensors[k];
+      fprintf(file, "    {\n      \"layer\": %d,\n      \"name\": \"%s\",\n", t.layer, t.name.c_str());
+      fprintf(file, "      \"min\": [");
+      for(Eigen::Index u = 0; u < t.min.size(); u++) fprintf(file, "%s%.9g", u ? ", " : "", t.min[u]);
+      fprintf(file, "],\n      \"max\": [");
+      for(Eigen::Index u = 0; u < t.max.size(); u++) fprintf(file, "%s%.9g", u ? ", " : "", t.max[u]);
+      fprintf(file, "],\n      \"histogram\": [\n");
+      for(Eigen::Index u = 0; u < t.histogram.rows(); u++)
+      {
+        fprintf(file, "        [");
+        for(Eigen::Index b = 0; b < t.histogram.cols(); b++) fprintf(file, "%s%ld", b ? ", " : "", t.histogram(u, b));
+        fprintf(file, "]%s\n", u + 1 < t.histogram.rows() ? "," : "");
+      }
+      fprintf(file, "      ]\n    }%s\n", k + 1 < tensors.size() ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+
+    if(fclose(file) != 0)
+    {
+      error = "failed writing " + path;
+      return false;
+    }
+    return true;
+  }
+
+  const std::vector<CalibrationTensor>& GetTensors() const { return tensors; }
+  int GetBins() const { return bins; }
+
+  template<typename T, int h, int d>
+  void Record(const LstmLayer<T, h, d>& l)
+  {
+    const int j = LayerIndex(&l, "lstm");
+    if(j < 0) return;
+    Add(j, "pre_i", Wx(l.Wii, l.Whi, l.bii + l.bhi, l));
+    Add(j, "pre_f", Wx(l.Wif, l.Whf, l.bif + l.bhf, l));
+    Add(j, "pre_g", Wx(l.Wig, l.Whg, l.big + l.bhg, l));
+    Add(j, "pre_o", Wx(l.Wio, l.Who, l.bio + l.bho, l));
+    Add(j, "ct", l.ct);
+    Add(j, "ht", l.ht);
+  }
+
+  template<typename T, int h, int d>
+  void Record(const GruLayer<T, h, d>& l)
+  {
+    const int j = LayerIndex(&l, "gru");
+    if(j < 0) return;
+    Add(j, "pre_r", Wx(l.Wir, l.Whr, l.bir + l.bhr, l));
+    Add(j, "pre_z", Wx(l.Wiz, l.Whz, l.biz + l.bhz, l));
+    const Eigen::Vector<T, h> hn = l.Whn * l.htn1 + l.bhn;
+    Add(j, "hn", hn); //Recurrent part of the new gate, before the reset gate scales it
+    Add(j, "pre_n", l.Win * l.xt + l.bin + l.rt.cwiseProduct(hn));
+    Add(j, "ht", l.ht);
+  }
+
+  template<typename T, int h, int d>
+  void Record(const RnnLayer<T, h, d>& l)
+  {
+    const int j = LayerIndex(&l, "rnn");
+    if(j < 0) return;
+    Add(j, "pre", Wx(l.Wih, l.Whh, l.bih + l.bhh, l));
+    Add(j, "ht", l.ht);
+  }
+
+  template<typename T, int h, int d>
+  void Record(const FccLayer<T, h, d>& l)
+  {
+    const int j = LayerIndex(&l, "fcc");
+    if(j < 0) return;
+    Add(j, "pre", l.xt.transpose() * l.A + l.b.transpose());
+    Add(j, "output", Eigen::Matrix<double, 1, 1>(double(l.y)));
+  }
+
+  /**
+   * Recorder of the Run() in progress on this thread, nullptr if none
+   */
+  static CalibrationRecorder*& Active()
+  {
+    thread_local CalibrationRecorder* active = nullptr;
+    return active;
+  }
+
+private:
+  /**
+   * Gate pre-activation for the step in progress, htn1 still holds the previous state
+   */
+  template<typename A, typename B, typename C, typename L>
+  static auto Wx(const A& Wi, const B& Wh, const C& b, const L& l)
+  {
+    return (Wi * l.xt + Wh * l.htn1 + b).eval();
+  }
+
+  int LayerIndex(const void* l, const char* type)
+  {
+    for(size_t j = 0; j < layerAddress.size(); j++)
+    {
+      if(layerAddress[j] == l)
+      {
+        layerTypes[j] = type;
+        return static_cast<int>(j);
+      }
+    }
+    return -1;
+  }
+
+  template<typename V>
+  void Add(int layer, const char* name, const V& v)
+  {
+    const Eigen::MatrixXd m = v.template cast<double>();
+    const Eigen::Map<const Eigen::ArrayXd> a(m.data(), m.size());
+    CalibrationTensor& t = Find(layer, name, static_cast<int>(a.size()));
+    if(pass == 0)
+    {
+      t.min = t.min.min(a);
+      t.max = t.max.max(a);
+      return;
+    }
+    for(Eigen::Index u = 0; u < a.size(); u++)
+    {
+      const double range = t.max[u] - t.min[u];
+      const int b = range > 0. ? static_cast<int>((a[u] - t.min[u]) / range * bins) : 0;
+      t.histogram(u, std::clamp(b, 0, bins - 1))++;
+    }
+  }
+
+  CalibrationTensor& Find(int layer, const char* name, int units)
+  {
+    for(CalibrationTensor& t : tensors)
+    {
+      if(t.layer == layer && t.name == name) return t;
+    }
+    CalibrationTensor& t = tensors.emplace_back();
+    t.layer = layer;
+    t.name = name;
+    t.min = Eigen::ArrayXd::Constant(units, INFINITY);
+    t.max = Eigen::ArrayXd::Constant(units, -INFINITY);
+    t.histogram = Eigen::Array<long, Eigen::Dynamic, Eigen::Dynamic>::Zero(units, bins);
+    return t;
+  }
+
+  std::vector<CalibrationTensor> tensors;
+  std::vector<std::string> layerTypes;
+  std::vector<const void*> layerAddress; //l0.., f
+  long samples = 0;
+  int bins;
+  int pass = 0;
+};
+
+template<typename L>
+void RecordCalibration(const L& l)
+{
+  if(CalibrationRecorder* recorder = CalibrationRecorder::Active()) recorder->Record(l);
+}
@@ -0,0 +1,153 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "ModelState.h"
+#include "Wavefront.h"
+#include "Denormals.h"
+
+/**
+ * Chunk-parallel offline rendering.
+ * Recurrent inference is serial, but the compressor models have finite memory. A long signal
+ * is split into chunks which are rendered in parallel, each by its own copy of the model.
+ * Every chunk after the first starts from the initial state and is first run over a warm-up
+ * prefix of the preceding input so its state has converged by the start of its output region.
+ * The result differs from a serial render only by the unconverged remainder at each seam,
+ * which CompareChunkedToSerial measures.
+ * Spawns threads and allocates, not for use on the audio thread.
+ */
+
+struct ChunkRenderSettings
+{
+  long chunkSize = 48000 * 10; //Output frames per chunk
+  long warmup = 48000;         //Input frames run before each chunk to converge its state
+  int nThreads = 0;            //0 = hardware concurrency
+};
+
+struct ChunkRenderReport
+{
+  int nChunks = 0;
+  double maxError = 0.;        //Largest absolute difference to the serial render
+  double rmsError = 0.;        //RMS difference to the serial render over the whole signal
+  std::vector<double> seamError; //Largest absolute difference within each chunk after the first
+};
+
+/**
+ * Run f(i) for i in [0, n) on up to nThreads threads, handing out indices dynamically
+ */
+template<typename F>
+void ParallelFor(int n, int nThreads, F&& f)
+{
+  if(nThreads <= 0)
+  {
+    nThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  nThreads = std::min(nThreads, n);
+
+  std::atomic<int> next {0};
+  auto work = [&]() {
+    for(int i = next++; i < n; i = next++)
+    {
+      f(i);
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for(int t = 1; t < nThreads; t++)
+  {
+    workers.emplace_back(work);
+  }
+  work();
+
+  for(auto& w : workers)
+  {
+    w.join();
+  }
+}
+
+/**
+ * Render one region [start, end) of x into y with a private copy of m, warmed up over
+ * [warmStart, start). With warmStart == start the copy keeps the state of m.
+ */
+template<typename M, typename T>
+void RenderRegion(const M& m, const T* x, T* y, long warmStart, long start, long end, bool reset)
+{
+  constexpr int kBlock = 256;
+  ScopedDenormalGuard denormalGuard;
+
+  auto local = std::make_unique<M>(m);
+  if(reset)
+  {
+    ResetState(*local);
+  }
+
+  //Warm up, output discarded
+  T scratch[kBlock];
+  for(long t = warmStart; t < start; t += kBlock)
+  {
+    ApplyModelWavefront(*local, x + t, scratch, static_cast<int>(std::min<long>(kBlock, start - t)));
+  }
+
+  for(long t = start; t < end; t += kBlock)
+  {
+    ApplyModelWavefront(*local, x + t, y + t, static_cast<int>(std::min<long>(kBlock, end - t)));
+  }
+}
+
+/**
+ * Render nFrames of x into y through model m in parallel chunks. m is not modified; the
+ * first chunk continues from its current state, later chunks start from the initial state.
+ */
+template<typename M, typename T>
+int RenderChunked(const M& m, const T* x, T* y, const long nFrames, const ChunkRenderSettings& settings = {})
+{
+  const long chunkSize = std::max(1L, settings.chunkSize);
+  const long warmup = std::max(0L, settings.warmup);
+  const int nChunks = static_cast<int>((nFrames + chunkSize - 1) / chunkSize);
+
+  ParallelFor(nChunks, settings.nThreads, [&](int i) {
+    const long start = i * chunkSize;
+    const long end = std::min(nFrames, start + chunkSize);
+    const long warmStart = std::max(0L, start - warmup);
+    RenderRegion(m, x, y, i == 0 ? start : warmStart, start, end, i > 0);
+  });
+
+  return nChunks;
+}
+
+/**
+ * Render x both serially and in chunks and report the difference, for choosing chunk and
+ * warm-up lengths. y receives the chunked render.
+ */
+template<typename M, typename T>
+ChunkRenderReport CompareChunkedToSerial(const M& m, const T* x, T* y, const long nFrames, const ChunkRenderSettings& settings = {})
+{
+  ChunkRenderReport report;
+  std::vector<T> serial(nFrames);
+  RenderRegion(m, x, serial.data(), 0, 0, nFrames, false);
+  report.nChunks = RenderChunked(m, x, y, nFrames, settings);
+
+  const long chunkSize = std::max(1L, settings.chunkSize);
+  double sum = 0.;
+  for(int i = 0; i < report.nChunks; i++)
+  {
+    double chunkMax = 0.;
+    const long end = std::min(nFrames, (i + 1) * chunkSize);
+    for(long t = i * chunkSize; t < end; t++)
+    {
+      const double e = std::abs(static_cast<double>(y[t]) - static_cast<double>(serial[t]));
+      chunkMax = std::max(chunkMax, e);
+      sum += e * e;
+    }
+    report.maxError = std::max(report.maxError, chunkMax);
+    if(i > 0)
+    {
+      report.seamError.push_back(chunkMax);
+    }
+  }
+  report.rmsError = nFrames > 0 ? std::sqrt(sum / nFrames) : 0.;
+  return report;
+}
@@ -0,0 +1,171 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+/**
+ * Adaptive model tier selection ("eco" mode).
+ * The plugin models come in three quality tiers per type, 32-1/16-2/8-4, 16-1/8-2/4-4 and
+ * 8-1/4-2/2-4, each tier roughly a quarter of the cost of the one above (see the model
+ * order in NNComp.cpp). The governor measures the time spent on every block against its
+ * real-time deadline. On an overrun, or when the smoothed load passes kHighLoad, it steps
+ * down to the same shape in the next cheaper tier, if the requested model has one. Once the load has stayed under kLowLoad
+ * for the hold time it steps back up; the hold doubles each time a step up has to be undone
+ * soon after. A step up that overruns is undone at once. Model switches are crossfaded by
+ * NNProcessor, so both models run for a moment after a switch.
+ * Update() runs on the audio thread, the getters may be read from the UI thread.
+ */
+class CpuGovernor
+{
+public:
+  static constexpr int kModelsPerType = 9;
+  static constexpr int kModelsPerTier = 3;
+  static constexpr int kTiers = 3;
+  static constexpr double kHighLoad = 0.7;
+  static constexpr double kLowLoad = 0.15;
+  static constexpr double kSmoothing = 0.1;  //Load time constant in seconds
+  static constexpr double kSettle = 0.5;     //Seconds ignored after a switch, covers the crossfade
+  static constexpr double kMinHold = 2.;     //Seconds under kLowLoad before stepping up
+  static constexpr double kMaxHold = 64.;
+
+  void Reset(double sampleRate)
+  {
+    sr = sampleRate;
+    load = 0.;
+    settle = 0.;
+    lowTime = 0.;
+    sinceUp = kMaxHold;
+    hold = kMinHold;
+    steps = 0;
+    steppedUp = false;
+    stepsOut.store(0, std::memory_order_relaxed);
+  }
+
+  void SetEnabled(bool enable)
+  {
+    if(enable != enabled.load(std::memory_order_relaxed))
+    {
+      enabled.store(enable, std::memory_order_relaxed);
+      steps = 0;
+      stepsOut.store(0, std::memory_order_relaxed);
+      settle = 0.;
+      lowTime = 0.;
+    }
+  }
+
+  bool IsEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+  /**
+   * Model to run for the requested model, a cheaper one of the same type when stepped down
+   */
+  int GetModel(int requested) const
+  {
+    if(!IsEnabled() || requested < 0) return requested;
+    const int type = requested / kModelsPerType;
+    const int tier = GetTier(requested);
+    const int shape = requested % kModelsPerTier;
+    const int active = std::min(kTiers - 1, tier + stepsOut.load(std::memory_order_relaxed));
+    return type * kModelsPerType + active * kModelsPerTier + shape;
+  }
+
+  /**
+   * Account for one processed block. seconds - time spent processing nFrames with the model
+   * GetModel(requested) returned
+   */
+  void Update(double seconds, int nFrames, int requested)
+  {
+    if(!IsEnabled() || nFrames <= 0 || sr <= 0.) return;
+
+    //Only the tiers below the requested model can be stepped down to
+    const int maxSteps = requested < 0 ? 0 : kTiers - 1 - GetTier(requested);
+    if(steps > maxSteps)
+    {
+      steps = maxSteps;
+      stepsOut.store(steps, std::memory_order_relaxed);
+    }
+
+    const double duration = nFrames / sr;
+    const double blockLoad = seconds / duration;
+    load += (blockLoad - load) * (1. - std::exp(-duration / kSmoothing));
+    loadOut.store(static_cast<float>(load), std::memory_order_relaxed);
+    sinceUp += duration;
+
+    if(blockLoad > 1.)
+    {
+      overruns.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    //Give a switch time to settle, but undo a step up straight away if it overruns
+    if(settle > 0.)
+    {
+      settle -= duration;
+      if(!(blockLoad > 1. && steppedUp)) return;
+    }
+
+    if((blockLoad > 1. || load > kHighLoad) && steps < maxSteps)
+    {
+      //Backing off a step up that did not fit, wait longer next time
+      if(sinceUp < hold)
+      {
+        hold = std::min(kMaxHold, 2. * hold);
+      }
+      Step(1);
+    }
+    else if(load < kLowLoad && steps > 0)
+    {
+      lowTime += duration;
+      if(lowTime >= hold)
+      {
+        sinceUp = 0.;
+        Step(-1);
+        steppedUp = true;
+      }
+    }
+    else
+    {
+      lowTime = 0.;
+    }
+  }
+
+  /**
+   * Number of tiers below the requested model
+   */
+  int GetStepsDown() const { return stepsOut.load(std::memory_order_relaxed); }
+
+  /**
+   * Blocks that took longer than their duration since construction
+   */
+  int GetOverrunCount() const { return overruns.load(std::memory_order_relaxed); }
+
+  /**
+   * Smoothed processing time over block duration
+   */
+  float GetLoad() const { return loadOut.load(std::memory_order_relaxed); }
+
+private:
+  static int GetTier(int model) { return (model % kModelsPerType) / kModelsPerTier; }
+
+  void Step(int direction)
+  {
+    steps += direction;
+    steppedUp = false;
+    stepsOut.store(steps, std::memory_order_relaxed);
+    settle = kSettle;
+    lowTime = 0.;
+    load = 0.;
+  }
+
+  double sr = 0.;
+  double load = 0.;
+  double settle = 0.;
+  double lowTime = 0.;
+  double sinceUp = kMaxHold;
+  double hold = kMinHold;
+  int steps = 0;
+  bool steppedUp = false;
+  std::atomic<bool> enabled {false}; //Written by the audio thread, read by the UI
+
+  std::atomic<int> stepsOut {0};
+  std::atomic<int> overruns {0};
+  std::atomic<float> loadOut {0.f};
+};
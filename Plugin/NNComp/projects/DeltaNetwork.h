@@ -0,0 +1,321 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+#include "Eigen/Dense"
+#include "layers.h"
+#include "ModelState.h"
+#include "Wavefront.h"
+
+/**
+ * Delta network execution of a model.
+ * Every layer keeps its weight products W * x and Wh * htn1 as accumulators, together with
+ * the inputs and states they were computed from. Each sample only the units whose input or
+ * state moved by more than the threshold since they were last applied are updated: their
+ * indices are gathered, then their columns of the stacked gate matrix times their changes
+ * are added in one product, the others keep their old value. On audio with slowly varying
+ * envelopes most hidden units change little from sample to sample, so most columns are
+ * skipped, and a layer none of whose units changed keeps its gate activations. The error per
+ * unit is bounded by the threshold and does not accumulate. The accumulators and stacked
+ * matrices are recomputed in full every kRefreshInterval samples to bound rounding error,
+ * and after a reset or a model change.
+ * A threshold of 0 runs the model as usual and is exact.
+ * T - Type
+ */
+template<typename T>
+class DeltaNetwork
+{
+public:
+  static constexpr int kMaxLayers = 4;
+  static constexpr int kMaxRows = 4 * 32; //Stacked gate rows of the largest layer
+  static constexpr int kMaxUnits = 32;
+  static constexpr int kRefreshInterval = 4096;
+
+  DeltaNetwork() {}
+
+  /**
+   * threshold - smallest change of a unit that is applied, 0 = exact
+   */
+  void Set(T threshold)
+  {
+    this->threshold = std::max(T(0), threshold);
+    Reset();
+  }
+
+  /**
+   * Allocates the stacked weights on first use, not realtime safe
+   */
+  void SetEnabled(bool enable)
+  {
+    enabled = enable;
+    if(enable && stackedX.empty())
+    {
+      stackedX.assign(kMaxLayers * kMaxRows * kMaxUnits, T(0));
+      stackedH.assign(kMaxLayers * kMaxRows * kMaxUnits, T(0));
+    }
+    Reset();
+  }
+
+  /**
+   * Recompute the accumulators on the next sample, eg. after a model change or a state reset
+   */
+  void Reset()
+  {
+    stale = true;
+  }
+
+  bool IsEnabled() const { return enabled; }
+  T GetThreshold() const { return threshold; }
+
+  /**
+   * Fraction of weight columns applied since the last ResetStats(), for diagnostics
+   */
+  double GetUpdateRatio() const { return total > 0 ? double(updated) / double(total) : 1.; }
+
+  void ResetStats()
+  {
+    updated = 0;
+    total = 0;
+  }
+
+  /**
+   * Process a block through model m
+   */
+  template<typename M>
+  void Process(M& m, const T* x, T* y, const int nFrames)
+  {
+    static_assert(M::layers <= kMaxLayers, "DeltaNetwork takes models of 1 to 4 layers");
+    static_assert(ModelWidth<M>() <= kMaxUnits, "DeltaNetwork takes layers of up to 32 units");
+    if(threshold <= T(0) || stackedX.empty())
+    {
+      ApplyModelWavefront(m, x, y, nFrames);
+      stale = true;
+      return;
+    }
+
+    auto& top = GetLayer<M::layers - 1>(m);
+    for(int s = 0; s < nFrames; s++)
+    {
+      const bool full = stale || sinceRefresh >= kRefreshInterval;
+      sinceRefresh = full ? 0 : sinceRefresh + 1;
+      stale = false;
+
+      StepLayers<0>(m, x[s], full);
+      y[s] = m.f.apply_layer(top.ht);
+    }
+  }
+
+private:
+  template<int j, typename M>
+  void StepLayers(M& m, const T x, const bool full)
+  {
+    auto& l = GetLayer<j>(m);
+    if constexpr (j == 0)
+    {
+      l.xt.setConstant(x);
+      Step(l, j, l.xt, full);
+    }
+    else Step(l, j, GetLayer<j - 1>(m).ht, full);
+    if constexpr (j + 1 < M::layers) StepLayers<j + 1>(m, x, full);
+  }
+
+  template<int n>
+  Eigen::Map<Eigen::Vector<T, n>> Acc(std::array<T, kMaxLayers * kMaxRows>& data, int j)
+  {
+    return Eigen::Map<Eigen::Vector<T, n>>(data.data() + j * kMaxRows);
+  }
+
+  /**
+   * Stacked gate matrix of layer j, column-major with kMaxRows between columns
+   */
+  template<int rows, int cols>
+  Eigen::Map<Eigen::Matrix<T, rows, cols>, 0, Eigen::OuterStride<kMaxRows>> Stacked(std::vector<T>& data, int j)
+  {
+    return Eigen::Map<Eigen::Matrix<T, rows, cols>, 0, Eigen::OuterStride<kMaxRows>>(data.data() + j * kMaxRows * kMaxUnits);
+  }
+
+  template<int n>
+  Eigen::Map<Eigen::Vector<T, n>> Last(std::array<T, kMaxLayers * kMaxUnits>& data, int j)
+  {
+    return Eigen::Map<Eigen::Vector<T, n>>(data.data() + j * kMaxUnits);
+  }
+
+  /**
+   * Apply the changes of v against last above the threshold to the accumulator: the units
+   * that moved are gathered, then their columns of the stacked gate matrix w are applied in
+   * one product. Returns false if nothing changed.
+   */
+  template<typename V, typename L, typename A, typename W>
+  bool Update(const V& v, L&& last, A&& acc, const W& w)
+  {
+    int n = 0;
+    for(int i = 0; i < v.size(); i++)
+    {
+      const T delta = v[i] - last[i];
+      if(std::abs(delta) > threshold)
+      {
+        changed[n] = i;
+        changes[n++] = delta;
+        last[i] = v[i];
+      }
+    }
+    updated += n;
+    total += v.size();
+    if(n == 0)
+    {
+      return false;
+    }
+
+    for(int k = 0; k < n; k++)
+    {
+      acc.noalias() += w.col(changed[k]) * changes[k];
+    }
+    return true;
+  }
+
+  /**
+   * Sigmoid as 0.5 + 0.5 * tanh(z / 2) with Eigen's vectorized tanh, like JitKernel.h
+   */
+  template<typename V>
+  static auto VecSigmoid(const V& z)
+  {
+    return T(0.5) + T(0.5) * (T(0.5) * z.array()).tanh();
+  }
+
+  template<int h, int d>
+  void Step(LstmLayer<T, h, d>& l, const int j, const Eigen::Vector<T, d>& x, const bool full)
+  {
+    auto ax = Acc<4 * h>(accX, j);
+    auto ah = Acc<4 * h>(accH, j);
+    auto lx = Last<d>(lastX, j);
+    auto lh = Last<h>(lastH, j);
+    bool changed = true;
+    auto wx = Stacked<4 * h, d>(stackedX, j);
+    auto wh = Stacked<4 * h, h>(stackedH, j);
+    if(full)
+    {
+      wx << l.Wii, l.Wif, l.Wig, l.Wio;
+      wh << l.Whi, l.Whf, l.Whg, l.Who;
+      Acc<4 * h>(bias, j) << l.bii + l.bhi, l.bif + l.bhf, l.big + l.bhg, l.bio + l.bho;
+      ax.noalias() = wx * x;
+      ah.noalias() = wh * l.htn1;
+      lx = x;
+      lh = l.htn1;
+      updated += d + h;
+      total += d + h;
+    }
+    else
+    {
+      const bool changedX = Update(x, lx, ax, wx);
+      const bool changedH = Update(l.htn1, lh, ah, wh);
+      changed = changedX || changedH;
+    }
+
+    //Unchanged accumulators leave the gates as they were
+    l.xt = x;
+    if(changed)
+    {
+      const Eigen::Vector<T, 4 * h> z = ax + ah + Acc<4 * h>(bias, j);
+      l.it = VecSigmoid(z.template segment<h>(0));
+      l.ft = VecSigmoid(z.template segment<h>(h));
+      l.gt = z.template segment<h>(2 * h).array().tanh();
+      l.ot = VecSigmoid(z.template segment<h>(3 * h));
+    }
+    l.ct = l.ft.cwiseProduct(l.ctn1) + l.it.cwiseProduct(l.gt);
+    l.ht = l.ct.array().tanh();
+    l.ht = l.ot.cwiseProduct(l.ht);
+    l.htn1 = l.ht;
+    l.ctn1 = l.ct;
+  }
+
+  template<int h, int d>
+  void Step(GruLayer<T, h, d>& l, const int j, const Eigen::Vector<T, d>& x, const bool full)
+  {
+    auto ax = Acc<3 * h>(accX, j);
+    auto ah = Acc<3 * h>(accH, j);
+    auto lx = Last<d>(lastX, j);
+    auto lh = Last<h>(lastH, j);
+    bool changed = true;
+    auto wx = Stacked<3 * h, d>(stackedX, j);
+    auto wh = Stacked<3 * h, h>(stackedH, j);
+    if(full)
+    {
+      wx << l.Wir, l.Wiz, l.Win;
+      wh << l.Whr, l.Whz, l.Whn;
+      Acc<3 * h>(bias, j) << l.bir + l.bhr, l.biz + l.bhz, l.bin;
+      ax.noalias() = wx * x;
+      ah.noalias() = wh * l.htn1;
+      lx = x;
+      lh = l.htn1;
+      updated += d + h;
+      total += d + h;
+    }
+    else
+    {
+      const bool changedX = Update(x, lx, ax, wx);
+      const bool changedH = Update(l.htn1, lh, ah, wh);
+      changed = changedX || changedH;
+    }
+
+    l.xt = x;
+    if(changed)
+    {
+      auto b = Acc<3 * h>(bias, j);
+      const Eigen::Vector<T, 2 * h> zrz = ax.template head<2 * h>() + ah.template head<2 * h>() + b.template head<2 * h>();
+      l.rt = VecSigmoid(zrz.template head<h>());
+      l.zt = VecSigmoid(zrz.template tail<h>());
+      l.nt = (ax.template tail<h>() + b.template tail<h>() + l.rt.cwiseProduct(ah.template tail<h>() + l.bhn)).array().tanh();
+    }
+    l.ht = (l.ht.Constant(1) - l.zt).cwiseProduct(l.nt) + l.zt.cwiseProduct(l.htn1);
+    l.htn1 = l.ht;
+  }
+
+  template<int h, int d>
+  void Step(RnnLayer<T, h, d>& l, const int j, const Eigen::Vector<T, d>& x, const bool full)
+  {
+    auto ax = Acc<h>(accX, j);
+    auto ah = Acc<h>(accH, j);
+    auto lx = Last<d>(lastX, j);
+    auto lh = Last<h>(lastH, j);
+    bool changed = true;
+    if(full)
+    {
+      ax = l.Wih * x;
+      ah = l.Whh * l.htn1;
+      lx = x;
+      lh = l.htn1;
+      updated += d + h;
+      total += d + h;
+    }
+    else
+    {
+      const bool changedX = Update(x, lx, ax, l.Wih);
+      const bool changedH = Update(l.htn1, lh, ah, l.Whh);
+      changed = changedX || changedH;
+    }
+
+    l.xt = x;
+    if(changed)
+    {
+      l.ht = (ax + l.bih + ah + l.bhh).array().tanh();
+      l.htn1 = l.ht;
+    }
+  }
+
+  std::array<T, kMaxLayers * kMaxRows> accX;
+  std::array<T, kMaxLayers * kMaxRows> accH;
+  std::array<T, kMaxLayers * kMaxRows> bias; //Stacked biases, the gru's bhn is applied with rt
+  std::array<T, kMaxLayers * kMaxUnits> lastX;
+  std::array<T, kMaxLayers * kMaxUnits> lastH;
+  std::vector<T> stackedX; //Gate matrices of every layer stacked, see Stacked()
+  std::vector<T> stackedH;
+  std::array<int, kMaxUnits> changed; //Units gathered by Update()
+  std::array<T, kMaxUnits> changes;
+  T threshold = 0;
+  long updated = 0;
+  long total = 0;
+  int sinceRefresh = 0;
+  bool enabled = false;
+  bool stale = true;
+};
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+  #include <xmmintrin.h>
+  #define NNCOMP_DENORMALS_SSE 1
+#elif defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+  #define NNCOMP_DENORMALS_ARM64 1
+#endif
+
+/**
+ * Enables flush-to-zero and denormals-are-zero for the lifetime of the object and restores
+ * the previous floating point mode afterwards. Recurrent state decaying towards silence would
+ * otherwise end up in the subnormal range, which is very slow on x86.
+ * No-op on platforms without a known control register.
+ */
+class ScopedDenormalGuard
+{
+public:
+  ScopedDenormalGuard()
+  {
+#if defined(NNCOMP_DENORMALS_SSE)
+    prevState = _mm_getcsr();
+    _mm_setcsr(static_cast<unsigned int>(prevState) | kFtz | kDaz);
+#elif defined(NNCOMP_DENORMALS_ARM64)
+    asm volatile("mrs %0, fpcr" : "=r"(prevState));
+    const uint64_t state = prevState | kFz;
+    asm volatile("msr fpcr, %0" : : "r"(state));
+#endif
+  }
+
+  ~ScopedDenormalGuard()
+  {
+#if defined(NNCOMP_DENORMALS_SSE)
+    _mm_setcsr(static_cast<unsigned int>(prevState));
+#elif defined(NNCOMP_DENORMALS_ARM64)
+    asm volatile("msr fpcr, %0" : : "r"(prevState));
+#endif
+  }
+
+  ScopedDenormalGuard(const ScopedDenormalGuard&) = delete;
+  ScopedDenormalGuard& operator=(const ScopedDenormalGuard&) = delete;
+
+private:
+  static constexpr unsigned int kFtz = 0x8000; //MXCSR flush to zero
+  static constexpr unsigned int kDaz = 0x0040; //MXCSR denormals are zero
+  static constexpr uint64_t kFz = 1ULL << 24;  //FPCR flush to zero
+
+  uint64_t prevState = 0;
+};
@@ -0,0 +1,545 @@
+#pragma once
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Eigen/Dense"
+#include "layers.h"
+#include "GraphDesc.h"
+#include "ModelState.h"
+#include "RuntimeModel.h"
+
+/**
+ * Recurrent layer of a common shape run as the fixed size layers.h layer, for the shapes of the
+ * NNComp models: 2 to 32 units with one input or as many inputs as units.
+ */
+class GraphFixedLayer
+{
+public:
+  /**
+   * Set up the layer for desc, false if there is no fixed size layer of its shape
+   */
+  bool Init(const RuntimeLayerDesc& desc) { return InitWidth<2>(desc) || InitWidth<4>(desc) || InitWidth<8>(desc) || InitWidth<16>(desc) || InitWidth<32>(desc); }
+
+  /**
+   * Process n samples, x and y one column per sample
+   */
+  void Run(const float* x, float* y, int n) { run(layer.get(), x, y, n); }
+
+  /**
+   * Advance one sample, the output is then at GetOutput()
+   */
+  void Step(const float* x) { step(layer.get(), x); }
+  const float* GetOutput() const { return ht; }
+  int GetWidth() const { return width; }
+  void Reset() { reset(layer.get()); }
+
+private:
+  template<int h>
+  bool InitWidth(const RuntimeLayerDesc& desc)
+  {
+    if(desc.GetHidden() != h) return false;
+    if(desc.GetInputs() == 1) return InitType<h, 1>(desc);
+    if(desc.GetInputs() == h) return InitType<h, h>(desc);
+    return false;
+  }
+
+  template<int h, int d>
+  bool InitType(const RuntimeLayerDesc& desc)
+  {
+    if(desc.type == RuntimeLayerType::Lstm) Set<LstmLayer<float, h, d>, h, d>(desc);
+    else if(desc.type == RuntimeLayerType::Gru) Set<GruLayer<float, h, d>, h, d>(desc);
+    else Set<RnnLayer<float, h, d>, h, d>(desc);
+    return true;
+  }
+
+  template<typename L, int h, int d>
+  void Set(const RuntimeLayerDesc& desc)
+  {
+    L* l = new L();
+    layer = std::unique_ptr<void, void (*)(void*)>(l, [](void* p) { delete static_cast<L*>(p); });
+    LoadLayer(desc, *l);
+    run = &RunLayer<L, h, d>;
+    step = &StepLayer<L, d>;
+    reset = &ResetLayer<L>;
+    reset(l);
+    ht = l->ht.data();
+    width = h;
+  }
+
+  template<typename L, int d>
+  static void StepLayer(void* p, const float* x)
+  {
+    L& l = *static_cast<L*>(p);
+    if constexpr (d == 1) l.apply_layer(*x);
+    else l.apply_layer(Eigen::Map<const Eigen::Vector<float, d>>(x));
+  }
+
+  template<typename L, int h, int d>
+  static void RunLayer(void* p, const float* x, float* y, int n)
+  {
+    L& l = *static_cast<L*>(p);
+    for(int t = 0; t < n; t++)
+    {
+      if constexpr (d == 1) l.apply_layer(x[t]);
+      else l.apply_layer(Eigen::Map<const Eigen::Vector<float, d>>(x + t * d));
+      Eigen::Map<Eigen::Vector<float, h>>(y + t * h) = l.ht;
+    }
+  }
+
+  template<typename L>
+  static void ResetLayer(void* p)
+  {
+    L& l = *static_cast<L*>(p);
+    ForEachLayerState(l, [](auto& v) { v.setZero(); });
+    l.ht.setZero();
+  }
+
+  std::unique_ptr<void, void (*)(void*)> layer{nullptr, nullptr};
+  void (*run)(void*, const float*, float*, int) = nullptr;
+  void (*step)(void*, const float*) = nullptr;
+  void (*reset)(void*) = nullptr;
+  const float* ht = nullptr;
+  int width = 0;
+};
+
+/**
+ * Block processor for a GraphDesc. Init() plans the graph and allocates everything,
+ * ProcessBlock() does not allocate. The planner
+ * - drops nodes the output does not depend on,
+ * - fuses gain, tanh and sigmoid nodes into the step computing their input when nothing else
+ *   reads that input, so they run on its buffer while it is in cache,
+ * - picks a kernel per step: recurrent layers of the shapes of the NNComp models run as the
+ *   fixed size layers.h layers, a chain of them where nothing else reads the layers in between
+ *   as one step scheduled as a wavefront (see Wavefront.h), other recurrent layers with wide
+ *   inputs get their input
+ *   products for the whole block from one matrix product, dense layers run as one matrix
+ *   product per block,
+ * - gives every step output a block buffer from one arena, reusing buffers whose values are no
+ *   longer read, and adds in place into an input read for the last time.
+ * Steps run one after the other, each over the whole block, so the weights of one layer stay
+ * in cache for the block.
+ */
+class GraphModel
+{
+public:
+  /**
+   * Plan the graph for blocks of up to maxBlockSize samples. Not realtime safe.
+   */
+  bool Init(const GraphDesc& desc, int maxBlockSize, std::string& error)
+  {
+    std::vector<int> widths;
+    if(!desc.GetWidths(widths, error)) return false;
+    if(maxBlockSize < 1)
+    {
+      error = "block size must be at least 1";
+      return false;
+    }
+    maxBlock = maxBlockSize;
+    steps.clear();
+    layers.clear();
+    fixed.clear();
+    dense.clear();
+    buffers.clear();
+    gainSlots.assign(desc.nodes.size(), {-1, -1});
+
+    const int N = static_cast<int>(desc.nodes.size());
+
+    //Nodes the output depends on, and how many live nodes read each
+    std::vector<bool> live(N, false);
+    std::vector<int> readers(N, 0);
+    live[desc.output] = true;
+    for(int n = N - 1; n >= 0; n--)
+    {
+      if(!live[n]) continue;
+      for(int i : desc.nodes[n].inputs)
+      {
+        live[i] = true;
+        readers[i]++;
+      }
+    }
+
+    //Steps, with elementwise nodes fused into the step of their input
+    std::vector<int> nodeStep(N, -1);
+    for(int n = 0; n < N; n++)
+    {
+      if(!live[n]) continue;
+      const GraphNode& node = desc.nodes[n];
+      if(IsElementwise(node.op))
+      {
+        const int p = node.inputs[0];
+        Step& producer = steps[nodeStep[p]];
+        if(producer.node == p && readers[p] == 1 && p != desc.output)
+        {
+          AddPost(producer, nodeStep[p], n, node);
+          producer.node = n;
+          nodeStep[n] = nodeStep[p];
+          continue;
+        }
+      }
+
+      if(node.op == GraphOp::Recurrent)
+      {
+        //Continue a chain of fixed size layers
+        const int p = node.inputs[0];
+        Step& producer = steps[nodeStep[p]];
+        GraphFixedLayer l;
+        if(producer.kernel == Kernel::RecurrentFixed && producer.node == p && producer.post.empty() && readers[p] == 1 && p != desc.output && l.Init(node.layer))
+        {
+          producer.chain.push_back(static_cast<int>(fixed.size()));
+          fixed.push_back(std::move(l));
+          producer.node = n;
+          producer.width = widths[n];
+          nodeStep[n] = nodeStep[p];
+          continue;
+        }
+      }
+
+      Step s;
+      s.node = n;
+      s.width = widths[n];
+      for(int i : node.inputs)
+      {
+        s.in.push_back(nodeStep[i]);
+        s.inWidths.push_back(widths[i]);
+      }
+      switch(node.op)
+      {
+        case GraphOp::Input: s.kernel = Kernel::Input; break;
+        case GraphOp::Recurrent:
+        {
+          GraphFixedLayer l;
+          if(l.Init(node.layer))
+          {
+            s.kernel = Kernel::RecurrentFixed;
+            s.chain.push_back(static_cast<int>(fixed.size()));
+            fixed.push_back(std::move(l));
+            break;
+          }
+          s.kernel = s.inWidths[0] >= kProjectMinInputs ? Kernel::RecurrentProjected : Kernel::Recurrent;
+          s.index = static_cast<int>(layers.size());
+          layers.emplace_back();
+          layers.back().Init(node.layer);
+          break;
+        }
+        case GraphOp::Dense:
+          s.kernel = Kernel::Dense;
+          s.index = static_cast<int>(dense.size());
+          dense.push_back({node.W, node.b});
+          break;
+        case GraphOp::Add: s.kernel = Kernel::Add; break;
+        case GraphOp::Concat: s.kernel = Kernel::Concat; break;
+        default: s.kernel = Kernel::Elementwise; break;
+      }
+      steps.push_back(s);
+      nodeStep[n] = static_cast<int>(steps.size()) - 1;
+      if(s.kernel == Kernel::Elementwise) AddPost(steps.back(), nodeStep[n], n, node);
+    }
+    outputStep = nodeStep[desc.output];
+
+    Allocate();
+    return true;
+  }
+
+  /**
+   * Return the recurrent state to zero
+   */
+  void Reset()
+  {
+    for(RuntimeLayer& l : layers) l.Reset();
+    for(GraphFixedLayer& l : fixed) l.Reset();
+  }
+
+  /**
+   * Process nFrames samples from x into y
+   */
+  void ProcessBlock(const float* x, float* y, int nFrames)
+  {
+    for(int start = 0; start < nFrames; start += maxBlock)
+    {
+      const int n = std::min(maxBlock, nFrames - start);
+      for(const Step& s : steps) Run(s, x + start, n);
+      const Step& out = steps[outputStep];
+      std::copy_n(BufferData(out.out), n, y + start);
+    }
+  }
+
+  void apply_model(float* x, float* y) { ProcessBlock(x, y, 1); }
+
+  /**
+   * Change the gain of a gain node, from the next block. False if node is not a gain node the
+   * output depends on.
+   */
+  bool SetGain(int node, float gain)
+  {
+    if(node < 0 || node >= static_cast<int>(gainSlots.size()) || gainSlots[node].first < 0) return false;
+    steps[gainSlots[node].first].post[gainSlots[node].second].gain = gain;
+    return true;
+  }
+
+  int GetNumSteps() const { return static_cast<int>(steps.size()); }
+  int GetNumBuffers() const { return static_cast<int>(buffers.size()); }
+
+  /**
+   * Floats of the block buffers
+   */
+  size_t GetArenaSize() const { return static_cast<size_t>(arena.size()); }
+
+  /**
+   * The steps, one per line, as kernel, nodes, input and output buffers and fused ops
+   */
+  std::string DescribePlan() const
+  {
+    static const char* kernels[] = {"input", "recurrent-fixed", "recurrent", "recurrent-projected", "dense", "add", "concat", "elementwise"};
+    std::string plan;
+    for(size_t k = 0; k < steps.size(); k++)
+    {
+      const Step& s = steps[k];
+      plan += std::to_string(k) + ": " + kernels[static_cast<int>(s.kernel)];
+      if(s.chain.size() > 1) plan += " x" + std::to_string(s.chain.size());
+      plan += " node " + std::to_string(s.node) + " [";
+      for(size_t i = 0; i < s.in.size(); i++) plan += (i ? " " : "") + std::to_string(steps[s.in[i]].out);
+      plan += "] -> " + std::to_string(s.out);
+      if(s.scratch >= 0) plan += " scratch " + std::to_string(s.scratch);
+      for(const Post& p : s.post) plan += std::string(" +") + GraphOpName(p.op);
+      plan += "\n";
+    }
+    return plan;
+  }
+
+private:
+  //Recurrent layers with at least this many inputs get the input products of a block at once
+  static constexpr int kProjectMinInputs = 4;
+
+  enum class Kernel
+  {
+    Input,
+    RecurrentFixed,
+    Recurrent,
+    RecurrentProjected,
+    Dense,
+    Add,
+    Concat,
+    Elementwise
+  };
+
+  /**
+   * Elementwise op applied to the output of a step
+   */
+  struct Post
+  {
+    GraphOp op;
+    float gain;
+  };
+
+  struct Step
+  {
+    Kernel kernel;
+    int node;                  //last node computed by the step
+    int width;
+    std::vector<int> in;       //steps read
+    std::vector<int> inWidths;
+    std::vector<Post> post;
+    int index = -1;            //layer or dense weights
+    std::vector<int> chain;    //fixed size layers
+    int out = -1;              //buffer
+    int scratch = -1;          //buffer for projected gates
+  };
+
+  struct DenseWeights
+  {
+    Eigen::MatrixXf W;
+    Eigen::VectorXf b;
+  };
+
+  struct Buffer
+  {
+    int rows;
+    Eigen::Index offset = 0;
+  };
+
+  void AddPost(Step& s, int step, int n, const GraphNode& node)
+  {
+    if(node.op == GraphOp::Gain) gainSlots[n] = {step, static_cast<int>(s.post.size())};
+    s.post.push_back({node.op, node.gain});
+  }
+
+  /**
+   * Assign block buffers to the step outputs, reusing the buffers of values no longer read
+   */
+  void Allocate()
+  {
+    const int S = static_cast<int>(steps.size());
+    std::vector<int> lastRead(S, -1);
+    for(int k = 0; k < S; k++)
+    {
+      for(int i : steps[k].in) lastRead[i] = k;
+    }
+    lastRead[outputStep] = INT_MAX;
+
+    std::vector<int> free;
+    auto take = [&](int rows) {
+      //Smallest free buffer that fits, else a new one
+      auto best = free.end();
+      for(auto it = free.begin(); it != free.end(); ++it)
+      {
+        if(buffers[*it].rows >= rows && (best == free.end() || buffers[*it].rows < buffers[*best].rows)) best = it;
+      }
+      if(best == free.end())
+      {
+        buffers.push_back({rows});
+        return static_cast<int>(buffers.size()) - 1;
+      }
+      const int b = *best;
+      free.erase(best);
+      return b;
+    };
+
+    for(int k = 0; k < S; k++)
+    {
+      Step& s = steps[k];
+      if(s.kernel == Kernel::Add)
+      {
+        //Sum into an input read for the last time, unless it is read more than once here
+        for(size_t i = 0; i < s.in.size() && s.out < 0; i++)
+        {
+          if(lastRead[s.in[i]] == k && std::count(s.in.begin(), s.in.end(), s.in[i]) == 1)
+          {
+            s.out = steps[s.in[i]].out;
+            std::swap(s.in[0], s.in[i]);
+          }
+        }
+      }
+      if(s.out < 0) s.out = take(s.width);
+      if(s.kernel == Kernel::RecurrentProjected)
+      {
+        s.scratch = take(static_cast<int>(layers[s.index].Wx.rows()));
+        free.push_back(s.scratch);
+      }
+      for(size_t i = 0; i < s.in.size(); i++)
+      {
+        const int b = steps[s.in[i]].out;
+        if(lastRead[s.in[i]] == k && b != s.out && std::find(free.begin(), free.end(), b) == free.end()) free.push_back(b);
+      }
+    }
+
+    Eigen::Index size = 0;
+    for(Buffer& b : buffers)
+    {
+      b.offset = size;
+      size += static_cast<Eigen::Index>(b.rows) * maxBlock;
+    }
+    arena = Eigen::VectorXf::Zero(size);
+  }
+
+  float* BufferData(int b) { return arena.data() + buffers[b].offset; }
+
+  /**
+   * Values of step k for n samples, one column per sample
+   */
+  Eigen::Map<Eigen::MatrixXf> Values(int k, int n) { return Eigen::Map<Eigen::MatrixXf>(BufferData(steps[k].out), steps[k].width, n); }
+
+  /**
+   * Fixed size layers of a step, a wavefront over the block when there are several
+   */
+  void RunChain(const Step& s, Eigen::Map<Eigen::MatrixXf>& y, int n)
+  {
+    const float* x = BufferData(steps[s.in[0]].out);
+    const int L = static_cast<int>(s.chain.size());
+    if(L == 1)
+    {
+      fixed[s.chain[0]].Run(x, y.data(), n);
+      return;
+    }
+    const GraphFixedLayer& top = fixed[s.chain[L - 1]];
+    for(int k = 0; k < n + L - 1; k++)
+    {
+      //Top down so every layer reads the output of the layer below before it is overwritten
+      for(int j = std::min(L - 1, k); j >= 0; j--)
+      {
+        const int t = k - j;
+        if(t >= n) break;
+        fixed[s.chain[j]].Step(j == 0 ? x + static_cast<Eigen::Index>(t) * s.inWidths[0] : fixed[s.chain[j - 1]].GetOutput());
+      }
+      const int t = k - L + 1;
+      if(t >= 0) y.col(t) = Eigen::Map<const Eigen::VectorXf>(top.GetOutput(), top.GetWidth());
+    }
+  }
+
+  void Run(const Step& s, const float* x, int n)
+  {
+    Eigen::Map<Eigen::MatrixXf> y(BufferData(s.out), s.width, n);
+    switch(s.kernel)
+    {
+      case Kernel::Input: y.row(0) = Eigen::Map<const Eigen::RowVectorXf>(x, n); break;
+      case Kernel::RecurrentFixed: RunChain(s, y, n); break;
+      case Kernel::Recurrent:
+      {
+        RuntimeLayer& l = layers[s.index];
+        const float* in = BufferData(steps[s.in[0]].out);
+        for(int t = 0; t < n; t++)
+        {
+          l.Step(in + static_cast<Eigen::Index>(t) * s.inWidths[0]);
+          y.col(t) = l.ht;
+        }
+        break;
+      }
+      case Kernel::RecurrentProjected:
+      {
+        RuntimeLayer& l = layers[s.index];
+        Eigen::Map<Eigen::MatrixXf> gates(BufferData(s.scratch), l.Wx.rows(), n);
+        gates.noalias() = l.Wx * Values(s.in[0], n);
+        gates.colwise() += l.bi;
+        for(int t = 0; t < n; t++)
+        {
+          l.gi = gates.col(t);
+          l.Recur();
+          y.col(t) = l.ht;
+        }
+        break;
+      }
+      case Kernel::Dense:
+      {
+        const DenseWeights& w = dense[s.index];
+        y.noalias() = w.W * Values(s.in[0], n);
+        y.colwise() += w.b;
+        break;
+      }
+      case Kernel::Add:
+        if(BufferData(steps[s.in[0]].out) != BufferData(s.out)) y = Values(s.in[0], n);
+        for(size_t i = 1; i < s.in.size(); i++) y += Values(s.in[i], n);
+        break;
+      case Kernel::Concat:
+      {
+        int row = 0;
+        for(size_t i = 0; i < s.in.size(); i++)
+        {
+          y.middleRows(row, s.inWidths[i]) = Values(s.in[i], n);
+          row += s.inWidths[i];
+        }
+        break;
+      }
+      case Kernel::Elementwise: y = Values(s.in[0], n); break;
+    }
+
+    auto a = y.array();
+    for(const Post& p : s.post)
+    {
+      if(p.op == GraphOp::Gain) a *= p.gain;
+      else if(p.op == GraphOp::Tanh) a = a.tanh();
+      else a = a.unaryExpr([](float v) { return Sigmoid<float>(v); });
+    }
+  }
+
+  int maxBlock = 0;
+  std::vector<Step> steps;
+  std::vector<RuntimeLayer> layers;
+  std::vector<GraphFixedLayer> fixed;
+  std::vector<DenseWeights> dense;
+  std::vector<Buffer> buffers;
+  std::vector<std::pair<int, int>> gainSlots; //step and post op of each gain node
+  int outputStep = -1;
+  Eigen::VectorXf arena;
+};
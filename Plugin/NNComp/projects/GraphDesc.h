@@ -0,0 +1,302 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "Eigen/Dense"
+#include "RuntimeModelDesc.h"
+
+/**
+ * Inference graphs. A GraphDesc holds the nodes of a model that is not a plain stack of layers,
+ * eg. with a residual input path or parallel branches. Every node produces a vector per sample
+ * from the nodes it reads, which come before it, so the nodes are in execution order. The
+ * graph has one input and one output sample. It is read from and written to .nncg files.
+ * Graph.h plans and runs it.
+ */
+
+enum class GraphOp
+{
+  Input = 0,     //the input sample, width 1
+  Recurrent = 1, //lstm/gru/rnn layer, width h
+  Dense = 2,     //W * x + b, width W.rows()
+  Add = 3,       //sum of inputs of equal width
+  Concat = 4,    //inputs stacked in order
+  Gain = 5,      //x * gain, the gain can be changed while running
+  Tanh = 6,
+  Sigmoid = 7
+};
+
+inline const char* GraphOpName(GraphOp op)
+{
+  static const char* names[] = {"input", "recurrent", "dense", "add", "concat", "gain", "tanh", "sigmoid"};
+  return names[static_cast<int>(op)];
+}
+
+/**
+ * True for ops computed one value at a time from one input
+ */
+inline bool IsElementwise(GraphOp op)
+{
+  return op == GraphOp::Gain || op == GraphOp::Tanh || op == GraphOp::Sigmoid;
+}
+
+struct GraphNode
+{
+  GraphOp op = GraphOp::Input;
+  std::vector<int> inputs;
+  RuntimeLayerDesc layer; //Recurrent
+  Eigen::MatrixXf W;      //Dense
+  Eigen::VectorXf b;      //Dense
+  float gain = 1.f;       //Gain
+};
+
+struct GraphDesc
+{
+  std::vector<GraphNode> nodes;
+  int output = -1;
+
+  /**
+   * Add a node, returning its index to use as input of later nodes
+   */
+  int AddInput() { return Add(GraphOp::Input, {}); }
+  int AddRecurrent(int x, const RuntimeLayerDesc& layer)
+  {
+    const int n = Add(GraphOp::Recurrent, {x});
+    nodes[n].layer = layer;
+    return n;
+  }
+  int AddDense(int x, const Eigen::MatrixXf& W, const Eigen::VectorXf& b)
+  {
+    const int n = Add(GraphOp::Dense, {x});
+    nodes[n].W = W;
+    nodes[n].b = b;
+    return n;
+  }
+  int AddSum(const std::vector<int>& x) { return Add(GraphOp::Add, x); }
+  int AddConcat(const std::vector<int>& x) { return Add(GraphOp::Concat, x); }
+  int AddGain(int x, float gain)
+  {
+    const int n = Add(GraphOp::Gain, {x});
+    nodes[n].gain = gain;
+    return n;
+  }
+  int AddTanh(int x) { return Add(GraphOp::Tanh, {x}); }
+  int AddSigmoid(int x) { return Add(GraphOp::Sigmoid, {x}); }
+
+  /**
+   * Check the graph and work out the width of every node
+   */
+  bool GetWidths(std::vector<int>& widths, std::string& error) const
+  {
+    widths.assign(nodes.size(), 0);
+    int nInputs = 0;
+    for(size_t n = 0; n < nodes.size(); n++)
+    {
+      const GraphNode& node = nodes[n];
+      const std::string name = "node " + std::to_string(n) + " (" + GraphOpName(node.op) + ")";
+      for(int i : node.inputs)
+      {
+        if(i < 0 || i >= static_cast<int>(n))
+        {
+          error = name + " reads a node that does not come before it";
+          return false;
+        }
+      }
+      const size_t arity = node.op == GraphOp::Input ? 0 : node.op == GraphOp::Add || node.op == GraphOp::Concat ? node.inputs.size() : 1;
+      if(node.inputs.size() != arity || ((node.op == GraphOp::Add || node.op == GraphOp::Concat) && arity < 2))
+      {
+        error = name + " has the wrong number of inputs";
+        return false;
+      }
+      const int d = arity ? widths[node.inputs[0]] : 0;
+
+      switch(node.op)
+      {
+        case GraphOp::Input:
+          nInputs++;
+          widths[n] = 1;
+          break;
+        case GraphOp::Recurrent:
+        {
+          const RuntimeLayerDesc& l = node.layer;
+          const int h = l.GetHidden();
+          const int rows = RuntimeGates(l.type) * h;
+          const bool gru = l.type == RuntimeLayerType::Gru;
+          if(h < 1 || l.Wx.rows() != rows || l.Wx.cols() != d || l.Wh.rows() != rows || l.bi.size() != rows || l.bh.size() != (gru ? rows : 0))
+          {
+            error = name + " has inconsistent weight sizes";
+            return false;
+          }
+          widths[n] = h;
+          break;
+        }
+        case GraphOp::Dense:
+          if(node.W.rows() < 1 || node.W.cols() != d || node.b.size() != node.W.rows())
+          {
+            error = name + " has inconsistent weight sizes";
+            return false;
+          }
+          widths[n] = static_cast<int>(node.W.rows());
+          break;
+        case GraphOp::Add:
+          for(int i : node.inputs)
+          {
+            if(widths[i] != d)
+            {
+              error = name + " adds nodes of different widths";
+              return false;
+            }
+          }
+          widths[n] = d;
+          break;
+        case GraphOp::Concat:
+          for(int i : node.inputs) widths[n] += widths[i];
+          break;
+        default:
+          widths[n] = d;
+          break;
+      }
+    }
+    if(nInputs != 1)
+    {
+      error = "graph must have one input node";
+      return false;
+    }
+    if(output < 0 || output >= static_cast<int>(nodes.size()) || widths[output] != 1)
+    {
+      error = "graph output must be a node of width 1";
+      return false;
+    }
+    return true;
+  }
+
+  bool Validate(std::string& error) const
+  {
+    std::vector<int> widths;
+    return GetWidths(widths, error);
+  }
+
+  /**
+   * Write the graph as .nncg: "NNCG", version, node count, output node, then per node its op,
+   * input count and inputs followed by, for recurrent nodes the layer as in .nncm files, for
+   * dense nodes the rows, columns, W in column-major order and b, for gain nodes the gain.
+   * Little-endian 32 bit integers and floats.
+   */
+  bool Save(const std::string& path, std::string& error) const
+  {
+    if(!Validate(error)) return false;
+    FILE* file = fopen(path.c_str(), "wb");
+    if(!file)
+    {
+      error = "cannot open " + path;
+      return false;
+    }
+    bool ok = fwrite(kMagic, 1, 4, file) == 4 && WriteInt32(file, kVersion);
+    ok = ok && WriteInt32(file, static_cast<int32_t>(nodes.size())) && WriteInt32(file, output);
+    for(const GraphNode& node : nodes)
+    {
+      ok = ok && WriteInt32(file, static_cast<int32_t>(node.op)) && WriteInt32(file, static_cast<int32_t>(node.inputs.size()));
+      for(int i : node.inputs) ok = ok && WriteInt32(file, i);
+      if(node.op == GraphOp::Recurrent) ok = ok && node.layer.Write(file);
+      if(node.op == GraphOp::Dense)
+      {
+        ok = ok && WriteInt32(file, static_cast<int32_t>(node.W.rows())) && WriteInt32(file, static_cast<int32_t>(node.W.cols()));
+        ok = ok && WriteFloats(file, node.W.data(), node.W.size()) && WriteFloats(file, node.b.data(), node.b.size());
+      }
+      if(node.op == GraphOp::Gain) ok = ok && WriteFloats(file, &node.gain, 1);
+    }
+    if(fclose(file) != 0 || !ok)
+    {
+      error = "failed writing " + path;
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * Read a .nncg file written by Save
+   */
+  bool Load(const std::string& path, std::string& error)
+  {
+    FILE* file = fopen(path.c_str(), "rb");
+    if(!file)
+    {
+      error = "cannot open " + path;
+      return false;
+    }
+    const bool ok = Read(file);
+    fclose(file);
+    if(!ok)
+    {
+      error = path + ": not a valid .nncg file";
+      return false;
+    }
+    return Validate(error);
+  }
+
+private:
+  static constexpr char kMagic[4] = {'N', 'N', 'C', 'G'};
+  static constexpr int32_t kVersion = 1;
+  static constexpr int32_t kMaxSize = 4096; //sanity limit for sizes read from a file
+
+  int Add(GraphOp op, const std::vector<int>& inputs)
+  {
+    GraphNode node;
+    node.op = op;
+    node.inputs = inputs;
+    nodes.push_back(node);
+    return static_cast<int>(nodes.size()) - 1;
+  }
+
+  bool Read(FILE* file)
+  {
+    char magic[4];
+    int32_t version, nNodes;
+    if(fread(magic, 1, 4, file) != 4 || std::string(magic, 4) != std::string(kMagic, 4)) return false;
+    if(!ReadInt32(file, version) || version != kVersion || !ReadInt32(file, nNodes) || nNodes < 1 || nNodes > kMaxSize) return false;
+    if(!ReadInt32(file, output)) return false;
+
+    nodes.assign(nNodes, GraphNode());
+    for(GraphNode& node : nodes)
+    {
+      int32_t op, nIn;
+      if(!ReadInt32(file, op) || op < 0 || op > 7 || !ReadInt32(file, nIn) || nIn < 0 || nIn > nNodes) return false;
+      node.op = static_cast<GraphOp>(op);
+      node.inputs.resize(nIn);
+      for(int& i : node.inputs)
+      {
+        int32_t v;
+        if(!ReadInt32(file, v)) return false;
+        i = v;
+      }
+      if(node.op == GraphOp::Recurrent && !node.layer.Read(file, kMaxSize)) return false;
+      if(node.op == GraphOp::Dense)
+      {
+        int32_t rows, cols;
+        if(!ReadInt32(file, rows) || !ReadInt32(file, cols) || rows < 1 || rows > kMaxSize || cols < 1 || cols > kMaxSize) return false;
+        node.W.resize(rows, cols);
+        node.b.resize(rows);
+        if(!ReadFloats(file, node.W.data(), node.W.size()) || !ReadFloats(file, node.b.data(), node.b.size())) return false;
+      }
+      if(node.op == GraphOp::Gain && !ReadFloats(file, &node.gain, 1)) return false;
+    }
+    return true;
+  }
+};
+
+/**
+ * Graph of a stack of layers: the layers in order, then the output layer as dense and tanh.
+ * Returns the node of the output sample, which is not made the graph output.
+ */
+inline int AddModel(GraphDesc& g, int x, const RuntimeModelDesc& model)
+{
+  for(const RuntimeLayerDesc& l : model.layers) x = g.AddRecurrent(x, l);
+  return g.AddTanh(g.AddDense(x, model.A.transpose(), Eigen::VectorXf::Constant(1, model.b)));
+}
+
+inline GraphDesc GraphFromModel(const RuntimeModelDesc& model)
+{
+  GraphDesc g;
+  g.output = AddModel(g, g.AddInput(), model);
+  return g;
+}
@@ -0,0 +1,475 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include "Eigen/Dense"
+#include "layers.h"
+#include "ModelState.h"
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#endif
+
+/**
+ * Recurrent layers with 16 bit weight storage and float (or T) compute.
+ * The stacked gate weights of a layer (i, f, g, o for lstm, r, z, n for gru) are stored as
+ * IEEE half (fp16) or bfloat16 and converted while they are multiplied, which halves their
+ * size against float. fp16 keeps 11 significant bits over a small range, bf16 keeps the float
+ * range with 8 significant bits. Biases and state stay in T. With AVX2 and FMA, fp16 is
+ * converted with F16C and bf16 by widening and shifting, 8 weights per instruction; other
+ * targets use a portable conversion.
+ * HalfModel<M, format> wraps a generated model class and converts its weights on
+ * construction. The layers have the same interface and state members as the ones in
+ * layers.h, so half models work with apply_model, the wavefront and the ModelState helpers.
+ */
+
+enum class HalfFormat
+{
+  Fp16,
+  Bf16
+};
+
+/**
+ * float to fp16, rounded to nearest even, out of range values go to infinity
+ */
+inline uint16_t FloatToFp16(float f)
+{
+  uint32_t x;
+  std::memcpy(&x, &f, sizeof(x));
+  const uint32_t sign = (x >> 16) & 0x8000;
+  uint32_t mant = x & 0x7fffff;
+  const int exp = static_cast<int>((x >> 23) & 0xff);
+  if(exp == 255) return static_cast<uint16_t>(sign | 0x7c00 | (mant ? 0x200 : 0));
+
+  const int e = exp - 127 + 15;
+  if(e >= 31) return static_cast<uint16_t>(sign | 0x7c00);
+
+  int shift = 13;
+  uint32_t half = 0;
+  if(e <= 0)
+  {
+    //Subnormal
+    if(e < -10) return static_cast<uint16_t>(sign);
+    mant |= 0x800000;
+    shift = 14 - e;
+  }
+  else
+  {
+    half = static_cast<uint32_t>(e) << 10;
+  }
+  half |= mant >> shift;
+  const uint32_t rest = mant & ((1u << shift) - 1);
+  const uint32_t mid = 1u << (shift - 1);
+  if(rest > mid || (rest == mid && (half & 1))) half++; //A carry into the exponent is the correct result
+  return static_cast<uint16_t>(sign | half);
+}
+
+inline float Fp16ToFloat(uint16_t h)
+{
+  const uint32_t sign = static_cast<uint32_t>(h & 0x8000) << 16;
+  int exp = (h >> 10) & 0x1f;
+  uint32_t mant = h & 0x3ff;
+  uint32_t x;
+  if(exp == 0)
+  {
+    if(mant == 0) x = sign;
+    else
+    {
+      //Subnormal, normalise
+      exp = 1;
+      while(!(mant & 0x400))
+      {
+        mant <<= 1;
+        exp--;
+      }
+      x = sign | (static_cast<uint32_t>(exp + 112) << 23) | ((mant & 0x3ff) << 13);
+    }
+  }
+  else if(exp == 31) x = sign | 0x7f800000 | (mant << 13);
+  else x = sign | (static_cast<uint32_t>(exp + 112) << 23) | (mant << 13);
+
+  float f;
+  std::memcpy(&f, &x, sizeof(f));
+  return f;
+}
+
+/**
+ * float to bfloat16, rounded to nearest even
+ */
+inline uint16_t FloatToBf16(float f)
+{
+  uint32_t x;
+  std::memcpy(&x, &f, sizeof(x));
+  if((x & 0x7fffffff) > 0x7f800000) return static_cast<uint16_t>((x >> 16) | 0x40); //Keep NaN a NaN
+  return static_cast<uint16_t>((x + 0x7fff + ((x >> 16) & 1)) >> 16);
+}
+
+inline float Bf16ToFloat(uint16_t b)
+{
+  const uint32_t x = static_cast<uint32_t>(b) << 16;
+  float f;
+  std::memcpy(&f, &x, sizeof(f));
+  return f;
+}
+
+template<HalfFormat F>
+inline uint16_t ToHalf(float f) { return F == HalfFormat::Fp16 ? FloatToFp16(f) : FloatToBf16(f); }
+
+template<HalfFormat F>
+inline float FromHalf(uint16_t h) { return F == HalfFormat::Fp16 ? Fp16ToFloat(h) : Bf16ToFloat(h); }
+
+/**
+ * Fixed size matrix stored in 16 bits, column major with the rows padded to a multiple of 8
+ * T - compute type
+ * rows, cols - size
+ * F - storage format
+ */
+template<typename T, int rows, int cols, HalfFormat F>
+class HalfMatrix
+{
+public:
+  static constexpr int kPaddedRows = (rows + 7) / 8 * 8; //Size of the output of Apply()
+
+  HalfMatrix()
+  {
+    data.fill(0);
+  }
+
+  void Set(const Eigen::Matrix<T, rows, cols>& W)
+  {
+    for(int c = 0; c < cols; c++)
+    {
+      for(int r = 0; r < rows; r++) data[c * kPaddedRows + r] = ToHalf<F>(static_cast<float>(W(r, c)));
+    }
+  }
+
+  /**
+   * The stored weights in T
+   */
+  Eigen::Matrix<T, rows, cols> Get() const
+  {
+    Eigen::Matrix<T, rows, cols> W;
+    for(int c = 0; c < cols; c++)
+    {
+      for(int r = 0; r < rows; r++) W(r, c) = static_cast<T>(FromHalf<F>(data[c * kPaddedRows + r]));
+    }
+    return W;
+  }
+
+  /**
+   * y = W * x, y has kPaddedRows rows
+   */
+  template<typename Y>
+  void Apply(const Eigen::Vector<T, cols>& x, Y& y) const
+  {
+#if defined(__AVX2__) && defined(__FMA__)
+    if constexpr (std::is_same_v<T, float> && (F == HalfFormat::Bf16 || HasF16c()))
+    {
+      //Two accumulators per 8 rows, over even and odd columns
+      for(int r = 0; r < kPaddedRows; r += 8)
+      {
+        __m256 acc0 = _mm256_setzero_ps();
+        __m256 acc1 = _mm256_setzero_ps();
+        int c = 0;
+        for(; c + 1 < cols; c += 2)
+        {
+          acc0 = _mm256_fmadd_ps(Load8(c * kPaddedRows + r), _mm256_set1_ps(x[c]), acc0);
+          acc1 = _mm256_fmadd_ps(Load8((c + 1) * kPaddedRows + r), _mm256_set1_ps(x[c + 1]), acc1);
+        }
+        if(c < cols) acc0 = _mm256_fmadd_ps(Load8(c * kPaddedRows + r), _mm256_set1_ps(x[c]), acc0);
+        _mm256_storeu_ps(y.data() + r, _mm256_add_ps(acc0, acc1));
+      }
+      return;
+    }
+#endif
+    y.setZero();
+    for(int c = 0; c < cols; c++)
+    {
+      for(int r = 0; r < kPaddedRows; r++) y[r] += static_cast<T>(FromHalf<F>(data[c * kPaddedRows + r])) * x[c];
+    }
+  }
+
+  alignas(32) std::array<uint16_t, kPaddedRows * cols> data;
+
+private:
+#if defined(__AVX2__) && defined(__FMA__)
+  static constexpr bool HasF16c()
+  {
+#if defined(__F16C__)
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  /**
+   * 8 weights from offset i converted to float
+   */
+  __m256 Load8(int i) const
+  {
+    const __m128i h = _mm_load_si128(reinterpret_cast<const __m128i*>(data.data() + i));
+    if constexpr (F == HalfFormat::Bf16) return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(h), 16));
+#if defined(__F16C__)
+    else return _mm256_cvtph_ps(h);
+#else
+    else return _mm256_setzero_ps();
+#endif
+  }
+#endif
+};
+
+/**
+ * Lstm layer with 16 bit weights.
+ * T - Type
+ * h - hidden size
+ * d - input size
+ * F - weight storage format
+ */
+template<typename T, int h, int d, HalfFormat F>
+class HalfLstmLayer {
+public:
+  void Load(const LstmLayer<T, h, d>& l)
+  {
+    Eigen::Matrix<T, 4 * h, d> Wx;
+    Eigen::Matrix<T, 4 * h, h> Whs;
+    Wx << l.Wii, l.Wif, l.Wig, l.Wio;
+    Whs << l.Whi, l.Whf, l.Whg, l.Who;
+    Wi.Set(Wx);
+    Wh.Set(Whs);
+    b << l.bii + l.bhi, l.bif + l.bhf, l.big + l.bhg, l.bio + l.bho;
+    htn1 = l.htn1;
+    ctn1 = l.ctn1;
+  }
+
+  void apply_layer(Eigen::Vector<T, d> x) {
+    xt = x;
+    Step();
+  }
+
+  void apply_layer(T x) {
+    xt = xt.Constant(x);
+    Step();
+  }
+
+  HalfMatrix<T, 4 * h, d, F> Wi;
+  HalfMatrix<T, 4 * h, h, F> Wh;
+  Eigen::Vector<T, 4 * h> b; //bii + bhi, ..., bio + bho
+
+  Eigen::Vector<T, HalfMatrix<T, 4 * h, d, F>::kPaddedRows> gi;
+  Eigen::Vector<T, HalfMatrix<T, 4 * h, h, F>::kPaddedRows> gh;
+  Eigen::Vector<T, h> it;
+  Eigen::Vector<T, h> ft;
+  Eigen::Vector<T, h> gt;
+  Eigen::Vector<T, h> ot;
+  Eigen::Vector<T, h> ct;
+  Eigen::Vector<T, h> ht;
+
+  Eigen::Vector<T, d> xt;
+
+  Eigen::Vector<T, h> ctn1;
+  Eigen::Vector<T, h> htn1;
+
+private:
+  void Step() {
+    Wi.Apply(xt, gi);
+    Wh.Apply(htn1, gh);
+    gi.template head<4 * h>() += gh.template head<4 * h>() + b;
+    it = gi.template segment<h>(0).unaryExpr(std::ref(Sigmoid<T>));
+    ft = gi.template segment<h>(h).unaryExpr(std::ref(Sigmoid<T>));
+    gt = gi.template segment<h>(2 * h).array().tanh();
+    ot = gi.template segment<h>(3 * h).unaryExpr(std::ref(Sigmoid<T>));
+    ct = ft.cwiseProduct(ctn1) + it.cwiseProduct(gt);
+    ht = ct.array().tanh();
+    ht = ot.cwiseProduct(ht);
+    htn1 = ht;
+    ctn1 = ct;
+  }
+};
+
+/**
+ * Gru layer with 16 bit weights.
+ * T - Type
+ * h - hidden size
+ * d - input size
+ * F - weight storage format
+ */
+template<typename T, int h, int d, HalfFormat F>
+class HalfGruLayer {
+public:
+  void Load(const GruLayer<T, h, d>& l)
+  {
+    Eigen::Matrix<T, 3 * h, d> Wx;
+    Eigen::Matrix<T, 3 * h, h> Whs;
+    Wx << l.Wir, l.Wiz, l.Win;
+    Whs << l.Whr, l.Whz, l.Whn;
+    Wi.Set(Wx);
+    Wh.Set(Whs);
+    bi << l.bir, l.biz, l.bin;
+    bh << l.bhr, l.bhz, l.bhn;
+    htn1 = l.htn1;
+  }
+
+  void apply_layer(Eigen::Vector<T, d> x) {
+    xt = x;
+    Step();
+  }
+
+  void apply_layer(T x) {
+    xt = xt.Constant(x);
+    Step();
+  }
+
+  HalfMatrix<T, 3 * h, d, F> Wi;
+  HalfMatrix<T, 3 * h, h, F> Wh;
+  Eigen::Vector<T, 3 * h> bi; //bir, biz, bin
+  Eigen::Vector<T, 3 * h> bh; //bhr, bhz, bhn, the reset gate scales bhn
+
+  Eigen::Vector<T, HalfMatrix<T, 3 * h, d, F>::kPaddedRows> gi;
+  Eigen::Vector<T, HalfMatrix<T, 3 * h, h, F>::kPaddedRows> gh;
+  Eigen::Vector<T, h> rt;
+  Eigen::Vector<T, h> zt;
+  Eigen::Vector<T, h> nt;
+  Eigen::Vector<T, h> ht;
+
+  Eigen::Vector<T, d> xt;
+
+  Eigen::Vector<T, h> htn1;
+
+private:
+  void Step() {
+    Wi.Apply(xt, gi);
+    Wh.Apply(htn1, gh);
+    gi.template head<3 * h>() += bi;
+    gh.template head<3 * h>() += bh;
+    rt = (gi.template segment<h>(0) + gh.template segment<h>(0)).unaryExpr(std::ref(Sigmoid<T>));
+    zt = (gi.template segment<h>(h) + gh.template segment<h>(h)).unaryExpr(std::ref(Sigmoid<T>));
+    nt = (gi.template segment<h>(2 * h) + rt.cwiseProduct(gh.template segment<h>(2 * h))).array().tanh();
+    ht = (ht.Constant(1) - zt).cwiseProduct(nt) + zt.cwiseProduct(htn1);
+    htn1 = ht;
+  }
+};
+
+/**
+ * Rnn layer with 16 bit weights.
+ * T - Type
+ * h - hidden size
+ * d - input size
+ * F - weight storage format
+ */
+template<typename T, int h, int d, HalfFormat F>
+class HalfRnnLayer {
+public:
+  void Load(const RnnLayer<T, h, d>& l)
+  {
+    Wi.Set(l.Wih);
+    Wh.Set(l.Whh);
+    b = l.bih + l.bhh;
+    htn1 = l.htn1;
+  }
+
+  void apply_layer(Eigen::Vector<T, d> x) {
+    xt = x;
+    Step();
+  }
+
+  void apply_layer(T x) {
+    xt = xt.Constant(x);
+    Step();
+  }
+
+  HalfMatrix<T, h, d, F> Wi;
+  HalfMatrix<T, h, h, F> Wh;
+  Eigen::Vector<T, h> b; //bih + bhh
+
+  Eigen::Vector<T, HalfMatrix<T, h, d, F>::kPaddedRows> gi;
+  Eigen::Vector<T, HalfMatrix<T, h, h, F>::kPaddedRows> gh;
+  Eigen::Vector<T, h> ht;
+
+  Eigen::Vector<T, d> xt;
+
+  Eigen::Vector<T, h> htn1;
+
+private:
+  void Step() {
+    Wi.Apply(xt, gi);
+    Wh.Apply(htn1, gh);
+    ht = (gi.template head<h>() + gh.template head<h>() + b).array().tanh();
+    htn1 = ht;
+  }
+};
+
+/**
+ * Placeholder for the layers a model does not have
+ */
+struct HalfNoLayer {
+  template<typename L> void Load(const L&) {}
+};
+
+/**
+ * 16 bit form of a layer, HalfNoLayer for the layers a model does not have (void)
+ */
+template<typename L, HalfFormat F> struct HalfLayerOf { using type = HalfNoLayer; };
+template<typename T, int h, int d, HalfFormat F> struct HalfLayerOf<LstmLayer<T, h, d>, F> { using type = HalfLstmLayer<T, h, d, F>; };
+template<typename T, int h, int d, HalfFormat F> struct HalfLayerOf<GruLayer<T, h, d>, F> { using type = HalfGruLayer<T, h, d, F>; };
+template<typename T, int h, int d, HalfFormat F> struct HalfLayerOf<RnnLayer<T, h, d>, F> { using type = HalfRnnLayer<T, h, d, F>; };
+
+/**
+ * Generated model M with 16 bit recurrent weights. Built from a default constructed M, or
+ * from a given instance including its state. The output layer is kept as it is.
+ * M - generated model class, eg. Lstm_32_1<float>
+ * F - weight storage format
+ */
+template<typename M, HalfFormat F>
+class HalfModel
+{
+  using L0 = typename HalfLayerOf<typename ModelLayerType<M, 0>::type, F>::type;
+  using L1 = typename HalfLayerOf<typename ModelLayerType<M, 1>::type, F>::type;
+  using L2 = typename HalfLayerOf<typename ModelLayerType<M, 2>::type, F>::type;
+  using L3 = typename HalfLayerOf<typename ModelLayerType<M, 3>::type, F>::type;
+  using T = std::remove_reference_t<decltype(std::declval<M&>().f.y)>;
+  static_assert(M::layers <= 4, "HalfModel takes models of 1 to 4 layers");
+
+public:
+  const static int h = M::h;
+  const static int d = M::d;
+  const static int layers = M::layers;
+
+  HalfModel()
+  : HalfModel(*std::make_unique<M>())
+  {
+  }
+
+  explicit HalfModel(const M& m)
+  : f(m.f)
+  {
+    l0.Load(GetLayer<0>(m));
+    if constexpr (layers > 1) l1.Load(GetLayer<1>(m));
+    if constexpr (layers > 2) l2.Load(GetLayer<2>(m));
+    if constexpr (layers > 3) l3.Load(GetLayer<3>(m));
+  }
+
+  void apply_model(T* x, T* y) {
+    l0.apply_layer(*x);
+    if constexpr (layers > 1) l1.apply_layer(l0.ht);
+    if constexpr (layers > 2) l2.apply_layer(l1.ht);
+    if constexpr (layers > 3) l3.apply_layer(l2.ht);
+    if constexpr (layers == 1) *y = f.apply_layer(l0.ht);
+    else if constexpr (layers == 2) *y = f.apply_layer(l1.ht);
+    else if constexpr (layers == 3) *y = f.apply_layer(l2.ht);
+    else *y = f.apply_layer(l3.ht);
+  }
+
+  L0 l0;
+  L1 l1;
+  L2 l2;
+  L3 l3;
+  decltype(M::f) f;
+};
+
+template<typename T, int h, int d, HalfFormat F, typename Fn>
+void ForEachLayerState(HalfLstmLayer<T, h, d, F>& l, Fn&& f)
+{
+  f(l.htn1);
+  f(l.ctn1);
+}
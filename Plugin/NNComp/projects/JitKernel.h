@@ -0,0 +1,532 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <utility>
+#include <vector>
+#include "Eigen/Dense"
+#include "RuntimeModelDesc.h"
+
+#if (defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))) && (defined(__linux__) || defined(__APPLE__)) && !defined(NNCOMP_NO_JIT)
+  #include <sys/mman.h>
+  #include <unistd.h>
+  #define NNCOMP_JIT_X64 1
+#endif
+
+/**
+ * Run-time generated x86-64 code for a whole model, processing a block per call.
+ * The weights and sizes are known when the kernel is compiled, so the code of a sample is
+ * fully unrolled: for every layer each input is broadcast once and multiplied into all gate
+ * rows, eight at a time, with AVX2 FMAs reading the weights RIP-relative, then the activations
+ * and the state update run on groups of eight units, and the last layer feeds the output layer.
+ * Every gate is padded to a multiple of 8 units with zero weights, which keeps the padding units
+ * of the state at zero. The weights are stored in front of the code in the order the
+ * instructions read them (per layer and tile of row groups: bias, then column by column), so
+ * the loads stream through memory. All state lives in one arena of StateSize() floats.
+ * tanh is the rational approximation Eigen uses for float, sigmoid(x) is computed as
+ * 0.5 + 0.5 * tanh(x / 2).
+ * Needs AVX2 and FMA, the System V calling convention (Linux, macOS) and permission to map
+ * executable memory. Compile() returns false otherwise and the caller interprets the model.
+ * Define NNCOMP_NO_JIT to leave the generator out of the build.
+ */
+class JitModelKernel
+{
+public:
+  using Function = void (*)(const float* x, float* y, long nFrames, float* state);
+
+  JitModelKernel() = default;
+  ~JitModelKernel() { Release(); }
+
+  JitModelKernel(const JitModelKernel&) = delete;
+  JitModelKernel& operator=(const JitModelKernel&) = delete;
+
+  JitModelKernel(JitModelKernel&& other) noexcept { *this = std::move(other); }
+  JitModelKernel& operator=(JitModelKernel&& other) noexcept
+  {
+    if(this != &other)
+    {
+      Release();
+      fn = std::exchange(other.fn, nullptr);
+      memory = std::exchange(other.memory, nullptr);
+      mappedBytes = std::exchange(other.mappedBytes, 0);
+      codeBytes = std::exchange(other.codeBytes, 0);
+      dataBytes = std::exchange(other.dataBytes, 0);
+      stateSize = std::exchange(other.stateSize, 0);
+    }
+    return *this;
+  }
+
+  /**
+   * True if kernels can be generated for this build and CPU
+   */
+  static bool IsSupported()
+  {
+#if defined(NNCOMP_JIT_X64)
+    static const bool supported = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    return supported;
+#else
+    return false;
+#endif
+  }
+
+  /**
+   * Generate the kernel for a valid model
+   */
+  bool Compile(const RuntimeModelDesc& desc)
+  {
+    Release();
+#if defined(NNCOMP_JIT_X64)
+    if(!IsSupported()) return false;
+
+    //State arena: per layer ht, ct (lstm) and the gate pre-activations
+    std::vector<LayerState> states;
+    int size = 0;
+    for(const RuntimeLayerDesc& l : desc.layers)
+    {
+      LayerState s;
+      const int hp = PaddedUnits(l.GetHidden());
+      const int rows = RuntimeGates(l.type) * hp;
+      s.h = size * 4;
+      size += hp;
+      s.c = size * 4;
+      size += l.type == RuntimeLayerType::Lstm ? hp : 0;
+      s.gi = size * 4;
+      size += rows;
+      s.gh = size * 4;
+      size += l.type == RuntimeLayerType::Gru ? rows : 0;
+      states.push_back(s);
+    }
+
+    //Weights and constants first, in the order they are read, then the code
+    std::vector<float> data;
+    for(size_t j = 0; j < desc.layers.size(); j++)
+    {
+      SetLayer(desc.layers[j]);
+      for(const Product& p : GetProducts(desc.layers[j], states, j)) LayoutProduct(p, data);
+    }
+    constants = data.size() * sizeof(float);
+    for(float v : kConstants) data.insert(data.end(), 8, v);
+    const size_t output = data.size() * sizeof(float);
+    data.insert(data.end(), 8, desc.b);
+    for(int u = 0; u < PaddedUnits(static_cast<int>(desc.A.size())); u++) data.push_back(u < desc.A.size() ? desc.A[u] : 0.f);
+    dataBytes = data.size() * sizeof(float);
+    codeStart = (dataBytes + 63) & ~size_t(63);
+
+    //for(; nFrames > 0; nFrames--, x++, y++)
+    code.clear();
+    Emit({0x48, 0x85, 0xD2}); //test rdx, rdx
+    Emit({0x0F, 0x8E}); //jle end
+    const size_t skip = code.size();
+    Emit32(0);
+    const size_t loop = code.size();
+
+    size_t dataOffset = 0;
+    for(size_t j = 0; j < desc.layers.size(); j++)
+    {
+      SetLayer(desc.layers[j]);
+      for(const Product& p : GetProducts(desc.layers[j], states, j)) EmitProduct(p, dataOffset);
+      EmitActivations(states[j]);
+    }
+    EmitOutput(output, states.back().h);
+
+    Emit({0x48, 0x83, 0xC7, 0x04}); //add rdi, 4
+    Emit({0x48, 0x83, 0xC6, 0x04}); //add rsi, 4
+    Emit({0x48, 0xFF, 0xCA}); //dec rdx
+    Emit({0x0F, 0x85}); //jnz loop
+    Emit32(static_cast<int32_t>(static_cast<int64_t>(loop) - static_cast<int64_t>(code.size() + 4)));
+    const int32_t end = static_cast<int32_t>(code.size() - (skip + 4));
+    memcpy(code.data() + skip, &end, 4);
+    Emit({0xC5, 0xF8, 0x77}); //vzeroupper
+    Emit({0xC3}); //ret
+    codeBytes = code.size();
+
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    mappedBytes = (codeStart + codeBytes + page - 1) / page * page;
+    void* p = mmap(nullptr, mappedBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(p == MAP_FAILED)
+    {
+      mappedBytes = 0;
+      return false;
+    }
+    memory = static_cast<uint8_t*>(p);
+    memcpy(memory, data.data(), dataBytes);
+    memcpy(memory + codeStart, code.data(), codeBytes);
+    if(mprotect(memory, mappedBytes, PROT_READ | PROT_EXEC) != 0)
+    {
+      Release();
+      return false;
+    }
+    fn = reinterpret_cast<Function>(memory + codeStart);
+    stateSize = size;
+    code = std::vector<uint8_t>();
+    return true;
+#else
+    (void)desc;
+    return false;
+#endif
+  }
+
+  /**
+   * Process nFrames samples, state holds StateSize() floats, all zero initially
+   */
+  void Run(const float* x, float* y, int nFrames, float* state) const { fn(x, y, nFrames, state); }
+
+  explicit operator bool() const { return fn != nullptr; }
+  int GetStateSize() const { return stateSize; }
+  size_t GetCodeBytes() const { return codeBytes; }
+  size_t GetDataBytes() const { return dataBytes; }
+
+private:
+  //System V argument registers
+  static constexpr int kArgX = 7;     //rdi
+  static constexpr int kArgY = 6;     //rsi
+  static constexpr int kArgState = 1; //rcx
+
+  static constexpr int kMaxAccumulators = 14; //ymm0..13, ymm14/15 hold the broadcast inputs
+
+  //tanh clamp and rational coefficients (Eigen generic_fast_tanh_float), then 0.5
+  enum Constant { kClampHi, kClampLo, kA13, kA11, kA9, kA7, kA5, kA3, kA1, kB6, kB4, kB2, kB0, kHalf, kNumConstants };
+  static constexpr float kConstants[kNumConstants] = {
+    7.99881172180175781f, -7.99881172180175781f,
+    -2.76076847742355e-16f, 2.00018790482477e-13f, -8.60467152213735e-11f, 5.12229709037114e-08f,
+    1.48572235717979e-05f, 6.37261928875436e-04f, 4.89352455891786e-03f,
+    1.19825839466702e-06f, 1.18534705686654e-04f, 2.26843463243900e-03f, 4.89352518554385e-03f,
+    0.5f
+  };
+
+  /**
+   * VEX encoded AVX instruction: opcode map (1 = 0F, 2 = 0F38, 3 = 0F3A) and mandatory prefix
+   * (1 = 66, 2 = F3, 3 = F2)
+   */
+  struct Op
+  {
+    uint8_t map, pp, opcode;
+  };
+  static constexpr Op kLoadU{1, 0, 0x10};
+  static constexpr Op kStoreU{1, 0, 0x11};
+  static constexpr Op kStoreSS{1, 2, 0x11};
+  static constexpr Op kLoadA{1, 0, 0x28};
+  static constexpr Op kXor{1, 0, 0x57};
+  static constexpr Op kAdd{1, 0, 0x58};
+  static constexpr Op kMul{1, 0, 0x59};
+  static constexpr Op kSub{1, 0, 0x5C};
+  static constexpr Op kMin{1, 0, 0x5D};
+  static constexpr Op kDiv{1, 0, 0x5E};
+  static constexpr Op kMax{1, 0, 0x5F};
+  static constexpr Op kHadd{1, 3, 0x7C};
+  static constexpr Op kPerm2f128{3, 1, 0x06};
+  static constexpr Op kBroadcast{2, 1, 0x18};
+  static constexpr Op kFma213{2, 1, 0xA8}; //a = b * a + c
+  static constexpr Op kFma231{2, 1, 0xB8}; //a = b * c + a
+
+  /**
+   * Byte offsets of a layer's vectors in the state arena
+   */
+  struct LayerState
+  {
+    int h, c, gi, gh;
+  };
+
+  struct Source
+  {
+    const Eigen::MatrixXf* W;
+    int base; //register
+    int disp;
+  };
+
+  struct Product
+  {
+    const Eigen::VectorXf* b;
+    int out; //byte offset in the state arena
+    std::vector<Source> sources;
+  };
+
+  /**
+   * Row groups are split into tiles that fit the registers. Tiles with few row groups keep
+   * several accumulator sets and rotate the inputs over them to shorten the FMA chains.
+   */
+  struct Tiling
+  {
+    int groups; //per tile, the last one may have fewer
+    int sets;
+  };
+
+  static int PaddedUnits(int h) { return (h + 7) / 8 * 8; }
+
+  void SetLayer(const RuntimeLayerDesc& l)
+  {
+    type = l.type;
+    h = l.GetHidden();
+    hp = PaddedUnits(h);
+    gates = RuntimeGates(type);
+  }
+
+  /**
+   * Gate products of layer j, the gru keeps the recurrent one apart since the reset gate
+   * scales its new gate part
+   */
+  static std::vector<Product> GetProducts(const RuntimeLayerDesc& l, const std::vector<LayerState>& states, size_t j)
+  {
+    const Source x = j == 0 ? Source{&l.Wx, kArgX, 0} : Source{&l.Wx, kArgState, states[j - 1].h};
+    const Source h = {&l.Wh, kArgState, states[j].h};
+    if(l.type == RuntimeLayerType::Gru) return {{&l.bi, states[j].gi, {x}}, {&l.bh, states[j].gh, {h}}};
+    return {{&l.bi, states[j].gi, {x, h}}};
+  }
+
+  Tiling GetTiling(const Product& p) const
+  {
+    const int groups = gates * hp / 8;
+    int cols = 0;
+    for(const Source& s : p.sources) cols += static_cast<int>(s.W->cols());
+    const int tiles = (groups + kMaxAccumulators - 1) / kMaxAccumulators;
+    Tiling t;
+    t.groups = (groups + tiles - 1) / tiles;
+    t.sets = std::max(1, std::min({kMaxAccumulators / t.groups, 4, cols}));
+    return t;
+  }
+
+  /**
+   * Row r of the padded layout, -1 for padding
+   */
+  int SourceRow(int r) const
+  {
+    const int u = r % hp;
+    return u < h ? r / hp * h + u : -1;
+  }
+
+  void LayoutProduct(const Product& p, std::vector<float>& data) const
+  {
+    const int groups = gates * hp / 8;
+    const Tiling t = GetTiling(p);
+    auto append = [&](auto value, int g0, int g1) {
+      for(int r = g0 * 8; r < g1 * 8; r++) data.push_back(SourceRow(r) >= 0 ? value(SourceRow(r)) : 0.f);
+    };
+    for(int g0 = 0; g0 < groups; g0 += t.groups)
+    {
+      const int g1 = std::min(groups, g0 + t.groups);
+      append([&](int r) { return (*p.b)[r]; }, g0, g1);
+      for(const Source& s : p.sources)
+      {
+        for(int c = 0; c < s.W->cols(); c++) append([&](int r) { return (*s.W)(r, c); }, g0, g1);
+      }
+    }
+  }
+
+  void EmitProduct(const Product& p, size_t& dataOffset)
+  {
+    const int groups = gates * hp / 8;
+    const Tiling t = GetTiling(p);
+    for(int g0 = 0; g0 < groups; g0 += t.groups)
+    {
+      const int n = std::min(groups, g0 + t.groups) - g0;
+      const int sets = std::min(t.sets, kMaxAccumulators / n);
+
+      for(int a = 0; a < n; a++) Rip(kLoadA, a, 0, dataOffset + a * 32);
+      for(int a = n; a < n * sets; a++) Reg(kXor, a, a, a);
+      dataOffset += n * 32;
+
+      int col = 0;
+      for(const Source& s : p.sources)
+      {
+        for(int c = 0; c < s.W->cols(); c++, col++)
+        {
+          const int bcast = 14 + (col & 1);
+          Mem(kBroadcast, bcast, 0, s.base, s.disp + c * 4);
+          const int set = col % sets;
+          for(int a = 0; a < n; a++) Rip(kFma231, set * n + a, bcast, dataOffset + a * 32);
+          dataOffset += n * 32;
+        }
+      }
+
+      for(int set = 1; set < sets; set++)
+      {
+        for(int a = 0; a < n; a++) Reg(kAdd, a, a, set * n + a);
+      }
+      for(int a = 0; a < n; a++) Mem(kStoreU, a, 0, kArgState, p.out + (g0 + a) * 32);
+    }
+  }
+
+  /**
+   * Activations and state update, eight units at a time. ymm15 holds 0.5, ymm12/13 are the
+   * temporaries of tanh.
+   */
+  void EmitActivations(const LayerState& s)
+  {
+    Rip(kLoadA, 15, 0, ConstantAt(kHalf));
+    const int S = kArgState;
+    for(int u = 0; u < hp; u += 8)
+    {
+      auto gi = [&](int g) { return s.gi + (g * hp + u) * 4; };
+      auto gh = [&](int g) { return s.gh + (g * hp + u) * 4; };
+      const int ht = s.h + u * 4;
+      const int ct = s.c + u * 4;
+      if(type == RuntimeLayerType::Lstm)
+      {
+        Mem(kLoadU, 0, 0, S, gi(0));
+        Sigmoid(0);
+        Mem(kLoadU, 1, 0, S, gi(1));
+        Sigmoid(1);
+        Mem(kLoadU, 2, 0, S, gi(2));
+        Tanh(2);
+        Mem(kLoadU, 3, 0, S, gi(3));
+        Sigmoid(3);
+        Mem(kLoadU, 4, 0, S, ct);
+        Reg(kMul, 4, 4, 1);    //ct = ft * ctn1
+        Reg(kFma231, 4, 0, 2); //   + it * gt
+        Mem(kStoreU, 4, 0, S, ct);
+        Tanh(4);
+        Reg(kMul, 4, 4, 3);    //ht = ot * tanh(ct)
+        Mem(kStoreU, 4, 0, S, ht);
+      }
+      else if(type == RuntimeLayerType::Gru)
+      {
+        Mem(kLoadU, 0, 0, S, gi(0));
+        Mem(kAdd, 0, 0, S, gh(0));
+        Sigmoid(0);            //rt
+        Mem(kLoadU, 1, 0, S, gi(1));
+        Mem(kAdd, 1, 1, S, gh(1));
+        Sigmoid(1);            //zt
+        Mem(kLoadU, 2, 0, S, gh(2));
+        Mem(kFma213, 2, 0, S, gi(2));
+        Tanh(2);               //nt = tanh(Win x + bin + rt * (Whn h + bhn))
+        Mem(kLoadU, 3, 0, S, ht);
+        Reg(kSub, 3, 3, 2);
+        Reg(kFma213, 3, 1, 2); //ht = nt + zt * (htn1 - nt)
+        Mem(kStoreU, 3, 0, S, ht);
+      }
+      else
+      {
+        Mem(kLoadU, 0, 0, S, gi(0));
+        Tanh(0);
+        Mem(kStoreU, 0, 0, S, ht);
+      }
+    }
+  }
+
+  /**
+   * *y = tanh(A . ht + b) of the last layer, b and A at data offset output
+   */
+  void EmitOutput(size_t output, int ht)
+  {
+    for(int u = 0; u < hp; u += 8)
+    {
+      Mem(kLoadU, 1, 0, kArgState, ht + u * 4);
+      if(u == 0) Rip(kMul, 0, 1, output + 32);
+      else Rip(kFma231, 0, 1, output + 32 + u * 4);
+    }
+    Reg(kPerm2f128, 1, 0, 0);
+    Emit({0x01});
+    Reg(kAdd, 0, 0, 1);
+    Reg(kHadd, 0, 0, 0);
+    Reg(kHadd, 0, 0, 0);
+    Rip(kAdd, 0, 0, output);
+    Tanh(0);
+    Mem(kStoreSS, 0, 0, kArgY, 0);
+  }
+
+  void Tanh(int x)
+  {
+    const int x2 = 12, p = 13;
+    Rip(kMin, x, x, ConstantAt(kClampHi));
+    Rip(kMax, x, x, ConstantAt(kClampLo));
+    Reg(kMul, x2, x, x);
+    Rip(kLoadA, p, 0, ConstantAt(kA13));
+    for(int k = kA11; k <= kA1; k++) Rip(kFma213, p, x2, ConstantAt(static_cast<Constant>(k)));
+    Reg(kMul, p, p, x);
+    Rip(kLoadA, x, 0, ConstantAt(kB6));
+    for(int k = kB4; k <= kB0; k++) Rip(kFma213, x, x2, ConstantAt(static_cast<Constant>(k)));
+    Reg(kDiv, x, p, x);
+  }
+
+  void Sigmoid(int x)
+  {
+    Reg(kMul, x, x, 15);
+    Tanh(x);
+    Reg(kFma213, x, 15, 15);
+  }
+
+  size_t ConstantAt(Constant k) const { return constants + static_cast<size_t>(k) * 32; }
+
+  void Emit(std::initializer_list<uint8_t> bytes) { code.insert(code.end(), bytes); }
+
+  void Emit32(int32_t v)
+  {
+    for(int k = 0; k < 4; k++) code.push_back(static_cast<uint8_t>(v >> (8 * k)));
+  }
+
+  /**
+   * Three byte VEX prefix and opcode of a 256 bit instruction, src is the vvvv operand
+   */
+  void Vex(const Op& op, int reg, int src, bool rmExt)
+  {
+    const uint8_t r = reg >= 8 ? 0 : 0x80;
+    const uint8_t b = rmExt ? 0 : 0x20;
+    Emit({0xC4, static_cast<uint8_t>(r | 0x40 | b | op.map), static_cast<uint8_t>(((~src & 15) << 3) | 0x04 | op.pp), op.opcode});
+  }
+
+  /**
+   * op ymm(reg), ymm(src), ymm(rm)
+   */
+  void Reg(const Op& op, int reg, int src, int rm)
+  {
+    Vex(op, reg, src, rm >= 8);
+    Emit({static_cast<uint8_t>(0xC0 | ((reg & 7) << 3) | (rm & 7))});
+  }
+
+  /**
+   * op ymm(reg), ymm(src), [base + disp], base one of the argument registers
+   */
+  void Mem(const Op& op, int reg, int src, int base, int disp)
+  {
+    Vex(op, reg, src, false);
+    if(disp >= -128 && disp < 128)
+    {
+      Emit({static_cast<uint8_t>(0x40 | ((reg & 7) << 3) | base), static_cast<uint8_t>(disp)});
+    }
+    else
+    {
+      Emit({static_cast<uint8_t>(0x80 | ((reg & 7) << 3) | base)});
+      Emit32(disp);
+    }
+  }
+
+  /**
+   * op ymm(reg), ymm(src), [rip + data offset]
+   */
+  void Rip(const Op& op, int reg, int src, size_t target)
+  {
+    Vex(op, reg, src, false);
+    Emit({static_cast<uint8_t>(((reg & 7) << 3) | 0x05)});
+    const size_t next = codeStart + code.size() + 4;
+    Emit32(static_cast<int32_t>(static_cast<int64_t>(target) - static_cast<int64_t>(next)));
+  }
+
+  void Release()
+  {
+#if defined(NNCOMP_JIT_X64)
+    if(memory) munmap(memory, mappedBytes);
+#endif
+    memory = nullptr;
+    fn = nullptr;
+    mappedBytes = codeBytes = dataBytes = 0;
+    stateSize = 0;
+  }
+
+  Function fn = nullptr;
+  uint8_t* memory = nullptr;
+  size_t mappedBytes = 0;
+  size_t codeBytes = 0;
+  size_t dataBytes = 0;
+  int stateSize = 0;
+
+  //Code generation, layer being emitted
+  RuntimeLayerType type = RuntimeLayerType::Lstm;
+  int h = 0;
+  int hp = 0;
+  int gates = 0;
+  size_t constants = 0;
+  size_t codeStart = 0;
+  std::vector<uint8_t> code;
+};
@@ -0,0 +1,219 @@
+#pragma once
+#include "Eigen/Dense"
+#include "layers.h"
+#include "ModelState.h"
+
+/**
+ * Recurrent layers with low-rank factorized weights, emitted by Tools/nncomp_compress.
+ * The gate weights of a layer are stacked (i, f, g, o for lstm, r, z, n for gru) and each
+ * stacked matrix W is stored as U * V with U rows x r and V r x cols, so a product costs
+ * r * (rows + cols) multiplies instead of rows * cols. The input and recurrent matrices have
+ * their own rank. A rank equal to the column count stores the matrix densely in U and V is
+ * unused, which is how the 1 column input of the first layer is kept.
+ * Biases are folded where the gate equations allow it. The layers have the same interface
+ * and state members as the ones in layers.h, so compressed models work with apply_model,
+ * the wavefront and the ModelState helpers.
+ */
+
+/**
+ * out = U * V * x, or U * x when the matrix is stored densely
+ */
+template<int r, int cols, typename Out, typename U, typename V, typename X, typename Tmp>
+inline void ApplyFactors(Out& out, const U& u, const V& v, const X& x, Tmp& tmp)
+{
+  if constexpr (r == cols)
+  {
+    out.noalias() = u * x;
+  }
+  else
+  {
+    tmp.noalias() = v * x;
+    out.noalias() = u * tmp;
+  }
+}
+
+/**
+ * Lstm layer with low-rank weights.
+ * T - Type
+ * h - hidden size
+ * d - input size
+ * ri - rank of the stacked input weights
+ * rh - rank of the stacked recurrent weights
+ */
+template<typename T, int h, int d, int ri, int rh>
+class LowRankLstmLayer {
+public:
+  LowRankLstmLayer()
+  {
+    Vi.setIdentity();
+    Vh.setIdentity();
+  }
+
+  void apply_layer(Eigen::Vector<T, d> x) {
+    xt = x;
+    Step();
+  }
+
+  void apply_layer(T x) {
+    xt = xt.Constant(x);
+    Step();
+  }
+
+  Eigen::Matrix<T, 4 * h, ri> Ui;
+  Eigen::Matrix<T, ri, d> Vi;
+  Eigen::Matrix<T, 4 * h, rh> Uh;
+  Eigen::Matrix<T, rh, h> Vh;
+  Eigen::Vector<T, 4 * h> b; //bii + bhi, ..., bio + bho
+
+  Eigen::Vector<T, 4 * h> gi;
+  Eigen::Vector<T, 4 * h> gh;
+  Eigen::Vector<T, ri> ti;
+  Eigen::Vector<T, rh> th;
+  Eigen::Vector<T, h> it;
+  Eigen::Vector<T, h> ft;
+  Eigen::Vector<T, h> gt;
+  Eigen::Vector<T, h> ot;
+  Eigen::Vector<T, h> ct;
+  Eigen::Vector<T, h> ht;
+
+  Eigen::Vector<T, d> xt;
+
+  Eigen::Vector<T, h> ctn1;
+  Eigen::Vector<T, h> htn1;
+
+private:
+  void Step() {
+    ApplyFactors<ri, d>(gi, Ui, Vi, xt, ti);
+    ApplyFactors<rh, h>(gh, Uh, Vh, htn1, th);
+    gi += gh + b;
+    it = gi.template segment<h>(0).unaryExpr(std::ref(Sigmoid<T>));
+    ft = gi.template segment<h>(h).unaryExpr(std::ref(Sigmoid<T>));
+    gt = gi.template segment<h>(2 * h).array().tanh();
+    ot = gi.template segment<h>(3 * h).unaryExpr(std::ref(Sigmoid<T>));
+    ct = ft.cwiseProduct(ctn1) + it.cwiseProduct(gt);
+    ht = ct.array().tanh();
+    ht = ot.cwiseProduct(ht);
+    htn1 = ht;
+    ctn1 = ct;
+  }
+};
+
+/**
+ * Gru layer with low-rank weights.
+ * T - Type
+ * h - hidden size
+ * d - input size
+ * ri - rank of the stacked input weights
+ * rh - rank of the stacked recurrent weights
+ */
+template<typename T, int h, int d, int ri, int rh>
+class LowRankGruLayer {
+public:
+  LowRankGruLayer()
+  {
+    Vi.setIdentity();
+    Vh.setIdentity();
+  }
+
+  void apply_layer(Eigen::Vector<T, d> x) {
+    xt = x;
+    Step();
+  }
+
+  void apply_layer(T x) {
+    xt = xt.Constant(x);
+    Step();
+  }
+
+  Eigen::Matrix<T, 3 * h, ri> Ui;
+  Eigen::Matrix<T, ri, d> Vi;
+  Eigen::Matrix<T, 3 * h, rh> Uh;
+  Eigen::Matrix<T, rh, h> Vh;
+  Eigen::Vector<T, 3 * h> bi; //bir, biz, bin
+  Eigen::Vector<T, 3 * h> bh; //bhr, bhz, bhn, the reset gate scales bhn
+
+  Eigen::Vector<T, 3 * h> gi;
+  Eigen::Vector<T, 3 * h> gh;
+  Eigen::Vector<T, ri> ti;
+  Eigen::Vector<T, rh> th;
+  Eigen::Vector<T, h> rt;
+  Eigen::Vector<T, h> zt;
+  Eigen::Vector<T, h> nt;
+  Eigen::Vector<T, h> ht;
+
+  Eigen::Vector<T, d> xt;
+
+  Eigen::Vector<T, h> htn1;
+
+private:
+  void Step() {
+    ApplyFactors<ri, d>(gi, Ui, Vi, xt, ti);
+    ApplyFactors<rh, h>(gh, Uh, Vh, htn1, th);
+    gi += bi;
+    gh += bh;
+    rt = (gi.template segment<h>(0) + gh.template segment<h>(0)).unaryExpr(std::ref(Sigmoid<T>));
+    zt = (gi.template segment<h>(h) + gh.template segment<h>(h)).unaryExpr(std::ref(Sigmoid<T>));
+    nt = (gi.template segment<h>(2 * h) + rt.cwiseProduct(gh.template segment<h>(2 * h))).array().tanh();
+    ht = (ht.Constant(1) - zt).cwiseProduct(nt) + zt.cwiseProduct(htn1);
+    htn1 = ht;
+  }
+};
+
+/**
+ * Rnn layer with low-rank weights.
+ * T - Type
+ * h - hidden size
+ * d - input size
+ * ri - rank of the input weights
+ * rh - rank of the recurrent weights
+ */
+template<typename T, int h, int d, int ri, int rh>
+class LowRankRnnLayer {
+public:
+  LowRankRnnLayer()
+  {
+    Vi.setIdentity();
+    Vh.setIdentity();
+  }
+
+  void apply_layer(Eigen::Vector<T, d> x) {
+    xt = x;
+    Step();
+  }
+
+  void apply_layer(T x) {
+    xt = xt.Constant(x);
+    Step();
+  }
+
+  Eigen::Matrix<T, h, ri> Ui;
+  Eigen::Matrix<T, ri, d> Vi;
+  Eigen::Matrix<T, h, rh> Uh;
+  Eigen::Matrix<T, rh, h> Vh;
+  Eigen::Vector<T, h> b; //bih + bhh
+
+  Eigen::Vector<T, h> gi;
+  Eigen::Vector<T, h> gh;
+  Eigen::Vector<T, ri> ti;
+  Eigen::Vector<T, rh> th;
+  Eigen::Vector<T, h> ht;
+
+  Eigen::Vector<T, d> xt;
+
+  Eigen::Vector<T, h> htn1;
+
+private:
+  void Step() {
+    ApplyFactors<ri, d>(gi, Ui, Vi, xt, ti);
+    ApplyFactors<rh, h>(gh, Uh, Vh, htn1, th);
+    ht = (gi + gh + b).array().tanh();
+    htn1 = ht;
+  }
+};
+
+template<typename T, int h, int d, int ri, int rh, typename F>
+void ForEachLayerState(LowRankLstmLayer<T, h, d, ri, rh>& l, F&& f)
+{
+  f(l.htn1);
+  f(l.ctn1);
+}
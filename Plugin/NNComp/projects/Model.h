@@ -0,0 +1,118 @@
+#pragma once
+#include <tuple>
+#include <utility>
+#include "layers.h"
+#include "ModelState.h"
+#include "Wavefront.h"
+
+/**
+ * Compile-time model composition.
+ * Model<T, Gru<16>, Lstm<8>, Dense<1>> stacks the layers.h layers named by the specs, each
+ * recurrent layer taking the width of the one below as its input size, the first one the input
+ * sample. The last spec is the output layer. Any number of recurrent layers can be stacked, they
+ * are held in a std::tuple and reached with GetLayer<j> (ModelState.h), which also reaches the
+ * l0..l3 members of the other model classes, so the model works with Wavefront.h and the other
+ * model helpers.
+ * There are no virtual calls, the whole stack is visible to the compiler.
+ */
+
+/**
+ * Recurrent layer specs, h hidden units
+ */
+template<int h>
+struct Lstm
+{
+  static constexpr int width = h;
+  static constexpr bool recurrent = true;
+  template<typename T, int d> using Layer = LstmLayer<T, h, d>;
+};
+
+template<int h>
+struct Gru
+{
+  static constexpr int width = h;
+  static constexpr bool recurrent = true;
+  template<typename T, int d> using Layer = GruLayer<T, h, d>;
+};
+
+template<int h>
+struct Rnn
+{
+  static constexpr int width = h;
+  static constexpr bool recurrent = true;
+  template<typename T, int d> using Layer = RnnLayer<T, h, d>;
+};
+
+/**
+ * Fully connected tanh output layer spec, n outputs. FccLayer produces one sample.
+ */
+template<int n>
+struct Dense
+{
+  static_assert(n == 1, "Models produce one output sample");
+  static constexpr int width = n;
+  static constexpr bool recurrent = false;
+  template<typename T, int d> using Layer = FccLayer<T, d, n>;
+};
+
+/**
+ * Layer types of a stack of specs, d the input size of the next layer and Done the layers so far
+ */
+template<typename T, int d, typename Done, typename... Specs> struct ModelStack;
+
+template<typename T, int d, typename... L, typename Out>
+struct ModelStack<T, d, std::tuple<L...>, Out>
+{
+  static_assert(!Out::recurrent, "The last layer of a model must be Dense");
+  static_assert(sizeof...(L) >= 1, "Models have at least one recurrent layer");
+  using Layers = std::tuple<L...>;
+  using Output = typename Out::template Layer<T, d>;
+  static constexpr int h = d;
+  static constexpr int layers = sizeof...(L);
+};
+
+template<typename T, int d, typename... L, typename S, typename Next, typename... Rest>
+struct ModelStack<T, d, std::tuple<L...>, S, Next, Rest...>
+  : ModelStack<T, S::width, std::tuple<L..., typename S::template Layer<T, d>>, Next, Rest...>
+{
+  static_assert(S::recurrent, "Dense can only be the last layer of a model");
+};
+
+/**
+ * Stacked model of the layers in Specs, run on one input sample at a time
+ */
+template<typename T, typename... Specs>
+class Model
+{
+  using Stack = ModelStack<T, 1, std::tuple<>, Specs...>;
+
+public:
+  using LayerTuple = typename Stack::Layers;
+
+  static constexpr int h = Stack::h; //input size of the output layer
+  static constexpr int d = 1;
+  static constexpr int layers = Stack::layers;
+
+  Model() { ResetState(*this); }
+
+  void apply_model(T* x, T* y)
+  {
+    Forward(x, std::make_index_sequence<layers>());
+    *y = f.apply_layer(GetLayer<layers - 1>(*this).ht);
+  }
+
+  /**
+   * Process nFrames samples from x into y, equivalent to apply_model on every sample
+   */
+  void ProcessBlock(const T* x, T* y, int nFrames) { ApplyModelWavefront(*this, x, y, nFrames); }
+
+  typename Stack::Output f;
+  LayerTuple stack; //Recurrent layers in order, GetLayer<j> is layer j
+
+private:
+  template<size_t... j>
+  void Forward(const T* x, std::index_sequence<j...>)
+  {
+    (StepLayer<j>(*this, x, 0), ...);
+  }
+};
@@ -0,0 +1,135 @@
+#pragma once
+#include <algorithm>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "layers.h"
+
+/**
+ * Helpers to visit the layers and recurrent state of a model: a Model (Model.h) with its layers
+ * in a tuple, or a model class with the members l0..l3 followed by f.
+ */
+
+/**
+ * True for models holding their recurrent layers in a LayerTuple
+ */
+template<typename M, typename = void> struct HasLayerTuple : std::false_type {};
+template<typename M> struct HasLayerTuple<M, std::void_t<typename M::LayerTuple>> : std::true_type {};
+
+/**
+ * Layer j of a model
+ */
+template<int j, typename M>
+auto& GetLayer(M& m)
+{
+  static_assert(j >= 0 && j < M::layers, "Layer index out of range");
+  if constexpr (HasLayerTuple<M>::value) return std::get<j>(m.stack);
+  else if constexpr (j == 0) return m.l0;
+  else if constexpr (j == 1) return m.l1;
+  else if constexpr (j == 2) return m.l2;
+  else return m.l3;
+}
+
+template<typename M, typename F, size_t... j>
+void ForEachLayer(M& m, F&& f, std::index_sequence<j...>)
+{
+  (f(GetLayer<j>(m)), ...);
+}
+
+/**
+ * Call f on every recurrent layer of a model, in order
+ */
+template<typename M, typename F>
+void ForEachLayer(M& m, F&& f)
+{
+  ForEachLayer(m, f, std::make_index_sequence<M::layers>());
+}
+
+/**
+ * Type of layer j of a model, void past the last layer
+ */
+template<typename M, int j, typename = void> struct ModelLayerType { using type = void; };
+template<typename M, int j> struct ModelLayerType<M, j, std::enable_if_t<(j < M::layers)>>
+{
+  using type = std::remove_reference_t<decltype(GetLayer<j>(std::declval<M&>()))>;
+};
+
+template<typename T, int h, int d, typename F>
+void ForEachLayerState(LstmLayer<T, h, d>& l, F&& f)
+{
+  f(l.htn1);
+  f(l.ctn1);
+}
+
+template<typename L, typename F>
+void ForEachLayerState(L& l, F&& f)
+{
+  f(l.htn1);
+}
+
+/**
+ * Call f on every recurrent state vector of a model (htn1, plus ctn1 for lstm layers)
+ */
+template<typename M, typename F>
+void ForEachState(M& m, F&& f)
+{
+  ForEachLayer(m, [&](auto& l) { ForEachLayerState(l, f); });
+}
+
+/**
+ * Number of recurrent state values of layer type L (htn1, plus ctn1 for lstm layers)
+ */
+template<typename L, typename = void> struct LayerStateSize { static constexpr int value = decltype(L::htn1)::RowsAtCompileTime; };
+template<typename L> struct LayerStateSize<L, std::void_t<decltype(L::ctn1)>> { static constexpr int value = 2 * decltype(L::htn1)::RowsAtCompileTime; };
+
+template<typename M, size_t... j>
+constexpr int ModelStateSize(std::index_sequence<j...>)
+{
+  return (0 + ... + LayerStateSize<typename ModelLayerType<M, j>::type>::value);
+}
+
+/**
+ * Number of recurrent state values of a model, as visited by ForEachState
+ */
+template<typename M>
+constexpr int ModelStateSize()
+{
+  return ModelStateSize<M>(std::make_index_sequence<M::layers>());
+}
+
+template<typename M, size_t... j>
+constexpr int ModelWidth(std::index_sequence<j...>)
+{
+  return std::max({int(decltype(ModelLayerType<M, j>::type::htn1)::RowsAtCompileTime)...,
+                   int(decltype(ModelLayerType<M, j>::type::xt)::RowsAtCompileTime)...});
+}
+
+/**
+ * Largest input or hidden size of the recurrent layers of a model
+ */
+template<typename M>
+constexpr int ModelWidth()
+{
+  return ModelWidth<M>(std::make_index_sequence<M::layers>());
+}
+
+/**
+ * True if no recurrent state of the model holds NaN or Inf
+ */
+template<typename M>
+bool StateIsFinite(M& m)
+{
+  bool finite = true;
+  ForEachState(m, [&](const auto& v) { finite = finite && v.allFinite(); });
+  return finite;
+}
+
+/**
+ * Return the recurrent state of a model to its initial (zero) state
+ */
+template<typename M>
+void ResetState(M& m)
+{
+  ForEachState(m, [](auto& v) { v.setZero(); });
+  ForEachLayer(m, [](auto& l) { l.ht.setZero(); });
+}
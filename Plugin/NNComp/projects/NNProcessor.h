@@ -0,0 +1,374 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include "Eigen/Dense"
+#include "dsp.h"
+#include "AudioBuffer.h"
+#include "Denormals.h"
+#include "RealtimePool.h"
+
+/**
+ * Host independent NNComp signal path: input gain -> model -> gain reduction -> output gain.
+ * Has no iPlug2 dependency so it can be shared by the plugin, benchmarks and offline tools.
+ * All scratch memory lives in one aligned SoA arena allocated by Prepare().
+ * T - Sample type
+ * MAX_CHANS - Maximum number of channels run through a model
+ */
+template<typename T, int MAX_CHANS = 2>
+class NNProcessor
+{
+public:
+  static constexpr int kDefaultBlockSize = 512;
+
+  NNProcessor()
+  {
+    Prepare(kDefaultBlockSize);
+  }
+
+  /**
+   * Allocate scratch space for blocks of up to maxBlockSize frames. Not realtime safe.
+   */
+  void Prepare(int maxBlockSize)
+  {
+    maxBlock = std::max(1, maxBlockSize);
+    arena.SetFrameLength(maxBlock);
+    running = false;
+    EndModelFade();
+  }
+
+  /**
+   * Set linear input gain applied before the model
+   */
+  void SetInputGain(T gain) { inGain = gain; }
+
+  /**
+   * Set linear output gain applied after the model
+   */
+  void SetOutputGain(T gain) { outGain = gain; }
+
+  /**
+   * Select model index (see NN::ProcessSample). A change crossfades from the previous model
+   * over the crossfade length, running both models meanwhile. A change during a crossfade
+   * back to the model fading out reverses it, any other model is queued until it ends.
+   */
+  void SetModel(int idx)
+  {
+    if(modelMix < T(1))
+    {
+      if(idx == prevModel)
+      {
+        std::swap(model, prevModel);
+        modelMix = T(1) - modelMix;
+        pendingModel = -1;
+      }
+      else
+      {
+        pendingModel = idx == model ? -1 : idx;
+      }
+      return;
+    }
+
+    if(idx == model) return;
+    prevModel = model;
+    modelMix = IsBypassed() || !running ? T(1) : T(0);
+    model = idx;
+  }
+
+  /**
+   * Engage or release bypass. Both directions crossfade over the crossfade length.
+   * Once fully bypassed no inference runs and the model state is held.
+   */
+  void SetBypass(bool bypass)
+  {
+    bypassTarget = bypass ? T(0) : T(1);
+  }
+
+  /**
+   * Set bypass and model change crossfade length in frames
+   */
+  void SetCrossfadeLength(int nFrames)
+  {
+    fadeStep = T(1) / T(std::max(1, nFrames));
+  }
+
+  /**
+   * True when fully bypassed, ie. output is a copy of the input
+   */
+  bool IsBypassed() const { return wet == T(0) && bypassTarget == T(0); }
+
+  /**
+   * Skip inference while the input is silent and the model state has converged.
+   * See SilenceGate::Set for the parameters.
+   */
+  void SetSilenceGate(bool enable, T threshold = 0, T epsilon = T(1e-7), int holdSamples = 64)
+  {
+    for(int c = 0; c < MAX_CHANS; c++)
+    {
+      nn[c].gate.Set(threshold, epsilon, holdSamples);
+      nn[c].gate.SetEnabled(enable);
+    }
+  }
+
+  /**
+   * True when channel chan is emitting the cached fixed-point output
+   */
+  bool IsGated(int chan) const { return nn[chan].gate.IsGated(); }
+
+  /**
+   * Run the models as delta networks, skipping the weights of units that changed by less
+   * than threshold since they were last applied. Trades accuracy for cost, 0 is exact.
+   * Replaces the silence gate while enabled. See DeltaNetwork.
+   */
+  void SetDeltaNetwork(bool enable, T threshold = 0)
+  {
+    for(int c = 0; c < MAX_CHANS; c++)
+    {
+      nn[c].delta.Set(threshold);
+      nn[c].delta.SetEnabled(enable);
+    }
+  }
+
+  /**
+   * Fraction of weight columns applied by the delta network of channel chan
+   */
+  double GetDeltaUpdateRatio(int chan) const { return nn[chan].delta.GetUpdateRatio(); }
+
+  /**
+   * Return all models to their initial state. Touches every model, so avoid calling it per block.
+   */
+  void Reset()
+  {
+    for(int c = 0; c < MAX_CHANS; c++)
+    {
+      nn[c].Reset();
+    }
+    running = false;
+    EndModelFade();
+  }
+
+  /**
+   * Number of NaN/Inf state resets across all channels, for diagnostics
+   */
+  int GetStateResetCount() const
+  {
+    int count = 0;
+    for(int c = 0; c < MAX_CHANS; c++)
+    {
+      count += nn[c].GetStateResetCount();
+    }
+    return count;
+  }
+
+  /**
+   * Run the model channels on a shared worker pool, nullptr to process them serially.
+   * The pool must outlive its use here.
+   */
+  void SetPool(RealtimePool* p) { pool = p; }
+
+  int GetModel() const { return model; }
+  int GetMaxBlockSize() const { return maxBlock; }
+
+  /**
+   * Process nFrames of audio. Blocks larger than the prepared size are split internally.
+   * Inputs are never modified. Channels above MAX_CHANS are passed through with gain only, following the bypass crossfade.
+   */
+  void Process(const T* const* inputs, T* const* outputs, int nChans, int nFrames)
+  {
+    ScopedDenormalGuard denormalGuard;
+    
+    for(int offset = 0; offset < nFrames; offset += maxBlock)
+    {
+      ProcessChunk(inputs, outputs, nChans, offset, std::min(maxBlock, nFrames - offset));
+    }
+  }
+
+  /**
+   * Gain-scaled input of the last processed chunk, MAX_CHANS channels
+   */
+  T** GetInputBuffer() { return arena.GetBuffer(); }
+
+  /**
+   * Model output of the last processed chunk before output gain, MAX_CHANS channels
+   */
+  T** GetModelBuffer() { return arena.GetBuffer() + MAX_CHANS; }
+
+  /**
+   * Gain reduction (|in| - |out|) of the last processed chunk, MAX_CHANS channels
+   */
+  T** GetGrBuffer() { return arena.GetBuffer() + 2 * MAX_CHANS; }
+
+  NN<T>& GetNetwork(int chan) { return nn[chan]; }
+
+private:
+  using ArrayMap = Eigen::Map<Eigen::Array<T, Eigen::Dynamic, 1>, Eigen::Aligned64>;
+  using HostMap = Eigen::Map<Eigen::Array<T, Eigen::Dynamic, 1>>;
+  using ConstHostMap = Eigen::Map<const Eigen::Array<T, Eigen::Dynamic, 1>>;
+
+  void ProcessChunk(const T* const* inputs, T* const* outputs, int nChans, int offset, int nFrames)
+  {
+    //Bypassed, output is only a copy
+    if(IsBypassed())
+    {
+      for(int c = 0; c < nChans; c++)
+      {
+        if(outputs[c] != inputs[c])
+        {
+          std::copy(inputs[c] + offset, inputs[c] + offset + nFrames, outputs[c] + offset);
+        }
+      }
+      return;
+    }
+
+    running = true;
+    T** in = GetInputBuffer();
+    T** out = GetModelBuffer();
+    T** gr = GetGrBuffer();
+    const int nModelChans = std::min(nChans, MAX_CHANS);
+    const bool fading = wet != bypassTarget;
+    const bool modelFading = modelMix < T(1);
+
+    auto processChannel = [&](int c) {
+      ArrayMap x(in[c], nFrames);
+      ArrayMap y(out[c], nFrames);
+
+      //Input gain
+      x = ConstHostMap(inputs[c] + offset, nFrames) * inGain;
+
+      //Model, crossfaded from the previous one after a change
+      nn[c].ProcessBlock(in[c], out[c], nFrames, model);
+      if(modelFading)
+      {
+        T* prev = GetPrevModelBuffer()[c];
+        nn[c].ProcessFadeOutBlock(in[c], prev, nFrames, prevModel);
+        for(int s = 0; s < nFrames; s++)
+        {
+          y[s] = prev[s] + (y[s] - prev[s]) * ModelFadeGain(s);
+        }
+      }
+
+      //Gain reduction
+      ArrayMap(gr[c], nFrames) = x.abs() - y.abs();
+
+      //Output gain
+      if(fading)
+      {
+        //Crossfade against the untouched input, inputs may alias outputs
+        for(int s = 0; s < nFrames; s++)
+        {
+          const T dry = inputs[c][offset + s];
+          outputs[c][offset + s] = dry + (y[s] * outGain - dry) * FadeGain(s);
+        }
+      }
+      else
+      {
+        HostMap(outputs[c] + offset, nFrames) = y * outGain;
+      }
+    };
+
+    if(pool && nModelChans > 1)
+    {
+      pool->ParallelFor(nModelChans, processChannel);
+    }
+    else
+    {
+      for(int c = 0; c < nModelChans; c++)
+      {
+        processChannel(c);
+      }
+    }
+
+    //Unused model channels read as silence
+    for(int c = nModelChans; c < MAX_CHANS; c++)
+    {
+      std::fill(in[c], in[c] + nFrames, T(0));
+      std::fill(out[c], out[c] + nFrames, T(0));
+      std::fill(gr[c], gr[c] + nFrames, T(0));
+    }
+
+    //Extra channels are not modelled, but follow the bypass crossfade
+    for(int c = nModelChans; c < nChans; c++)
+    {
+      if(fading)
+      {
+        for(int s = 0; s < nFrames; s++)
+        {
+          const T dry = inputs[c][offset + s];
+          outputs[c][offset + s] = dry + (dry * (inGain * outGain) - dry) * FadeGain(s);
+        }
+      }
+      else
+      {
+        HostMap(outputs[c] + offset, nFrames) = ConstHostMap(inputs[c] + offset, nFrames) * (inGain * outGain);
+      }
+    }
+
+    if(modelFading)
+    {
+      modelMix = ModelFadeGain(nFrames - 1);
+      if(modelMix >= T(1)) EndModelFade();
+    }
+
+    if(fading)
+    {
+      wet = FadeGain(nFrames - 1);
+
+      //Meters read silence while bypassed
+      if(IsBypassed())
+      {
+        arena.Clear();
+      }
+    }
+  }
+
+  /**
+   * Wet gain for frame s of the current chunk
+   */
+  T FadeGain(int s) const
+  {
+    const T step = fadeStep * T(s + 1);
+    return wet < bypassTarget ? std::min(bypassTarget, wet + step) : std::max(bypassTarget, wet - step);
+  }
+
+  /**
+   * Weight of the new model for frame s of the current chunk
+   */
+  T ModelFadeGain(int s) const
+  {
+    return std::min(T(1), modelMix + fadeStep * T(s + 1));
+  }
+
+  /**
+   * Finish a model crossfade, starting the next one if a model was queued during it
+   */
+  void EndModelFade()
+  {
+    modelMix = T(1);
+    if(pendingModel >= 0)
+    {
+      const int next = pendingModel;
+      pendingModel = -1;
+      SetModel(next);
+    }
+  }
+
+  /**
+   * Output of the previous model during a model crossfade
+   */
+  T** GetPrevModelBuffer() { return arena.GetBuffer() + 3 * MAX_CHANS; }
+
+  NN<T> nn[MAX_CHANS];
+  CustomAudioBuffer<T, 4 * MAX_CHANS> arena;
+  RealtimePool* pool = nullptr;
+
+  T inGain = 1;
+  T outGain = 1;
+  T wet = 1;
+  T bypassTarget = 1;
+  T fadeStep = T(1) / T(kDefaultBlockSize);
+  T modelMix = 1;
+  int model = 0;
+  int prevModel = 0;
+  int pendingModel = -1; //Model selected during a crossfade, started when it ends
+  int maxBlock = 0;
+  bool running = false; //Audio processed since Prepare() or Reset(), model changes fade
+};
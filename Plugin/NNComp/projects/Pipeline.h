@@ -0,0 +1,144 @@
+#pragma once
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "Eigen/Dense"
+#include "Wavefront.h"
+#include "SpscRing.h"
+#include "Denormals.h"
+
+/**
+ * Multi-core layer pipelining for offline rendering.
+ * Each recurrent layer of the model runs on its own thread. Consecutive layers are connected
+ * by SPSC rings of hidden-state vectors which are handed over in chunks. The last layer runs
+ * on the calling thread together with the output layer f. Every layer sees exactly the same
+ * inputs in the same order as with apply_model, so the output is identical.
+ * Spawns threads and allocates, not for use on the audio thread.
+ *
+ * nn.WithModel(model, [&](auto& m) { ApplyModelPipelined(m, x, y, nFrames); });
+ */
+
+/**
+ * Hidden-state vector of layer j, handed to layer j+1
+ */
+template<typename M, int j>
+using PipelineState = std::decay_t<decltype(GetLayer<j>(std::declval<M&>()).ht)>;
+
+template<typename M, int... js>
+auto MakePipelineRings(std::integer_sequence<int, js...>) -> std::tuple<std::unique_ptr<SpscRing<PipelineState<M, js>>>...>;
+
+/**
+ * Ring j between layers j and j+1, the layers may differ in width
+ */
+template<typename M, typename T>
+using PipelineRings = decltype(MakePipelineRings<M>(std::make_integer_sequence<int, M::layers - 1>()));
+
+/**
+ * Wait until a ring has n readable (or writable) items
+ */
+template<typename F>
+inline size_t WaitFor(F&& available, size_t n)
+{
+  size_t count = available();
+  while(count < n)
+  {
+    std::this_thread::yield();
+    count = available();
+  }
+  return count;
+}
+
+/**
+ * Run layer j over the whole signal, reading from ring j-1 (or x) and writing ring j (or y)
+ */
+template<int j, typename M, typename T>
+void RunPipelineStage(M& m, const T* x, T* y, const long nFrames, PipelineRings<M, T>& rings, const int chunk)
+{
+  constexpr int L = M::layers;
+  ScopedDenormalGuard denormalGuard;
+  auto& layer = GetLayer<j>(m);
+
+  for(long t = 0; t < nFrames;)
+  {
+    const long remaining = nFrames - t;
+    long n = std::min<long>(chunk, remaining);
+
+    //Wait for input from the layer below
+    if constexpr (j > 0)
+    {
+      auto& in = *std::get<j - 1>(rings);
+      n = std::min<long>(n, WaitFor([&]() { return in.ReadAvailable(); }, 1));
+    }
+
+    //Wait for space in the layer above
+    if constexpr (j < L - 1)
+    {
+      auto& out = *std::get<j>(rings);
+      n = std::min<long>(n, WaitFor([&]() { return out.WriteAvailable(); }, 1));
+    }
+
+    for(long i = 0; i < n; i++)
+    {
+      if constexpr (j == 0) layer.apply_layer(x[t + i]);
+      else layer.apply_layer(std::get<j - 1>(rings)->ReadSlot(i));
+
+      if constexpr (j < L - 1) std::get<j>(rings)->WriteSlot(i) = layer.ht;
+      else y[t + i] = m.f.apply_layer(layer.ht);
+    }
+
+    if constexpr (j > 0) std::get<j - 1>(rings)->Consume(n);
+    if constexpr (j < L - 1) std::get<j>(rings)->Publish(n);
+    t += n;
+  }
+}
+
+template<typename M, typename T, int... js>
+void LaunchPipelineStages(M& m, const T* x, T* y, const long nFrames, PipelineRings<M, T>& rings,
+                          const int chunk, std::vector<std::thread>& workers, std::integer_sequence<int, js...>)
+{
+  (workers.emplace_back([&m, x, y, nFrames, &rings, chunk]() {
+    RunPipelineStage<js>(m, x, y, nFrames, rings, chunk);
+  }), ...);
+}
+
+/**
+ * Process nFrames of x into y through model m with one thread per layer.
+ * chunk - number of hidden-state vectors handed between layers at once
+ */
+template<typename M, typename T>
+void ApplyModelPipelined(M& m, const T* x, T* y, const long nFrames, const int chunk = 256)
+{
+  constexpr int L = M::layers;
+
+  if constexpr (L == 1)
+  {
+    ScopedDenormalGuard denormalGuard;
+    auto& l0 = GetLayer<0>(m);
+    for(long t = 0; t < nFrames; t++)
+    {
+      l0.apply_layer(x[t]);
+      y[t] = m.f.apply_layer(l0.ht);
+    }
+  }
+  else
+  {
+    //Room for a few chunks in flight between each pair of layers
+    PipelineRings<M, T> rings;
+    std::apply([&](auto&... ring) {
+      ((ring = std::make_unique<typename std::decay_t<decltype(ring)>::element_type>(4 * std::max(1, chunk))), ...);
+    }, rings);
+
+    std::vector<std::thread> workers;
+    LaunchPipelineStages(m, x, y, nFrames, rings, std::max(1, chunk), workers, std::make_integer_sequence<int, L - 1>());
+    RunPipelineStage<L - 1>(m, x, y, nFrames, rings, std::max(1, chunk));
+
+    for(auto& w : workers)
+    {
+      w.join();
+    }
+  }
+}
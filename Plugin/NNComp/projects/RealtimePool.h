@@ -0,0 +1,233 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "Denormals.h"
+#include "RealtimeThread.h"
+
+/**
+ * Process-wide worker pool for fanning out work inside the audio callback.
+ * Every plugin instance in the host shares one pool (see Acquire()), so channels of many
+ * instances can run on cores the host leaves idle.
+ *
+ * ParallelFor() runs with no locks and no allocation. The caller offers its job to idle
+ * workers, then claims job indices itself alongside them, so it never waits on a worker that
+ * has not started: offers that were not taken are withdrawn once the caller runs out of
+ * indices. When every worker is busy the job simply runs inline. The caller only waits for
+ * indices already being run by a worker, spinning for a bounded time and then yielding.
+ *
+ * Workers spin for kSpinUs after their last job and then park on a semaphore. A parked
+ * worker offered a job is posted, which only enters the kernel for a parked worker; it joins
+ * in if it wakes before the caller has claimed every index. So only work that takes longer
+ * per index than a thread takes to wake up gains from the pool. The default pool leaves one
+ * core to the host, so on a single core machine everything runs inline.
+ */
+class RealtimePool
+{
+public:
+  /**
+   * Shared pool, created on first use and destroyed with its last user. Not realtime safe.
+   * nThreads - workers for a newly created pool, 0 = one less than the number of cores
+   */
+  static std::shared_ptr<RealtimePool> Acquire(int nThreads = 0)
+  {
+    static std::mutex mutex;
+    static std::weak_ptr<RealtimePool> shared;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto pool = shared.lock();
+    if(!pool)
+    {
+      if(nThreads <= 0)
+      {
+        nThreads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency())) - 1;
+      }
+      pool = std::shared_ptr<RealtimePool>(new RealtimePool(nThreads));
+      shared = pool;
+    }
+    return pool;
+  }
+
+  ~RealtimePool()
+  {
+    stop = true;
+    for(int w = 0; w < nWorkers; w++)
+    {
+      workers[w].wake.Post();
+    }
+    for(auto& t : threads)
+    {
+      t.join();
+    }
+  }
+
+  RealtimePool(const RealtimePool&) = delete;
+  RealtimePool& operator=(const RealtimePool&) = delete;
+
+  int GetNumThreads() const { return nWorkers; }
+
+  /**
+   * Run f(i) for i in [0, n) on the calling thread and any idle workers, return when all
+   * are done. Realtime safe as long as f is.
+   */
+  template<typename F>
+  void ParallelFor(const int n, F&& f)
+  {
+    using Fn = std::remove_reference_t<F>;
+    Job job;
+    job.fn = [](void* ctx, int i) { (*static_cast<Fn*>(ctx))(i); };
+    job.ctx = const_cast<void*>(static_cast<const void*>(&f));
+    job.n = n;
+
+    //Offer to idle workers, at most one per index beyond the caller's
+    int offered = 0;
+    for(int w = 0; w < nWorkers && offered < n - 1; w++)
+    {
+      Worker& worker = workers[w];
+      Job* expected = nullptr;
+      if(worker.slot.load(std::memory_order_relaxed) == nullptr)
+      {
+        job.active.fetch_add(1, std::memory_order_relaxed);
+        if(worker.slot.compare_exchange_strong(expected, &job, std::memory_order_seq_cst, std::memory_order_relaxed))
+        {
+          offered++;
+
+          //Pairs with the fence in WorkerLoop(): either the worker sees the offer or we see it parked
+          std::atomic_thread_fence(std::memory_order_seq_cst);
+          if(worker.parked.exchange(false, std::memory_order_relaxed)) worker.wake.Post();
+        }
+        else
+        {
+          job.active.fetch_sub(1, std::memory_order_relaxed);
+        }
+      }
+    }
+
+    RunIndices(job);
+
+    //Withdraw offers nobody took
+    if(offered > 0)
+    {
+      for(int w = 0; w < nWorkers; w++)
+      {
+        Job* expected = &job;
+        if(workers[w].slot.compare_exchange_strong(expected, nullptr, std::memory_order_relaxed))
+        {
+          job.active.fetch_sub(1, std::memory_order_relaxed);
+        }
+      }
+    }
+
+    //Wait for indices still running on workers
+    for(int spins = 0; job.done.load(std::memory_order_acquire) < n || job.active.load(std::memory_order_acquire) > 0; spins++)
+    {
+      if(spins < kMaxSpins) SpinPause();
+      else std::this_thread::yield();
+    }
+  }
+
+private:
+  static constexpr int kMaxSpins = 4096;
+
+  struct Job
+  {
+    void (*fn)(void*, int) = nullptr;
+    void* ctx = nullptr;
+    int n = 0;
+    std::atomic<int> next {0};
+    std::atomic<int> done {0};
+    std::atomic<int> active {0}; //Workers offered the job that may still touch it
+  };
+
+  struct alignas(64) Worker
+  {
+    std::atomic<Job*> slot {nullptr};
+    std::atomic<bool> parked {false};
+    Semaphore wake;
+  };
+
+  explicit RealtimePool(int nThreads)
+  : nWorkers(std::max(0, nThreads))
+  , workers(new Worker[std::max(1, nWorkers)])
+  {
+    for(int w = 0; w < nWorkers; w++)
+    {
+      threads.emplace_back([this, w]() { WorkerLoop(workers[w]); });
+    }
+  }
+
+  static void RunIndices(Job& job)
+  {
+    for(int i = job.next.fetch_add(1, std::memory_order_relaxed); i < job.n; i = job.next.fetch_add(1, std::memory_order_relaxed))
+    {
+      job.fn(job.ctx, i);
+      job.done.fetch_add(1, std::memory_order_release);
+    }
+  }
+
+  /**
+   * Take an offered job. Replacing the pointer with the busy marker stops the caller from
+   * withdrawing it.
+   */
+  Job* Accept(Worker& worker)
+  {
+    Job* job = worker.slot.load(std::memory_order_acquire);
+    if(job == nullptr || job == Busy()) return nullptr;
+    return worker.slot.compare_exchange_strong(job, Busy(), std::memory_order_acquire) ? job : nullptr;
+  }
+
+  static Job* Busy() { return reinterpret_cast<Job*>(alignof(Job)); }
+
+  void WorkerLoop(Worker& worker)
+  {
+    SetRealtimePriority();
+    ScopedDenormalGuard denormalGuard;
+    auto spinEnd = std::chrono::steady_clock::now() + std::chrono::microseconds(kSpinUs);
+    int spins = 0;
+
+    while(!stop.load(std::memory_order_relaxed))
+    {
+      if(Job* job = Accept(worker))
+      {
+        RunIndices(*job);
+        //The caller may return as soon as active drops, do not touch job afterwards
+        job->active.fetch_sub(1, std::memory_order_release);
+        worker.slot.store(nullptr, std::memory_order_release);
+        spinEnd = std::chrono::steady_clock::now() + std::chrono::microseconds(kSpinUs);
+        spins = 0;
+        continue;
+      }
+
+      //Busy wait briefly for a job of the same callback, yielding on an oversubscribed machine
+      if(std::chrono::steady_clock::now() < spinEnd)
+      {
+        if(spins++ < kMaxSpins) SpinPause();
+        else std::this_thread::yield();
+        continue;
+      }
+
+      //Idle, park until a caller offers a job or the pool stops
+      worker.parked.store(true, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if(worker.slot.load(std::memory_order_relaxed) == nullptr && !stop.load(std::memory_order_relaxed))
+      {
+        worker.wake.Wait();
+      }
+      worker.parked.store(false, std::memory_order_relaxed);
+      spinEnd = std::chrono::steady_clock::now() + std::chrono::microseconds(kSpinUs);
+      spins = 0;
+    }
+  }
+
+  static constexpr int kSpinUs = 50;
+
+  const int nWorkers;
+  std::unique_ptr<Worker[]> workers;
+  std::vector<std::thread> threads;
+  std::atomic<bool> stop {false};
+};
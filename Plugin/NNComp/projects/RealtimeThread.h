@@ -0,0 +1,107 @@
+#pragma once
+#include <climits>
+#include <thread>
+
+#if defined(_WIN32)
+  #include <windows.h>
+#elif defined(__APPLE__)
+  #include <pthread.h>
+  #include <dispatch/dispatch.h>
+  #include <mach/mach.h>
+  #include <mach/thread_policy.h>
+#else
+  #include <pthread.h>
+  #include <sched.h>
+  #include <semaphore.h>
+#endif
+
+/**
+ * Helpers for worker threads that compute audio for the host callback.
+ */
+
+/**
+ * Raise the priority of the calling thread to (near) audio priority. Best effort: without
+ * the required privileges the thread keeps its normal priority. Returns true on success.
+ */
+inline bool SetRealtimePriority()
+{
+#if defined(_WIN32)
+  return SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL) != 0;
+#elif defined(__APPLE__)
+  //Time constraint policy like the CoreAudio IO thread, 1 ms period at 48 kHz scale
+  mach_timebase_info_data_t timebase;
+  mach_timebase_info(&timebase);
+  const double ticksPerMs = 1e6 * double(timebase.denom) / double(timebase.numer);
+  thread_time_constraint_policy_data_t policy;
+  policy.period = static_cast<uint32_t>(ticksPerMs);
+  policy.computation = static_cast<uint32_t>(0.5 * ticksPerMs);
+  policy.constraint = static_cast<uint32_t>(ticksPerMs);
+  policy.preemptible = 1;
+  return thread_policy_set(pthread_mach_thread_np(pthread_self()), THREAD_TIME_CONSTRAINT_POLICY,
+                           reinterpret_cast<thread_policy_t>(&policy), THREAD_TIME_CONSTRAINT_POLICY_COUNT) == KERN_SUCCESS;
+#else
+  sched_param param {};
+  param.sched_priority = sched_get_priority_min(SCHED_FIFO) + 10;
+  return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+#endif
+}
+
+/**
+ * Hint to the CPU that the caller is spin waiting
+ */
+inline void SpinPause()
+{
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+  #if defined(_MSC_VER)
+    _mm_pause();
+  #else
+    __builtin_ia32_pause();
+  #endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+  #if defined(_MSC_VER)
+    __yield();
+  #else
+    asm volatile("yield");
+  #endif
+#else
+  std::this_thread::yield();
+#endif
+}
+
+/**
+ * Counting semaphore for parking worker threads. Post() takes no lock, so the audio thread
+ * can wake a worker; it only enters the kernel when a thread is waiting (on Windows it
+ * always does).
+ */
+class Semaphore
+{
+public:
+#if defined(_WIN32)
+  Semaphore() : handle(CreateSemaphore(nullptr, 0, LONG_MAX, nullptr)) {}
+  ~Semaphore() { CloseHandle(handle); }
+  void Post() { ReleaseSemaphore(handle, 1, nullptr); }
+  void Wait() { WaitForSingleObject(handle, INFINITE); }
+#elif defined(__APPLE__)
+  Semaphore() : handle(dispatch_semaphore_create(0)) {}
+  ~Semaphore() { dispatch_release(handle); }
+  void Post() { dispatch_semaphore_signal(handle); }
+  void Wait() { dispatch_semaphore_wait(handle, DISPATCH_TIME_FOREVER); }
+#else
+  Semaphore() { sem_init(&handle, 0, 0); }
+  ~Semaphore() { sem_destroy(&handle); }
+  void Post() { sem_post(&handle); }
+  void Wait() { while(sem_wait(&handle) != 0) {} } //Retry when interrupted by a signal
+#endif
+
+  Semaphore(const Semaphore&) = delete;
+  Semaphore& operator=(const Semaphore&) = delete;
+
+private:
+#if defined(_WIN32)
+  HANDLE handle;
+#elif defined(__APPLE__)
+  dispatch_semaphore_t handle;
+#else
+  sem_t handle;
+#endif
+};
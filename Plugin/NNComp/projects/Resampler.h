@@ -0,0 +1,289 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <vector>
+#include "Eigen/Dense"
+#include "NNProcessor.h"
+
+/**
+ * Streaming rational polyphase resampler.
+ * Converts by L/M with a Kaiser windowed sinc prototype split into L phases of K taps. Each
+ * output sample is one K tap dot product (vectorised by Eigen) against a contiguous
+ * history window, no other work is done per sample. The bank is computed in Setup().
+ * T - Sample type
+ */
+template<typename T>
+class Resampler
+{
+public:
+  static constexpr int kBaseTaps = 64; //Taps per phase when upsampling, more when decimating
+  static constexpr double kBeta = 8.;  //Kaiser window, about 80 dB stopband
+  static constexpr double kPi = 3.14159265358979323846;
+
+  /**
+   * Design the filter bank for a rate pair. Not realtime safe.
+   */
+  void Setup(int inRate, int outRate)
+  {
+    const int g = std::gcd(inRate, outRate);
+    L = outRate / g;
+    M = inRate / g;
+    K = static_cast<int>(std::ceil(kBaseTaps * std::max(1., double(M) / L)));
+
+    //Prototype at L * inRate, stopband edge at the lower Nyquist frequency
+    const int N = K * L;
+    const double rate = double(L) * inRate;
+    const double nyquist = 0.5 * std::min(inRate, outRate);
+    const double transition = (80. - 8.) / (2.285 * 2. * kPi * N) * rate;
+    const double fc = (nyquist - 0.5 * transition) / rate;
+    const double centre = 0.5 * (N - 1);
+
+    bank.resize(static_cast<size_t>(N));
+    for(int n = 0; n < N; n++)
+    {
+      const double t = n - centre;
+      const double sinc = t == 0. ? 2. * fc : std::sin(2. * kPi * fc * t) / (kPi * t);
+      const double r = 2. * n / (N - 1) - 1.;
+      const double window = BesselI0(kBeta * std::sqrt(std::max(0., 1. - r * r))) / BesselI0(kBeta);
+
+      //Phase p, tap k at p * K + k, gain L makes up for the zero stuffing
+      const int p = n % L;
+      const int k = n / L;
+      bank[static_cast<size_t>(p * K + k)] = static_cast<T>(sinc * window * L);
+    }
+
+    delay = centre / rate;
+    history.assign(static_cast<size_t>(2 * K), T(0));
+    Reset();
+  }
+
+  /**
+   * Clear the history, the delay stays the same
+   */
+  void Reset()
+  {
+    std::fill(history.begin(), history.end(), T(0));
+    write = 0;
+    phase = 0;
+  }
+
+  /**
+   * Largest number of output frames for nIn input frames
+   */
+  int GetMaxOutput(int nIn) const { return static_cast<int>((static_cast<long>(nIn) * L + M - 1) / M) + 1; }
+
+  /**
+   * Group delay in seconds
+   */
+  double GetDelay() const { return delay; }
+
+  /**
+   * Convert nIn frames, returns the number written to y
+   */
+  int Process(const T* x, int nIn, T* y)
+  {
+    using Vec = Eigen::Map<const Eigen::Matrix<T, Eigen::Dynamic, 1>>;
+    int nOut = 0;
+
+    for(int i = 0; i < nIn; i++)
+    {
+      //Newest sample first, mirrored so the window is always contiguous
+      write = write == 0 ? K - 1 : write - 1;
+      history[write] = history[write + K] = x[i];
+      const Vec window(history.data() + write, K);
+
+      for(; phase < L; phase += M)
+      {
+        y[nOut++] = Vec(bank.data() + phase * K, K).dot(window);
+      }
+      phase -= L;
+    }
+    return nOut;
+  }
+
+private:
+  static double BesselI0(double x)
+  {
+    double sum = 1., term = 1.;
+    for(int k = 1; k < 50 && term > 1e-12 * sum; k++)
+    {
+      term *= (x / (2. * k)) * (x / (2. * k));
+      sum += term;
+    }
+    return sum;
+  }
+
+  std::vector<T> bank;
+  std::vector<T> history;
+  double delay = 0.;
+  int L = 1;
+  int M = 1;
+  int K = 1;
+  int write = 0;
+  int phase = 0;
+};
+
+/**
+ * Runs an NNProcessor at the 48 kHz the models were trained at, whatever the host rate.
+ * Each channel is resampled to 48 kHz, processed, and resampled back. A host block of n
+ * frames yields at least n frames after the round trip, the few extra are kept for the next
+ * block, so the delay is constant: the group delay of both filters, see GetLatency().
+ * At 48 kHz the processor runs directly with no delay.
+ * Meter buffers are at the host rate, picked from the 48 kHz ones.
+ * Channels above MAX_CHANS output silence while resampling.
+ * T - Sample type
+ * MAX_CHANS - Maximum number of channels run through a model
+ */
+template<typename T, int MAX_CHANS = 2>
+class RateAdapter
+{
+public:
+  static constexpr int kModelRate = 48000;
+
+  explicit RateAdapter(NNProcessor<T, MAX_CHANS>& p)
+  : processor(p)
+  {
+  }
+
+  /**
+   * Prepare for a host rate and block size, also prepares the processor. Not realtime safe.
+   */
+  void Prepare(double sampleRate, int maxBlockSize)
+  {
+    hostRate = static_cast<int>(std::lround(sampleRate));
+    maxBlock = std::max(1, maxBlockSize);
+    active = hostRate > 0 && hostRate != kModelRate;
+    latency = 0;
+
+    if(!active)
+    {
+      processor.Prepare(maxBlock);
+      return;
+    }
+
+    for(int c = 0; c < MAX_CHANS; c++)
+    {
+      up[c].Setup(hostRate, kModelRate);
+      down[c].Setup(kModelRate, hostRate);
+    }
+    const int maxModel = up[0].GetMaxOutput(maxBlock);
+    processor.Prepare(maxModel);
+    modelIo.SetFrameLength(maxModel);
+    meters.SetFrameLength(maxBlock);
+
+    //Round trip output waiting for the next block
+    fifoSize = down[0].GetMaxOutput(maxModel) + maxBlock;
+    for(int c = 0; c < MAX_CHANS; c++)
+    {
+      fifo[c].assign(static_cast<size_t>(fifoSize), T(0));
+    }
+    fifoCount = 0;
+    latency = static_cast<int>(std::lround((up[0].GetDelay() + down[0].GetDelay()) * hostRate));
+  }
+
+  bool IsActive() const { return active; }
+
+  int GetMaxBlockSize() const { return maxBlock; }
+
+  /**
+   * Delay added by resampling in host frames
+   */
+  int GetLatency() const { return latency; }
+
+  /**
+   * Clear the filter histories, eg. on transport start
+   */
+  void Reset()
+  {
+    for(int c = 0; c < MAX_CHANS; c++)
+    {
+      up[c].Reset();
+      down[c].Reset();
+    }
+    fifoCount = 0;
+  }
+
+  /**
+   * Process nFrames (<= max block size) at the host rate
+   */
+  void Process(const T* const* inputs, T* const* outputs, int nChans, int nFrames)
+  {
+    if(!active)
+    {
+      processor.Process(inputs, outputs, nChans, nFrames);
+      return;
+    }
+
+    const int nModelChans = std::min(nChans, MAX_CHANS);
+    T** io = modelIo.GetBuffer();
+    int nModel = 0;
+
+    //To 48 kHz, process in place, back to the host rate behind what is already queued
+    for(int c = 0; c < nModelChans; c++)
+    {
+      nModel = up[c].Process(inputs[c], nFrames, io[c]);
+    }
+    processor.Process(io, io, nModelChans, nModel);
+
+    int nHost = 0;
+    for(int c = 0; c < nModelChans; c++)
+    {
+      nHost = down[c].Process(io[c], nModel, fifo[c].data() + fifoCount);
+    }
+    fifoCount += nHost;
+
+    const int n = std::min(nFrames, fifoCount);
+    for(int c = 0; c < nModelChans; c++)
+    {
+      std::copy(fifo[c].begin(), fifo[c].begin() + n, outputs[c]);
+      std::fill(outputs[c] + n, outputs[c] + nFrames, T(0));
+      std::copy(fifo[c].begin() + n, fifo[c].begin() + fifoCount, fifo[c].begin());
+    }
+    for(int c = nModelChans; c < nChans; c++)
+    {
+      std::fill(outputs[c], outputs[c] + nFrames, T(0));
+    }
+    fifoCount -= n;
+
+    //Meters at the host rate
+    T** meter = meters.GetBuffer();
+    T** in = processor.GetInputBuffer();
+    T** gr = processor.GetGrBuffer();
+    const bool bypassed = processor.IsBypassed();
+    for(int c = 0; c < MAX_CHANS; c++)
+    {
+      for(int s = 0; s < nFrames; s++)
+      {
+        const int m = std::min(nModel - 1, static_cast<int>(static_cast<long>(s) * nModel / nFrames));
+        const bool valid = !bypassed && c < nModelChans && m >= 0;
+        meter[c][s] = valid ? in[c][m] : T(0);
+        meter[MAX_CHANS + c][s] = valid ? gr[c][m] : T(0);
+      }
+    }
+  }
+
+  /**
+   * Gain-scaled input of the last block at the host rate, MAX_CHANS channels
+   */
+  T** GetInputBuffer() { return active ? meters.GetBuffer() : processor.GetInputBuffer(); }
+
+  /**
+   * Gain reduction of the last block at the host rate, MAX_CHANS channels
+   */
+  T** GetGrBuffer() { return active ? meters.GetBuffer() + MAX_CHANS : processor.GetGrBuffer(); }
+
+private:
+  NNProcessor<T, MAX_CHANS>& processor;
+  Resampler<T> up[MAX_CHANS];
+  Resampler<T> down[MAX_CHANS];
+  CustomAudioBuffer<T, MAX_CHANS> modelIo;
+  CustomAudioBuffer<T, 2 * MAX_CHANS> meters;
+  std::vector<T> fifo[MAX_CHANS];
+  int fifoSize = 0;
+  int fifoCount = 0;
+  int hostRate = kModelRate;
+  int maxBlock = 0;
+  int latency = 0;
+  bool active = false;
+};
@@ -0,0 +1,183 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+#include "Eigen/Dense"
+#include "layers.h"
+#include "RuntimeModelDesc.h"
+#include "JitKernel.h"
+
+/**
+ * One recurrent layer of a run-time model, the layers.h equations as dynamic size Eigen
+ * expressions. Init() allocates, Step() does not.
+ */
+struct RuntimeLayer
+{
+  RuntimeLayerType type;
+  int h;
+  Eigen::MatrixXf Wx;
+  Eigen::MatrixXf Wh;
+  Eigen::VectorXf bi;
+  Eigen::VectorXf bh;
+  Eigen::VectorXf gi; //gate pre-activations
+  Eigen::VectorXf gh; //gru recurrent products
+  Eigen::VectorXf ht;
+  Eigen::VectorXf ct;
+
+  void Init(const RuntimeLayerDesc& src)
+  {
+    type = src.type;
+    h = src.GetHidden();
+    Wx = src.Wx;
+    Wh = src.Wh;
+    bi = src.bi;
+    bh = src.bh;
+    gi = Eigen::VectorXf::Zero(src.bi.size());
+    gh = Eigen::VectorXf::Zero(src.bh.size());
+    ht = Eigen::VectorXf::Zero(h);
+    ct = Eigen::VectorXf::Zero(type == RuntimeLayerType::Lstm ? h : 0);
+  }
+
+  void Reset()
+  {
+    ht.setZero();
+    ct.setZero();
+  }
+
+  /**
+   * Advance one sample with input x, of Wx.cols() values
+   */
+  void Step(const float* x)
+  {
+    const Eigen::Map<const Eigen::VectorXf> xt(x, Wx.cols());
+    gi.noalias() = bi;
+    gi.noalias() += Wx * xt;
+    Recur();
+  }
+
+  /**
+   * Advance one sample with gi already holding bi + Wx * x
+   */
+  void Recur()
+  {
+    const bool gru = type == RuntimeLayerType::Gru;
+    if(gru)
+    {
+      gh.noalias() = bh;
+      gh.noalias() += Wh * ht;
+    }
+    else
+    {
+      gi.noalias() += Wh * ht;
+    }
+
+    auto sigmoid = [](float v) { return Sigmoid<float>(v); };
+    auto g = gi.array();
+    auto hta = ht.array();
+    if(type == RuntimeLayerType::Lstm)
+    {
+      auto cta = ct.array();
+      cta = g.segment(h, h).unaryExpr(sigmoid) * cta + g.segment(0, h).unaryExpr(sigmoid) * g.segment(2 * h, h).tanh();
+      hta = g.segment(3 * h, h).unaryExpr(sigmoid) * cta.tanh();
+    }
+    else if(gru)
+    {
+      auto gha = gh.array();
+      g.head(2 * h) = (g.head(2 * h) + gha.head(2 * h)).unaryExpr(sigmoid); //rt, zt
+      g.segment(2 * h, h) = (g.segment(2 * h, h) + g.head(h) * gha.segment(2 * h, h)).tanh(); //nt
+      hta = (1.f - g.segment(h, h)) * g.segment(2 * h, h) + g.segment(h, h) * hta;
+    }
+    else
+    {
+      hta = g.tanh();
+    }
+  }
+};
+
+/**
+ * Block processor for a RuntimeModelDesc. Init() allocates everything, ProcessBlock() does not
+ * allocate. With the JIT enabled and supported the model runs as code generated for its
+ * weights (see JitKernel.h). Otherwise it is interpreted with dynamic size Eigen expressions
+ * of the layers.h equations, the layers scheduled as a wavefront (see Wavefront.h).
+ */
+class RuntimeModel
+{
+public:
+  /**
+   * Set up the model, generating code for it if useJit is set and the build and CPU support
+   * it. Not realtime safe.
+   */
+  bool Init(const RuntimeModelDesc& desc, bool useJit, std::string& error)
+  {
+    if(!desc.Validate(error)) return false;
+    kernel = JitModelKernel();
+    if(useJit && kernel.Compile(desc))
+    {
+      state = Eigen::VectorXf::Zero(kernel.GetStateSize());
+    }
+
+    layers.clear();
+    layers.resize(desc.layers.size());
+    for(size_t j = 0; j < desc.layers.size(); j++) layers[j].Init(desc.layers[j]);
+    A = desc.A;
+    b = desc.b;
+    return true;
+  }
+
+  /**
+   * Return the recurrent state to zero
+   */
+  void Reset()
+  {
+    state.setZero();
+    for(RuntimeLayer& l : layers) l.Reset();
+  }
+
+  /**
+   * Process nFrames samples from x into y
+   */
+  void ProcessBlock(const float* x, float* y, int nFrames)
+  {
+    if(kernel)
+    {
+      kernel.Run(x, y, nFrames, state.data());
+      return;
+    }
+
+    const int L = static_cast<int>(layers.size());
+    for(int k = 0; k < nFrames + L - 1; k++)
+    {
+      //Top down so every layer reads the output of the layer below before it is overwritten
+      for(int j = std::min(L - 1, k); j >= 0; j--)
+      {
+        const int t = k - j;
+        if(t >= nFrames) break;
+        layers[j].Step(j == 0 ? x + t : layers[j - 1].ht.data());
+      }
+      const int t = k - L + 1;
+      if(t >= 0) y[t] = std::tanh(A.dot(layers.back().ht) + b);
+    }
+  }
+
+  void apply_model(float* x, float* y) { ProcessBlock(x, y, 1); }
+
+  /**
+   * True if the model runs as generated code
+   */
+  bool IsJit() const { return static_cast<bool>(kernel); }
+
+  /**
+   * Generated code and weight bytes, 0 without the JIT
+   */
+  size_t GetJitBytes() const { return kernel.GetCodeBytes() + kernel.GetDataBytes(); }
+
+  int GetNumLayers() const { return static_cast<int>(layers.size()); }
+
+private:
+  std::vector<RuntimeLayer> layers;
+  Eigen::VectorXf A;
+  float b = 0.f;
+  JitModelKernel kernel;
+  Eigen::VectorXf state; //arena of the generated code
+};
@@ -0,0 +1,295 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "Eigen/Dense"
+#include "layers.h"
+#include "ModelState.h"
+
+/**
+ * Models loaded at run time. A RuntimeModelDesc holds the weights of a stack of lstm, gru and
+ * rnn layers followed by the output layer, with sizes only known at run time (the layer types
+ * and widths may differ from layer to layer). It is read from and written to .nncm files, or
+ * taken from a compiled model with DescribeModel. RuntimeModel.h runs it.
+ */
+
+enum class RuntimeLayerType
+{
+  Lstm = 0,
+  Gru = 1,
+  Rnn = 2
+};
+
+inline int RuntimeGates(RuntimeLayerType type)
+{
+  return type == RuntimeLayerType::Lstm ? 4 : type == RuntimeLayerType::Gru ? 3 : 1;
+}
+
+inline const char* RuntimeLayerName(RuntimeLayerType type)
+{
+  return type == RuntimeLayerType::Lstm ? "lstm" : type == RuntimeLayerType::Gru ? "gru" : "rnn";
+}
+
+/**
+ * Little-endian 32 bit values of the .nncm and .nncg files
+ */
+inline bool WriteInt32(FILE* file, int32_t v) { return fwrite(&v, sizeof(v), 1, file) == 1; }
+inline bool ReadInt32(FILE* file, int32_t& v) { return fread(&v, sizeof(v), 1, file) == 1; }
+inline bool WriteFloats(FILE* file, const float* v, Eigen::Index n) { return n == 0 || fwrite(v, sizeof(float), n, file) == static_cast<size_t>(n); }
+inline bool ReadFloats(FILE* file, float* v, Eigen::Index n) { return n == 0 || fread(v, sizeof(float), n, file) == static_cast<size_t>(n); }
+
+/**
+ * Weights of one recurrent layer, gates stacked i, f, g, o (lstm) or r, z, n (gru)
+ */
+struct RuntimeLayerDesc
+{
+  RuntimeLayerType type = RuntimeLayerType::Lstm;
+  Eigen::MatrixXf Wx; //gates * h x d
+  Eigen::MatrixXf Wh; //gates * h x h
+  Eigen::VectorXf bi; //folded biases, except bhn of the gru new gate
+  Eigen::VectorXf bh; //gru: zero for r and z, bhn for n; empty otherwise
+
+  int GetHidden() const { return static_cast<int>(Wh.cols()); }
+  int GetInputs() const { return static_cast<int>(Wx.cols()); }
+
+  /**
+   * Write the type, hidden and input size and Wx, Wh, bi, bh in column-major order
+   */
+  bool Write(FILE* file) const
+  {
+    bool ok = WriteInt32(file, static_cast<int32_t>(type)) && WriteInt32(file, GetHidden()) && WriteInt32(file, GetInputs());
+    ok = ok && WriteFloats(file, Wx.data(), Wx.size()) && WriteFloats(file, Wh.data(), Wh.size());
+    return ok && WriteFloats(file, bi.data(), bi.size()) && WriteFloats(file, bh.data(), bh.size());
+  }
+
+  /**
+   * Read a layer written by Write, with sizes up to maxSize
+   */
+  bool Read(FILE* file, int32_t maxSize)
+  {
+    int32_t t, h, d;
+    if(!ReadInt32(file, t) || t < 0 || t > 2 || !ReadInt32(file, h) || !ReadInt32(file, d)) return false;
+    if(h < 1 || h > maxSize || d < 1 || d > maxSize) return false;
+    type = static_cast<RuntimeLayerType>(t);
+    const int rows = RuntimeGates(type) * h;
+    Wx.resize(rows, d);
+    Wh.resize(rows, h);
+    bi.resize(rows);
+    bh.resize(type == RuntimeLayerType::Gru ? rows : 0);
+    if(!ReadFloats(file, Wx.data(), Wx.size()) || !ReadFloats(file, Wh.data(), Wh.size())) return false;
+    return ReadFloats(file, bi.data(), bi.size()) && ReadFloats(file, bh.data(), bh.size());
+  }
+};
+
+struct RuntimeModelDesc
+{
+  std::vector<RuntimeLayerDesc> layers;
+  Eigen::VectorXf A; //output weights
+  float b = 0.f;
+
+  /**
+   * Check that the sizes of all weights agree
+   */
+  bool Validate(std::string& error) const
+  {
+    if(layers.empty())
+    {
+      error = "model has no layers";
+      return false;
+    }
+    int d = 1;
+    for(size_t j = 0; j < layers.size(); j++)
+    {
+      const RuntimeLayerDesc& l = layers[j];
+      const int h = l.GetHidden();
+      const int rows = RuntimeGates(l.type) * h;
+      const bool gru = l.type == RuntimeLayerType::Gru;
+      if(h < 1 || l.Wx.rows() != rows || l.Wx.cols() != d || l.Wh.rows() != rows || l.bi.size() != rows || l.bh.size() != (gru ? rows : 0))
+      {
+        error = "layer " + std::to_string(j) + " has inconsistent weight sizes";
+        return false;
+      }
+      d = h;
+    }
+    if(A.size() != d)
+    {
+      error = "output layer does not match the last layer";
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * Write the model as .nncm: "NNCM", version, layer count, then per layer its type, hidden
+   * and input size and Wx, Wh, bi, bh in column-major order, then A and b. Little-endian
+   * 32 bit integers and floats.
+   */
+  bool Save(const std::string& path, std::string& error) const
+  {
+    if(!Validate(error)) return false;
+    FILE* file = fopen(path.c_str(), "wb");
+    if(!file)
+    {
+      error = "cannot open " + path;
+      return false;
+    }
+    bool ok = fwrite(kMagic, 1, 4, file) == 4 && WriteInt32(file, kVersion) && WriteInt32(file, static_cast<int32_t>(layers.size()));
+    for(const RuntimeLayerDesc& l : layers) ok = ok && l.Write(file);
+    ok = ok && WriteFloats(file, A.data(), A.size()) && WriteFloats(file, &b, 1);
+    if(fclose(file) != 0 || !ok)
+    {
+      error = "failed writing " + path;
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * Read a .nncm file written by Save
+   */
+  bool Load(const std::string& path, std::string& error)
+  {
+    FILE* file = fopen(path.c_str(), "rb");
+    if(!file)
+    {
+      error = "cannot open " + path;
+      return false;
+    }
+    const bool ok = Read(file);
+    fclose(file);
+    if(!ok)
+    {
+      error = path + ": not a valid .nncm file";
+      return false;
+    }
+    return Validate(error);
+  }
+
+private:
+  static constexpr char kMagic[4] = {'N', 'N', 'C', 'M'};
+  static constexpr int32_t kVersion = 1;
+  static constexpr int32_t kMaxSize = 4096; //sanity limit for widths read from a file
+
+  bool Read(FILE* file)
+  {
+    char magic[4];
+    int32_t version, nLayers;
+    if(fread(magic, 1, 4, file) != 4 || std::string(magic, 4) != std::string(kMagic, 4)) return false;
+    if(!ReadInt32(file, version) || version != kVersion || !ReadInt32(file, nLayers) || nLayers < 1 || nLayers > 64) return false;
+
+    layers.assign(nLayers, RuntimeLayerDesc());
+    for(RuntimeLayerDesc& l : layers)
+    {
+      if(!l.Read(file, kMaxSize)) return false;
+    }
+    A.resize(layers.back().GetHidden());
+    return ReadFloats(file, A.data(), A.size()) && ReadFloats(file, &b, 1);
+  }
+};
+
+template<typename T, int h, int d>
+RuntimeLayerDesc DescribeLayer(const LstmLayer<T, h, d>& l)
+{
+  RuntimeLayerDesc r;
+  r.type = RuntimeLayerType::Lstm;
+  r.Wx.resize(4 * h, d);
+  r.Wh.resize(4 * h, h);
+  r.bi.resize(4 * h);
+  r.Wx << l.Wii.template cast<float>(), l.Wif.template cast<float>(), l.Wig.template cast<float>(), l.Wio.template cast<float>();
+  r.Wh << l.Whi.template cast<float>(), l.Whf.template cast<float>(), l.Whg.template cast<float>(), l.Who.template cast<float>();
+  r.bi << (l.bii + l.bhi).template cast<float>(), (l.bif + l.bhf).template cast<float>(), (l.big + l.bhg).template cast<float>(), (l.bio + l.bho).template cast<float>();
+  return r;
+}
+
+template<typename T, int h, int d>
+RuntimeLayerDesc DescribeLayer(const GruLayer<T, h, d>& l)
+{
+  RuntimeLayerDesc r;
+  r.type = RuntimeLayerType::Gru;
+  r.Wx.resize(3 * h, d);
+  r.Wh.resize(3 * h, h);
+  r.bi.resize(3 * h);
+  r.bh = Eigen::VectorXf::Zero(3 * h);
+  r.Wx << l.Wir.template cast<float>(), l.Wiz.template cast<float>(), l.Win.template cast<float>();
+  r.Wh << l.Whr.template cast<float>(), l.Whz.template cast<float>(), l.Whn.template cast<float>();
+  r.bi << (l.bir + l.bhr).template cast<float>(), (l.biz + l.bhz).template cast<float>(), l.bin.template cast<float>();
+  r.bh.tail(h) = l.bhn.template cast<float>();
+  return r;
+}
+
+template<typename T, int h, int d>
+RuntimeLayerDesc DescribeLayer(const RnnLayer<T, h, d>& l)
+{
+  RuntimeLayerDesc r;
+  r.type = RuntimeLayerType::Rnn;
+  r.Wx = l.Wih.template cast<float>();
+  r.Wh = l.Whh.template cast<float>();
+  r.bi = (l.bih + l.bhh).template cast<float>();
+  return r;
+}
+
+/**
+ * Weights of a run-time layer into a layers.h layer of the same shape, the inverse of
+ * DescribeLayer. The folded biases go to the input biases.
+ */
+template<typename T, int h, int d>
+void LoadLayer(const RuntimeLayerDesc& r, LstmLayer<T, h, d>& l)
+{
+  l.Wii = r.Wx.middleRows(0, h).template cast<T>();
+  l.Wif = r.Wx.middleRows(h, h).template cast<T>();
+  l.Wig = r.Wx.middleRows(2 * h, h).template cast<T>();
+  l.Wio = r.Wx.middleRows(3 * h, h).template cast<T>();
+  l.Whi = r.Wh.middleRows(0, h).template cast<T>();
+  l.Whf = r.Wh.middleRows(h, h).template cast<T>();
+  l.Whg = r.Wh.middleRows(2 * h, h).template cast<T>();
+  l.Who = r.Wh.middleRows(3 * h, h).template cast<T>();
+  l.bii = r.bi.segment(0, h).template cast<T>();
+  l.bif = r.bi.segment(h, h).template cast<T>();
+  l.big = r.bi.segment(2 * h, h).template cast<T>();
+  l.bio = r.bi.segment(3 * h, h).template cast<T>();
+  l.bhi.setZero();
+  l.bhf.setZero();
+  l.bhg.setZero();
+  l.bho.setZero();
+}
+
+template<typename T, int h, int d>
+void LoadLayer(const RuntimeLayerDesc& r, GruLayer<T, h, d>& l)
+{
+  l.Wir = r.Wx.middleRows(0, h).template cast<T>();
+  l.Wiz = r.Wx.middleRows(h, h).template cast<T>();
+  l.Win = r.Wx.middleRows(2 * h, h).template cast<T>();
+  l.Whr = r.Wh.middleRows(0, h).template cast<T>();
+  l.Whz = r.Wh.middleRows(h, h).template cast<T>();
+  l.Whn = r.Wh.middleRows(2 * h, h).template cast<T>();
+  l.bir = r.bi.segment(0, h).template cast<T>();
+  l.biz = r.bi.segment(h, h).template cast<T>();
+  l.bin = r.bi.segment(2 * h, h).template cast<T>();
+  l.bhr.setZero();
+  l.bhz.setZero();
+  l.bhn = r.bh.segment(2 * h, h).template cast<T>();
+}
+
+template<typename T, int h, int d>
+void LoadLayer(const RuntimeLayerDesc& r, RnnLayer<T, h, d>& l)
+{
+  l.Wih = r.Wx.template cast<T>();
+  l.Whh = r.Wh.template cast<T>();
+  l.bih = r.bi.template cast<T>();
+  l.bhh.setZero();
+}
+
+/**
+ * Weights of a compiled model (eg. Lstm_32_1<float>) as a run-time model
+ */
+template<typename M>
+RuntimeModelDesc DescribeModel(const M& m)
+{
+  RuntimeModelDesc r;
+  ForEachLayer(m, [&](const auto& l) { r.layers.push_back(DescribeLayer(l)); });
+  r.A = m.f.A.col(0).template cast<float>();
+  r.b = static_cast<float>(m.f.b(0));
+  return r;
+}
@@ -0,0 +1,135 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include "ModelState.h"
+#include "Wavefront.h"
+
+/**
+ * Skips model evaluation on idle input.
+ * Once the input has been below the threshold and the recurrent state has moved less than
+ * epsilon per sample for holdSamples in a row, the model is considered to be sitting on its
+ * fixed point and the cached output is emitted instead. Evaluation resumes on the first
+ * sample above the threshold. Convergence is only measured on silent runs of at least
+ * kMinSilentRun samples, so blocks of program material stay on the wavefront path.
+ * T - Type
+ */
+template<typename T>
+class SilenceGate
+{
+public:
+  static constexpr int kMaxState = 2 * 32 * 4; //4 lstm layers of 32 units
+
+  SilenceGate() {}
+
+  /**
+   * threshold - input magnitude treated as silence (0 = digital silence only)
+   * epsilon - largest per sample state change treated as converged
+   * holdSamples - number of converged samples required before gating
+   */
+  void Set(T threshold, T epsilon, int holdSamples)
+  {
+    this->threshold = threshold;
+    this->epsilon = epsilon;
+    this->holdSamples = std::max(1, holdSamples);
+    Reset();
+  }
+
+  void SetEnabled(bool enable)
+  {
+    enabled = enable;
+    Reset();
+  }
+
+  /**
+   * Forget convergence, eg. after a model change or a state reset
+   */
+  void Reset()
+  {
+    gated = false;
+    count = 0;
+    silentRun = 0;
+  }
+
+  bool IsEnabled() const { return enabled; }
+  bool IsGated() const { return gated; }
+
+  /**
+   * Process a block through model m
+   */
+  template<typename M>
+  void Process(M& m, T* x, T* y, const int nFrames)
+  {
+    static_assert(ModelStateSize<M>() <= kMaxState, "SilenceGate takes models of up to kMaxState state values");
+    int start = 0;
+    if(enabled && gated)
+    {
+      while(start < nFrames && IsSilent(x[start])) y[start++] = cachedY;
+      if(start == nFrames) return;
+      gated = false;
+      count = 0;
+      silentRun = 0;
+    }
+
+    //Only a silent run reaching the end of the block and at least kMinSilentRun long is
+    //measured sample by sample, the rest of the block takes the wavefront path
+    int tail = nFrames;
+    if(enabled)
+    {
+      while(tail > start && IsSilent(x[tail - 1])) tail--;
+      silentRun = (tail == start ? silentRun : 0) + nFrames - tail;
+      if(silentRun < kMinSilentRun) tail = nFrames;
+    }
+    if(tail > start)
+    {
+      ApplyModelWavefront(m, x + start, y + start, tail - start);
+      count = 0;
+    }
+
+    for(int s = tail; s < nFrames; s++)
+    {
+      if(gated)
+      {
+        y[s] = cachedY;
+        continue;
+      }
+
+      //Silent, run the model and measure how far the state moves
+      int n = 0;
+      ForEachState(m, [&](const auto& v) {
+        for(int i = 0; i < v.size(); i++) snapshot[n++] = v[i];
+      });
+
+      m.apply_model(&x[s], &y[s]);
+
+      T delta = 0;
+      n = 0;
+      ForEachState(m, [&](const auto& v) {
+        for(int i = 0; i < v.size(); i++) delta = std::max(delta, std::abs(v[i] - snapshot[n++]));
+      });
+
+      count = delta <= epsilon ? count + 1 : 0;
+      if(count >= holdSamples)
+      {
+        gated = true;
+        cachedY = y[s];
+      }
+    }
+  }
+
+private:
+  //Shorter silent runs, eg. zero crossings, do not leave the wavefront path
+  static constexpr int kMinSilentRun = 32;
+
+  bool IsSilent(T v) const { return std::abs(v) <= threshold; }
+
+  std::array<T, kMaxState> snapshot;
+  T threshold = 0;
+  T epsilon = T(1e-7);
+  T cachedY = 0;
+  int holdSamples = 64;
+  int count = 0;
+  int silentRun = 0; //silent samples at the end of the last block
+  bool enabled = false;
+  bool gated = false;
+};
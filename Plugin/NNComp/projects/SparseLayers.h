@@ -0,0 +1,271 @@
+#pragma once
+#include <array>
+#include "Eigen/Dense"
+#include "layers.h"
+#include "ModelState.h"
+
+/**
+ * Recurrent layers with block-sparse weights, emitted by Tools/nncomp_prune.
+ * The gate weights of a layer are stacked (i, f, g, o for lstm, r, z, n for gru) and split
+ * into blocks of 8 rows by 4 columns (fewer columns for 1 and 2 column matrices). Only the
+ * blocks holding a nonzero weight are stored, ordered by column, and each is a fixed size
+ * product Eigen vectorises, accumulated straight into the output so consecutive blocks
+ * mostly update different rows and do not wait on each other. Pruned blocks cost nothing,
+ * but a stored block is slower per weight than a dense product, so at these matrix sizes a
+ * layer only gets faster once more than about 60% of its blocks are pruned.
+ * The block count of every matrix is a template parameter, so the storage is fixed size and
+ * nothing is allocated. Headers set each matrix from its dense pruned form with Set(), zeros
+ * included, which keeps them readable. The layers have the same interface and state members
+ * as the ones in layers.h, so pruned models work with apply_model, the wavefront and the
+ * ModelState helpers.
+ */
+
+constexpr int kSparseBlockRows = 8;
+
+/**
+ * Block width for a matrix with cols columns
+ */
+constexpr int SparseBlockCols(int cols) { return cols < 4 ? cols : 4; }
+
+/**
+ * Number of blocks of W holding a nonzero weight
+ */
+template<typename D>
+int CountSparseBlocks(const Eigen::MatrixBase<D>& W)
+{
+  const int rows = static_cast<int>(W.rows());
+  const int cols = static_cast<int>(W.cols());
+  const int bc = SparseBlockCols(cols);
+  int n = 0;
+  for(int c = 0; c < cols; c += bc)
+  {
+    for(int r = 0; r < rows; r += kSparseBlockRows)
+    {
+      if((W.block(r, c, std::min(kSparseBlockRows, rows - r), bc).array() != 0).any()) n++;
+    }
+  }
+  return n;
+}
+
+/**
+ * Fixed size block-sparse matrix
+ * T - Type
+ * rows, cols - dense size, cols must be 1, 2 or a multiple of 4
+ * nBlocks - number of stored blocks
+ */
+template<typename T, int rows, int cols, int nBlocks>
+class BlockSparseMatrix
+{
+public:
+  static constexpr int kBlockCols = SparseBlockCols(cols);
+  static constexpr int kPaddedRows = (rows + kSparseBlockRows - 1) / kSparseBlockRows * kSparseBlockRows; //Size of the output of Apply()
+  static_assert(cols % kBlockCols == 0, "Columns must be 1, 2 or a multiple of 4");
+
+  BlockSparseMatrix()
+  {
+    values.setZero();
+    blockRow.fill(0);
+    blockCol.fill(0);
+  }
+
+  /**
+   * Pack the nonzero blocks of W. Returns false if W does not have exactly nBlocks of them,
+   * blocks beyond nBlocks are dropped.
+   */
+  bool Set(const Eigen::Matrix<T, rows, cols>& W)
+  {
+    Eigen::Matrix<T, kPaddedRows, cols> padded;
+    padded.setZero();
+    padded.template topRows<rows>() = W;
+
+    int k = 0;
+    for(int c = 0; c < cols; c += kBlockCols)
+    {
+      for(int r = 0; r < rows && k < nBlocks; r += kSparseBlockRows)
+      {
+        const auto block = padded.template block<kSparseBlockRows, kBlockCols>(r, c);
+        if((block.array() != T(0)).any())
+        {
+          values.template middleCols<kBlockCols>(k * kBlockCols) = block;
+          blockRow[k] = r;
+          blockCol[k++] = c;
+        }
+      }
+    }
+    return k == nBlocks && CountSparseBlocks(W) == nBlocks;
+  }
+
+  /**
+   * y = W * x, y has kPaddedRows rows
+   */
+  template<typename X, typename Y>
+  void Apply(const X& x, Y& y) const
+  {
+    y.setZero();
+    for(int k = 0; k < nBlocks; k++)
+    {
+      y.template segment<kSparseBlockRows>(blockRow[k]).noalias() +=
+        values.template middleCols<kBlockCols>(k * kBlockCols) * x.template segment<kBlockCols>(blockCol[k]);
+    }
+  }
+
+  Eigen::Matrix<T, kSparseBlockRows, kBlockCols * nBlocks> values;
+  std::array<int, nBlocks> blockRow; //First row of each block
+  std::array<int, nBlocks> blockCol; //First column of each block
+};
+
+/**
+ * Lstm layer with block-sparse weights.
+ * T - Type
+ * h - hidden size
+ * d - input size
+ * ni - stored blocks of the stacked input weights
+ * nh - stored blocks of the stacked recurrent weights
+ */
+template<typename T, int h, int d, int ni, int nh>
+class SparseLstmLayer {
+public:
+  void apply_layer(Eigen::Vector<T, d> x) {
+    xt = x;
+    Step();
+  }
+
+  void apply_layer(T x) {
+    xt = xt.Constant(x);
+    Step();
+  }
+
+  BlockSparseMatrix<T, 4 * h, d, ni> Wi;
+  BlockSparseMatrix<T, 4 * h, h, nh> Wh;
+  Eigen::Vector<T, 4 * h> b; //bii + bhi, ..., bio + bho
+
+  Eigen::Vector<T, BlockSparseMatrix<T, 4 * h, d, ni>::kPaddedRows> gi;
+  Eigen::Vector<T, BlockSparseMatrix<T, 4 * h, h, nh>::kPaddedRows> gh;
+  Eigen::Vector<T, h> it;
+  Eigen::Vector<T, h> ft;
+  Eigen::Vector<T, h> gt;
+  Eigen::Vector<T, h> ot;
+  Eigen::Vector<T, h> ct;
+  Eigen::Vector<T, h> ht;
+
+  Eigen::Vector<T, d> xt;
+
+  Eigen::Vector<T, h> ctn1;
+  Eigen::Vector<T, h> htn1;
+
+private:
+  void Step() {
+    Wi.Apply(xt, gi);
+    Wh.Apply(htn1, gh);
+    gi.template head<4 * h>() += gh.template head<4 * h>() + b;
+    it = gi.template segment<h>(0).unaryExpr(std::ref(Sigmoid<T>));
+    ft = gi.template segment<h>(h).unaryExpr(std::ref(Sigmoid<T>));
+    gt = gi.template segment<h>(2 * h).array().tanh();
+    ot = gi.template segment<h>(3 * h).unaryExpr(std::ref(Sigmoid<T>));
+    ct = ft.cwiseProduct(ctn1) + it.cwiseProduct(gt);
+    ht = ct.array().tanh();
+    ht = ot.cwiseProduct(ht);
+    htn1 = ht;
+    ctn1 = ct;
+  }
+};
+
+/**
+ * Gru layer with block-sparse weights.
+ * T - Type
+ * h - hidden size
+ * d - input size
+ * ni - stored blocks of the stacked input weights
+ * nh - stored blocks of the stacked recurrent weights
+ */
+template<typename T, int h, int d, int ni, int nh>
+class SparseGruLayer {
+public:
+  void apply_layer(Eigen::Vector<T, d> x) {
+    xt = x;
+    Step();
+  }
+
+  void apply_layer(T x) {
+    xt = xt.Constant(x);
+    Step();
+  }
+
+  BlockSparseMatrix<T, 3 * h, d, ni> Wi;
+  BlockSparseMatrix<T, 3 * h, h, nh> Wh;
+  Eigen::Vector<T, 3 * h> bi; //bir, biz, bin
+  Eigen::Vector<T, 3 * h> bh; //bhr, bhz, bhn, the reset gate scales bhn
+
+  Eigen::Vector<T, BlockSparseMatrix<T, 3 * h, d, ni>::kPaddedRows> gi;
+  Eigen::Vector<T, BlockSparseMatrix<T, 3 * h, h, nh>::kPaddedRows> gh;
+  Eigen::Vector<T, h> rt;
+  Eigen::Vector<T, h> zt;
+  Eigen::Vector<T, h> nt;
+  Eigen::Vector<T, h> ht;
+
+  Eigen::Vector<T, d> xt;
+
+  Eigen::Vector<T, h> htn1;
+
+private:
+  void Step() {
+    Wi.Apply(xt, gi);
+    Wh.Apply(htn1, gh);
+    gi.template head<3 * h>() += bi;
+    gh.template head<3 * h>() += bh;
+    rt = (gi.template segment<h>(0) + gh.template segment<h>(0)).unaryExpr(std::ref(Sigmoid<T>));
+    zt = (gi.template segment<h>(h) + gh.template segment<h>(h)).unaryExpr(std::ref(Sigmoid<T>));
+    nt = (gi.template segment<h>(2 * h) + rt.cwiseProduct(gh.template segment<h>(2 * h))).array().tanh();
+    ht = (ht.Constant(1) - zt).cwiseProduct(nt) + zt.cwiseProduct(htn1);
+    htn1 = ht;
+  }
+};
+
+/**
+ * Rnn layer with block-sparse weights.
+ * T - Type
+ * h - hidden size
+ * d - input size
+ * ni - stored blocks of the input weights
+ * nh - stored blocks of the recurrent weights
+ */
+template<typename T, int h, int d, int ni, int nh>
+class SparseRnnLayer {
+public:
+  void apply_layer(Eigen::Vector<T, d> x) {
+    xt = x;
+    Step();
+  }
+
+  void apply_layer(T x) {
+    xt = xt.Constant(x);
+    Step();
+  }
+
+  BlockSparseMatrix<T, h, d, ni> Wi;
+  BlockSparseMatrix<T, h, h, nh> Wh;
+  Eigen::Vector<T, h> b; //bih + bhh
+
+  Eigen::Vector<T, BlockSparseMatrix<T, h, d, ni>::kPaddedRows> gi;
+  Eigen::Vector<T, BlockSparseMatrix<T, h, h, nh>::kPaddedRows> gh;
+  Eigen::Vector<T, h> ht;
+
+  Eigen::Vector<T, d> xt;
+
+  Eigen::Vector<T, h> htn1;
+
+private:
+  void Step() {
+    Wi.Apply(xt, gi);
+    Wh.Apply(htn1, gh);
+    ht = (gi.template head<h>() + gh.template head<h>() + b).array().tanh();
+    htn1 = ht;
+  }
+};
+
+template<typename T, int h, int d, int ni, int nh, typename F>
+void ForEachLayerState(SparseLstmLayer<T, h, d, ni, nh>& l, F&& f)
+{
+  f(l.htn1);
+  f(l.ctn1);
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/**
+ * Lock-free single producer single consumer ring buffer.
+ * Items are written in place and published in batches so a whole chunk costs one
+ * release store. Capacity is rounded up to a power of two. Allocation only happens
+ * in the constructor.
+ * V - Item type
+ */
+template<typename V>
+class SpscRing
+{
+public:
+  explicit SpscRing(size_t minCapacity)
+  {
+    size_t capacity = 1;
+    while(capacity < minCapacity) capacity <<= 1;
+    items.resize(capacity);
+    mask = capacity - 1;
+  }
+
+  size_t Capacity() const { return mask + 1; }
+
+  //Producer side
+
+  /**
+   * Number of free slots the producer may write
+   */
+  size_t WriteAvailable() const
+  {
+    return Capacity() - (head.load(std::memory_order_relaxed) - tail.load(std::memory_order_acquire));
+  }
+
+  /**
+   * Slot i past the last published item, i < WriteAvailable()
+   */
+  V& WriteSlot(size_t i)
+  {
+    return items[(head.load(std::memory_order_relaxed) + i) & mask];
+  }
+
+  /**
+   * Make n written slots visible to the consumer
+   */
+  void Publish(size_t n)
+  {
+    head.store(head.load(std::memory_order_relaxed) + n, std::memory_order_release);
+  }
+
+  /**
+   * Copy one item in, returns false if full
+   */
+  bool Push(const V& item)
+  {
+    if(WriteAvailable() == 0) return false;
+    WriteSlot(0) = item;
+    Publish(1);
+    return true;
+  }
+
+  //Consumer side
+
+  /**
+   * Number of published items the consumer may read
+   */
+  size_t ReadAvailable() const
+  {
+    return head.load(std::memory_order_acquire) - tail.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Item i from the front, i < ReadAvailable()
+   */
+  const V& ReadSlot(size_t i) const
+  {
+    return items[(tail.load(std::memory_order_relaxed) + i) & mask];
+  }
+
+  /**
+   * Release n items back to the producer
+   */
+  void Consume(size_t n)
+  {
+    tail.store(tail.load(std::memory_order_relaxed) + n, std::memory_order_release);
+  }
+
+  /**
+   * Copy one item out, returns false if empty
+   */
+  bool Pop(V& item)
+  {
+    if(ReadAvailable() == 0) return false;
+    item = ReadSlot(0);
+    Consume(1);
+    return true;
+  }
+
+private:
+  std::vector<V> items;
+  size_t mask = 0;
+  alignas(64) std::atomic<size_t> head {0};
+  alignas(64) std::atomic<size_t> tail {0};
+};
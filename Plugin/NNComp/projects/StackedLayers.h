@@ -0,0 +1,160 @@
+#pragma once
+#include "Eigen/Dense"
+#include "layers.h"
+#include "ModelState.h"
+
+/**
+ * Dense recurrent layers with stacked gate weights and folded biases, emitted by
+ * Tools/nncomp_optimize. The gate weights of a layer are stacked (i, f, g, o for lstm, r, z, n
+ * for gru) into one input and one recurrent matrix, so a step is two matrix-vector products
+ * instead of one per gate, and the input and recurrent bias pairs are summed into one bias
+ * wherever the gate equations allow it. The gru new gate keeps bhn apart since the reset gate
+ * scales it. The layers have the same interface and state members as the ones in layers.h,
+ * so optimized models work with apply_model, the wavefront and the ModelState helpers.
+ */
+
+/**
+ * Lstm layer with stacked weights.
+ * T - Type
+ * h - hidden size
+ * d - input size
+ */
+template<typename T, int h, int d>
+class StackedLstmLayer {
+public:
+  void apply_layer(Eigen::Vector<T, d> x) {
+    xt = x;
+    Step();
+  }
+
+  void apply_layer(T x) {
+    xt = xt.Constant(x);
+    Step();
+  }
+
+  Eigen::Matrix<T, 4 * h, d> Wi;
+  Eigen::Matrix<T, 4 * h, h> Wh;
+  Eigen::Vector<T, 4 * h> b; //bii + bhi, ..., bio + bho
+
+  Eigen::Vector<T, 4 * h> g;
+  Eigen::Vector<T, h> it;
+  Eigen::Vector<T, h> ft;
+  Eigen::Vector<T, h> gt;
+  Eigen::Vector<T, h> ot;
+  Eigen::Vector<T, h> ct;
+  Eigen::Vector<T, h> ht;
+
+  Eigen::Vector<T, d> xt;
+
+  Eigen::Vector<T, h> ctn1;
+  Eigen::Vector<T, h> htn1;
+
+private:
+  void Step() {
+    g.noalias() = Wi * xt + b;
+    g.noalias() += Wh * htn1;
+    it = g.template segment<h>(0).unaryExpr(std::ref(Sigmoid<T>));
+    ft = g.template segment<h>(h).unaryExpr(std::ref(Sigmoid<T>));
+    gt = g.template segment<h>(2 * h).array().tanh();
+    ot = g.template segment<h>(3 * h).unaryExpr(std::ref(Sigmoid<T>));
+    ct = ft.cwiseProduct(ctn1) + it.cwiseProduct(gt);
+    ht = ct.array().tanh();
+    ht = ot.cwiseProduct(ht);
+    htn1 = ht;
+    ctn1 = ct;
+  }
+};
+
+/**
+ * Gru layer with stacked weights.
+ * T - Type
+ * h - hidden size
+ * d - input size
+ */
+template<typename T, int h, int d>
+class StackedGruLayer {
+public:
+  void apply_layer(Eigen::Vector<T, d> x) {
+    xt = x;
+    Step();
+  }
+
+  void apply_layer(T x) {
+    xt = xt.Constant(x);
+    Step();
+  }
+
+  Eigen::Matrix<T, 3 * h, d> Wi;
+  Eigen::Matrix<T, 3 * h, h> Wh;
+  Eigen::Vector<T, 2 * h> b; //bir + bhr, biz + bhz
+  Eigen::Vector<T, h> bin;
+  Eigen::Vector<T, h> bhn; //Scaled by the reset gate
+
+  Eigen::Vector<T, 3 * h> gi;
+  Eigen::Vector<T, 3 * h> gh;
+  Eigen::Vector<T, h> rt;
+  Eigen::Vector<T, h> zt;
+  Eigen::Vector<T, h> nt;
+  Eigen::Vector<T, h> ht;
+
+  Eigen::Vector<T, d> xt;
+
+  Eigen::Vector<T, h> htn1;
+
+private:
+  void Step() {
+    gi.noalias() = Wi * xt;
+    gh.noalias() = Wh * htn1;
+    rt = (gi.template segment<h>(0) + gh.template segment<h>(0) + b.template segment<h>(0)).unaryExpr(std::ref(Sigmoid<T>));
+    zt = (gi.template segment<h>(h) + gh.template segment<h>(h) + b.template segment<h>(h)).unaryExpr(std::ref(Sigmoid<T>));
+    nt = (gi.template segment<h>(2 * h) + bin + rt.cwiseProduct(gh.template segment<h>(2 * h) + bhn)).array().tanh();
+    ht = (ht.Constant(1) - zt).cwiseProduct(nt) + zt.cwiseProduct(htn1);
+    htn1 = ht;
+  }
+};
+
+/**
+ * Rnn layer with a folded bias.
+ * T - Type
+ * h - hidden size
+ * d - input size
+ */
+template<typename T, int h, int d>
+class StackedRnnLayer {
+public:
+  void apply_layer(Eigen::Vector<T, d> x) {
+    xt = x;
+    Step();
+  }
+
+  void apply_layer(T x) {
+    xt = xt.Constant(x);
+    Step();
+  }
+
+  Eigen::Matrix<T, h, d> Wi;
+  Eigen::Matrix<T, h, h> Wh;
+  Eigen::Vector<T, h> b; //bih + bhh
+
+  Eigen::Vector<T, h> g;
+  Eigen::Vector<T, h> ht;
+
+  Eigen::Vector<T, d> xt;
+
+  Eigen::Vector<T, h> htn1;
+
+private:
+  void Step() {
+    g.noalias() = Wi * xt + b;
+    g.noalias() += Wh * htn1;
+    ht = g.array().tanh();
+    htn1 = ht;
+  }
+};
+
+template<typename T, int h, int d, typename F>
+void ForEachLayerState(StackedLstmLayer<T, h, d>& l, F&& f)
+{
+  f(l.htn1);
+  f(l.ctn1);
+}
@@ -0,0 +1,546 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+  #include <sys/mman.h>
+  #include <unistd.h>
+  #define NNCOMP_WAV_MMAP 1
+#endif
+
+/**
+ * Streaming WAV and RF64 reading and writing for the offline tools.
+ * Reads PCM 16/24/32 bit and 32 bit float, writes PCM 16/24 bit or 32 bit float. Memory use
+ * does not depend on file length: the reader memory maps the file where possible, releasing
+ * the pages it has read, and falls back to large buffered reads, the writer appends blocks and patches the header on Close(),
+ * switching to RF64 once the data no longer fits a 32 bit RIFF size.
+ * Samples are converted to and from de-interleaved channels of the inference type.
+ * Assumes a little endian host.
+ */
+
+namespace wav
+{
+  enum class Encoding
+  {
+    Pcm16 = 0,
+    Pcm24,
+    Pcm32,
+    Float32
+  };
+
+  inline int BytesPerSample(Encoding e) { return e == Encoding::Pcm16 ? 2 : e == Encoding::Pcm24 ? 3 : 4; }
+
+  inline uint32_t ReadU32(const uint8_t* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | (uint32_t(p[3]) << 24); }
+  inline uint16_t ReadU16(const uint8_t* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+  inline uint64_t ReadU64(const uint8_t* p) { return ReadU32(p) | (uint64_t(ReadU32(p + 4)) << 32); }
+
+  inline void PutU16(uint8_t* p, uint16_t v) { p[0] = uint8_t(v); p[1] = uint8_t(v >> 8); }
+  inline void PutU32(uint8_t* p, uint32_t v) { for(int i = 0; i < 4; i++) p[i] = uint8_t(v >> (8 * i)); }
+  inline void PutU64(uint8_t* p, uint64_t v) { PutU32(p, uint32_t(v)); PutU32(p + 4, uint32_t(v >> 32)); }
+
+  /**
+   * Decode nFrames of one channel from interleaved bytes starting at src. Each case is a
+   * plain strided loop the compiler can vectorize.
+   */
+  template<typename T>
+  void Decode(const uint8_t* src, int frameBytes, Encoding e, T* dst, long nFrames)
+  {
+    switch(e)
+    {
+      case Encoding::Pcm16:
+        for(long s = 0; s < nFrames; s++)
+        {
+          int16_t v;
+          std::memcpy(&v, src + s * frameBytes, 2);
+          dst[s] = T(v) * T(1. / 32768.);
+        }
+        break;
+      case Encoding::Pcm24:
+        for(long s = 0; s < nFrames; s++)
+        {
+          const uint8_t* p = src + s * frameBytes;
+          const int32_t v = static_cast<int32_t>((uint32_t(p[0]) << 8) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 24));
+          dst[s] = T(v) * T(1. / 2147483648.);
+        }
+        break;
+      case Encoding::Pcm32:
+        for(long s = 0; s < nFrames; s++)
+        {
+          int32_t v;
+          std::memcpy(&v, src + s * frameBytes, 4);
+          dst[s] = T(v) * T(1. / 2147483648.);
+        }
+        break;
+      case Encoding::Float32:
+        for(long s = 0; s < nFrames; s++)
+        {
+          float v;
+          std::memcpy(&v, src + s * frameBytes, 4);
+          dst[s] = T(v);
+        }
+        break;
+    }
+  }
+
+  /**
+   * Encode nFrames of one channel into interleaved bytes, clipping integer formats
+   */
+  template<typename T>
+  void Encode(const T* src, Encoding e, uint8_t* dst, int frameBytes, long nFrames)
+  {
+    switch(e)
+    {
+      case Encoding::Pcm16:
+        for(long s = 0; s < nFrames; s++)
+        {
+          const int16_t v = static_cast<int16_t>(std::lrint(std::clamp(double(src[s]), -1., 32767. / 32768.) * 32768.));
+          std::memcpy(dst + s * frameBytes, &v, 2);
+        }
+        break;
+      case Encoding::Pcm24:
+        for(long s = 0; s < nFrames; s++)
+        {
+          const int32_t v = static_cast<int32_t>(std::lrint(std::clamp(double(src[s]), -1., 8388607. / 8388608.) * 8388608.));
+          uint8_t* p = dst + s * frameBytes;
+          p[0] = uint8_t(v);
+          p[1] = uint8_t(v >> 8);
+          p[2] = uint8_t(v >> 16);
+        }
+        break;
+      case Encoding::Pcm32:
+        for(long s = 0; s < nFrames; s++)
+        {
+          const int32_t v = static_cast<int32_t>(std::llrint(std::clamp(double(src[s]), -1., 2147483647. / 2147483648.) * 2147483648.));
+          std::memcpy(dst + s * frameBytes, &v, 4);
+        }
+        break;
+      case Encoding::Float32:
+        for(long s = 0; s < nFrames; s++)
+        {
+          const float v = float(src[s]);
+          std::memcpy(dst + s * frameBytes, &v, 4);
+        }
+        break;
+    }
+  }
+}
+
+/**
+ * Streaming WAV/RF64 reader
+ */
+class WavReader
+{
+public:
+  WavReader() {}
+  ~WavReader() { Close(); }
+
+  WavReader(const WavReader&) = delete;
+  WavReader& operator=(const WavReader&) = delete;
+
+  /**
+   * Open a file and parse its header. Returns false and sets error on failure.
+   */
+  bool Open(const std::string& path, std::string& error)
+  {
+    Close();
+    file = fopen(path.c_str(), "rb");
+    if(!file)
+    {
+      error = "cannot open " + path;
+      return false;
+    }
+
+    if(!ParseHeader(error))
+    {
+      error = path + ": " + error;
+      Close();
+      return false;
+    }
+
+    MapData();
+    return true;
+  }
+
+  void Close()
+  {
+#if defined(NNCOMP_WAV_MMAP)
+    if(mapping)
+    {
+      munmap(mapping, mappingBytes);
+      mapping = nullptr;
+    }
+#endif
+    if(file)
+    {
+      fclose(file);
+      file = nullptr;
+    }
+    position = 0;
+  }
+
+  int GetNumChannels() const { return nChans; }
+  int GetSampleRate() const { return sampleRate; }
+  long long GetFrames() const { return nFrames; }
+  long long GetPosition() const { return position; }
+  bool IsMapped() const { return mapping != nullptr; }
+
+  /**
+   * Read up to maxFrames into nChans de-interleaved channels. Returns frames read, 0 at the end.
+   */
+  template<typename T>
+  long Read(T* const* chans, long maxFrames)
+  {
+    const long n = static_cast<long>(std::min<long long>(maxFrames, nFrames - position));
+    if(n <= 0)
+    {
+      return 0;
+    }
+
+    const uint8_t* src = nullptr;
+    if(mapping)
+    {
+      src = static_cast<const uint8_t*>(mapping) + mapOffset + position * frameBytes;
+    }
+    else
+    {
+      buffer.resize(static_cast<size_t>(n) * frameBytes);
+      Seek(dataStart + position * frameBytes);
+      if(fread(buffer.data(), frameBytes, n, file) != static_cast<size_t>(n))
+      {
+        return 0;
+      }
+      src = buffer.data();
+    }
+
+    const int sampleBytes = wav::BytesPerSample(encoding);
+    for(int c = 0; c < nChans; c++)
+    {
+      wav::Decode(src + c * sampleBytes, frameBytes, encoding, chans[c], n);
+    }
+    position += n;
+    ReleaseConsumed();
+    return n;
+  }
+
+private:
+  void Seek(long long offset)
+  {
+#if defined(_WIN32)
+    _fseeki64(file, offset, SEEK_SET);
+#else
+    fseeko(file, static_cast<off_t>(offset), SEEK_SET);
+#endif
+  }
+
+  bool ParseHeader(std::string& error)
+  {
+    uint8_t header[12];
+    if(fread(header, 1, 12, file) != 12 || std::memcmp(header + 8, "WAVE", 4) != 0)
+    {
+      error = "not a WAV file";
+      return false;
+    }
+    const bool rf64 = std::memcmp(header, "RF64", 4) == 0;
+    if(!rf64 && std::memcmp(header, "RIFF", 4) != 0)
+    {
+      error = "not a WAV file";
+      return false;
+    }
+
+    long long offset = 12;
+    long long dataBytes64 = -1;
+    long long dataBytes = 0;
+    int bits = 0, format = 0;
+    bool haveFmt = false;
+
+    //Walk chunks until data
+    for(;;)
+    {
+      uint8_t chunk[8];
+      Seek(offset);
+      if(fread(chunk, 1, 8, file) != 8)
+      {
+        error = "no data chunk";
+        return false;
+      }
+      const uint32_t size = wav::ReadU32(chunk + 4);
+      const long long body = offset + 8;
+
+      if(std::memcmp(chunk, "ds64", 4) == 0)
+      {
+        uint8_t ds64[28];
+        if(size < 24 || fread(ds64, 1, 24, file) != 24)
+        {
+          error = "bad ds64 chunk";
+          return false;
+        }
+        dataBytes64 = static_cast<long long>(wav::ReadU64(ds64 + 8));
+      }
+      else if(std::memcmp(chunk, "fmt ", 4) == 0)
+      {
+        uint8_t fmt[40] = {};
+        if(size < 16 || fread(fmt, 1, std::min<uint32_t>(size, 40), file) < 16)
+        {
+          error = "bad fmt chunk";
+          return false;
+        }
+        format = wav::ReadU16(fmt);
+        nChans = wav::ReadU16(fmt + 2);
+        sampleRate = static_cast<int>(wav::ReadU32(fmt + 4));
+        bits = wav::ReadU16(fmt + 14);
+        //WAVE_FORMAT_EXTENSIBLE, sub format is the first two bytes of the GUID
+        if(format == 0xFFFE && size >= 26)
+        {
+          format = wav::ReadU16(fmt + 24);
+        }
+        haveFmt = true;
+      }
+      else if(std::memcmp(chunk, "data", 4) == 0)
+      {
+        if(!haveFmt)
+        {
+          error = "data before fmt chunk";
+          return false;
+        }
+        dataStart = body;
+        dataBytes = (rf64 && size == 0xFFFFFFFF && dataBytes64 >= 0) ? dataBytes64 : size;
+
+        //Clamp to what is actually on disk, eg. unfinished recordings
+        fseek(file, 0, SEEK_END);
+        dataBytes = std::min(dataBytes, Tell() - dataStart);
+        break;
+      }
+      offset = body + size + (size & 1);
+    }
+
+    if(format == 1 && bits == 16) encoding = wav::Encoding::Pcm16;
+    else if(format == 1 && bits == 24) encoding = wav::Encoding::Pcm24;
+    else if(format == 1 && bits == 32) encoding = wav::Encoding::Pcm32;
+    else if(format == 3 && bits == 32) encoding = wav::Encoding::Float32;
+    else
+    {
+      error = "unsupported sample format";
+      return false;
+    }
+
+    if(nChans <= 0)
+    {
+      error = "no channels";
+      return false;
+    }
+
+    frameBytes = nChans * wav::BytesPerSample(encoding);
+    nFrames = dataBytes / frameBytes;
+    return true;
+  }
+
+  long long Tell()
+  {
+#if defined(_WIN32)
+    return _ftelli64(file);
+#else
+    return static_cast<long long>(ftello(file));
+#endif
+  }
+
+  /**
+   * Map the data chunk, reads fall back to buffered IO if this fails
+   */
+  void MapData()
+  {
+#if defined(NNCOMP_WAV_MMAP)
+    if(nFrames <= 0)
+    {
+      return;
+    }
+    const long long page = sysconf(_SC_PAGESIZE);
+    const long long start = (dataStart / page) * page;
+    mapOffset = static_cast<size_t>(dataStart - start);
+    mappingBytes = mapOffset + static_cast<size_t>(nFrames * frameBytes);
+    void* p = mmap(nullptr, mappingBytes, PROT_READ, MAP_PRIVATE, fileno(file), static_cast<off_t>(start));
+    if(p != MAP_FAILED)
+    {
+      mapping = p;
+      releasedBytes = 0;
+      madvise(mapping, mappingBytes, MADV_SEQUENTIAL);
+    }
+#endif
+  }
+
+  /**
+   * Drop the mapped pages before the read position every few MB, so the resident size of the
+   * mapping stays bounded however long the file is. Pages read again are faulted back in.
+   */
+  void ReleaseConsumed()
+  {
+#if defined(NNCOMP_WAV_MMAP)
+    if(!mapping)
+    {
+      return;
+    }
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const size_t consumed = (mapOffset + static_cast<size_t>(position * frameBytes)) / page * page;
+    if(consumed >= releasedBytes + kReleaseBytes)
+    {
+      madvise(static_cast<uint8_t*>(mapping) + releasedBytes, consumed - releasedBytes, MADV_DONTNEED);
+      releasedBytes = consumed;
+    }
+#endif
+  }
+
+  static constexpr size_t kReleaseBytes = 4 << 20;
+
+  FILE* file = nullptr;
+  void* mapping = nullptr;
+  size_t mappingBytes = 0;
+  size_t mapOffset = 0;
+  size_t releasedBytes = 0; //start of the mapping already released
+  std::vector<uint8_t> buffer;
+  wav::Encoding encoding = wav::Encoding::Pcm16;
+  long long dataStart = 0;
+  long long nFrames = 0;
+  long long position = 0;
+  int frameBytes = 0;
+  int nChans = 0;
+  int sampleRate = 0;
+};
+
+/**
+ * Streaming WAV writer. Files larger than 4 GB are finalised as RF64.
+ */
+class WavWriter
+{
+public:
+  WavWriter() {}
+  ~WavWriter() { std::string error; Close(error); }
+
+  WavWriter(const WavWriter&) = delete;
+  WavWriter& operator=(const WavWriter&) = delete;
+
+  /**
+   * Create a file. Returns false and sets error on failure.
+   */
+  bool Open(const std::string& path, int nChans, int sampleRate, wav::Encoding encoding, std::string& error)
+  {
+    std::string closeError;
+    Close(closeError);
+    file = fopen(path.c_str(), "wb");
+    if(!file)
+    {
+      error = "cannot create " + path;
+      return false;
+    }
+    this->path = path;
+    this->nChans = nChans;
+    this->sampleRate = sampleRate;
+    this->encoding = encoding;
+    frameBytes = nChans * wav::BytesPerSample(encoding);
+    dataBytes = 0;
+
+    //Sizes are patched on Close. The JUNK chunk reserves room for a ds64 chunk.
+    uint8_t header[kHeaderBytes];
+    WriteHeader(header, false);
+    return fwrite(header, 1, kHeaderBytes, file) == kHeaderBytes;
+  }
+
+  /**
+   * Append nFrames from nChans de-interleaved channels
+   */
+  template<typename T>
+  bool Write(const T* const* chans, long nFrames)
+  {
+    if(!file)
+    {
+      return false;
+    }
+    const int sampleBytes = wav::BytesPerSample(encoding);
+    buffer.resize(static_cast<size_t>(nFrames) * frameBytes);
+    for(int c = 0; c < nChans; c++)
+    {
+      wav::Encode(chans[c], encoding, buffer.data() + c * sampleBytes, frameBytes, nFrames);
+    }
+    const bool ok = fwrite(buffer.data(), frameBytes, nFrames, file) == static_cast<size_t>(nFrames);
+    dataBytes += static_cast<unsigned long long>(nFrames) * frameBytes;
+    return ok;
+  }
+
+  /**
+   * Patch the header and close. Returns false and sets error on failure.
+   */
+  bool Close(std::string& error)
+  {
+    if(!file)
+    {
+      return true;
+    }
+
+    if(dataBytes & 1)
+    {
+      fputc(0, file);
+    }
+
+    uint8_t header[kHeaderBytes];
+    WriteHeader(header, dataBytes + kHeaderBytes - 8 > 0xFFFFFFFFull);
+    bool ok = fseek(file, 0, SEEK_SET) == 0 && fwrite(header, 1, kHeaderBytes, file) == kHeaderBytes;
+    ok = (fclose(file) == 0) && ok;
+    file = nullptr;
+    if(!ok)
+    {
+      error = "failed writing " + path;
+    }
+    return ok;
+  }
+
+private:
+  //RIFF + ds64/JUNK + fmt + data chunk headers
+  static constexpr size_t kHeaderBytes = 12 + 36 + 24 + 8;
+
+  void WriteHeader(uint8_t* h, bool rf64) const
+  {
+    const unsigned long long riffBytes = dataBytes + (dataBytes & 1) + kHeaderBytes - 8;
+
+    std::memcpy(h, rf64 ? "RF64" : "RIFF", 4);
+    wav::PutU32(h + 4, rf64 ? 0xFFFFFFFF : static_cast<uint32_t>(riffBytes));
+    std::memcpy(h + 8, "WAVE", 4);
+
+    //ds64, or JUNK of the same size in plain RIFF files
+    uint8_t* ds = h + 12;
+    std::memset(ds, 0, 36);
+    std::memcpy(ds, rf64 ? "ds64" : "JUNK", 4);
+    wav::PutU32(ds + 4, 28);
+    if(rf64)
+    {
+      wav::PutU64(ds + 8, riffBytes);
+      wav::PutU64(ds + 16, dataBytes);
+      wav::PutU64(ds + 24, dataBytes / frameBytes);
+    }
+
+    uint8_t* fmt = ds + 36;
+    std::memcpy(fmt, "fmt ", 4);
+    wav::PutU32(fmt + 4, 16);
+    wav::PutU16(fmt + 8, encoding == wav::Encoding::Float32 ? 3 : 1);
+    wav::PutU16(fmt + 10, static_cast<uint16_t>(nChans));
+    wav::PutU32(fmt + 12, static_cast<uint32_t>(sampleRate));
+    wav::PutU32(fmt + 16, static_cast<uint32_t>(sampleRate * frameBytes));
+    wav::PutU16(fmt + 20, static_cast<uint16_t>(frameBytes));
+    wav::PutU16(fmt + 22, static_cast<uint16_t>(8 * wav::BytesPerSample(encoding)));
+
+    uint8_t* data = fmt + 24;
+    std::memcpy(data, "data", 4);
+    wav::PutU32(data + 4, rf64 ? 0xFFFFFFFF : static_cast<uint32_t>(dataBytes));
+  }
+
+  FILE* file = nullptr;
+  std::string path;
+  std::vector<uint8_t> buffer;
+  unsigned long long dataBytes = 0;
+  wav::Encoding encoding = wav::Encoding::Float32;
+  int frameBytes = 0;
+  int nChans = 0;
+  int sampleRate = 0;
+};
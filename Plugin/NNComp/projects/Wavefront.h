@@ -0,0 +1,93 @@
+#pragma once
+#include "ModelState.h"
+
+/**
+ * Layer wavefront scheduling for stacked models.
+ * apply_model runs l0 -> l1 -> ... -> f for one sample, so every layer waits on the one below.
+ * Over a block, layer j at time t only depends on layer j-1 at time t and on itself at t-1,
+ * so the wavefront advances along diagonals: step k runs layer j at time k-j for every j.
+ * The layers within a step are independent and can overlap in the pipeline. Layers are
+ * visited top down inside a step so each one reads the output of the layer below before it
+ * is overwritten. Every layer performs the same operations on the same values as apply_model,
+ * so outputs are bit-identical.
+ */
+
+/**
+ * Run layer j for time t, feeding it the input sample or the output of layer j-1
+ */
+template<int j, typename M, typename T>
+inline void StepLayer(M& m, const T* x, int t)
+{
+  if constexpr (j == 0) GetLayer<0>(m).apply_layer(x[t]);
+  else GetLayer<j>(m).apply_layer(GetLayer<j - 1>(m).ht);
+}
+
+/**
+ * One wavefront step k over layers j..0, skipping times outside [0, nFrames)
+ */
+template<int j, typename M, typename T>
+inline void StepEdge(M& m, const T* x, int k, int nFrames)
+{
+  const int t = k - j;
+  if(t >= 0 && t < nFrames) StepLayer<j>(m, x, t);
+  if constexpr (j > 0) StepEdge<j - 1>(m, x, k, nFrames);
+}
+
+/**
+ * One wavefront step k over layers j..0 where every layer has a valid time
+ */
+template<int j, typename M, typename T>
+inline void StepFull(M& m, const T* x, int k)
+{
+  StepLayer<j>(m, x, k - j);
+  if constexpr (j > 0) StepFull<j - 1>(m, x, k);
+}
+
+/**
+ * Process a block through model m using the layer wavefront. Equivalent to calling
+ * apply_model on every sample in order.
+ */
+template<typename M, typename T>
+void ApplyModelWavefront(M& m, const T* x, T* y, const int nFrames)
+{
+  constexpr int L = M::layers;
+
+  if constexpr (L == 1)
+  {
+    auto& l0 = GetLayer<0>(m);
+    for(int s = 0; s < nFrames; s++)
+    {
+      l0.apply_layer(x[s]);
+      y[s] = m.f.apply_layer(l0.ht);
+    }
+  }
+  else
+  {
+    auto& top = GetLayer<L - 1>(m);
+
+    //Fill the pipeline
+    int k = 0;
+    for(; k < L - 1 && k < nFrames + L - 1; k++)
+    {
+      StepEdge<L - 1>(m, x, k, nFrames);
+    }
+
+    //Steady state, all layers busy
+    for(; k < nFrames; k++)
+    {
+      StepFull<L - 1>(m, x, k);
+      y[k - L + 1] = m.f.apply_layer(top.ht);
+    }
+
+    //Drain, top layer output for time k - L + 1 is ready after step k
+    for(; k < nFrames + L - 1; k++)
+    {
+      StepEdge<L - 1>(m, x, k, nFrames);
+      const int t = k - L + 1;
+      if(t >= 0)
+      {
+        y[t] = m.f.apply_layer(top.ht);
+      }
+    }
+  }
+}
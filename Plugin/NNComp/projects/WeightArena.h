@@ -0,0 +1,454 @@
+#pragma once
+#include <array>
+#include <memory>
+#include <type_traits>
+#include "Eigen/Dense"
+#include "layers.h"
+#include "ModelState.h"
+
+/**
+ * Generated models with their weights packed into one arena.
+ * The layers in layers.h hold their weights as members next to their state vectors, aligned
+ * to the SIMD width only. PackedModel<M> copies the weights of model M into a single 64
+ * byte aligned block in the order apply_layer reads them (per gate the input weights, input
+ * bias, recurrent weights and recurrent bias, layer by layer, then the output layer). Every
+ * weight matrix starts on a cache line. The layers keep Eigen maps into the arena under the
+ * usual member names and hold only the mutable state, so the state of the whole model is one
+ * small block next to the maps. A packed model works wherever a generated one does
+ * (apply_model, the wavefront, the ModelState helpers) and computes the same values.
+ * The layout is opt-in, NN keeps the generated classes: a generated model already keeps its
+ * weights within one object, and the compiler can keep the weights of the small models in
+ * registers only as members. Tools/nncomp_arena measures both layouts.
+ */
+
+/**
+ * n rounded up to a whole number of 64 byte cache lines of T
+ */
+template<typename T>
+constexpr int AlignToCacheLine(int n)
+{
+  constexpr int line = 64 / static_cast<int>(sizeof(T));
+  return (n + line - 1) / line * line;
+}
+
+/**
+ * Offset of tensor k in a packed layer, from the sizes of its tensors. Even tensors are weight
+ * matrices and start on a cache line, odd ones are biases following their matrix. Tensor n is
+ * the end of the layer.
+ */
+template<typename T, size_t n>
+constexpr int ArenaOffset(const std::array<int, n>& sizes, int k)
+{
+  int offset = 0;
+  for(int i = 0; i < k; i++)
+  {
+    offset += sizes[i];
+    if(i % 2 == 1 || i + 1 == static_cast<int>(n)) offset = AlignToCacheLine<T>(offset);
+  }
+  return offset;
+}
+
+template<typename T, int rows, int cols>
+using ArenaMatrix = Eigen::Map<Eigen::Matrix<T, rows, cols>, Eigen::Aligned64>;
+
+template<typename T, int rows>
+using ArenaVector = Eigen::Map<Eigen::Vector<T, rows>>;
+
+/**
+ * Lstm layer with weights in an arena.
+ * T - Type
+ * h - hidden size
+ * d - input size
+ */
+template<typename T, int h, int d>
+class PackedLstmLayer {
+public:
+  static constexpr std::array<int, 16> kSizes = {h * d, h, h * h, h, h * d, h, h * h, h, h * d, h, h * h, h, h * d, h, h * h, h};
+  static constexpr int kSize = ArenaOffset<T>(kSizes, 16);
+
+  static constexpr int Offset(int k) { return ArenaOffset<T>(kSizes, k); }
+
+  explicit PackedLstmLayer(T* w)
+  : Wii(w + Offset(0)), bii(w + Offset(1)), Whi(w + Offset(2)), bhi(w + Offset(3))
+  , Wif(w + Offset(4)), bif(w + Offset(5)), Whf(w + Offset(6)), bhf(w + Offset(7))
+  , Wig(w + Offset(8)), big(w + Offset(9)), Whg(w + Offset(10)), bhg(w + Offset(11))
+  , Wio(w + Offset(12)), bio(w + Offset(13)), Who(w + Offset(14)), bho(w + Offset(15))
+  {
+  }
+
+  PackedLstmLayer(const PackedLstmLayer&) = delete;
+
+  void Load(const LstmLayer<T, h, d>& l)
+  {
+    Wii = l.Wii; Wif = l.Wif; Wig = l.Wig; Wio = l.Wio;
+    Whi = l.Whi; Whf = l.Whf; Whg = l.Whg; Who = l.Who;
+    bii = l.bii; bif = l.bif; big = l.big; bio = l.bio;
+    bhi = l.bhi; bhf = l.bhf; bhg = l.bhg; bho = l.bho;
+    ht = l.ht; ct = l.ct; xt = l.xt; htn1 = l.htn1; ctn1 = l.ctn1;
+  }
+
+  void CopyState(const PackedLstmLayer& l)
+  {
+    it = l.it; ft = l.ft; gt = l.gt; ot = l.ot; ct = l.ct; ht = l.ht;
+    xt = l.xt; ctn1 = l.ctn1; htn1 = l.htn1;
+  }
+
+  void apply_layer(Eigen::Vector<T, d> x) {
+    xt = x;
+    Step();
+  }
+
+  void apply_layer(T x) {
+    xt = xt.Constant(x);
+    Step();
+  }
+
+  ArenaMatrix<T, h, d> Wii;
+  ArenaVector<T, h> bii;
+  ArenaMatrix<T, h, h> Whi;
+  ArenaVector<T, h> bhi;
+  ArenaMatrix<T, h, d> Wif;
+  ArenaVector<T, h> bif;
+  ArenaMatrix<T, h, h> Whf;
+  ArenaVector<T, h> bhf;
+  ArenaMatrix<T, h, d> Wig;
+  ArenaVector<T, h> big;
+  ArenaMatrix<T, h, h> Whg;
+  ArenaVector<T, h> bhg;
+  ArenaMatrix<T, h, d> Wio;
+  ArenaVector<T, h> bio;
+  ArenaMatrix<T, h, h> Who;
+  ArenaVector<T, h> bho;
+
+  Eigen::Vector<T, h> it;
+  Eigen::Vector<T, h> ft;
+  Eigen::Vector<T, h> gt;
+  Eigen::Vector<T, h> ot;
+  Eigen::Vector<T, h> ct;
+  Eigen::Vector<T, h> ht;
+
+  Eigen::Vector<T, d> xt;
+
+  Eigen::Vector<T, h> ctn1;
+  Eigen::Vector<T, h> htn1;
+
+private:
+  void Step() {
+    it = (Wii * xt + bii + Whi * htn1 + bhi).unaryExpr(std::ref(Sigmoid<T>));
+    ft = (Wif * xt + bif + Whf * htn1 + bhf).unaryExpr(std::ref(Sigmoid<T>));
+    gt = (Wig * xt + big + Whg * htn1 + bhg).array().tanh();
+    ot = (Wio * xt + bio + Who * htn1 + bho).unaryExpr(std::ref(Sigmoid<T>));
+    ct = ft.cwiseProduct(ctn1) + it.cwiseProduct(gt);
+    ht = ct.array().tanh();
+    ht = ot.cwiseProduct(ht);
+    htn1 = ht;
+    ctn1 = ct;
+  }
+};
+
+/**
+ * Gru layer with weights in an arena.
+ * T - Type
+ * h - hidden size
+ * d - input size
+ */
+template<typename T, int h, int d>
+class PackedGruLayer {
+public:
+  static constexpr std::array<int, 12> kSizes = {h * d, h, h * h, h, h * d, h, h * h, h, h * d, h, h * h, h};
+  static constexpr int kSize = ArenaOffset<T>(kSizes, 12);
+
+  static constexpr int Offset(int k) { return ArenaOffset<T>(kSizes, k); }
+
+  explicit PackedGruLayer(T* w)
+  : Wir(w + Offset(0)), bir(w + Offset(1)), Whr(w + Offset(2)), bhr(w + Offset(3))
+  , Wiz(w + Offset(4)), biz(w + Offset(5)), Whz(w + Offset(6)), bhz(w + Offset(7))
+  , Win(w + Offset(8)), bin(w + Offset(9)), Whn(w + Offset(10)), bhn(w + Offset(11))
+  {
+  }
+
+  PackedGruLayer(const PackedGruLayer&) = delete;
+
+  void Load(const GruLayer<T, h, d>& l)
+  {
+    Wir = l.Wir; Wiz = l.Wiz; Win = l.Win;
+    Whr = l.Whr; Whz = l.Whz; Whn = l.Whn;
+    bir = l.bir; biz = l.biz; bin = l.bin;
+    bhr = l.bhr; bhz = l.bhz; bhn = l.bhn;
+    ht = l.ht; xt = l.xt; htn1 = l.htn1;
+  }
+
+  void CopyState(const PackedGruLayer& l)
+  {
+    rt = l.rt; zt = l.zt; nt = l.nt; ht = l.ht;
+    xt = l.xt; htn1 = l.htn1;
+  }
+
+  void apply_layer(Eigen::Vector<T, d> x) {
+    xt = x;
+    Step();
+  }
+
+  void apply_layer(T x) {
+    xt = xt.Constant(x);
+    Step();
+  }
+
+  ArenaMatrix<T, h, d> Wir;
+  ArenaVector<T, h> bir;
+  ArenaMatrix<T, h, h> Whr;
+  ArenaVector<T, h> bhr;
+  ArenaMatrix<T, h, d> Wiz;
+  ArenaVector<T, h> biz;
+  ArenaMatrix<T, h, h> Whz;
+  ArenaVector<T, h> bhz;
+  ArenaMatrix<T, h, d> Win;
+  ArenaVector<T, h> bin;
+  ArenaMatrix<T, h, h> Whn;
+  ArenaVector<T, h> bhn;
+
+  Eigen::Vector<T, h> rt;
+  Eigen::Vector<T, h> zt;
+  Eigen::Vector<T, h> nt;
+  Eigen::Vector<T, h> ht;
+
+  Eigen::Vector<T, d> xt;
+
+  Eigen::Vector<T, h> htn1;
+
+private:
+  void Step() {
+    rt = (Wir * xt + bir + Whr * htn1 + bhr).unaryExpr(std::ref(Sigmoid<T>));
+    zt = (Wiz * xt + biz + Whz * htn1 + bhz).unaryExpr(std::ref(Sigmoid<T>));
+    nt = (Win * xt + bin + rt.cwiseProduct(Whn * htn1 + bhn)).array().tanh();
+    ht = (ht.Constant(1) - zt).cwiseProduct(nt) + zt.cwiseProduct(htn1);
+    htn1 = ht;
+  }
+};
+
+/**
+ * Rnn layer with weights in an arena.
+ * T - Type
+ * h - hidden size
+ * d - input size
+ */
+template<typename T, int h, int d>
+class PackedRnnLayer {
+public:
+  static constexpr std::array<int, 4> kSizes = {h * d, h, h * h, h};
+  static constexpr int kSize = ArenaOffset<T>(kSizes, 4);
+
+  static constexpr int Offset(int k) { return ArenaOffset<T>(kSizes, k); }
+
+  explicit PackedRnnLayer(T* w)
+  : Wih(w + Offset(0)), bih(w + Offset(1)), Whh(w + Offset(2)), bhh(w + Offset(3))
+  {
+  }
+
+  PackedRnnLayer(const PackedRnnLayer&) = delete;
+
+  void Load(const RnnLayer<T, h, d>& l)
+  {
+    Wih = l.Wih; Whh = l.Whh;
+    bih = l.bih; bhh = l.bhh;
+    ht = l.ht; xt = l.xt; htn1 = l.htn1;
+  }
+
+  void CopyState(const PackedRnnLayer& l)
+  {
+    ht = l.ht; xt = l.xt; htn1 = l.htn1;
+  }
+
+  void apply_layer(Eigen::Vector<T, d> x) {
+    xt = x;
+    Step();
+  }
+
+  void apply_layer(T x) {
+    xt = xt.Constant(x);
+    Step();
+  }
+
+  ArenaMatrix<T, h, d> Wih;
+  ArenaVector<T, h> bih;
+  ArenaMatrix<T, h, h> Whh;
+  ArenaVector<T, h> bhh;
+
+  Eigen::Vector<T, h> ht;
+  Eigen::Vector<T, d> xt;
+  Eigen::Vector<T, h> htn1;
+
+private:
+  void Step() {
+    ht = (Wih * xt + bih + Whh * htn1 + bhh).array().tanh();
+    htn1 = ht;
+  }
+};
+
+/**
+ * Fully connected output layer with weights in an arena
+ */
+template<typename T, int h, int d>
+class PackedFccLayer {
+public:
+  static constexpr std::array<int, 2> kSizes = {h * d, d};
+  static constexpr int kSize = ArenaOffset<T>(kSizes, 2);
+
+  explicit PackedFccLayer(T* w)
+  : A(w), b(w + h * d)
+  {
+  }
+
+  PackedFccLayer(const PackedFccLayer&) = delete;
+
+  void Load(const FccLayer<T, h, d>& l)
+  {
+    A = l.A;
+    b = l.b;
+  }
+
+  void CopyState(const PackedFccLayer& l)
+  {
+    xt = l.xt;
+    y = l.y;
+  }
+
+  T apply_layer(Eigen::Vector<T, h> x) {
+    xt = x;
+    y = (xt.transpose() * A + b).array().tanh()(0);
+    return y;
+  }
+
+  ArenaMatrix<T, h, d> A;
+  ArenaVector<T, d> b;
+  Eigen::Vector<T, h> xt;
+  T y = 0;
+};
+
+/**
+ * Placeholder for the layers a model does not have
+ */
+struct PackedNoLayer {
+  static constexpr int kSize = 0;
+
+  template<typename T>
+  explicit PackedNoLayer(T*) {}
+
+  template<typename L> void Load(const L&) {}
+  void CopyState(const PackedNoLayer&) {}
+};
+
+/**
+ * Packed form of a layer, PackedNoLayer for the layers a model does not have (void)
+ */
+template<typename L> struct PackedLayerOf { using type = PackedNoLayer; };
+template<typename T, int h, int d> struct PackedLayerOf<LstmLayer<T, h, d>> { using type = PackedLstmLayer<T, h, d>; };
+template<typename T, int h, int d> struct PackedLayerOf<GruLayer<T, h, d>> { using type = PackedGruLayer<T, h, d>; };
+template<typename T, int h, int d> struct PackedLayerOf<RnnLayer<T, h, d>> { using type = PackedRnnLayer<T, h, d>; };
+template<typename T, int h, int d> struct PackedLayerOf<FccLayer<T, h, d>> { using type = PackedFccLayer<T, h, d>; };
+
+/**
+ * Generated model M with its weights in one arena. Built from a default constructed M, or
+ * from a given instance including its state.
+ * M - generated model class, eg. Lstm_32_1<float>
+ */
+template<typename M>
+class PackedModel
+{
+  using L0 = typename PackedLayerOf<typename ModelLayerType<M, 0>::type>::type;
+  using L1 = typename PackedLayerOf<typename ModelLayerType<M, 1>::type>::type;
+  using L2 = typename PackedLayerOf<typename ModelLayerType<M, 2>::type>::type;
+  using L3 = typename PackedLayerOf<typename ModelLayerType<M, 3>::type>::type;
+  using F = typename PackedLayerOf<decltype(M::f)>::type;
+  using T = std::remove_reference_t<decltype(std::declval<M&>().f.y)>;
+
+  static_assert(M::layers <= 4, "PackedModel takes models of 1 to 4 layers");
+
+  static constexpr int kOffset1 = L0::kSize;
+  static constexpr int kOffset2 = kOffset1 + L1::kSize;
+  static constexpr int kOffset3 = kOffset2 + L2::kSize;
+  static constexpr int kOffsetF = kOffset3 + L3::kSize;
+
+public:
+  const static int h = M::h;
+  const static int d = M::d;
+  const static int layers = M::layers;
+
+  //Size of the arena in elements
+  static constexpr int kArenaSize = kOffsetF + F::kSize;
+
+  PackedModel()
+  : PackedModel(*std::make_unique<M>())
+  {
+  }
+
+  explicit PackedModel(const M& m)
+  : l0(arena.data()), l1(arena.data() + kOffset1), l2(arena.data() + kOffset2), l3(arena.data() + kOffset3)
+  , f(arena.data() + kOffsetF)
+  {
+    arena.fill(T(0));
+    l0.Load(GetLayer<0>(m));
+    if constexpr (layers > 1) l1.Load(GetLayer<1>(m));
+    if constexpr (layers > 2) l2.Load(GetLayer<2>(m));
+    if constexpr (layers > 3) l3.Load(GetLayer<3>(m));
+    f.Load(m.f);
+  }
+
+  PackedModel(const PackedModel& other)
+  : arena(other.arena)
+  , l0(arena.data()), l1(arena.data() + kOffset1), l2(arena.data() + kOffset2), l3(arena.data() + kOffset3)
+  , f(arena.data() + kOffsetF)
+  {
+    CopyState(other);
+  }
+
+  PackedModel& operator=(const PackedModel& other)
+  {
+    arena = other.arena;
+    CopyState(other);
+    return *this;
+  }
+
+  void apply_model(T* x, T* y) {
+    l0.apply_layer(*x);
+    if constexpr (layers > 1) l1.apply_layer(l0.ht);
+    if constexpr (layers > 2) l2.apply_layer(l1.ht);
+    if constexpr (layers > 3) l3.apply_layer(l2.ht);
+    *y = f.apply_layer(GetTop().ht);
+  }
+
+private:
+  alignas(64) std::array<T, kArenaSize> arena;
+
+public:
+  L0 l0;
+  L1 l1;
+  L2 l2;
+  L3 l3;
+  F f;
+
+private:
+  auto& GetTop()
+  {
+    if constexpr (layers == 1) return l0;
+    else if constexpr (layers == 2) return l1;
+    else if constexpr (layers == 3) return l2;
+    else return l3;
+  }
+
+  void CopyState(const PackedModel& other)
+  {
+    l0.CopyState(other.l0);
+    l1.CopyState(other.l1);
+    l2.CopyState(other.l2);
+    l3.CopyState(other.l3);
+    f.CopyState(other.f);
+  }
+};
+
+template<typename T, int h, int d, typename F>
+void ForEachLayerState(PackedLstmLayer<T, h, d>& l, F&& f)
+{
+  f(l.htn1);
+  f(l.ctn1);
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include "IControl.h"
 #include "NetworkControl.h"
+#include "ModelState.h"
 
 BEGIN_IPLUG_NAMESPACE
 BEGIN_IGRAPHICS_NAMESPACE
@@ -15,7 +16,7 @@ public:
     
   }
   
-  void ProcessWeights(NN<sample> nn, int ctrlTag = kNoTag, int model = 0)
+  void ProcessWeights(const NN<sample>& nn, int ctrlTag = kNoTag, int model = 0)
   {
     switch(model)
     {
@@ -105,20 +106,20 @@ public:
   }
   
   template<typename T>
-  void ProcessGru_1(T model, int ctrlTag)
+  void ProcessGru_1(const T& model, int ctrlTag)
   {
     ISenderData<MAX_LAYERS + 1, std::array<float, MAX_HIDDEN * MAX_HIDDEN>> d {ctrlTag, model.h, 0};
     
     //process input layer
     for(int i = 0; i < model.h; i++)
     {
-      d.vals[0][i] = model.l0.Wir.coeff(i, 0) * model.l0.xt.coeff(i, 0);
+      d.vals[0][i] = GetLayer<0>(model).Wir.coeff(i, 0) * GetLayer<0>(model).xt.coeff(i, 0);
     }
     
     //layer 1
     for(int i = 0; i < model.h; i++)
     {
-      d.vals[MAX_LAYERS][i] = model.l0.ht[i] * model.f.A.coeff(i, 0);
+      d.vals[MAX_LAYERS][i] = GetLayer<0>(model).ht[i] * model.f.A.coeff(i, 0);
     }
     
     //Send data
@@ -126,14 +127,14 @@ public:
   }
   
   template<typename T>
-  void ProcessGru_2(T model, int ctrlTag)
+  void ProcessGru_2(const T& model, int ctrlTag)
   {
     ISenderData<MAX_LAYERS + 1, std::array<float, MAX_HIDDEN * MAX_HIDDEN>> d {ctrlTag, model.h, 0};
     
     //process input layer
     for(int i = 0; i < model.h; i++)
     {
-      d.vals[0][i] = model.l0.Wir.coeff(i, 0) * model.l0.xt.coeff(i, 0);
+      d.vals[0][i] = GetLayer<0>(model).Wir.coeff(i, 0) * GetLayer<0>(model).xt.coeff(i, 0);
     }
     
     //layers
@@ -141,9 +142,9 @@ public:
     {
       for(int o = 0; o < model.h; o++)
       {
-        d.vals[1][i + (o * model.h)] = model.l0.ht[i] * model.l1.Wir.coeff(i, o);
+        d.vals[1][i + (o * model.h)] = GetLayer<0>(model).ht[i] * GetLayer<1>(model).Wir.coeff(i, o);
       }
-      d.vals[MAX_LAYERS][i] = model.l1.ht[i] * model.f.A.coeff(i, 0);
+      d.vals[MAX_LAYERS][i] = GetLayer<1>(model).ht[i] * model.f.A.coeff(i, 0);
     }
     
     //Send data
@@ -151,14 +152,14 @@ public:
   }
   
   template<typename T>
-  void ProcessGru_4(T model, int ctrlTag)
+  void ProcessGru_4(const T& model, int ctrlTag)
   {
     ISenderData<MAX_LAYERS + 1, std::array<float, MAX_HIDDEN * MAX_HIDDEN>> d {ctrlTag, model.h, 0};
     
     //process input layer
     for(int i = 0; i < model.h; i++)
     {
-      d.vals[0][i] = model.l0.Wir.coeff(i, 0) * model.l0.xt.coeff(i, 0);
+      d.vals[0][i] = GetLayer<0>(model).Wir.coeff(i, 0) * GetLayer<0>(model).xt.coeff(i, 0);
     }
     
     //layers
@@ -166,11 +167,11 @@ public:
     {
       for(int o = 0; o < model.h; o++)
       {
-        d.vals[1][i + (o * model.h)] = model.l0.ht[i] * model.l1.Wir.coeff(i, o);
-        d.vals[2][i + (o * model.h)] = model.l1.ht[i] * model.l2.Wir.coeff(i, o);
-        d.vals[3][i + (o * model.h)] = model.l2.ht[i] * model.l3.Wir.coeff(i, o);
+        d.vals[1][i + (o * model.h)] = GetLayer<0>(model).ht[i] * GetLayer<1>(model).Wir.coeff(i, o);
+        d.vals[2][i + (o * model.h)] = GetLayer<1>(model).ht[i] * GetLayer<2>(model).Wir.coeff(i, o);
+        d.vals[3][i + (o * model.h)] = GetLayer<2>(model).ht[i] * GetLayer<3>(model).Wir.coeff(i, o);
       }
-      d.vals[MAX_LAYERS][i] = model.l3.ht[i] * model.f.A.coeff(i, 0);
+      d.vals[MAX_LAYERS][i] = GetLayer<3>(model).ht[i] * model.f.A.coeff(i, 0);
     }
     
     //Send data
@@ -178,20 +179,20 @@ public:
   }
   
   template<typename T>
-  void ProcessLstm_1(T model, int ctrlTag)
+  void ProcessLstm_1(const T& model, int ctrlTag)
   {
     ISenderData<MAX_LAYERS + 1, std::array<float, MAX_HIDDEN * MAX_HIDDEN>> d {ctrlTag, model.h, 0};
     
     //process input layer
     for(int i = 0; i < model.h; i++)
     {
-      d.vals[0][i] = model.l0.Wii.coeff(i, 0) * model.l0.xt.coeff(i, 0);
+      d.vals[0][i] = GetLayer<0>(model).Wii.coeff(i, 0) * GetLayer<0>(model).xt.coeff(i, 0);
     }
     
     //layer 1
     for(int i = 0; i < model.h; i++)
     {
-      d.vals[MAX_LAYERS][i] = model.l0.ht[i] * model.f.A.coeff(i, 0);
+      d.vals[MAX_LAYERS][i] = GetLayer<0>(model).ht[i] * model.f.A.coeff(i, 0);
     }
     
     
@@ -200,14 +201,14 @@ public:
   }
   
   template<typename T>
-  void ProcessLstm_2(T model, int ctrlTag)
+  void ProcessLstm_2(const T& model, int ctrlTag)
   {
     ISenderData<MAX_LAYERS + 1, std::array<float, MAX_HIDDEN * MAX_HIDDEN>> d {ctrlTag, model.h, 0};
     
     //process input layer
     for(int i = 0; i < model.h; i++)
     {
-      d.vals[0][i] = model.l0.Wii.coeff(i, 0) * model.l0.xt.coeff(i, 0);
+      d.vals[0][i] = GetLayer<0>(model).Wii.coeff(i, 0) * GetLayer<0>(model).xt.coeff(i, 0);
     }
     
     //layers
@@ -215,9 +216,9 @@ public:
     {
       for(int o = 0; o < model.h; o++)
       {
-        d.vals[1][i + (o * model.h)] = model.l0.ht[i] * model.l1.Wii.coeff(i, o);
+        d.vals[1][i + (o * model.h)] = GetLayer<0>(model).ht[i] * GetLayer<1>(model).Wii.coeff(i, o);
       }
-      d.vals[MAX_LAYERS][i] = model.l1.ht[i] * model.f.A.coeff(i, 0);
+      d.vals[MAX_LAYERS][i] = GetLayer<1>(model).ht[i] * model.f.A.coeff(i, 0);
     }
     
     //Send data
@@ -225,14 +226,14 @@ public:
   }
   
   template<typename T>
-  void ProcessLstm_4(T model, int ctrlTag)
+  void ProcessLstm_4(const T& model, int ctrlTag)
   {
     ISenderData<MAX_LAYERS + 1, std::array<float, MAX_HIDDEN * MAX_HIDDEN>> d {ctrlTag, model.h, 0};
     
     //process input layer
     for(int i = 0; i < model.h; i++)
     {
-      d.vals[0][i] = model.l0.Wii.coeff(i, 0) * model.l0.xt.coeff(i, 0);
+      d.vals[0][i] = GetLayer<0>(model).Wii.coeff(i, 0) * GetLayer<0>(model).xt.coeff(i, 0);
     }
     
     //layers
@@ -240,11 +241,11 @@ public:
     {
       for(int o = 0; o < model.h; o++)
       {
-        d.vals[1][i + (o * model.h)] = model.l0.ht[i] * model.l1.Wii.coeff(i, o);
-        d.vals[2][i + (o * model.h)] = model.l1.ht[i] * model.l2.Wii.coeff(i, o);
-        d.vals[3][i + (o * model.h)] = model.l2.ht[i] * model.l3.Wii.coeff(i, o);
+        d.vals[1][i + (o * model.h)] = GetLayer<0>(model).ht[i] * GetLayer<1>(model).Wii.coeff(i, o);
+        d.vals[2][i + (o * model.h)] = GetLayer<1>(model).ht[i] * GetLayer<2>(model).Wii.coeff(i, o);
+        d.vals[3][i + (o * model.h)] = GetLayer<2>(model).ht[i] * GetLayer<3>(model).Wii.coeff(i, o);
       }
-      d.vals[MAX_LAYERS][i] = model.l3.ht[i] * model.f.A.coeff(i, 0);
+      d.vals[MAX_LAYERS][i] = GetLayer<3>(model).ht[i] * model.f.A.coeff(i, 0);
     }
     
     //Send data
@@ -252,20 +253,20 @@ public:
   }
   
   template<typename T>
-  void ProcessRnn_1(T model, int ctrlTag)
+  void ProcessRnn_1(const T& model, int ctrlTag)
   {
     ISenderData<MAX_LAYERS + 1, std::array<float, MAX_HIDDEN * MAX_HIDDEN>> d {ctrlTag, model.h, 0};
     
     //process input layer
     for(int i = 0; i < model.h; i++)
     {
-      d.vals[0][i] = model.l0.Wih.coeff(i, 0) * model.l0.xt.coeff(i, 0);
+      d.vals[0][i] = GetLayer<0>(model).Wih.coeff(i, 0) * GetLayer<0>(model).xt.coeff(i, 0);
     }
     
     //layer 1
     for(int i = 0; i < model.h; i++)
     {
-      d.vals[MAX_LAYERS][i] = model.l0.ht[i] * model.f.A.coeff(i, 0);
+      d.vals[MAX_LAYERS][i] = GetLayer<0>(model).ht[i] * model.f.A.coeff(i, 0);
     }
     
     //Send data
@@ -273,14 +274,14 @@ public:
   }
   
   template<typename T>
-  void ProcessRnn_2(T model, int ctrlTag)
+  void ProcessRnn_2(const T& model, int ctrlTag)
   {
     ISenderData<MAX_LAYERS + 1, std::array<float, MAX_HIDDEN * MAX_HIDDEN>> d {ctrlTag, model.h, 0};
     
     //process input layer
     for(int i = 0; i < model.h; i++)
     {
-      d.vals[0][i] = model.l0.Wih.coeff(i, 0) * model.l0.xt.coeff(i, 0);
+      d.vals[0][i] = GetLayer<0>(model).Wih.coeff(i, 0) * GetLayer<0>(model).xt.coeff(i, 0);
     }
     
     //layers
@@ -288,9 +289,9 @@ public:
     {
       for(int o = 0; o < model.h; o++)
       {
-        d.vals[1][i + (o * model.h)] = model.l0.ht[i] * model.l1.Wih.coeff(i, o);
+        d.vals[1][i + (o * model.h)] = GetLayer<0>(model).ht[i] * GetLayer<1>(model).Wih.coeff(i, o);
       }
-      d.vals[MAX_LAYERS][i] = model.l1.ht[i] * model.f.A.coeff(i, 0);
+      d.vals[MAX_LAYERS][i] = GetLayer<1>(model).ht[i] * model.f.A.coeff(i, 0);
     }
     
     //Send data
@@ -298,14 +299,14 @@ public:
   }
   
   template<typename T>
-  void ProcessRnn_4(T model, int ctrlTag)
+  void ProcessRnn_4(const T& model, int ctrlTag)
   {
     ISenderData<MAX_LAYERS + 1, std::array<float, MAX_HIDDEN * MAX_HIDDEN>> d {ctrlTag, model.h, 0};
     
     //process input layer
     for(int i = 0; i < model.h; i++)
     {
-      d.vals[0][i] = model.l0.Wih.coeff(i, 0) * model.l0.xt.coeff(i, 0);
+      d.vals[0][i] = GetLayer<0>(model).Wih.coeff(i, 0) * GetLayer<0>(model).xt.coeff(i, 0);
     }
     
     //layers
@@ -313,11 +314,11 @@ public:
     {
       for(int o = 0; o < model.h; o++)
       {
-        d.vals[1][i + (o * model.h)] = model.l0.ht[i] * model.l1.Wih.coeff(i, o);
-        d.vals[2][i + (o * model.h)] = model.l1.ht[i] * model.l2.Wih.coeff(i, o);
-        d.vals[3][i + (o * model.h)] = model.l2.ht[i] * model.l3.Wih.coeff(i, o);
+        d.vals[1][i + (o * model.h)] = GetLayer<0>(model).ht[i] * GetLayer<1>(model).Wih.coeff(i, o);
+        d.vals[2][i + (o * model.h)] = GetLayer<1>(model).ht[i] * GetLayer<2>(model).Wih.coeff(i, o);
+        d.vals[3][i + (o * model.h)] = GetLayer<2>(model).ht[i] * GetLayer<3>(model).Wih.coeff(i, o);
       }
-      d.vals[MAX_LAYERS][i] = model.l3.ht[i] * model.f.A.coeff(i, 0);
+      d.vals[MAX_LAYERS][i] = GetLayer<3>(model).ht[i] * model.f.A.coeff(i, 0);
     }
     
     //Send data
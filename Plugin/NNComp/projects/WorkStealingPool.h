@@ -0,0 +1,187 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Work-stealing thread pool for offline batch jobs.
+ * Every worker owns a task deque. Tasks submitted from a worker go to its own deque and are
+ * run newest first; idle workers steal the oldest tasks from the other deques. Tasks
+ * submitted from outside the pool are spread round robin.
+ * Allocates per task, not for use on the audio thread.
+ */
+class WorkStealingPool
+{
+public:
+  using Task = std::function<void()>;
+
+  /**
+   * nThreads - number of workers, 0 = hardware concurrency
+   */
+  explicit WorkStealingPool(int nThreads = 0)
+  {
+    if(nThreads <= 0)
+    {
+      nThreads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+
+    for(int i = 0; i < nThreads; i++)
+    {
+      queues.push_back(std::make_unique<Queue>());
+    }
+    for(int i = 0; i < nThreads; i++)
+    {
+      threads.emplace_back([this, i]() { WorkerLoop(i); });
+    }
+  }
+
+  ~WorkStealingPool()
+  {
+    Wait();
+    {
+      std::lock_guard<std::mutex> lock(sleepMutex);
+      stop = true;
+    }
+    wake.notify_all();
+    for(auto& t : threads)
+    {
+      t.join();
+    }
+  }
+
+  WorkStealingPool(const WorkStealingPool&) = delete;
+  WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+  int GetNumThreads() const { return static_cast<int>(threads.size()); }
+
+  /**
+   * Queue a task. Safe to call from inside a running task.
+   */
+  void Submit(Task task)
+  {
+    const int self = CurrentWorker();
+    const int idx = self >= 0 ? self : static_cast<int>(nextQueue++ % queues.size());
+    pending++;
+    {
+      std::lock_guard<std::mutex> lock(queues[idx]->mutex);
+      queues[idx]->tasks.push_back(std::move(task));
+    }
+    {
+      std::lock_guard<std::mutex> lock(sleepMutex);
+      queued++;
+    }
+    wake.notify_one();
+  }
+
+  /**
+   * Block until every submitted task, including tasks they submitted, has finished.
+   * Must not be called from inside a task.
+   */
+  void Wait()
+  {
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    idle.wait(lock, [this]() { return pending.load() == 0; });
+  }
+
+private:
+  struct Queue
+  {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  int CurrentWorker() const
+  {
+    return WorkerSlot().first == this ? WorkerSlot().second : -1;
+  }
+
+  static std::pair<const WorkStealingPool*, int>& WorkerSlot()
+  {
+    static thread_local std::pair<const WorkStealingPool*, int> slot {nullptr, -1};
+    return slot;
+  }
+
+  /**
+   * Take the newest task of queue self, else the oldest task of any other queue
+   */
+  bool TryTake(int self, Task& task)
+  {
+    {
+      std::lock_guard<std::mutex> lock(queues[self]->mutex);
+      if(!queues[self]->tasks.empty())
+      {
+        task = std::move(queues[self]->tasks.back());
+        queues[self]->tasks.pop_back();
+        return true;
+      }
+    }
+
+    const int n = static_cast<int>(queues.size());
+    for(int i = 1; i < n; i++)
+    {
+      Queue& victim = *queues[(self + i) % n];
+      std::lock_guard<std::mutex> lock(victim.mutex);
+      if(!victim.tasks.empty())
+      {
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void WorkerLoop(int self)
+  {
+    WorkerSlot() = {this, self};
+
+    for(;;)
+    {
+      {
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [this]() { return stop || queued > 0; });
+        if(stop && queued == 0)
+        {
+          return;
+        }
+      }
+
+      Task task;
+      if(!TryTake(self, task))
+      {
+        //Another worker got there first
+        std::this_thread::yield();
+        continue;
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        queued--;
+      }
+
+      task();
+
+      if(--pending == 0)
+      {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        idle.notify_all();
+      }
+    }
+  }
+
+  std::vector<std::unique_ptr<Queue>> queues;
+  std::vector<std::thread> threads;
+  std::atomic<int> pending {0};
+  std::atomic<unsigned> nextQueue {0};
+  std::mutex sleepMutex;
+  std::condition_variable wake;
+  std::condition_variable idle;
+  int queued = 0;
+  bool stop = false;
+};
@@ -1,7 +1,14 @@
 #pragma once
 #include "Eigen/Dense"
 #include <cmath>
+#include <algorithm>
+#include <cstring>
+#include <atomic>
 #include "layers.h"
+#include "SilenceGate.h"
+#include "DeltaNetwork.h"
+#include "ModelState.h"
+#include "Denormals.h"
 #include "gru-2-4.h"
 #include "gru-4-2.h"
 #include "gru-4-4.h"
@@ -37,8 +44,62 @@ template<typename T>
 class NN
 {
 public:
+  static constexpr int kNumModels = 27;
+  
   NN(){}
   
+  /**
+   * Name of a model index, in the same order as the plugin's model list
+   */
+  static const char* GetModelName(const int model)
+  {
+    static const char* names[kNumModels] = {
+      "gru-32-1",
+      "gru-16-2",
+      "gru-8-4",
+      "gru-16-1",
+      "gru-8-2",
+      "gru-4-4",
+      "gru-8-1",
+      "gru-4-2",
+      "gru-2-4",
+      "lstm-32-1",
+      "lstm-16-2",
+      "lstm-8-4",
+      "lstm-16-1",
+      "lstm-8-2",
+      "lstm-4-4",
+      "lstm-8-1",
+      "lstm-4-2",
+      "lstm-2-4",
+      "rnn-32-1",
+      "rnn-16-2",
+      "rnn-8-4",
+      "rnn-16-1",
+      "rnn-8-2",
+      "rnn-4-4",
+      "rnn-8-1",
+      "rnn-4-2",
+      "rnn-2-4"
+    };
+    return model >= 0 && model < kNumModels ? names[model] : "";
+  }
+  
+  /**
+   * Index of a model by name (eg. "lstm-8-4"), -1 if unknown
+   */
+  static int FindModel(const char* name)
+  {
+    for(int i = 0; i < kNumModels; i++)
+    {
+      if(std::strcmp(name, GetModelName(i)) == 0)
+      {
+        return i;
+      }
+    }
+    return -1;
+  }
+  
   /**
    * Process a single sample of audio using defined model
    */
@@ -132,6 +193,53 @@ public:
     }
   }
   
+  /**
+   * Process a block of audio using defined model. The model is selected once per block
+   * rather than once per sample.
+   */
+  void ProcessBlock(T* x, T* y, const int nFrames, const int model)
+  {
+    ScopedDenormalGuard denormalGuard;
+    
+    //Convergence of the previous model says nothing about the new one
+    if(model != lastModel)
+    {
+      gate.Reset();
+      delta.Reset();
+      lastModel = model;
+    }
+    
+    const bool valid = WithModel(model, [&](auto& m) {
+      ApplyBlock(m, x, y, nFrames);
+    });
+    
+    if(!valid)
+    {
+      //Pass output
+      std::copy(x, x + nFrames, y);
+    }
+  }
+  
+  /**
+   * Process a block with a model that is being faded out after a model change. It runs
+   * without the silence gate and delta network, whose state belongs to the active model.
+   */
+  void ProcessFadeOutBlock(T* x, T* y, const int nFrames, const int model)
+  {
+    ScopedDenormalGuard denormalGuard;
+    
+    const bool valid = WithModel(model, [&](auto& m) {
+      m.ProcessBlock(x, y, nFrames);
+      RecoverState(m, y, nFrames);
+    });
+    
+    if(!valid)
+    {
+      //Pass output
+      std::copy(x, x + nFrames, y);
+    }
+  }
+  
   //Models
   Gru_32_1<T> m0;
   Gru_16_2<T> m1;
@@ -168,5 +276,177 @@ public:
   Rnn_8_1<T> m24;
   Rnn_4_2<T> m25;
   Rnn_2_4<T> m26;
+  
+  /**
+   * Call f on the model with index model. Returns false for an unknown index.
+   */
+  template<typename F>
+  bool WithModel(const int model, F&& f)
+  {
+    switch(model) {
+      case 0:
+        f(m0);
+        return true;
+      case 1:
+        f(m1);
+        return true;
+      case 2:
+        f(m2);
+        return true;
+      case 3:
+        f(m3);
+        return true;
+      case 4:
+        f(m4);
+        return true;
+      case 5:
+        f(m5);
+        return true;
+      case 6:
+        f(m6);
+        return true;
+      case 7:
+        f(m7);
+        return true;
+      case 8:
+        f(m8);
+        return true;
+      case 9:
+        f(m9);
+        return true;
+      case 10:
+        f(m10);
+        return true;
+      case 11:
+        f(m11);
+        return true;
+      case 12:
+        f(m12);
+        return true;
+      case 13:
+        f(m13);
+        return true;
+      case 14:
+        f(m14);
+        return true;
+      case 15:
+        f(m15);
+        return true;
+      case 16:
+        f(m16);
+        return true;
+      case 17:
+        f(m17);
+        return true;
+      case 18:
+        f(m18);
+        return true;
+      case 19:
+        f(m19);
+        return true;
+      case 20:
+        f(m20);
+        return true;
+      case 21:
+        f(m21);
+        return true;
+      case 22:
+        f(m22);
+        return true;
+      case 23:
+        f(m23);
+        return true;
+      case 24:
+        f(m24);
+        return true;
+      case 25:
+        f(m25);
+        return true;
+      case 26:
+        f(m26);
+        return true;
+      default:
+        return false;
+    }
+  }
+  
+  /**
+   * Call f on every model
+   */
+  template<typename F>
+  void ForEachModel(F&& f)
+  {
+    f(m0); f(m1); f(m2); f(m3); f(m4); f(m5); f(m6); f(m7); f(m8);
+    f(m9); f(m10); f(m11); f(m12); f(m13); f(m14); f(m15); f(m16); f(m17);
+    f(m18); f(m19); f(m20); f(m21); f(m22); f(m23); f(m24); f(m25); f(m26);
+  }
+  
+  /**
+   * Return every model to its initial state
+   */
+  void Reset()
+  {
+    ForEachModel([](auto& m) { ResetState(m); });
+    gate.Reset();
+    delta.Reset();
+  }
+  
+  /**
+   * Number of times a model was reset because its state went NaN or Inf
+   */
+  int GetStateResetCount() const { return stateResets.load(std::memory_order_relaxed); }
+  
+  //Skips the active model on idle input in ProcessBlock
+  SilenceGate<T> gate;
+  
+  //Delta network execution of the active model in ProcessBlock, replaces the silence gate when enabled
+  DeltaNetwork<T> delta;
+  
+private:
+  template<typename M>
+  void ApplyBlock(M& m, T* x, T* y, const int nFrames)
+  {
+    if(delta.IsEnabled())
+    {
+      delta.Process(m, x, y, nFrames);
+    }
+    else
+    {
+      gate.Process(m, x, y, nFrames);
+    }
+    
+    if(RecoverState(m, y, nFrames))
+    {
+      gate.Reset();
+      delta.Reset();
+    }
+  }
+  
+  /**
+   * A single NaN would otherwise stay in the recurrent state forever. Resets the model and
+   * zeroes non-finite output if its state is not finite, returns true if it did.
+   */
+  template<typename M>
+  bool RecoverState(M& m, T* y, const int nFrames)
+  {
+    if(StateIsFinite(m))
+    {
+      return false;
+    }
+    
+    ResetState(m);
+    stateResets.fetch_add(1, std::memory_order_relaxed);
+    for(int s = 0; s < nFrames; s++)
+    {
+      if(!std::isfinite(y[s]))
+      {
+        y[s] = 0;
+      }
+    }
+    return true;
+  }
+  
+  int lastModel = -1;
+  std::atomic<int> stateResets {0};
 
 };
@@ -7,20 +7,16 @@
 */
 
 #pragma once
-#include "layers.h"
+#include "Model.h"
 
 template<typename T>
-class Gru_16_1
+class Gru_16_1 : public Model<T, Gru<16>, Dense<1>>
 {
 public:
-	const static int h = 16;
-	const static int d = 1;
-	const static int layers = 1;
-
-	FccLayer<T, h, d> f;
-	GruLayer<T, h, d> l0;
-
 	Gru_16_1() {
+		auto& f = this->f;
+		auto& l0 = GetLayer<0>(*this);
+
 		l0.Wir <<  0.27893916,-2.1258757 ,-0.3970895 ,-0.5574526 , 2.523165  , 0.84526104, -3.6282525 ,-0.7521546 , 0.81744605, 1.9932568 ,-0.295576  ,-0.5134377 ,  1.8504004 ,-0.13971417, 0.20421004, 1.2244154 ;
 		l0.Wiz <<  0.02659834, 1.2554411 , 0.09727331, 2.4422328 , 6.9741163 ,-0.30447254, -0.35997212,-0.3051374 ,-0.95647854,-0.64692104,-4.029797  ,-2.170972  , -3.2995517 , 3.1043587 ,-0.03954135,-0.06517141;
 		l0.Win <<  0.32523045, 1.5146903 ,-0.04441947,-0.47936296,-1.9159491 , 0.36180255, -0.9666442 ,-0.06086715, 0.5617051 ,-0.41070625,-0.7751687 , 0.4612036 , -0.8650407 ,-0.89856225,-0.3680561 , 0.96806896;
@@ -37,14 +33,7 @@ public:
 		l0.bhz <<  0.8151953 ,-0.04045216, 0.97819704,-1.363327  , 0.5596629 ,-1.366977  , -0.7351249 ,-0.5268156 , 0.02896106,-0.6784932 , 0.04403391, 1.3805687 ,  0.19210815, 0.88054466, 2.2611835 ,-1.285048  ;
 		l0.bhn <<  0.11235637,-0.08201875, 0.17643934, 0.24211232,-0.00215196, 0.1090021 , -0.09217978, 0.21715723, 0.14639936,-0.20694888, 0.20192048,-0.1997313 , -0.16298842, 0.04474931,-0.02064876, 0.26035807;
 
-		l0.htn1 << 0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.;
-
 		f.A <<  0.20492052,-0.33631343, 0.18189   , 0.24872412,-0.01715062, 0.05266555,  0.15256317, 0.14832914, 0.19716908, 0.1535017 ,-0.14224797,-0.15405113,  0.46534947, 0.05340185,-0.07787204,-0.17626143;
 		f.b << 0.08720787;
 	}
-
-	void apply_model(T* x, T* y) {
-		l0.apply_layer(*x);
-		*y=f.apply_layer(l0.ht);
-	}
 };
\ No newline at end of file
@@ -7,21 +7,17 @@
 */
 
 #pragma once
-#include "layers.h"
+#include "Model.h"
 
 template<typename T>
-class Gru_16_2
+class Gru_16_2 : public Model<T, Gru<16>, Gru<16>, Dense<1>>
 {
 public:
-	const static int h = 16;
-	const static int d = 1;
-	const static int layers = 2;
-
-	FccLayer<T, h, d> f;
-	GruLayer<T, h, d> l0;
-	GruLayer<T, h, h> l1;
-
 	Gru_16_2() {
+		auto& f = this->f;
+		auto& l0 = GetLayer<0>(*this);
+		auto& l1 = GetLayer<1>(*this);
+
 		l0.Wir << -0.9439706 , 0.7224515 ,-1.3896171 , 0.3964356 , 0.0410811 ,-0.48924088, -0.68596697, 2.171525  , 0.14718431,-1.8031199 ,-0.0529203 , 0.37238488, -0.2834706 , 0.89238596,-0.49455932, 0.49450234;
 		l0.Wiz << -1.9218254 , 3.1473987 , 5.527617  ,-0.75189775,-0.13398717, 1.7496414 ,  1.1712339 , 2.4975646 , 0.19318469,-0.47757164,-2.2457688 ,-2.0986054 ,  0.3506293 , 0.6031943 , 0.18779737,-0.28291205;
 		l0.Win <<  1.5624487 , 0.85018533, 1.2173139 , 0.08488095,-0.5242452 , 0.37934515,  0.11419888, 1.8659626 ,-0.29233676, 1.2567198 , 0.34954378, 0.25584567,  0.22921048, 1.3315179 ,-0.02155741, 0.88393724;
@@ -38,8 +34,6 @@ public:
 		l0.bhz << -2.2499464 ,-0.6695939 ,-2.5168455 ,-0.03686955,-0.5721556 ,-0.35598132,  0.20933335,-1.7572902 , 0.40876034,-0.82097226,-1.2161124 ,-0.36414823, -0.5002111 ,-1.7019132 ,-2.3440459 , 0.5759782 ;
 		l0.bhn << -0.03071878, 0.22837351,-0.00979532, 0.27466568,-0.06589767, 0.04863128,  0.16313735, 0.42990062, 0.20738688,-0.12502412, 0.12459188, 0.23160039, -0.12662749, 0.13682169, 0.01743958,-0.12073138;
 
-		l0.htn1 << 0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.;
-
 		l1.Wir <<  7.95397162e-01, 2.87991911e-01, 1.72480702e+00, 6.97070640e-03, -8.18395078e-01,-1.23443566e-02, 1.89986691e-01, 1.00629485e+00, -3.18203598e-01, 4.79729436e-02,-9.39788818e-02, 1.31860316e-01, -8.70576560e-01, 7.43170977e-01, 1.67439118e-01, 1.95328131e-01, -3.82381350e-01, 2.60636032e-01,-1.38757467e-01, 8.68579894e-02,  1.04985856e-01, 1.61426127e-01,-8.14391226e-02, 1.17480978e-01, -2.96437498e-02, 2.93584853e-01, 7.60578290e-02, 2.44022787e-01,  1.98993251e-01,-1.33884788e-01, 1.99038506e-01, 8.11288431e-02,  1.49084544e-02,-4.37131077e-02, 3.42840999e-02,-7.18386238e-03,  3.82271796e-01,-2.37944230e-01,-9.22246873e-02, 5.52312024e-02,  4.70021695e-01,-3.65588278e-01, 3.98154646e-01, 2.21768796e-01,  1.34896711e-02, 9.77424458e-02, 1.21067658e-01,-2.50286400e-01, -6.59654856e-01,-1.95193157e-01,-4.87529606e-01, 3.57200712e-01,  4.74992901e-01,-1.54718593e-01,-4.56565134e-02,-2.74337083e-01,  8.01244453e-02,-8.87375593e-01, 1.30897537e-01,-1.43881381e-01, -3.74692112e-01,-3.70125324e-01, 1.86829969e-01,-1.99284941e-01, -6.36365533e-01,-2.58229941e-01,-5.08641124e-01,-8.48374814e-02,  2.41165429e-01,-1.00980997e-01,-2.37514511e-01,-8.44457686e-01, -1.14473589e-01, 2.00101182e-01,-1.71146750e-01, 1.16418302e-01, -3.39028635e-03,-5.87561429e-01, 2.78450191e-01,-2.33570769e-01, -1.32410240e+00,-7.42684826e-02,-7.00075030e-01,-1.79961056e-01,  9.38222051e-01,-2.54122168e-01,-1.24744050e-01,-1.10759950e+00,  4.89097565e-01, 2.75581449e-01,-5.16300917e-01,-4.46059465e-01,  4.98171061e-01,-5.42937100e-01, 1.16139092e-01, 3.31867486e-01,  3.09956640e-01,-6.87787458e-02, 3.60389590e-01, 3.73890735e-02, -2.41297141e-01, 9.74348411e-02, 8.73897150e-02, 5.34650385e-01,  2.79999077e-01, 3.31436634e-01,-1.31201982e-01, 2.86130041e-01,  6.92795217e-02, 4.72425222e-01,-6.68075457e-02,-1.51445135e-01, -5.36833823e-01, 1.91070512e-01,-4.72610563e-01, 8.95222798e-02,  5.31920969e-01,-9.48555544e-02, 9.76121128e-02,-4.26561326e-01, -2.65621260e-04, 3.11774343e-01,-9.47510004e-02, 2.34035254e-02,  4.29632455e-01, 2.87507266e-01,-7.17939734e-02, 1.16089314e-01,  1.05283320e+00, 2.16946495e-03, 5.16326427e-01, 2.66731322e-01, -3.26965421e-01,-1.79811060e-01, 6.08861521e-02, 4.69763786e-01, -1.48255497e-01, 4.20266300e-01, 5.11992015e-02,-1.22564547e-01,  4.13295701e-02, 1.85633942e-01,-1.56528696e-01,-2.76854932e-01,  9.50409546e-02,-1.02926128e-01,-7.78860629e-01, 8.65004808e-02, -1.50251999e-01,-2.19517022e-01, 1.56665266e-01,-4.66520160e-01,  3.91198874e-01, 1.58767208e-01, 6.99600205e-02,-9.83032733e-02,  3.21165413e-01, 1.54880151e-01, 1.32665604e-01, 2.57250607e-01,  5.86537719e-01, 1.15646154e-01, 1.44784465e-01, 1.53296888e-01, -2.43848175e-01,-2.37057760e-01, 5.44783175e-02, 4.93016243e-01,  5.02281189e-02, 2.64184833e-01, 2.81087667e-01,-1.51053399e-01, -7.80651271e-01, 3.87709327e-02,-8.94945674e-03,-3.61245513e-01, -6.07847631e-01, 1.58466101e-01,-2.69021809e-01,-5.75620458e-02,  3.19024026e-01,-3.28128815e-01,-8.83062719e-04,-9.57623795e-02,  1.41902134e-01,-1.91151202e-01, 3.26866686e-01, 1.00186795e-01, -4.32300307e-02, 1.44557819e-01,-3.57024483e-02,-4.64332193e-01,  4.92229789e-01, 1.17418557e-01,-1.80317182e-02,-2.70843893e-01, -1.00724655e-03,-1.58374906e-01, 2.18440127e-03,-2.51327287e-02, -3.61929163e-02,-6.34332672e-02,-7.41052181e-02,-1.71028838e-01,  3.54243964e-01,-1.42746493e-01, 2.61715800e-01, 1.74979642e-01,  3.52597803e-01,-2.57130135e-02, 2.19010919e-01,-7.37352595e-02,  8.58492851e-02, 2.15961337e-01, 5.78472130e-02, 4.47083898e-02, -1.43062070e-01, 2.77826726e-01, 2.27361426e-01, 9.42580104e-02, -1.55346813e-02, 2.05746561e-01,-1.23475142e-01,-2.79532492e-01, -4.01492476e-01, 1.19592644e-01,-1.98472619e-01,-7.52570182e-02, -2.45850068e-02, 7.30975196e-02,-2.66557932e-02,-7.96958581e-02, -1.01893626e-01, 3.40879649e-01,-1.61419392e-01, 2.03980699e-01,  1.82829961e-01,-2.10631013e-01,-2.55527467e-01,-2.48983741e-01,  2.03921840e-01, 2.69439667e-01,-1.23495152e-02, 9.35349837e-02,  2.91387141e-01,-2.13491395e-02,-1.67941097e-02, 2.27237582e-01,  2.65955776e-01, 5.19776978e-02, 2.10109383e-01, 1.99763536e-01,  2.11723998e-01, 1.13760985e-01, 4.65275526e-01, 3.17022890e-01;
 		l1.Wiz << -0.24144492, 0.4342422 , 0.15423566, 0.12254014, 0.43711135, 0.20598862,  0.46859318,-0.22783513,-0.6565622 ,-0.65968096, 0.13810758, 0.22072467,  0.37679726, 0.9143584 , 0.18793797, 0.35318652, 0.45418358, 0.0998762 ,  1.4363301 ,-0.555704  ,-2.0569026 , 0.72954905, 0.6011492 , 1.2356896 , -0.9084837 , 0.74239266,-0.24208468,-0.24093324, 0.01816852, 1.2314405 , -0.88391006, 0.17602155,-0.5028315 , 0.0517101 ,-0.8498266 , 2.0841162 ,  1.4838197 ,-1.6235554 ,-0.6307086 ,-1.2754012 , 0.728864  ,-3.137036  , -0.26720423, 0.5284375 ,-0.07220549,-1.2291865 , 1.2933929 ,-0.58236736, -0.6040165 , 0.7366718 , 0.45454532,-0.5441226 ,-0.26322854, 0.7161246 ,  0.16261426,-0.79084074,-0.78617   ,-0.86925316,-0.40877852,-0.20573363, -0.08237986, 1.010621  ,-0.3033651 , 0.81575817,-0.91987735, 0.13691926, -0.8120038 , 0.16242026, 0.56061864,-0.12179098,-0.39965412,-0.06238662, -0.34645715,-0.9857764 ,-0.14163259,-0.26010805,-0.46339414, 0.04118817,  0.13168624, 0.3172483 , 0.16408332, 1.0757164 ,-0.7686474 , 0.7890617 , -1.176403  ,-1.0206816 ,-0.96678627, 1.9092203 , 0.6102925 ,-0.4411551 ,  0.89148897, 0.9828146 ,-2.4731295 , 1.2416228 , 0.44819024,-2.6254454 , -1.395504  , 0.16762532,-0.6281532 ,-0.45728305, 0.57513994, 0.64985377,  0.02812038,-0.58221596, 0.14086871, 0.5880201 ,-0.51998764,-0.48576015,  1.2765508 ,-0.04678346, 0.17983468, 1.2072678 ,-0.3826351 ,-0.20612119, -0.66492563,-0.17936641,-0.30889648, 0.29477796, 0.14461066,-0.38500744, -0.3224384 ,-0.39265266, 0.17339508,-0.12419401,-0.50634325,-0.63874954,  0.02715149, 0.5213512 ,-0.04278024, 0.42362377, 0.06370908, 0.34215936, -0.3571599 , 0.18837757, 0.0524821 ,-0.50638413,-0.5347471 , 0.32736763, -0.11732132, 0.1855539 , 0.08300685, 0.81499106,-0.4289728 , 0.82710737, -0.34251294, 0.43150887, 0.05484036, 0.9789513 , 0.2996692 ,-0.683336  , -0.98928416,-0.04400829, 0.9723919 ,-1.0365586 ,-0.28893006, 0.32764137, -0.80302113, 0.02157389, 0.8656182 ,-0.82118255,-0.19173856,-1.0935417 , -0.36205104,-0.5716545 ,-0.9125693 , 0.3680345 , 0.47415152, 0.49095267, -0.62477434, 0.82346475,-0.22198173,-0.15513004,-0.7455216 ,-0.10059267, -0.04375205, 0.56467223, 0.05941846, 0.59698063,-0.17933719, 0.2135987 ,  0.62004447,-0.29623356,-0.79953384, 0.40547442, 0.70421803,-0.1614237 ,  0.93757033, 0.42554784,-0.59000885, 0.290029  , 0.8279971 ,-0.39499736,  0.79649645,-0.2756034 , 0.95229733,-0.32087162,-0.82905614,-0.41968986,  0.07960888, 0.02425749,-0.06889886, 1.9636137 ,-0.1398696 , 0.25246793,  0.0035723 , 0.6424041 , 0.03938926, 0.694188  ,-0.177146  ,-0.19963606, -0.18664068,-0.02631741, 0.20339233,-0.4738266 ,-1.09753   , 0.11297919,  0.66444916,-0.23906118, 0.09514676, 0.11584771,-0.5071367 , 0.2956659 ,  0.6083076 , 0.35298187,-0.11095064, 0.407085  , 0.57703763, 0.11983375,  0.5439961 ,-0.04527342,-0.06037755,-0.01417012,-0.03867563,-0.48421392,  0.96600014, 0.20766665,-0.24129497, 0.6045227 , 0.46840364, 0.4420158 , -1.8068608 ,-0.13056314,-0.8518138 , 0.37084183, 1.4904943 ,-0.85485643, -0.90288824,-0.8993093 , 1.1186327 ,-1.8231668 , 0.3013725 , 0.50672823, -0.5924819 ,-1.0308278 , 0.6887605 , 0.16038229;
 		l1.Win <<  5.45137882e-01, 2.99521059e-01, 5.87196708e-01, 1.35272130e-01, -1.78449646e-01, 3.01212221e-01, 1.08584575e-01, 3.20950150e-01, -1.31978989e-01, 3.81320596e-01, 2.51334637e-01, 1.48232445e-01,  3.87396179e-02, 2.34004244e-01,-2.25614443e-01, 3.31137955e-01, -6.51020370e-03, 1.12657927e-01, 1.22097008e-01,-1.82549670e-01, -1.98369727e-01,-2.02205181e-01,-2.17453256e-01,-1.39866835e-02,  3.60687152e-02,-1.99785024e-01, 2.74235576e-01,-2.00787256e-03,  3.88975263e-01,-6.89047277e-02, 2.08513886e-02, 1.73706412e-01, -6.49751499e-02,-6.78420365e-02,-2.38851205e-01, 8.67789984e-03,  3.59915704e-01,-2.05743209e-01,-4.53105271e-02, 5.50037362e-02,  2.28069238e-02,-3.50118071e-01, 1.15773477e-01, 1.52021438e-01,  6.99739158e-02,-1.63297966e-01,-1.91349313e-02,-2.65214264e-01,  2.32168287e-01,-2.87714385e-04, 7.05900371e-01,-1.13441855e-01, -3.97783190e-01,-3.21717858e-02, 4.44982424e-02, 1.60456926e-01, -2.02332497e-01, 1.55728772e-01,-8.45021382e-02,-9.15601104e-02, -2.27002934e-01, 6.65660381e-01,-7.04886690e-02,-3.92258018e-01, -3.17666024e-01,-2.03042343e-01,-2.88879544e-01,-2.10717887e-01,  2.17323586e-01, 2.10277334e-01, 2.68901557e-01,-2.21157119e-01, -1.88824505e-01,-3.33347440e-01,-1.24172084e-01,-1.27674356e-01,  2.36197039e-02,-1.70389280e-01,-1.96494550e-01, 3.53157856e-02, -2.47668147e-01,-1.01517059e-01, 4.47323844e-02,-6.04006015e-02, -4.06441331e-01, 3.52756046e-02, 3.08660656e-01,-3.64246666e-01,  8.83657560e-02, 1.89089030e-01,-1.44338217e-02,-3.69891934e-02, -2.74444669e-01, 3.71268719e-01,-2.17451543e-01, 1.68029498e-02,  5.47987074e-02, 1.22953691e-01, 4.03363973e-01,-1.65748104e-01, -1.57205626e-01,-6.67246655e-02,-1.14256196e-01, 3.14067572e-01,  2.04765275e-01,-7.68281370e-02,-5.32107949e-02, 6.69695735e-02, -2.29098406e-02, 6.38144910e-02,-9.66816023e-02, 1.74957037e-01,  1.16211534e-01, 7.51474053e-02,-2.84277707e-01, 2.30064452e-01, -2.00762302e-01, 5.12294061e-02,-1.91450015e-01,-3.02566975e-01, -2.05364287e-01,-3.28451872e-01,-1.90791786e-01, 7.41372034e-02, -2.05439895e-01,-2.00294986e-01,-2.09580585e-01, 1.71378136e-01,  2.22984120e-01,-2.46598884e-01, 6.39444366e-02,-8.62942711e-02, -5.21809123e-02, 1.80834725e-01, 2.25791797e-01, 2.85299301e-01, -1.96057603e-01, 2.03804165e-01,-2.21867427e-01, 1.52044788e-01,  2.40874797e-01,-1.21531241e-01,-7.95729086e-02,-1.06039502e-01, -5.46801537e-02, 9.15801823e-02, 1.71358943e-01, 1.04681015e-01, -1.42680332e-01, 1.03916004e-01, 9.38738510e-02,-9.05555189e-02, -1.91806585e-01, 2.91039467e-01,-1.92166388e-01, 9.25926715e-02, -7.61750340e-02, 1.94092914e-01,-1.76960319e-01, 1.36066183e-01, -1.88393727e-01,-4.70281430e-02,-1.58479035e-01,-1.09223604e-01,  3.14083725e-01, 1.63377985e-01, 2.72666812e-01, 1.22615874e-01,  2.32105441e-02,-1.10799111e-01,-1.79457530e-01, 1.57692760e-01, -1.12455655e-02,-3.24215174e-01,-1.64338961e-01, 8.16674307e-02, -3.63625586e-01, 2.21393317e-01,-9.86238196e-02, 2.14911610e-01,  2.08232582e-01, 1.04405448e-01,-7.09898323e-02,-9.16929822e-03,  2.76468962e-01,-9.92576927e-02,-7.16937110e-02, 2.10856304e-01,  1.59662127e-01,-1.51945785e-01, 3.44727258e-03, 8.10066387e-02,  1.16600432e-01,-6.72030672e-02,-1.28232971e-01, 1.41229674e-01, -3.34896833e-01,-1.68175384e-01, 2.51831979e-01, 1.35618716e-01, -4.32643890e-02, 2.53580481e-01,-1.82052364e-03,-2.28411794e-01, -1.60775378e-01, 6.98534921e-02, 3.21707428e-02, 8.27715099e-02, -6.03899136e-02,-1.37139231e-01, 1.37744829e-01,-2.20594600e-01, -2.99641460e-01, 1.63464621e-01,-4.10280414e-02,-2.74810623e-02, -1.68747306e-01,-1.10367753e-01,-8.76459256e-02,-1.21941552e-01, -3.48895043e-02, 9.66291223e-03,-2.46833041e-01, 6.41977564e-02, -2.19784498e-01, 8.64122435e-02,-2.41774723e-01, 1.50520086e-01,  5.32007264e-03, 9.71568674e-02,-1.80997420e-03, 1.49312327e-02, -1.74191535e-01, 5.40147498e-02,-1.98058233e-01, 2.58505076e-01, -5.27617112e-02, 1.76878020e-01, 1.69447124e-01,-1.80715442e-01,  6.00856058e-02, 2.56979644e-01, 7.56455839e-01, 1.41397953e-01,  3.02384526e-01, 3.00650038e-02,-2.30792731e-01, 2.41170481e-01, -1.35876879e-01, 1.50220513e-01,-1.67477369e-01,-4.66190167e-02,  2.70270675e-01,-1.88310936e-01, 6.32281825e-02, 1.72605440e-02;
@@ -56,15 +50,7 @@ public:
 		l1.bhz << -0.04739672,-0.16099592, 0.3919905 ,-0.61403173,-0.5226063 , 0.971736  , -0.7273371 ,-0.1305485 ,-0.26329756, 0.5675337 ,-1.3178856 , 0.9794231 , -0.23155811,-0.40301868, 0.26848695, 0.08659443;
 		l1.bhn <<  0.08745799, 0.14257735, 0.03664549,-0.17753232,-0.21249141, 0.20191975,  0.14130701,-0.10492832,-0.03167261,-0.04270551,-0.2727418 , 0.09861345,  0.06306724,-0.11212786, 0.12065415,-0.15184857;
 
-		l1.htn1 << 0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.;
-
 		f.A <<  0.05358513,-0.10366008, 0.01574804, 0.16906846,-0.2670302 ,-0.02227836,  0.08064642,-0.06410672, 0.23408759, 0.01054003,-0.10547752, 0.20525861, -0.06817457,-0.11747938,-0.19088854, 0.11092967;
 		f.b << -0.15442017;
 	}
-
-	void apply_model(T* x, T* y) {
-		l0.apply_layer(*x);
-		l1.apply_layer(l0.ht);
-		*y=f.apply_layer(l1.ht);
-	}
 };
\ No newline at end of file
@@ -7,23 +7,19 @@
 */
 
 #pragma once
-#include "layers.h"
+#include "Model.h"
 
 template<typename T>
-class Gru_2_4
+class Gru_2_4 : public Model<T, Gru<2>, Gru<2>, Gru<2>, Gru<2>, Dense<1>>
 {
 public:
-	const static int h = 2;
-	const static int d = 1;
-	const static int layers = 4;
-
-	FccLayer<T, h, d> f;
-	GruLayer<T, h, d> l0;
-	GruLayer<T, h, h> l1;
-	GruLayer<T, h, h> l2;
-	GruLayer<T, h, h> l3;
-
 	Gru_2_4() {
+		auto& f = this->f;
+		auto& l0 = GetLayer<0>(*this);
+		auto& l1 = GetLayer<1>(*this);
+		auto& l2 = GetLayer<2>(*this);
+		auto& l3 = GetLayer<3>(*this);
+
 		l0.Wir << 0.73170173,1.8199013 ;
 		l0.Wiz << -1.0353577, 3.093266 ;
 		l0.Win <<  1.8550142,-1.281948 ;
@@ -40,8 +36,6 @@ public:
 		l0.bhz << -1.1480725,-4.9265094;
 		l0.bhn <<  0.28657708,-0.66745263;
 
-		l0.htn1 << 0.,0.;
-
 		l1.Wir << -1.2510879, 1.7820867, 1.1093959,-2.5185828;
 		l1.Wiz << -1.4426203,-1.1308622, 3.0357575,-5.0806985;
 		l1.Win << -0.3619458 , 0.29371178, 0.7308175 ,-0.9404542 ;
@@ -58,8 +52,6 @@ public:
 		l1.bhz << -1.5317484, 2.3256383;
 		l1.bhn << 0.5689794 ,0.42432982;
 
-		l1.htn1 << 0.,0.;
-
 		l2.Wir <<  0.9711418,-1.0965059, 1.2748269,-0.8333272;
 		l2.Wiz <<  2.5833511 ,-1.0176791 ,-0.5970022 , 0.38189897;
 		l2.Win <<  1.9812739 ,-0.96994317, 0.39501327,-0.1971058 ;
@@ -76,8 +68,6 @@ public:
 		l2.bhz << -0.35967472, 2.2250881 ;
 		l2.bhn << 0.3391896,0.4545959;
 
-		l2.htn1 << 0.,0.;
-
 		l3.Wir << -0.49244878,-1.172149  ,-1.1232188 , 0.7346976 ;
 		l3.Wiz <<  9.734827 , 1.0713928, 2.2314696,-2.682722 ;
 		l3.Win << -1.1680564 ,-0.87083507,-0.54275745, 0.4242437 ;
@@ -94,17 +84,7 @@ public:
 		l3.bhz <<  1.4739358,-4.863761 ;
 		l3.bhn << 0.64099485,0.30651036;
 
-		l3.htn1 << 0.,0.;
-
 		f.A << -0.19534938,-0.66420937;
 		f.b << 0.28236303;
 	}
-
-	void apply_model(T* x, T* y) {
-		l0.apply_layer(*x);
-		l1.apply_layer(l0.ht);
-		l2.apply_layer(l1.ht);
-		l3.apply_layer(l2.ht);
-		*y=f.apply_layer(l3.ht);
-	}
 };
\ No newline at end of file
@@ -7,20 +7,16 @@
 */
 
 #pragma once
-#include "layers.h"
+#include "Model.h"
 
 template<typename T>
-class Gru_32_1
+class Gru_32_1 : public Model<T, Gru<32>, Dense<1>>
 {
 public:
-	const static int h = 32;
-	const static int d = 1;
-	const static int layers = 1;
-
-	FccLayer<T, h, d> f;
-	GruLayer<T, h, d> l0;
-
 	Gru_32_1() {
+		auto& f = this->f;
+		auto& l0 = GetLayer<0>(*this);
+
 		l0.Wir <<  0.42766395,-0.43099263, 0.15104263, 0.10165697,-0.5989094 , 0.11671366,  0.8173448 , 0.8467096 ,-1.5310674 , 1.85702   , 0.46533296,-0.4159454 , -0.5700047 ,-0.3359856 , 0.03878533, 0.24606857,-0.09333429, 0.09959096, -0.0111119 ,-1.1118628 , 0.9111333 , 0.0432326 ,-0.1567214 , 0.24371731, -1.2155083 ,-0.16574125,-0.554381  ,-0.1783082 ,-0.85453856, 0.63864195,  0.1311472 ,-0.9095916 ;
 		l0.Wiz <<  3.0497656 , 0.35859925,-0.0108089 , 1.2490764 , 0.2720147 ,-0.2750713 , -7.200796  ,-0.5190284 ,-1.3219819 ,-0.62573874, 1.3936085 ,-0.14787349, -0.1443417 , 1.6140577 , 4.8502746 ,-1.8856869 , 2.3917086 ,-3.4275126 ,  0.42504668,-2.1006038 , 0.45289123,-0.32615578, 0.05291725,-0.9720949 , -0.19264911, 0.61590546,-0.03058002, 0.9038171 ,-1.6877093 , 0.01470509,  0.22223715, 3.316838  ;
 		l0.Win <<  0.9680193 ,-0.1024133 , 0.4984012 ,-1.1054988 , 0.2576347 , 0.10807227,  0.14848348, 2.2488487 ,-0.5520805 ,-1.3345734 , 0.5785185 , 0.20075122, -0.0198545 , 0.58235335, 0.57221335, 0.1306757 ,-1.0668285 , 0.15456603,  0.1967976 , 1.155783  ,-0.7132265 ,-0.19163914,-0.31955007,-0.0077171 ,  1.7193792 ,-2.1425781 , 0.29531097,-0.10470694, 0.4591982 , 0.06724364, -0.4952107 , 0.23775439;
@@ -37,14 +33,7 @@ public:
 		l0.bhz << -0.49802434, 0.01706184,-0.22772683,-0.85337776,-0.69672126, 0.05141955, -0.15915492,-0.727919  , 0.53672516,-0.3806699 ,-0.3931893 , 1.7563443 , -0.1430344 ,-0.04038498, 1.1307698 ,-0.07482649,-0.7372256 ,-0.31188145,  0.5723215 ,-0.5967447 ,-0.43028915,-0.30118415, 0.06109455,-0.37690875, -0.373219  ,-0.6185186 ,-0.187164  ,-0.36086607,-0.2212408 , 0.17595783,  1.605103  , 0.67783195;
 		l0.bhn << -0.01845269,-0.09850569,-0.02191368,-0.16175427,-0.06349612,-0.0715783 ,  0.18115364,-0.03288107, 0.16518752,-0.17612644,-0.06942739, 0.09124255, -0.09182426,-0.1447633 , 0.0005163 , 0.08725851,-0.05126464, 0.05683129,  0.12956251,-0.07050719, 0.05933398,-0.12765695,-0.16848245, 0.12045985, -0.03929141,-0.05997002, 0.00202414, 0.16178013, 0.11108608,-0.14948948,  0.04684114, 0.04034922;
 
-		l0.htn1 << 0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0., 0.,0.,0.,0.,0.,0.,0.,0.;
-
 		f.A << -0.13293073,-0.05015588,-0.16244711, 0.05296609,-0.15803975,-0.14714152, -0.14504439,-0.09481631, 0.16861667, 0.12309469,-0.17794223,-0.11440527, -0.18137476,-0.12620763,-0.06380118, 0.24522439, 0.08790296,-0.13573089, -0.01528473,-0.17140841, 0.1813428 , 0.15878396,-0.12755731,-0.10848299, -0.10084685, 0.06215213,-0.18917115, 0.1301561 ,-0.17282656, 0.14365841, -0.11693647, 0.10465908;
 		f.b << 0.04237672;
 	}
-
-	void apply_model(T* x, T* y) {
-		l0.apply_layer(*x);
-		*y=f.apply_layer(l0.ht);
-	}
 };
\ No newline at end of file
@@ -7,21 +7,17 @@
 */
 
 #pragma once
-#include "layers.h"
+#include "Model.h"
 
 template<typename T>
-class Gru_4_2
+class Gru_4_2 : public Model<T, Gru<4>, Gru<4>, Dense<1>>
 {
 public:
-	const static int h = 4;
-	const static int d = 1;
-	const static int layers = 2;
-
-	FccLayer<T, h, d> f;
-	GruLayer<T, h, d> l0;
-	GruLayer<T, h, h> l1;
-
 	Gru_4_2() {
+		auto& f = this->f;
+		auto& l0 = GetLayer<0>(*this);
+		auto& l1 = GetLayer<1>(*this);
+
 		l0.Wir << -1.8892064, 4.816038 ,-1.9469038,-3.5019228;
 		l0.Wiz << -1.9703698,-1.486663 , 2.0468755, 1.2649411;
 		l0.Win << -0.6313784 ,-1.8038576 ,-1.0313373 ,-0.21424322;
@@ -38,8 +34,6 @@ public:
 		l0.bhz << -0.9779821,-1.8345214,-1.0401769, 2.7561352;
 		l0.bhn <<  0.24555911,-0.60312325,-0.1931712 , 0.13687816;
 
-		l0.htn1 << 0.,0.,0.,0.;
-
 		l1.Wir << -0.27199122,-1.333561  , 0.17300224, 0.3889428 ,-0.88803303,-0.64999294, -0.6237047 , 0.26393113,-0.44894138, 0.75531405, 0.18865101,-0.09519161,  3.7011552 , 0.6007876 , 1.0050408 ,-0.12053498;
 		l1.Wiz <<  0.8532494 ,-0.01733788,-0.2881158 , 1.3215739 , 3.833003  ,-0.24625067, -0.60189015,-0.7901541 ,-0.61514467,-2.517455  ,-0.9163626 , 1.3934046 ,  3.3834841 ,-0.02565162, 0.20059562, 1.0205101 ;
 		l1.Win <<  0.68023264, 0.50379246, 0.7553532 , 0.15753603,-0.03310113,-0.27118436, -0.21138106,-0.11748099, 0.4369494 , 0.36454   , 0.10902438, 0.08455969, -0.8878362 ,-0.27316   ,-0.88128084, 0.66926783;
@@ -56,15 +50,7 @@ public:
 		l1.bhz <<  2.2635267 ,-0.06160586,-0.71094406,-0.1758989 ;
 		l1.bhn << -0.27020097, 0.34844378,-0.5921277 ,-0.24239957;
 
-		l1.htn1 << 0.,0.,0.,0.;
-
 		f.A <<  0.17608471, 0.37994152,-0.33145112, 0.44371623;
 		f.b << -0.32140473;
 	}
-
-	void apply_model(T* x, T* y) {
-		l0.apply_layer(*x);
-		l1.apply_layer(l0.ht);
-		*y=f.apply_layer(l1.ht);
-	}
 };
\ No newline at end of file
@@ -7,23 +7,19 @@
 */
 
 #pragma once
-#include "layers.h"
+#include "Model.h"
 
 template<typename T>
-class Gru_4_4
+class Gru_4_4 : public Model<T, Gru<4>, Gru<4>, Gru<4>, Gru<4>, Dense<1>>
 {
 public:
-	const static int h = 4;
-	const static int d = 1;
-	const static int layers = 4;
-
-	FccLayer<T, h, d> f;
-	GruLayer<T, h, d> l0;
-	GruLayer<T, h, h> l1;
-	GruLayer<T, h, h> l2;
-	GruLayer<T, h, h> l3;
-
 	Gru_4_4() {
+		auto& f = this->f;
+		auto& l0 = GetLayer<0>(*this);
+		auto& l1 = GetLayer<1>(*this);
+		auto& l2 = GetLayer<2>(*this);
+		auto& l3 = GetLayer<3>(*this);
+
 		l0.Wir << -1.0174628 , 0.20717734, 4.1875134 ,-0.15309192;
 		l0.Wiz <<  -0.5749636,  2.4617474,  1.8048645,-10.067118 ;
 		l0.Win << -0.3046936, 1.0523466, 1.4080242,-0.8511566;
@@ -40,8 +36,6 @@ public:
 		l0.bhz << -0.3004794 ,-4.9596663 ,-2.1181514 , 0.31464022;
 		l0.bhn <<  0.7432255 ,-0.5354451 , 0.46440145,-0.49385998;
 
-		l0.htn1 << 0.,0.,0.,0.;
-
 		l1.Wir << -0.92566526,-0.86115485,-0.3170603 ,-0.9059549 ,-0.25953993, 0.2627743 ,  0.06761551,-0.20090099, 0.8139889 ,-0.26050746, 0.17946556,-0.33858716,  0.6749993 ,-0.8574713 ,-0.34467697,-0.7553538 ;
 		l1.Wiz << -1.3344105 ,-1.9035095 ,-1.3141731 , 0.36822546, 1.1693333 , 0.20502248, -0.32060185, 1.0840545 , 2.2482567 ,-1.0869589 ,-0.4637613 ,-1.3117576 ,  0.05072731,-2.2254112 ,-5.5485883 ,-0.95410854;
 		l1.Win <<  0.01878533, 0.3626592 , 0.95921797,-0.83412415,-0.40937132, 0.18789856, -0.26772237,-0.13059235,-0.41157347, 0.1840303 , 0.64927226,-0.7102377 ,  0.6831283 ,-0.11567075,-1.2676038 , 1.1839544 ;
@@ -58,8 +52,6 @@ public:
 		l1.bhz << -1.6750469 ,-0.13210112, 1.544614  , 0.12605283;
 		l1.bhn <<  0.07110404, 0.12084483,-0.14285345, 0.24696682;
 
-		l1.htn1 << 0.,0.,0.,0.;
-
 		l2.Wir <<  0.6569797 ,-1.4410545 , 0.9485761 ,-0.8188581 , 0.9073642 , 0.7762805 , -0.30571353,-0.22924788, 0.142834  ,-0.09873353, 0.26541662,-0.20196912, -0.3193399 ,-0.12537588, 0.61424744, 0.28145796;
 		l2.Wiz <<  0.4056287 ,-0.16507283,-0.757352  ,-2.2139702 , 2.2132547 , 3.7310603 ,  0.4291701 , 0.8492616 , 1.0059642 , 0.84595555,-0.34341142,-1.3868129 , -1.4744413 ,-1.7344815 ,-1.672837  , 1.9968678 ;
 		l2.Win <<  1.025191  ,-0.25178325, 0.7388501 ,-1.0932792 , 0.27148515, 0.5394441 , -0.09149153,-0.15508404,-0.60827774,-0.42383015, 0.47090587,-0.37998587,  0.42485857, 0.38764444,-0.48890287,-0.8416764 ;
@@ -76,8 +68,6 @@ public:
 		l2.bhz <<  0.27351218,-1.044119  ,-1.8066665 ,-0.52123845;
 		l2.bhn <<  0.10787399, 0.23512614,-0.41548273,-0.3736804 ;
 
-		l2.htn1 << 0.,0.,0.,0.;
-
 		l3.Wir << -0.9768311 ,-0.5104097 , 0.32602015,-0.44310448, 1.6291212 ,-0.5541421 ,  0.752578  , 0.40901646, 0.04983525,-0.89275527, 0.7231681 ,-0.7229029 ,  0.67285866,-0.38386402,-0.36641973,-0.287086  ;
 		l3.Wiz <<  0.28009433, 2.0199177 ,-1.0530841 , 1.6847854 ,-4.141548  ,-1.6405207 ,  1.7416856 ,-3.0308132 ,-1.4487581 ,-2.0684614 , 1.4021384 ,-3.1370714 , -2.702146  ,-2.360656  , 2.617509  ,-3.8319457 ;
 		l3.Win << -0.42811775,-0.8222731 , 0.27272272, 0.47548446,-0.23020929,-0.524625  ,  0.02198713, 0.1882763 , 0.6350405 , 0.6011843 ,-0.6399169 , 0.35964853,  0.3420525 ,-0.06070032,-0.19223878, 0.50494677;
@@ -94,17 +84,7 @@ public:
 		l3.bhz << -0.08726117,-2.7578938 ,-3.766388  ,-3.9843514 ;
 		l3.bhn <<  0.4132729 , 0.29086876,-0.2601275 ,-0.10032684;
 
-		l3.htn1 << 0.,0.,0.,0.;
-
 		f.A <<  0.2675774 , 0.10134018,-0.46924585,-0.29429603;
 		f.b << 0.4023674;
 	}
-
-	void apply_model(T* x, T* y) {
-		l0.apply_layer(*x);
-		l1.apply_layer(l0.ht);
-		l2.apply_layer(l1.ht);
-		l3.apply_layer(l2.ht);
-		*y=f.apply_layer(l3.ht);
-	}
 };
\ No newline at end of file
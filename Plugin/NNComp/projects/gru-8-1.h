@@ -7,20 +7,16 @@
 */
 
 #pragma once
-#include "layers.h"
+#include "Model.h"
 
 template<typename T>
-class Gru_8_1
+class Gru_8_1 : public Model<T, Gru<8>, Dense<1>>
 {
 public:
-	const static int h = 8;
-	const static int d = 1;
-	const static int layers = 1;
-
-	FccLayer<T, h, d> f;
-	GruLayer<T, h, d> l0;
-
 	Gru_8_1() {
+		auto& f = this->f;
+		auto& l0 = GetLayer<0>(*this);
+
 		l0.Wir <<  1.8422728 , 0.06536334, 0.53276914, 0.26808965, 3.2612278 ,-1.4393789 ,  2.1016226 , 0.0414125 ;
 		l0.Wiz << -7.756088 ,-1.4953905,-3.8684738, 4.6167016, 4.58307  ,-0.8138322, -4.6301904,-2.2786505;
 		l0.Win << -0.7007015 ,-1.4178905 , 0.64452296,-0.2210694 , 1.0894285 ,-0.14391007, -0.99526477, 0.38442498;
@@ -37,14 +33,7 @@ public:
 		l0.bhz <<  0.84189117,-0.87809503, 1.2497293 , 2.3331912 ,-1.6105835 , 1.181751  , -0.2160782 ,-0.8528844 ;
 		l0.bhn << -0.04314838,-0.00085158,-0.27204478, 0.09373655, 0.38045606,-0.09028518, -0.37312463,-0.34707478;
 
-		l0.htn1 << 0.,0.,0.,0.,0.,0.,0.,0.;
-
 		f.A <<  0.4054227 , 0.20639338, 0.267022  , 0.08973229,-0.5035806 ,-0.472147  ,  0.34590602, 0.46224377;
 		f.b << 0.18217367;
 	}
-
-	void apply_model(T* x, T* y) {
-		l0.apply_layer(*x);
-		*y=f.apply_layer(l0.ht);
-	}
 };
\ No newline at end of file
@@ -7,21 +7,17 @@
 */
 
 #pragma once
-#include "layers.h"
+#include "Model.h"
 
 template<typename T>
-class Gru_8_2
+class Gru_8_2 : public Model<T, Gru<8>, Gru<8>, Dense<1>>
 {
 public:
-	const static int h = 8;
-	const static int d = 1;
-	const static int layers = 2;
-
-	FccLayer<T, h, d> f;
-	GruLayer<T, h, d> l0;
-	GruLayer<T, h, h> l1;
-
 	Gru_8_2() {
+		auto& f = this->f;
+		auto& l0 = GetLayer<0>(*this);
+		auto& l1 = GetLayer<1>(*this);
+
 		l0.Wir <<  0.45656258, 0.44866747, 0.46986613, 0.17708106, 2.4579532 ,-0.0569401 , -1.2990896 , 3.8109558 ;
 		l0.Wiz <<  2.4748726,-3.2389612,-1.2617847, 0.5872553, 1.3211089, 1.3740914, -2.9897563, 1.1088424;
 		l0.Win << -0.55284226, 0.26850736,-1.2868751 ,-0.7271688 ,-0.7030903 , 0.936395  ,  0.4784288 , 1.4717445 ;
@@ -38,8 +34,6 @@ public:
 		l0.bhz << -0.00640721,-1.0882583 , 1.0204453 ,-1.7581183 ,-2.0954068 , 0.55681777,  1.7216281 ,-0.17138937;
 		l0.bhn << -0.4072977 , 0.13912505,-0.13268375, 0.00067488, 0.23883979,-0.2874453 , -0.25093687, 0.27903306;
 
-		l0.htn1 << 0.,0.,0.,0.,0.,0.,0.,0.;
-
 		l1.Wir <<  1.99070036e-01, 4.68672626e-02, 2.87753493e-01,-2.77417302e-01, -2.87265182e-01,-2.28230312e-01,-4.81575906e-01, 4.67017991e-03, -5.19939363e-01, 7.62935519e-01, 2.27625892e-01, 4.52583104e-01, -9.71578993e-03,-1.00449659e-01,-1.17820930e+00, 2.42909670e-01,  2.71904707e-01,-2.35295504e-01, 9.60382074e-02,-1.73313856e-01,  3.01448613e-01,-7.07785904e-01,-1.08184087e+00,-5.20827115e-01, -5.87915666e-02, 3.97346795e-01, 4.61778380e-02, 2.62100428e-01,  2.84880698e-01, 8.00125226e-02, 2.97874779e-01, 1.26173645e-01, -2.68346518e-01, 3.06465626e-01,-5.93693614e-01, 1.41184464e-01,  8.11482444e-02,-3.31503488e-02, 2.67096590e-02,-1.23027183e-01,  1.84933662e-01, 4.09828156e-01, 5.17580628e-01, 2.76944667e-01, -6.58264980e-02,-4.54789937e-01, 2.70045865e-02, 9.91042331e-02,  2.95879394e-01,-1.54621273e-01,-4.22888428e-01, 3.73730846e-02, -2.26915628e-01,-4.28758226e-02,-5.52279060e-04, 3.04588377e-01,  1.27327189e-01, 3.03575039e-01,-1.16033924e+00,-1.02977745e-01, -2.81198829e-01,-2.02410892e-02,-3.40658784e-01, 5.12779057e-01;
 		l1.Wiz << -1.5905762 ,-0.7512498 , 1.5168705 , 0.5536709 ,-1.2099698 , 0.93778366, -2.1837893 ,-1.5039393 ,-1.034915  , 1.0377971 ,-1.3285438 ,-0.5753548 , -0.01493329, 1.834316  , 1.5073441 , 1.360427  ,-1.1002136 , 0.47530496, -1.8164487 ,-1.6511501 ,-0.01953006, 1.0050216 , 1.2155812 , 1.1168635 , -0.9056723 ,-1.4501188 ,-0.8860899 ,-0.74979985, 0.32672226,-0.1663079 , -0.4895971 ,-0.14649284,-0.56819224,-1.7477343 ,-0.8522444 ,-0.5918796 ,  0.5569079 , 1.6579291 , 1.0416492 ,-1.9511889 ,-1.0429102 , 0.3402184 ,  0.73558223, 0.99921453, 1.2309365 , 0.87094235,-0.6493124 ,-0.32285768, -0.39715627,-2.4041576 , 0.87890714,-0.7444446 , 0.20226972,-0.65116626,  2.031314  ,-1.5173429 ,-0.30774957, 0.22141065, 0.00533509,-0.33189368,  1.6272061 , 0.68494684, 1.3043183 ,-0.9980012 ;
 		l1.Win << -0.29572022, 0.09000791,-0.24881572, 0.17415074,-0.03998614,-0.07794986, -0.23140597, 0.45185426, 0.1394122 , 0.05350109,-0.14213833,-0.08828479,  0.44008398, 0.11981521, 0.15143079,-0.15286058,-0.17343755, 0.07083523,  0.2698581 , 0.25437438, 0.26757   ,-0.29413614, 0.00377923,-0.54335356,  0.2628815 , 0.27081022,-0.02881009, 0.04963512, 0.20671771,-0.05469057,  0.2788475 ,-0.5698229 ,-0.1846628 ,-0.4650723 ,-0.07795374, 0.1684694 , -0.07230453,-0.34780958, 0.3415536 , 0.41543323,-0.27298665,-0.19448493, -0.18648009, 0.30864355,-0.15215328,-0.05979884, 0.16276486, 0.37000394,  0.2920866 , 0.08716591, 0.36784616,-0.3365071 ,-0.4135045 ,-0.23845953,  0.08323878, 0.32020792, 0.07809686,-0.2867419 ,-0.35145286,-0.18853064, -0.3348973 , 0.4503758 , 0.2902544 , 0.9890308 ;
@@ -56,15 +50,7 @@ public:
 		l1.bhz << -0.36191547, 0.43882447,-0.44775724,-1.3722099 ,-0.34911677, 1.6799475 , -1.4483681 ,-0.5464187 ;
 		l1.bhn <<  0.09132868,-0.3616623 , 0.09670886, 0.20240255,-0.07153431,-0.03304608,  0.22428282, 0.11864106;
 
-		l1.htn1 << 0.,0.,0.,0.,0.,0.,0.,0.;
-
 		f.A <<  0.12179868, 0.04144806, 0.23233043, 0.39631617,-0.44079885, 0.21931869, -0.47560063,-0.31639093;
 		f.b << -0.23360391;
 	}
-
-	void apply_model(T* x, T* y) {
-		l0.apply_layer(*x);
-		l1.apply_layer(l0.ht);
-		*y=f.apply_layer(l1.ht);
-	}
 };
\ No newline at end of file
@@ -7,23 +7,19 @@
 */
 
 #pragma once
-#include "layers.h"
+#include "Model.h"
 
 template<typename T>
-class Gru_8_4
+class Gru_8_4 : public Model<T, Gru<8>, Gru<8>, Gru<8>, Gru<8>, Dense<1>>
 {
 public:
-	const static int h = 8;
-	const static int d = 1;
-	const static int layers = 4;
-
-	FccLayer<T, h, d> f;
-	GruLayer<T, h, d> l0;
-	GruLayer<T, h, h> l1;
-	GruLayer<T, h, h> l2;
-	GruLayer<T, h, h> l3;
-
 	Gru_8_4() {
+		auto& f = this->f;
+		auto& l0 = GetLayer<0>(*this);
+		auto& l1 = GetLayer<1>(*this);
+		auto& l2 = GetLayer<2>(*this);
+		auto& l3 = GetLayer<3>(*this);
+
 		l0.Wir << -1.4232734 ,-2.4546568 ,-1.3232173 ,-0.63220257,-1.0901357 ,-2.2629669 ,  0.12335698, 0.7014477 ;
 		l0.Wiz << -1.215442  ,-3.7260273 ,-0.97895825,-2.8131056 , 2.8428948 ,-0.61656743, -0.92831534, 0.5164742 ;
 		l0.Win <<  0.3877517 , 0.47264156,-0.20685218,-1.5545801 ,-0.8068039 , 1.5317166 ,  1.0577775 , 0.51657426;
@@ -40,8 +36,6 @@ public:
 		l0.bhz << -0.7556441 ,-1.265362  ,-0.15259965,-0.5736795 ,-1.2968148 ,-1.885477  , -1.115915  , 1.2597429 ;
 		l0.bhn <<  0.15946908, 0.18060066,-0.18123044, 0.19544043, 0.2765791 ,-0.36052155, -0.10973501,-0.2534826 ;
 
-		l0.htn1 << 0.,0.,0.,0.,0.,0.,0.,0.;
-
 		l1.Wir <<  0.09564038, 0.01000079, 0.29522258, 0.5863624 ,-0.05685555,-0.32148108, -0.00201657,-0.40304792,-0.17116793, 0.32376546, 0.36452907,-0.6080132 , -0.00206656, 0.327613  , 0.41294587,-0.31917918,-0.07044595,-0.17301808, -0.0269529 ,-0.11325731, 0.14095072, 0.03305101, 0.20621881,-0.3866588 ,  0.24784887, 0.26568657, 0.21791287,-0.13182205,-0.77308387, 1.1957613 ,  0.30119616, 0.9073036 ,-0.13474852, 0.22643724,-0.12052343,-1.4222994 ,  0.5672635 , 0.85769594, 1.1464417 ,-0.29940313,-0.2534717 , 0.49190298,  0.0415922 ,-1.4122111 ,-0.56385595, 0.27761233, 1.021899  ,-0.15156332,  0.13753526,-0.18655176, 0.2857849 , 0.4305523 ,-0.5352681 ,-0.36527824,  0.21737818,-1.0396733 ,-0.17638533, 0.2874534 , 0.12830299,-0.31163046, -0.0154198 ,-0.3511454 , 0.1985496 , 0.0103575 ;
 		l1.Wiz <<  0.4494137 ,-0.6310551 , 0.02038081, 1.4094012 , 1.6706523 , 2.66394   ,  0.35292938,-0.633582  ,-0.6604122 ,-0.23932399,-0.3873506 , 1.6781392 ,  0.46170667,-0.30048183,-0.08643054,-0.33844337, 0.07200152,-0.7141927 ,  0.4557667 , 0.9069731 , 0.06540191, 0.7715512 , 0.37558985, 0.01578386,  0.62642956, 0.1785421 ,-0.23867278, 1.1889509 , 0.81386065,-0.3463817 ,  0.6337641 ,-0.26031193, 1.0739785 , 0.7930837 , 1.1768788 , 2.7738953 ,  0.19112344,-1.976852  ,-1.8022392 ,-0.6006377 , 0.50557023, 0.03698851, -0.44779298, 0.57819366,-0.09202937, 0.63182837,-0.01282632,-0.21663871, -0.7481009 ,-1.064297  ,-1.1758376 , 0.7295777 , 0.68199086, 1.2296436 ,  0.42765486,-0.09666634, 0.6243623 , 0.8729602 , 0.8857109 , 1.0287113 , -1.4266554 , 0.3079693 ,-0.97759897, 0.07599477;
 		l1.Win <<  0.36830792,-0.15468243,-0.14327478,-0.5112918 ,-0.5648764 , 0.12300722, -0.12630785, 0.03549352,-0.3049183 , 0.23534516, 0.0278667 , 0.08421392,  0.51675737,-0.10767631, 0.1267439 ,-0.03905641,-0.1626464 ,-0.16059645, -0.02854661, 0.5843249 , 0.29313943,-0.9045057 , 0.08352839, 0.325949  , -0.45029995,-0.1920926 , 0.28670827,-0.05929487, 0.17238057,-0.06321848, -0.14020456, 0.49740484,-0.35566247,-0.3210199 , 0.28769708,-0.2191243 , -0.1981971 , 0.24409944, 0.25118506, 0.48352516,-0.27213058,-0.1784302 , -0.04351055,-0.8480347 ,-0.6997613 , 0.8711225 , 0.39830664, 0.0906717 ,  0.09038831, 0.17465432,-0.05824156,-0.42224213,-0.10675229,-0.24848896,  0.01492531,-0.29428542, 0.22607768, 0.32176375,-0.1484385 , 0.21599253, -0.06598473,-0.0900832 ,-0.30452338, 0.26559168;
@@ -58,8 +52,6 @@ public:
 		l1.bhz << -0.3245847 ,-0.56764895,-0.93033123,-0.266422  , 0.06367999,-0.7471782 , -1.1298116 , 0.6426684 ;
 		l1.bhn <<  0.08124097, 0.07006393,-0.3801861 ,-0.12642516, 0.13365175, 0.51866364,  0.00236786, 0.39927703;
 
-		l1.htn1 << 0.,0.,0.,0.,0.,0.,0.,0.;
-
 		l2.Wir << -0.2750247 , 0.01458492, 0.9277269 , 0.84708697, 0.25382608,-0.50488   ,  0.12432902, 0.50953305, 0.3628555 , 0.27243412, 0.18492478, 0.04034413,  0.3200485 ,-0.08905881,-0.08263778, 0.07424908, 0.10856216, 0.05237443,  0.16221923,-0.01157719,-0.26158535, 0.36176598, 0.8177974 ,-0.1362226 ,  0.14579897, 0.12685587, 0.03600231,-0.31278303, 0.24440363, 0.27664688, -0.1505325 , 0.17915499,-0.14685483, 0.20121838, 0.41517988, 0.39520037, -0.5834094 ,-0.39298066, 0.05095824, 0.15242778,-0.14134489, 0.4080644 ,  0.11402277, 0.9003724 , 0.51725733,-0.92325014, 0.13055366, 0.6173408 ,  0.11833951,-0.1690549 , 0.30286902,-0.07796492,-0.6891616 ,-0.33348802, -0.12458391,-0.11269131, 0.07546481,-0.1530611 ,-0.18773077,-0.27445778, -0.24895588, 0.12337651, 0.16020478,-0.2028141 ;
 		l2.Wiz << -0.727654  , 0.64800346, 0.09286184,-0.07575402, 1.7569945 , 2.5539036 , -1.321616  ,-0.49104768,-0.28190944, 0.21549942,-1.2523702 ,-0.3203813 , -0.6033789 ,-1.281681  , 1.7212975 , 0.7632427 ,-0.4197162 ,-0.25977463, -0.7098474 , 0.3663072 ,-0.20828411, 0.19185163, 0.41084546,-0.08024725,  0.11280812,-0.0492192 ,-0.02414935, 0.07729758,-0.687745  , 0.14453079, -0.33688354,-0.24500944, 0.51113087,-0.24355026,-1.106549  ,-0.3360936 , -0.21840522,-0.22527874, 0.6506655 , 0.35467848, 1.9365588 ,-0.05473978, -2.8512163 ,-1.4097275 , 0.31707364, 2.104391  , 0.04356035, 1.6027222 ,  0.06435634,-0.34590423,-0.02452257,-0.6991545 ,-1.4881076 ,-2.177192  ,  0.8690472 , 0.11069074,-1.3192916 ,-1.6463108 ,-0.69717574, 0.86077386, -2.197658  ,-0.766011  ,-1.3632402 ,-0.07761076;
 		l2.Win <<  0.01678094,-0.2394836 ,-0.17794143,-0.3851367 ,-0.01305648, 0.33196688,  0.11730967, 0.2976169 , 0.34976825,-0.1314057 ,-0.10659715,-0.02075699, -0.02835834, 0.16211711, 0.28630286, 0.25829062, 0.08020128, 0.00935318, -0.5078867 ,-0.39518768, 0.38491717, 0.4939247 ,-0.0432743 , 0.14330779,  0.33047548,-0.2775523 ,-0.1188137 , 0.23925987, 0.02242634, 0.28028473,  0.40130463,-0.11358552,-0.30540136,-0.10838165, 0.5691581 , 0.4234949 , -0.14023404,-0.47076797,-0.13214165,-0.05315723,-0.14836927, 0.09009553,  0.16175053,-0.15209928, 0.1244982 ,-0.44970512,-0.1421061 ,-0.24742715, -0.19479868, 0.04957993,-0.02893228, 0.210329  ,-0.33048692,-0.40783572, -0.18190752, 0.23103105, 0.2411207 , 0.12969938, 0.04872566, 0.17383091,  0.17974459,-0.00216331, 0.00479646, 0.1126025 ;
@@ -76,8 +68,6 @@ public:
 		l2.bhz <<  0.336027  ,-0.28653884,-0.97559476, 0.27408144,-0.58268905, 1.0254904 ,  0.08419521,-0.8329531 ;
 		l2.bhn << -0.1646504 ,-0.17656636,-0.23859099,-0.01016381, 0.18307222,-0.3403202 ,  0.34373027, 0.33388928;
 
-		l2.htn1 << 0.,0.,0.,0.,0.,0.,0.,0.;
-
 		l3.Wir << -0.14340155,-0.07998636, 0.21766742,-0.47898313, 0.11341031,-0.17872621, -0.7301605 , 0.23186663,-0.09086764,-0.09588691, 0.06729442, 0.13964671, -0.20703317, 0.01239136, 0.2194513 , 0.12006943, 0.04636985, 0.10422127, -0.13074547, 0.13525912,-0.22536089,-0.05691854, 0.21273372,-0.13954458,  0.04861594, 0.1531866 ,-0.2861636 , 0.27741244,-0.07732366, 0.27277905, -0.5845243 , 0.35685351,-0.1699818 , 0.02802692,-0.18754098, 0.39335722, -0.2848602 ,-0.15121664, 0.39517048, 0.01462499,-0.21496458, 0.23701558, -0.22268754,-0.11230557, 0.30244142, 0.33485585, 0.6837566 ,-0.24021536,  0.01305287,-0.1955868 ,-0.60751677, 0.7560744 ,-0.11860828, 0.43632257,  0.3850699 , 0.1815538 , 0.09626305,-0.02350225, 0.6411111 , 0.26333085, -0.10990297, 0.07783292, 0.17022498,-0.16888206;
 		l3.Wiz << -0.22190212, 0.24218623, 0.7840122 ,-0.11625469,-0.08380036, 0.03729228, -1.0050782 , 0.36124027, 2.0140684 ,-1.777664  ,-0.6710751 ,-0.06363318,  1.6696488 ,-0.28721818, 2.8153934 ,-1.3558322 ,-0.02933672, 0.47682476,  1.2074753 , 0.28878152,-0.1931159 ,-0.13154933,-0.40157244, 0.33686253,  1.4403275 ,-0.3870393 ,-0.7176311 , 0.00853693, 0.11315653, 0.57428443,  0.79118544,-0.37309462, 0.91494656, 0.34191582, 1.9759063 , 0.89712197, -0.0961858 ,-1.2674799 , 0.1520035 , 0.07012334,-0.8485313 , 1.0609093 ,  0.6380208 ,-0.788408  ,-1.0129591 , 0.44469246,-0.3552523 , 1.3750387 ,  0.4714245 ,-0.78093314,-0.33893842,-0.13849649,-0.12857781,-0.0527029 ,  1.2568477 , 0.19067003, 1.4274411 , 0.34061524, 0.03947655,-0.2646905 , -1.1071006 ,-0.5009882 ,-0.18835656, 0.06880557;
 		l3.Win << -0.23013322,-0.1972695 ,-0.14838842, 0.15337299, 0.3305553 , 0.39589706, -0.03494315,-0.2791594 , 0.20748436, 0.28009528,-0.03458947,-0.00057634, -0.24498723, 0.0115751 ,-0.27199048, 0.36049777,-0.23997185,-0.13647944,  0.1785465 , 0.20443709,-0.25064683, 0.32292575,-0.18716598, 0.01479276,  0.17879125,-0.17360497,-0.42423838, 0.12274448, 0.33138388,-0.27988625,  0.17402299, 0.13275   , 0.00535593, 0.13561311,-0.31985077,-0.30757758,  0.23191798,-0.1855797 ,-0.04119021,-0.09623602, 0.02249089, 0.04368065, -0.4366059 , 0.39791647, 0.22269782,-0.10078765, 0.2821087 , 0.001571  ,  0.17757976,-0.33124766,-0.4305931 , 0.04937458, 0.3889089 , 0.15589477,  0.29200053,-0.16819698, 0.08634911,-0.13870017, 0.4476147 ,-0.14469051, -0.50440204,-0.40320143,-0.19239111,-0.28170654;
@@ -94,17 +84,7 @@ public:
 		l3.bhz <<  0.30038765,-1.9215163 , 0.42303386,-0.9450779 ,-0.17171063, 1.5206562 , -0.49668053, 0.01589588;
 		l3.bhn << -0.25775915, 0.31883234, 0.18610395,-0.2857972 ,-0.05411552, 0.26463094,  0.23253323, 0.2934851 ;
 
-		l3.htn1 << 0.,0.,0.,0.,0.,0.,0.,0.;
-
 		f.A <<  0.26209342, 0.2470558 ,-0.21571608,-0.37634504, 0.09912661, 0.26996833, -0.349954  , 0.33970073;
 		f.b << -0.15671152;
 	}
-
-	void apply_model(T* x, T* y) {
-		l0.apply_layer(*x);
-		l1.apply_layer(l0.ht);
-		l2.apply_layer(l1.ht);
-		l3.apply_layer(l2.ht);
-		*y=f.apply_layer(l3.ht);
-	}
 };
\ No newline at end of file
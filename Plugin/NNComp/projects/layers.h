@@ -1,5 +1,17 @@
 #pragma once
 #include "Eigen/Dense"
+#include <cmath>
+
+/**
+ * Calibration builds (NNCOMP_CALIBRATION defined) report the activations of every layer step
+ * to the active CalibrationRecorder, see Calibration.h. Otherwise the hooks compile to nothing.
+ */
+#if defined(NNCOMP_CALIBRATION)
+template<typename L> void RecordCalibration(const L& l);
+#define NNCOMP_CALIBRATE(layer) RecordCalibration(layer)
+#else
+#define NNCOMP_CALIBRATE(layer)
+#endif
 
 /*
 // ---- Fast Approximations ---
@@ -21,8 +33,9 @@ double tanh_fast (const double x) {
 /**
  * Sigmoid activation function
  */
-double Sigmoid(const double z) {
-  return 1.0 / (1.0 + exp(-z));
+template<typename T>
+T Sigmoid(const T z) {
+  return T(1) / (T(1) + std::exp(-z));
   //return 1.0 / (1.0 + exp_fast(-z)); //Fast Approx.
 }
 
@@ -39,30 +52,32 @@ public:
   
   void apply_layer(Eigen::Vector<T, d> x) {
     xt = x;
-    it = (Wii * xt + bii + Whi * htn1 + bhi).unaryExpr(std::ref(Sigmoid));
-    ft = (Wif * xt + bif + Whf * htn1 + bhf).unaryExpr(std::ref(Sigmoid));
+    it = (Wii * xt + bii + Whi * htn1 + bhi).unaryExpr(std::ref(Sigmoid<T>));
+    ft = (Wif * xt + bif + Whf * htn1 + bhf).unaryExpr(std::ref(Sigmoid<T>));
     gt = (Wig * xt + big + Whg * htn1 + bhg).array().tanh();
     //gt = (Wig * xt + big + Whg * htn1 + bhg).unaryExpr(std::ref(tanh_fast)); //Fast Approx.
-    ot = (Wio * xt + bio + Who * htn1 + bho).unaryExpr(std::ref(Sigmoid));
+    ot = (Wio * xt + bio + Who * htn1 + bho).unaryExpr(std::ref(Sigmoid<T>));
     ct = ft.cwiseProduct(ctn1) + it.cwiseProduct(gt);
     ht = ct.array().tanh();
     //ht = ct.unaryExpr(std::ref(tanh_fast)); //Fast Approx.
     ht = ot.cwiseProduct(ht);
+    NNCOMP_CALIBRATE(*this);
     htn1 = ht;
     ctn1 = ct;
   }
   
   void apply_layer(T x) {
     xt = xt.Constant(x);
-    it = (Wii * xt + bii + Whi * htn1 + bhi).unaryExpr(std::ref(Sigmoid));
-    ft = (Wif * xt + bif + Whf * htn1 + bhf).unaryExpr(std::ref(Sigmoid));
+    it = (Wii * xt + bii + Whi * htn1 + bhi).unaryExpr(std::ref(Sigmoid<T>));
+    ft = (Wif * xt + bif + Whf * htn1 + bhf).unaryExpr(std::ref(Sigmoid<T>));
     gt = (Wig * xt + big + Whg * htn1 + bhg).array().tanh();
     //gt = (Wig * xt + big + Whg * htn1 + bhg).unaryExpr(std::ref(tanh_fast)); //Fast Approx.
-    ot = (Wio * xt + bio + Who * htn1 + bho).unaryExpr(std::ref(Sigmoid));
+    ot = (Wio * xt + bio + Who * htn1 + bho).unaryExpr(std::ref(Sigmoid<T>));
     ct = ft.cwiseProduct(ctn1) + it.cwiseProduct(gt);
     ht = ct.array().tanh();
     //ht = ct.unaryExpr(std::ref(tanh_fast)); //Fast Approx.
     ht = ot.cwiseProduct(ht);
+    NNCOMP_CALIBRATE(*this);
     htn1 = ht;
     ctn1 = ct;
   }
@@ -113,21 +128,23 @@ public:
   
   void apply_layer(Eigen::Vector<T, d> x) {
     xt = x;
-    rt = (Wir * xt + bir + Whr * htn1 + bhr).unaryExpr(std::ref(Sigmoid));
-    zt = (Wiz * xt + biz + Whz * htn1 + bhz).unaryExpr(std::ref(Sigmoid));
+    rt = (Wir * xt + bir + Whr * htn1 + bhr).unaryExpr(std::ref(Sigmoid<T>));
+    zt = (Wiz * xt + biz + Whz * htn1 + bhz).unaryExpr(std::ref(Sigmoid<T>));
     nt = (Win * xt + bin + rt.cwiseProduct(Whn * htn1 + bhn)).array().tanh();
     //nt = (Win * xt + bin + rt.cwiseProduct(Whn * htn1 + bhn)).unaryExpr(std::ref(tanh_fast)); //Fast Approx.
     ht = (ht.Constant(1) - zt).cwiseProduct(nt) + zt.cwiseProduct(htn1);
+    NNCOMP_CALIBRATE(*this);
     htn1 = ht;
   }
   
   void apply_layer(T x) {
     xt = xt.Constant(x);
-    rt = (Wir * xt + bir + Whr * htn1 + bhr).unaryExpr(std::ref(Sigmoid));
-    zt = (Wiz * xt + biz + Whz * htn1 + bhz).unaryExpr(std::ref(Sigmoid));
+    rt = (Wir * xt + bir + Whr * htn1 + bhr).unaryExpr(std::ref(Sigmoid<T>));
+    zt = (Wiz * xt + biz + Whz * htn1 + bhz).unaryExpr(std::ref(Sigmoid<T>));
     nt = (Win * xt + bin + rt.cwiseProduct(Whn * htn1 + bhn)).array().tanh();
     //nt = (Win * xt + bin + rt.cwiseProduct(Whn * htn1 + bhn)).unaryExpr(std::ref(tanh_fast)); //Fast Approx.
     ht = (ht.Constant(1) - zt).cwiseProduct(nt) + zt.cwiseProduct(htn1);
+    NNCOMP_CALIBRATE(*this);
     htn1 = ht;
   }
   
@@ -173,6 +190,7 @@ public:
     xt = x;
     ht = (Wih * xt + bih + Whh * htn1 + bhh).array().tanh();
     //ht = (Wih * xt + bih + Whh * htn1 + bhh).unaryExpr(std::ref(tanh_fast)); //Fast Approx.
+    NNCOMP_CALIBRATE(*this);
     htn1 = ht;
   }
   
@@ -180,6 +198,7 @@ public:
     xt = xt.Constant(x);
     ht = (Wih * xt + bih + Whh * htn1 + bhh).array().tanh();
     //ht = (Wih * xt + bih + Whh * htn1 + bhh).unaryExpr(std::ref(tanh_fast)); //Fast Approx.
+    NNCOMP_CALIBRATE(*this);
     htn1 = ht;
   }
   Eigen::Matrix<T, h, d> Wih;
@@ -204,6 +223,7 @@ public:
   T apply_layer(Eigen::Vector<T, h> x) {
     xt = x;
     y = (xt.transpose() * A + b).array().tanh()(0);
+    NNCOMP_CALIBRATE(*this);
     return y;
     //return (x.transpose() * A + b).array().unaryExpr(std::ref(tanh_fast))(0); //Fast Approx.
   }
@@ -214,3 +234,7 @@ public:
   T y;
   
 };
+
+#if defined(NNCOMP_CALIBRATION)
+#include "Calibration.h"
+#endif
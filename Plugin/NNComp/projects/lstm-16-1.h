@@ -7,20 +7,16 @@
 */
 
 #pragma once
-#include "layers.h"
+#include "Model.h"
 
 template<typename T>
-class Lstm_16_1
+class Lstm_16_1 : public Model<T, Lstm<16>, Dense<1>>
 {
 public:
-	const static int h = 16;
-	const static int d = 1;
-	const static int layers = 1;
-
-	FccLayer<T, h, d> f;
-	LstmLayer<T, h, d> l0;
-
 	Lstm_16_1() {
+		auto& f = this->f;
+		auto& l0 = GetLayer<0>(*this);
+
 		l0.Wii << -0.26173478,-0.08468687,-0.18403417,-0.39149186,-0.35535505, 0.4874956 , -0.6605775 , 0.40993333, 0.03428086, 0.34600917,-0.24235992, 0.11144082, -0.01754749, 0.32693258, 0.02174493,-1.2180092 ;
 		l0.Wif << -0.28522325, 0.32572392, 0.10535695, 0.13781843,-0.38247725,-0.3296848 ,  0.11513307, 0.0683234 ,-0.53343654,-0.0531835 , 0.15479104,-0.5231098 , -1.4408909 , 1.6555614 , 0.91807854,-0.9674012 ;
 		l0.Wig <<  1.0639082 , 0.85292345,-0.20808636,-0.7483622 , 0.25302547, 0.3913608 , -0.45797595, 0.38006428,-0.13246502,-0.5636763 ,-0.12242296, 0.23859352,  0.6991093 , 0.9532002 ,-0.5097309 ,-0.24022955;
@@ -41,15 +37,7 @@ public:
 		l0.bhg <<  0.11768948, 0.12893523, 0.17525098, 0.13336214,-0.07053549, 0.02745144,  0.23886003,-0.02372953,-0.05014867, 0.04741926, 0.05684699,-0.18855487, -0.05670652,-0.10784663,-0.17683618,-0.16946773;
 		l0.bho << -0.1985677 , 0.26635534,-0.1948754 , 0.00932742, 0.21549131, 0.32939553,  0.34818912, 0.16253795, 0.02159252, 0.01153751,-0.08323487, 0.2451504 ,  0.10212179,-0.08074372, 0.14673796, 0.1274933 ;
 
-		l0.htn1 << 0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.;
-		l0.ctn1 << 0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.;
-
 		f.A <<  0.39378706,-0.0853371 , 0.25087026,-0.5066945 , 0.00815051,-0.05413479,  0.07437845,-0.04823146, 0.15571225, 0.10570689, 0.2386153 ,-0.04133651,  0.32303602, 0.4714737 ,-0.04986421, 0.23166302;
 		f.b << -0.08982573;
 	}
-
-	void apply_model(T* x, T* y) {
-		l0.apply_layer(*x);
-		*y=f.apply_layer(l0.ht);
-	}
 };
\ No newline at end of file
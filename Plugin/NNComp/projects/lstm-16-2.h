@@ -7,21 +7,17 @@
 */
 
 #pragma once
-#include "layers.h"
+#include "Model.h"
 
 template<typename T>
-class Lstm_16_2
+class Lstm_16_2 : public Model<T, Lstm<16>, Lstm<16>, Dense<1>>
 {
 public:
-	const static int h = 16;
-	const static int d = 1;
-	const static int layers = 2;
-
-	FccLayer<T, h, d> f;
-	LstmLayer<T, h, d> l0;
-	LstmLayer<T, h, h> l1;
-
 	Lstm_16_2() {
+		auto& f = this->f;
+		auto& l0 = GetLayer<0>(*this);
+		auto& l1 = GetLayer<1>(*this);
+
 		l0.Wii << -0.73938715,-0.47281703, 0.2634353 , 0.49122217,-0.8729766 ,-1.1263143 ,  0.15037447, 0.03865751,-0.33932516, 0.51509184,-0.26573908, 0.7152366 ,  0.18931156,-0.28008628, 0.8909568 , 0.07603236;
 		l0.Wif << -0.6364387 , 0.5950935 ,-0.4635038 , 0.5684985 ,-0.9783812 ,-0.13028777,  0.00387524,-0.10246503,-0.2708684 ,-0.806897  ,-0.00399827, 1.0313786 , -0.3467959 , 0.11337901,-0.43859935, 0.1136686 ;
 		l0.Wig << -0.19908445,-0.97470355, 0.2666807 , 1.2744788 , 0.10304806, 1.0784718 ,  0.18448481, 0.47548074, 0.04762598, 0.12040798,-0.16571549,-0.01859047,  0.22784846, 0.22884245,-0.6552274 ,-0.02849995;
@@ -42,9 +38,6 @@ public:
 		l0.bhg <<  0.16863121,-0.18455231,-0.06332053, 0.05542027, 0.077864  , 0.04573668,  0.04702257,-0.1969311 , 0.18940704,-0.06131069, 0.19803245,-0.23787573, -0.15398735, 0.2351747 ,-0.12477362,-0.01398101;
 		l0.bho << -0.06942828, 0.00448592, 0.2839473 , 0.15741639,-0.05077   , 0.25161767, -0.03280656, 0.04068661, 0.06698285, 0.38839188, 0.11590429, 0.29686713,  0.23760317,-0.08057371, 0.7005202 , 0.25526842;
 
-		l0.htn1 << 0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.;
-		l0.ctn1 << 0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.;
-
 		l1.Wii << -8.02698135e-02, 2.70305961e-01,-1.63073882e-01,-3.39075089e-01,  3.15674305e-01,-1.44489601e-01,-1.29497200e-02,-5.49061298e-02, -7.03799278e-02, 3.20595689e-02, 3.62246215e-01, 2.23089516e-01, -2.90092468e-01, 3.69100831e-02, 1.08987741e-01, 5.37696183e-02,  1.37343347e-01, 1.66401453e-02,-6.24608761e-03,-4.01479930e-01, -1.49424566e-04, 2.60074642e-02, 2.57723719e-01,-1.72529847e-03, -1.73206717e-01, 2.28456333e-01,-1.82872072e-01, 8.06154385e-02,  1.57011762e-01,-2.19077483e-01, 1.22006357e-01,-2.31855765e-01, -1.30974621e-01,-1.09499581e-01, 2.19480783e-01,-2.19387442e-01,  1.91233799e-01, 1.68432891e-02,-1.26876622e-01, 2.12305468e-02,  1.57307371e-01,-9.92219150e-02, 1.30775869e-01, 6.26031086e-02,  1.63644835e-01, 4.33179401e-02,-2.21456915e-01,-6.88255578e-02,  2.68983036e-01,-3.47433418e-01, 8.43009278e-02, 2.03944430e-01,  3.46098095e-01,-1.64275557e-01, 3.11278552e-01,-2.60977805e-01,  4.77465056e-02,-1.54084191e-01,-3.03289711e-01,-3.77913386e-01,  8.67925212e-02, 2.28820354e-01, 8.05469453e-02,-1.09130830e-01,  1.94201037e-01, 2.44525418e-01, 1.05822258e-01,-2.66965955e-01,  2.37145260e-01, 4.82779890e-02, 1.56887963e-01,-2.56440461e-01,  1.78708956e-01,-1.08107649e-01, 1.56525001e-01, 2.26390600e-01, -2.67445356e-01, 1.19112544e-01, 3.36716771e-01,-1.05192527e-01,  1.55816063e-01,-1.70822039e-01,-1.98711574e-01, 2.51405388e-01,  2.04771310e-01,-5.40177703e-01, 5.89554429e-01,-1.47602081e-01,  1.25709280e-01,-4.26847160e-01, 2.41643772e-01,-3.97965282e-01, -1.77910656e-01,-1.75469726e-01,-6.61939919e-01,-9.04170647e-02,  2.28949592e-01,-1.51711673e-01,-1.59810081e-01, 2.73358803e-02, -1.22289851e-01, 2.60267556e-01,-4.22017276e-01,-2.50559777e-01,  2.38262832e-01,-2.07188442e-01,-5.08105308e-02,-1.83393404e-01, -4.04362381e-02, 3.00647855e-01,-1.25090778e-01,-2.35334054e-01,  4.30769799e-03, 1.26283690e-01, 4.31933068e-02,-1.60215676e-01, -1.40269995e-01, 2.18284547e-01, 7.85882547e-02, 1.34464040e-01, -1.25556827e-01,-9.83412862e-02,-9.04229283e-03, 2.37176389e-01, -1.56624377e-01,-8.69368464e-02,-1.81304932e-01,-1.82028666e-01,  2.54059225e-01, 7.85216689e-02,-5.51130474e-02,-7.44759500e-01, -7.15542883e-02,-5.47412574e-01,-3.44338417e-01, 8.90690554e-03, -3.79523098e-01, 6.47324473e-02, 2.27817997e-01, 2.45524943e-01,  6.61718622e-02,-1.40334681e-01, 6.99758083e-02, 1.22049689e-01,  3.65616113e-01,-5.67640588e-02,-2.25680441e-01, 4.80332272e-03, -1.67163283e-01,-2.73689091e-01,-1.62340552e-01,-3.57465222e-02,  2.99245238e-01,-1.22354021e-02,-3.34331580e-02,-1.83858261e-01,  1.97540015e-01, 2.86198646e-01,-4.22893107e-01,-2.07466170e-01,  1.84779704e-01,-1.97935253e-01, 5.72961532e-02, 7.05123916e-02, -2.89597005e-01, 3.53374988e-01, 2.27883965e-01,-2.28933200e-01,  1.06925547e-01, 1.02334365e-01,-2.90333420e-01,-2.25456245e-02,  2.80574292e-01, 1.61412910e-01,-4.12010133e-01, 1.21687852e-01,  2.89052278e-01,-7.31812045e-03,-4.32364680e-02,-4.07281303e-04,  1.05253056e-01, 2.68356144e-01,-3.58809412e-01, 9.23586413e-02,  1.68483313e-02, 1.70944691e-01,-3.64666134e-02,-1.21005625e-01,  1.24238729e-01, 3.07655245e-01,-6.43555298e-02,-9.86460298e-02,  1.53958440e-01, 6.80033714e-02, 1.12198904e-01, 9.34730053e-01, -2.91513354e-01,-5.48322976e-01,-2.35143632e-01, 1.92303620e-02,  1.46245360e-01, 9.97683108e-02, 1.22714616e-01,-4.66838740e-02,  7.55913928e-02, 7.89425597e-02, 6.06506288e-01,-1.21412620e-01,  1.57401279e-01, 1.71452612e-01, 1.33234322e-01,-5.65630794e-01, -9.17612240e-02, 3.61097693e-01,-1.90172195e-01, 2.09062502e-01,  2.36509934e-01, 1.59941256e-01,-2.28018224e-01, 3.44022274e-01, -4.67899367e-02, 1.66762486e-01, 2.57571489e-01, 2.46729597e-01,  1.82603821e-01, 4.98279780e-01,-2.47579180e-02,-6.44620299e-01,  5.94637990e-01,-1.51969445e+00, 2.90865958e-01,-1.47907913e-01,  2.59194635e-02,-4.54696417e-01,-1.23136088e-01,-1.09215014e-01, -4.58916485e-01, 6.87461020e-03, 6.91024721e-01,-1.23636439e-01, -1.23688981e-01, 6.62255287e-02,-2.11688876e-01,-3.63985479e-01,  2.63879541e-03,-1.05371632e-01,-1.43033937e-01,-5.37812300e-02, -3.21354717e-02,-2.21195772e-01, 9.26696584e-02,-1.44006342e-01,  1.61092103e-01, 2.94909403e-02,-1.12129807e-01, 2.35399008e-01;
 		l1.Wif << -1.97324473e-02, 2.29692698e-01,-1.91455528e-01,-8.02525878e-01, -1.12763315e-01,-2.86623895e-01,-3.10792714e-01,-1.90144360e-01, -9.14951563e-02,-2.11009935e-01, 1.34403080e-01, 3.96836102e-01, -3.94313842e-01, 1.26328215e-03, 1.56469181e-01,-1.78200975e-02,  1.33943155e-01,-2.89741397e-01,-1.55390918e-01,-9.68788341e-02, -2.20222864e-03,-2.52670944e-01,-1.43388927e-01,-9.26597044e-02,  2.10585415e-01, 2.37265676e-01,-2.18265112e-02,-2.26000324e-01,  2.09931418e-01,-2.14187339e-01, 5.06350286e-02, 2.02355191e-01,  3.61395985e-01,-3.00951600e-01,-2.13963076e-01,-1.95830762e-01,  4.07742448e-02,-1.87658712e-01,-1.38470113e-01, 5.18680736e-02, -1.50739983e-01, 1.62791312e-01, 3.46359909e-01,-2.80125141e-01, -3.15191178e-03,-1.28741026e-01,-2.90811002e-01, 7.76484311e-02,  1.36166304e-01,-3.91765654e-01,-2.25970015e-01, 9.45360363e-01,  1.01672091e-01,-1.32606849e-01,-4.04325575e-01, 3.25524174e-02,  2.38073736e-01, 2.02031851e-01, 1.11721754e-01,-3.24549265e-02,  3.45776767e-01, 1.41981050e-01,-3.60801876e-01, 9.29597095e-02,  8.99826065e-02, 9.59944166e-03, 1.52370602e-01,-6.33842111e-01,  8.60466138e-02,-2.06602052e-01, 6.02102233e-03, 2.91542619e-01,  2.61710942e-01, 1.63761973e-01, 1.37322873e-01, 2.13696525e-01, -2.48255551e-01,-2.63660073e-01, 3.54969539e-02, 6.65406212e-02, -1.45460665e-01, 4.45796072e-01, 1.24994824e-02,-6.95116758e-01,  1.22265391e-01, 8.02558482e-01, 3.56241345e-01, 2.96502441e-01,  6.21224821e-01,-1.32249579e-01, 2.41850540e-01, 4.94193763e-01, -1.36651009e-01,-1.50187939e-01, 5.36318004e-01, 1.22818753e-01,  3.09119225e-01,-2.04688072e-01, 1.40033290e-01, 2.13702738e-01, -7.35036209e-02, 9.09632742e-02,-4.95740712e-01,-2.02375337e-01,  3.65697175e-01,-1.40109688e-01, 3.48386198e-01,-2.88321167e-01,  1.97629780e-01,-7.77221918e-02,-1.10462256e-01,-1.87686250e-01, -1.58165842e-01,-2.75234990e-02, 1.23131804e-01,-2.44356841e-01, -5.99736162e-02, 6.34003654e-02,-2.74731368e-01,-1.70068279e-01, -7.86127523e-03, 5.03018647e-02,-1.74199313e-01, 2.92359233e-01, -2.83562809e-01,-1.92534208e-01, 3.85176063e-01,-8.00754577e-02,  1.04466267e-01,-5.36313206e-02,-1.04073949e-01,-1.06744811e-01, -5.13638929e-02, 7.72174355e-03,-2.95275569e-01,-2.09015280e-01, -3.97178411e-01,-1.55353993e-01, 2.32015699e-01,-2.37357020e-01, -3.46813351e-02, 1.48967206e-01,-6.30166531e-01,-2.01524943e-01,  7.93652833e-02,-5.69570102e-02,-1.59673750e-01, 8.85406360e-02, -1.81389768e-02,-1.23953573e-01,-4.47471857e-01,-7.73981363e-02,  2.57623792e-01, 3.02158520e-02, 3.21194351e-01,-1.39003500e-01,  3.55572343e-01,-9.78651345e-02,-3.79873842e-01,-1.67718828e-02,  3.31693999e-02,-2.02018961e-01, 2.25386232e-01,-2.04074264e-01, -1.30844070e-02, 1.07079931e-01, 2.04510748e-01, 2.67640293e-01,  2.05187783e-01,-3.78619060e-02,-2.07610413e-01, 1.74803928e-01,  3.09487879e-01, 1.40322587e-02,-9.71143395e-02, 2.75487360e-02,  5.81890903e-02, 6.10448532e-02,-2.53743976e-01, 2.04961047e-01,  1.35049969e-01,-1.33208670e-02,-3.23679805e-01,-2.34290898e-01,  1.63857102e-01,-9.22100917e-02, 1.08949572e-01,-3.87795895e-01,  6.19755685e-03, 2.77796388e-01, 4.07710969e-01, 7.11500794e-02, -2.97474325e-01,-1.51564330e-01,-4.39182557e-02, 1.12011015e+00, -2.78669875e-02, 5.81416965e-01,-5.94940223e-02, 1.01610897e-02,  2.53075927e-01, 2.04314843e-01,-1.95975617e-01, 8.15912485e-02,  4.57535237e-01, 1.66877076e-01, 1.26799047e-01,-2.43700027e-01,  6.83461055e-02, 4.05512527e-02,-1.82545587e-01,-7.37337053e-01,  2.16023386e-01,-1.07135907e-01,-7.89894387e-02,-1.68521740e-02,  1.10653006e-01,-3.95926058e-01, 3.53156507e-01,-1.05523534e-01, -4.99136508e-01, 1.60135195e-01, 2.41929814e-01,-3.68676722e-01, -4.11775649e-01, 4.30142522e-01, 8.69637802e-02,-4.73471135e-01,  2.40887366e-02, 8.62206340e-01, 4.22127157e-01,-7.71492254e-04,  4.32954699e-01,-2.45950907e-01, 2.50263722e-03, 4.28191572e-01, -8.31481740e-02, 1.30739072e-02, 2.04554200e-01,-2.13717893e-01, -1.72164008e-01, 3.55291754e-01, 1.15268482e-02,-4.60411727e-01,  2.20575005e-01,-1.30849019e-01, 4.38278392e-02, 2.21565008e-01, -4.94253412e-02, 1.73460677e-01,-1.50388107e-01, 5.20867519e-02,  1.85962826e-01, 3.39706354e-02, 8.29564780e-02,-1.40670180e-01;
 		l1.Wig << -0.0095391 ,-0.04783908,-0.0470194 ,-0.50093174, 0.19123475,-0.17440917, -0.34714228, 0.20812099, 0.10131911,-0.30852932, 0.14513746, 0.37925512, -0.1483667 ,-0.22269525,-0.00631058, 0.14562882, 0.0606045 , 0.05901645,  0.23309   ,-0.28219488,-0.21539779,-0.20252566, 0.19882117, 0.11654744,  0.03322822, 0.02069346, 0.03194667,-0.15553764, 0.21479173, 0.0615105 , -0.26562372,-0.1646749 , 0.22932921, 0.15746531, 0.04147988,-0.13673794, -0.16485658,-0.1976154 ,-0.03730784, 0.23042826, 0.08178595,-0.06423154, -0.02451508, 0.10283793, 0.07064178, 0.1905647 , 0.2242661 , 0.24479714, -0.06394836,-0.28767267, 0.09156516, 0.29197377,-0.00980722, 0.6700322 ,  0.17436333, 0.18587431, 0.01680727, 0.2646112 , 0.10381164, 0.12350761,  0.14040907,-0.21211019, 0.21249487, 0.13699184,-0.238195  , 0.33418342, -0.22760221,-0.33056417,-0.17436734,-0.19959897,-0.3045844 , 0.20969366, -0.1711234 ,-0.17986335,-0.1190308 , 0.24707595,-0.32276198, 0.2186459 , -0.09888492,-0.20278056,-0.37500814, 0.08762836, 0.10090598,-0.5689706 ,  0.3521405 ,-0.4163388 ,-0.6238957 ,-0.17688614, 0.169877  ,-0.14653948,  0.22011599, 0.24643156,-0.4747296 , 0.03477746, 0.46293807,-0.15808922, -0.33939144,-0.03914706, 0.2575803 ,-0.10918701, 0.14248739, 0.11477237,  0.0912071 , 0.33344775,-0.20894277, 0.12865806,-0.02871549, 0.29469615,  0.11693405,-0.32064784,-0.03418957, 0.04641934,-0.0770755 , 0.0257451 ,  0.08498179,-0.509729  ,-0.03901292,-0.10916641,-0.3585535 ,-0.16002128,  0.12024763, 0.14304529, 0.05371999, 0.3125884 ,-0.19499247,-0.23065968,  0.39925423,-0.18069986,-0.18834423, 0.1544601 ,-0.05220081, 0.04007756,  0.00892033,-0.0766615 , 0.21287127,-0.11442799,-0.13396028,-0.20324403,  0.0092014 , 0.05737244,-0.18984999,-0.17540844, 0.1246879 , 0.07817645, -0.19200508, 0.00923568,-0.06765128,-0.53075296, 0.36443952,-0.10042736, -0.09475105,-0.06114227, 0.10416886, 0.04193475, 0.18092178, 0.06692237, -0.28899434,-0.18591507, 0.5548148 ,-0.04134049, 0.1837451 ,-0.43386975,  0.15017812, 0.13703342, 0.01180433,-0.03696376, 0.2427308 , 0.16142267, -0.01956498, 0.17837133, 0.07159489,-0.3205588 , 0.12732561, 0.12959222, -0.06530602, 0.0590765 ,-0.07264772,-0.10847379, 0.22161867, 0.0424864 ,  0.1415415 , 0.12088758, 0.2113323 , 0.08308353, 0.10260772, 0.02397617, -0.15390082,-0.04900619, 0.32077128, 0.17609352,-0.05485405, 0.07015509,  0.04857963, 0.02593112,-0.04960923, 0.0019242 , 0.25312525, 0.17151332, -0.27449405, 0.20334086, 0.17647049,-0.26908547, 0.05474816, 0.17354524, -0.22039887, 0.23619188, 0.2336287 ,-0.14289516, 0.08243811, 0.23437652, -0.09953748, 0.09674821,-0.14108676, 0.0991661 ,-0.01756233,-0.12403733, -0.17492211,-0.09700449,-0.22282888, 0.01906494,-0.09907917,-0.16332589,  0.01636736, 0.02018681, 0.08973037,-0.35637683, 0.24897031, 0.19551036, -0.27694425, 0.51315504,-0.00386526, 0.27977827,-0.17426918, 0.05114037, -0.09005097, 0.06801742, 0.13923527,-0.01929459,-0.14264801, 0.15280525,  0.13530569, 0.14675413,-0.12491786,-0.03545258, 0.05161295,-0.254595  ,  0.1819543 , 0.07065568,-0.02553795,-0.12499864, 0.15822132, 0.2698399 ,  0.1348882 ,-0.00698236,-0.14814967, 0.16994365;
@@ -65,16 +58,7 @@ public:
 		l1.bhg << -0.02657126, 0.11355862, 0.07014682, 0.10148198,-0.01080461, 0.020508  ,  0.00674635, 0.21938756, 0.04538745,-0.0713184 , 0.20076816, 0.05998462, -0.09002066, 0.14084934,-0.08379319, 0.1657568 ;
 		l1.bho <<  0.19476682, 0.01663826,-0.099374  , 0.06642089, 0.27430972, 0.20770238,  0.15967007,-0.10661706, 0.10845305, 0.10543206, 0.06130045,-0.10776303, -0.04663138,-0.18339233, 0.04343718,-0.04835038;
 
-		l1.htn1 << 0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.;
-		l1.ctn1 << 0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.;
-
 		f.A << -0.21283941, 0.07890721,-0.00077326, 0.17953177,-0.14988905,-0.43451253, -0.23379427,-0.13199975,-0.05443525,-0.11011588, 0.24144386, 0.28294566, -0.17699234,-0.2094603 , 0.19873516,-0.18635882;
 		f.b << 0.01398221;
 	}
-
-	void apply_model(T* x, T* y) {
-		l0.apply_layer(*x);
-		l1.apply_layer(l0.ht);
-		*y=f.apply_layer(l1.ht);
-	}
 };
\ No newline at end of file
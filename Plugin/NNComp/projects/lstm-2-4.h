@@ -7,23 +7,19 @@
 */
 
 #pragma once
-#include "layers.h"
+#include "Model.h"
 
 template<typename T>
-class Lstm_2_4
+class Lstm_2_4 : public Model<T, Lstm<2>, Lstm<2>, Lstm<2>, Lstm<2>, Dense<1>>
 {
 public:
-	const static int h = 2;
-	const static int d = 1;
-	const static int layers = 4;
-
-	FccLayer<T, h, d> f;
-	LstmLayer<T, h, d> l0;
-	LstmLayer<T, h, h> l1;
-	LstmLayer<T, h, h> l2;
-	LstmLayer<T, h, h> l3;
-
 	Lstm_2_4() {
+		auto& f = this->f;
+		auto& l0 = GetLayer<0>(*this);
+		auto& l1 = GetLayer<1>(*this);
+		auto& l2 = GetLayer<2>(*this);
+		auto& l3 = GetLayer<3>(*this);
+
 		l0.Wii <<  0.4873019,-1.930246 ;
 		l0.Wif <<  0.0963292,-1.3617834;
 		l0.Wig <<  0.02839015,-1.3692526 ;
@@ -44,9 +40,6 @@ public:
 		l0.bhg << -0.53412724, 0.33543006;
 		l0.bho << 0.64706624,1.0917637 ;
 
-		l0.htn1 << 0.,0.;
-		l0.ctn1 << 0.,0.;
-
 		l1.Wii <<  2.7313383 , 3.704998  , 1.0172937 ,-0.20211829;
 		l1.Wif << -0.27500165,-0.4116335 , 1.4581541 , 1.2618043 ;
 		l1.Wig <<  0.9107036,-1.3911035,-1.7879906, 2.029843 ;
@@ -67,9 +60,6 @@ public:
 		l1.bhg << -0.4589658,-0.3315627;
 		l1.bho << 1.8666264,2.5347443;
 
-		l1.htn1 << 0.,0.;
-		l1.ctn1 << 0.,0.;
-
 		l2.Wii << -0.9665677,-0.6470147, 1.16947  ,-2.4347374;
 		l2.Wif <<  0.09759601,-0.26632643, 0.46649295,-1.7459782 ;
 		l2.Wig <<  2.5619297,-1.131221 , 1.6696538,-0.2519296;
@@ -90,9 +80,6 @@ public:
 		l2.bhg << -0.10314816,-0.20390227;
 		l2.bho <<  1.2032677 ,-0.09710956;
 
-		l2.htn1 << 0.,0.;
-		l2.ctn1 << 0.,0.;
-
 		l3.Wii <<  0.3603169 , 0.43497008,-0.17653555, 0.9228087 ;
 		l3.Wif << -0.58470917, 0.66512555,-0.97890884,-0.11858483;
 		l3.Wig << -0.25945833,-0.68757695, 1.2937835 ,-0.5377487 ;
@@ -113,18 +100,7 @@ public:
 		l3.bhg << -0.13997513, 0.4854995 ;
 		l3.bho << 0.37092978,0.7602654 ;
 
-		l3.htn1 << 0.,0.;
-		l3.ctn1 << 0.,0.;
-
 		f.A << -0.357076  , 0.45165426;
 		f.b << -0.2845098;
 	}
-
-	void apply_model(T* x, T* y) {
-		l0.apply_layer(*x);
-		l1.apply_layer(l0.ht);
-		l2.apply_layer(l1.ht);
-		l3.apply_layer(l2.ht);
-		*y=f.apply_layer(l3.ht);
-	}
 };
\ No newline at end of file
@@ -7,20 +7,16 @@
 */
 
 #pragma once
-#include "layers.h"
+#include "Model.h"
 
 template<typename T>
-class Lstm_32_1
+class Lstm_32_1 : public Model<T, Lstm<32>, Dense<1>>
 {
 public:
-	const static int h = 32;
-	const static int d = 1;
-	const static int layers = 1;
-
-	FccLayer<T, h, d> f;
-	LstmLayer<T, h, d> l0;
-
 	Lstm_32_1() {
+		auto& f = this->f;
+		auto& l0 = GetLayer<0>(*this);
+
 		l0.Wii << -0.40133786, 0.16764557, 0.10833129,-0.45806438, 0.39178124,-0.03291541,  0.6405147 , 0.19699308, 0.06669647,-0.46492517, 0.23017809,-1.2885064 , -0.5264386 ,-0.7924776 ,-0.29293308, 1.3794452 ,-0.07648207,-0.78229755, -0.30956244,-0.472097  , 0.09161533, 0.4126973 , 0.5931973 , 0.09254752, -0.38490888,-0.41166613, 0.01738542,-0.01347302, 0.03983083, 0.25826108, -0.26575777,-0.2057138 ;
 		l0.Wif <<  0.36356866,-0.05414906, 0.08864823,-0.10870333,-0.1635247 , 0.04767857, -0.5081234 , 0.9601626 ,-0.03493702,-0.26642478, 0.01743647,-0.4399886 , -0.19366743, 0.64446455, 0.32200438, 0.4711094 ,-0.5108544 ,-0.31803995, -0.18784559,-0.3541621 , 0.31042883,-1.1799834 ,-0.5207216 , 0.28993005,  0.13210294, 0.10348115,-0.1631006 ,-0.0693544 , 0.5708712 ,-0.04956959, -0.07373096,-0.49515256;
 		l0.Wig <<  0.36900815,-1.1614611 ,-0.03556826, 0.36849707, 0.30743772, 0.13921262, -0.8181487 , 0.45105216, 0.15449473,-0.10351776, 0.11041307, 1.3279524 , -0.2101755 , 0.3296511 , 0.1251197 ,-0.5734885 , 0.07746725,-0.2294995 ,  0.12929264, 0.25082096,-0.44813788, 0.6804998 ,-0.84650576, 0.1030792 , -0.3608517 , 0.29652745, 0.17177622,-0.1497582 ,-1.0124593 ,-0.03721407,  0.06797097,-0.07192252;
@@ -41,15 +37,7 @@ public:
 		l0.bhg << -0.00121488, 0.09032205, 0.08648782,-0.02111334,-0.04854497,-0.07513996, -0.12871948, 0.01114228, 0.10511698,-0.06535169,-0.12691145, 0.09925462,  0.05766133, 0.04360257,-0.11593482, 0.16542973, 0.11893947,-0.10067171,  0.09435631, 0.0281845 ,-0.03904457,-0.1321143 ,-0.02546006, 0.00267404, -0.09525049, 0.02623805, 0.03245769, 0.02971569, 0.09895068,-0.11767142, -0.11104997, 0.09115496;
 		l0.bho <<  0.15550795, 0.01513077,-0.17373918,-0.04554295, 0.12488441, 0.21982259,  0.20260313, 0.3358693 ,-0.03728959,-0.02787499, 0.00837201, 0.00740821,  0.2276781 , 0.21508531, 0.22168972, 0.24513043,-0.03146759, 0.07363242,  0.06356245, 0.10895713, 0.21914013,-0.03904855, 0.28556043, 0.02110188,  0.01772272, 0.18552801, 0.15836072, 0.2170154 , 0.177084  ,-0.11328583, -0.14859249,-0.1499528 ;
 
-		l0.htn1 << 0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0., 0.,0.,0.,0.,0.,0.,0.,0.;
-		l0.ctn1 << 0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0., 0.,0.,0.,0.,0.,0.,0.,0.;
-
 		f.A <<  0.19137937,-0.33538273, 0.1370304 ,-0.10639767,-0.11442564,-0.0800019 , -0.32603955, 0.10775494,-0.15000767, 0.11527911,-0.13538145, 0.26642287,  0.08297632, 0.20750232, 0.09028403, 0.01636642, 0.14000317, 0.15447737,  0.16973254, 0.210543  ,-0.23206173, 0.03783657,-0.12474605,-0.14465266,  0.04487202,-0.01208278, 0.21807957, 0.09402163,-0.4354991 ,-0.13561074, -0.0932335 , 0.14593293;
 		f.b << -0.0381943;
 	}
-
-	void apply_model(T* x, T* y) {
-		l0.apply_layer(*x);
-		*y=f.apply_layer(l0.ht);
-	}
 };
\ No newline at end of file
@@ -7,21 +7,17 @@
 */
 
 #pragma once
-#include "layers.h"
+#include "Model.h"
 
 template<typename T>
-class Lstm_4_2
+class Lstm_4_2 : public Model<T, Lstm<4>, Lstm<4>, Dense<1>>
 {
 public:
-	const static int h = 4;
-	const static int d = 1;
-	const static int layers = 2;
-
-	FccLayer<T, h, d> f;
-	LstmLayer<T, h, d> l0;
-	LstmLayer<T, h, h> l1;
-
 	Lstm_4_2() {
+		auto& f = this->f;
+		auto& l0 = GetLayer<0>(*this);
+		auto& l1 = GetLayer<1>(*this);
+
 		l0.Wii << -1.1237175 ,-0.5936374 , 1.6117938 , 0.23056762;
 		l0.Wif << 3.031693  ,0.54237497,0.32304212,0.4318755 ;
 		l0.Wig << -1.4807696 , 0.16132143, 1.7900767 , 0.8807571 ;
@@ -42,9 +38,6 @@ public:
 		l0.bhg << -0.30899653, 0.05103224,-0.34322152, 0.4682022 ;
 		l0.bho << 1.1738678 ,0.2915683 ,0.62957436,0.390069  ;
 
-		l0.htn1 << 0.,0.,0.,0.;
-		l0.ctn1 << 0.,0.,0.,0.;
-
 		l1.Wii << -0.10087327, 0.25020573, 0.08817308,-0.7710249 , 0.23750465,-0.3582187 ,  0.17340833, 0.00779419,-0.44913408, 0.02714528, 0.6659872 ,-0.16295414, -0.4923884 ,-0.36336285, 0.26706606, 0.49406403;
 		l1.Wif << -0.17917307,-0.6969838 ,-0.10870749, 0.07496659,-0.5347314 ,-0.38451958, -0.127195  ,-0.3012019 ,-0.3345358 , 0.16904274,-0.6363028 , 0.26223475, -0.02784953,-0.40592027,-0.07923207, 0.40534183;
 		l1.Wig <<  0.18330526, 0.40768817,-0.00237107, 0.02344959,-0.84929866, 0.4454104 ,  0.34133738, 0.2527639 ,-0.8430556 ,-0.11801845, 0.8601439 , 0.1738392 ,  0.30034563,-0.33608934, 0.16385093, 0.06155634;
@@ -65,16 +58,7 @@ public:
 		l1.bhg << 0.00612151,0.40690532,0.31589293,0.01645036;
 		l1.bho << -0.02216779, 0.61193764, 0.26258084, 0.16678509;
 
-		l1.htn1 << 0.,0.,0.,0.;
-		l1.ctn1 << 0.,0.,0.,0.;
-
 		f.A <<  0.48029938,-0.17035362, 0.7097976 ,-0.5044065 ;
 		f.b << 0.08724364;
 	}
-
-	void apply_model(T* x, T* y) {
-		l0.apply_layer(*x);
-		l1.apply_layer(l0.ht);
-		*y=f.apply_layer(l1.ht);
-	}
 };
\ No newline at end of file
@@ -7,23 +7,19 @@
 */
 
 #pragma once
-#include "layers.h"
+#include "Model.h"
 
 template<typename T>
-class Lstm_4_4
+class Lstm_4_4 : public Model<T, Lstm<4>, Lstm<4>, Lstm<4>, Lstm<4>, Dense<1>>
 {
 public:
-	const static int h = 4;
-	const static int d = 1;
-	const static int layers = 4;
-
-	FccLayer<T, h, d> f;
-	LstmLayer<T, h, d> l0;
-	LstmLayer<T, h, h> l1;
-	LstmLayer<T, h, h> l2;
-	LstmLayer<T, h, h> l3;
-
 	Lstm_4_4() {
+		auto& f = this->f;
+		auto& l0 = GetLayer<0>(*this);
+		auto& l1 = GetLayer<1>(*this);
+		auto& l2 = GetLayer<2>(*this);
+		auto& l3 = GetLayer<3>(*this);
+
 		l0.Wii << -1.696957  ,-0.5955281 ,-0.32794368, 0.00383047;
 		l0.Wif << -2.5160663 ,-0.51905197,-0.8460693 , 0.34745982;
 		l0.Wig <<  1.0271614 ,-0.52332664, 1.0663544 ,-0.15971507;
@@ -44,9 +40,6 @@ public:
 		l0.bhg << -0.21032658,-0.4807629 ,-0.4053663 ,-0.22490339;
 		l0.bho <<  0.56018084, 0.14312154,-0.10776085, 0.49521255;
 
-		l0.htn1 << 0.,0.,0.,0.;
-		l0.ctn1 << 0.,0.,0.,0.;
-
 		l1.Wii << -0.02517993,-0.7401389 ,-0.59589416,-0.7873249 , 0.24718906, 0.05743552,  0.22901979, 0.00519306,-0.41547355,-0.7918825 ,-0.71771955,-0.5209433 ,  0.33847165, 0.17276041, 0.40134642, 0.91415364;
 		l1.Wif << -0.00739662,-0.0240856 ,-0.12550385, 0.9316102 , 0.14427777,-0.5452504 , -0.23377784, 0.13806385,-0.05676574,-0.09842685, 0.09365167, 0.19227013, -1.1539274 , 0.16928747,-0.61030346, 0.35300267;
 		l1.Wig <<  1.2690202 , 0.31963393,-0.19856139,-0.43384698, 0.32209754,-0.49198574,  0.35033622, 0.05135982, 0.98166436, 0.69067144, 0.4523732 ,-0.53637344,  0.46085715,-0.3118141 ,-0.14046127, 0.21970463;
@@ -67,9 +60,6 @@ public:
 		l1.bhg << -0.2510557 ,-0.3588056 , 0.04640213,-0.10768756;
 		l1.bho <<  1.3207582 ,-0.2051922 , 0.22931738, 0.5715768 ;
 
-		l1.htn1 << 0.,0.,0.,0.;
-		l1.ctn1 << 0.,0.,0.,0.;
-
 		l2.Wii <<  0.6040187 , 0.05379336, 0.5811086 , 0.6008175 , 0.03620772,-0.29710448, -0.85095835, 0.6486576 , 0.06828269, 0.7769987 ,-1.011249  , 1.1785563 ,  0.03368271, 0.06417257, 0.7690144 , 0.32891685;
 		l2.Wif <<  0.0106111 ,-0.72597456, 0.2915589 , 0.49952602, 0.8310489 ,-0.21384348, -0.22679587,-0.12075736, 0.5146074 , 0.7788735 , 0.82437533, 0.5131086 ,  0.12371852, 0.61286134, 1.0490855 ,-0.14584489;
 		l2.Wig <<  0.10575638, 0.40022147,-0.10219736, 0.56520236,-0.09328454, 0.32751763, -0.18562348,-0.05533119,-1.0347921 ,-0.07398346,-0.9368971 ,-0.01260726,  0.20190017,-0.19728297, 0.088672  ,-0.06009484;
@@ -90,9 +80,6 @@ public:
 		l2.bhg <<  0.21983112,-0.32499367,-0.10985409, 0.3747616 ;
 		l2.bho <<  0.5750085 ,-0.12371989, 0.8012097 , 0.11069205;
 
-		l2.htn1 << 0.,0.,0.,0.;
-		l2.ctn1 << 0.,0.,0.,0.;
-
 		l3.Wii <<  0.33466035,-0.26674116, 0.27978447,-0.17386785, 0.25436476, 0.22357544, -1.0434169 , 0.5741696 , 0.52617604,-0.46886262, 0.69886035, 0.22254416,  1.0864664 ,-0.20157424,-0.11482176, 1.2438867 ;
 		l3.Wif <<  3.7725374e-01, 1.6285740e-01,-5.0265159e-02, 4.4044223e-01,  5.8415395e-01,-1.6659224e-01,-1.9966210e+00, 2.9750818e-01, -1.1702828e-01, 1.0261226e-03, 7.6803595e-01,-3.0474988e-01,  2.4354601e-01, 2.1938048e-01,-4.3089786e-01,-3.1759953e-01;
 		l3.Wig <<  0.25337765,-0.13181952,-0.6875357 ,-0.18692344,-0.47168982, 0.41201502, -0.11983944,-0.48764515, 0.31683326, 0.06755485,-0.41263992,-0.11644033,  0.17949219,-0.30445293, 1.1240798 ,-0.37207124;
@@ -113,18 +100,7 @@ public:
 		l3.bhg << -0.18150973, 0.4861466 , 0.4078682 ,-0.47202018;
 		l3.bho << -0.07705961, 0.28404444,-0.08263801, 0.66747326;
 
-		l3.htn1 << 0.,0.,0.,0.;
-		l3.ctn1 << 0.,0.,0.,0.;
-
 		f.A << -0.26123944, 0.26285827, 0.26897666, 1.0302578 ;
 		f.b << -0.06779221;
 	}
-
-	void apply_model(T* x, T* y) {
-		l0.apply_layer(*x);
-		l1.apply_layer(l0.ht);
-		l2.apply_layer(l1.ht);
-		l3.apply_layer(l2.ht);
-		*y=f.apply_layer(l3.ht);
-	}
 };
\ No newline at end of file
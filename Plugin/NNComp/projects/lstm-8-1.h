@@ -7,20 +7,16 @@
 */
 
 #pragma once
-#include "layers.h"
+#include "Model.h"
 
 template<typename T>
-class Lstm_8_1
+class Lstm_8_1 : public Model<T, Lstm<8>, Dense<1>>
 {
 public:
-	const static int h = 8;
-	const static int d = 1;
-	const static int layers = 1;
-
-	FccLayer<T, h, d> f;
-	LstmLayer<T, h, d> l0;
-
 	Lstm_8_1() {
+		auto& f = this->f;
+		auto& l0 = GetLayer<0>(*this);
+
 		l0.Wii << -1.5364909 , 0.30686668, 0.22601756, 0.28260782, 0.04452053, 0.35582164, -0.28118595,-0.36517638;
 		l0.Wif <<  0.8015449 ,-0.71728754, 0.29311794, 0.32368788,-0.5399201 ,-1.2816257 ,  0.1512787 ,-1.932779  ;
 		l0.Wig <<  0.41912642,-0.43669745, 0.02806793, 0.28199625,-0.23929136, 0.7369762 , -0.22313769, 1.6026275 ;
@@ -41,15 +37,7 @@ public:
 		l0.bhg << -0.17118193, 0.0084568 ,-0.20794103, 0.1931436 ,-0.01221483, 0.18431646,  0.09241755,-0.2535322 ;
 		l0.bho <<  0.24979177, 0.1719858 ,-0.23561515,-0.16866899, 0.27393815, 0.15654726,  0.2855998 , 0.03712488;
 
-		l0.htn1 << 0.,0.,0.,0.,0.,0.,0.,0.;
-		l0.ctn1 << 0.,0.,0.,0.,0.,0.,0.,0.;
-
 		f.A << -0.035661  , 0.1292121 ,-0.5131816 , 0.15557818,-0.20312908, 0.5554498 , -0.01062484, 0.73435044;
 		f.b << -0.16015466;
 	}
-
-	void apply_model(T* x, T* y) {
-		l0.apply_layer(*x);
-		*y=f.apply_layer(l0.ht);
-	}
 };
\ No newline at end of file
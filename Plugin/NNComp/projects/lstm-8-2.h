@@ -7,21 +7,17 @@
 */
 
 #pragma once
-#include "layers.h"
+#include "Model.h"
 
 template<typename T>
-class Lstm_8_2
+class Lstm_8_2 : public Model<T, Lstm<8>, Lstm<8>, Dense<1>>
 {
 public:
-	const static int h = 8;
-	const static int d = 1;
-	const static int layers = 2;
-
-	FccLayer<T, h, d> f;
-	LstmLayer<T, h, d> l0;
-	LstmLayer<T, h, h> l1;
-
 	Lstm_8_2() {
+		auto& f = this->f;
+		auto& l0 = GetLayer<0>(*this);
+		auto& l1 = GetLayer<1>(*this);
+
 		l0.Wii << -1.1796696 , 0.5961261 , 0.8695781 , 0.28497982, 0.89439756, 0.3507686 , -0.58730626,-0.4621848 ;
 		l0.Wif <<  0.26112095,-0.07447292, 0.08043795,-0.38281763, 0.5582472 , 0.3572076 ,  0.01143368,-0.04318481;
 		l0.Wig <<  1.2992758 , 0.01778085,-0.23929149, 1.0235358 , 0.2057008 ,-0.36921763,  0.3006783 ,-0.34114054;
@@ -42,9 +38,6 @@ public:
 		l0.bhg <<  0.21297956, 0.40376064,-0.17629562,-0.22563083, 0.08492201,-0.2697524 , -0.147653  , 0.00287443;
 		l0.bho <<  0.02871991, 0.23259045, 0.13527447, 0.57229584,-0.22090013,-0.16732942, -0.04872676, 0.08377458;
 
-		l0.htn1 << 0.,0.,0.,0.,0.,0.,0.,0.;
-		l0.ctn1 << 0.,0.,0.,0.,0.,0.,0.,0.;
-
 		l1.Wii << -0.18472888, 0.15968926, 0.01488668,-0.2934418 , 0.6078767 ,-0.31023318, -0.49985316, 0.16571337,-0.3071657 ,-0.04713576,-0.19732882,-0.39559862, -0.2001669 , 0.22069389, 0.11720484, 0.48867962, 0.5572336 , 0.37381142,  0.11113837,-0.02641749, 0.7112935 , 0.1209226 ,-0.20069759, 0.5315487 ,  0.14755417,-0.29983374, 0.25960913,-0.2950487 , 0.31114945,-0.34322223, -0.20690335, 0.10038118,-0.42396832, 0.3159681 ,-0.30300498,-0.05205058, -0.12734103, 0.23446813, 0.17479846,-0.20224206,-0.28924257, 0.1294098 ,  0.22366503,-0.16164207, 0.03097148, 0.12236834, 0.28281403, 0.05829117, -0.3902842 ,-0.08303122, 0.2718766 ,-0.18437931, 0.23530585, 0.09518826,  0.37212932,-0.06688096,-0.32172942,-0.16403972, 0.3527998 , 0.5095936 ,  0.11417023,-0.36168575, 0.21537536,-0.37049514;
 		l1.Wif <<  0.59492993,-0.16904141, 0.25789803,-0.15921915, 0.17397234,-0.18106222, -0.03621086, 0.15190043,-0.3181384 , 0.00109263, 0.25309533,-0.13425618,  0.15227793,-0.22080688, 0.11501104,-0.18263932, 0.944406  ,-0.3101062 ,  0.00926675, 0.21407272, 0.10761837, 0.09411157, 0.32235825,-0.34848684,  0.20251065, 0.06762754,-0.04263302, 0.11070548, 0.01198426,-0.51054966, -0.05074434, 0.03489405,-0.14953364,-0.23461504,-0.07801566,-0.1840035 ,  0.34544387,-0.17723055, 0.16420169, 0.08544857,-0.33758163,-0.3290092 , -0.0336818 , 0.24983804,-0.2772186 , 0.1128021 , 0.0284585 ,-0.13289489, -0.07391384, 0.21174425,-0.16257687, 0.29554072,-0.18407921,-0.10324799, -0.16589245, 0.1243614 , 0.2028503 , 0.3070318 ,-0.17633139, 0.10158124,  0.37900272,-0.30681303, 0.2996987 ,-0.03823843;
 		l1.Wig << -0.82183605,-0.05752868, 0.28413776,-0.9900455 ,-0.5570471 ,-0.08039373, -0.22480343,-0.0886323 ,-0.21920668,-0.25815874,-0.1107933 , 0.11989231, -0.16712403, 0.2635119 ,-0.01172316,-0.07792688, 0.9742786 , 0.34539834, -0.24109393, 0.7440202 ,-0.18021853, 0.07089637, 0.20387824,-0.28491694, -0.19388232,-0.2743823 , 0.18627988, 0.18907714, 0.0889067 , 0.08741088, -0.22994553,-0.01045165, 0.01851407,-0.17779712,-0.28286794,-0.11098198, -0.08906586,-0.06576829, 0.10399885, 0.45178905, 0.4370936 ,-0.12795663,  0.24657018, 0.21085258,-0.03082785, 0.20687772,-0.07662046,-0.28840402, -0.2122207 , 0.3090237 , 0.12240913, 0.00224651, 0.27464536,-0.37459555, -0.15792371, 0.2754673 ,-1.118113  , 0.08879491,-0.11181652,-0.15202527,  0.28558257,-0.32106766,-0.09994244, 0.04305411;
@@ -65,16 +58,7 @@ public:
 		l1.bhg <<  0.04588058, 0.22250436,-0.12336572,-0.10648052, 0.12836562,-0.20565039,  0.26954398, 0.17657621;
 		l1.bho << -0.08709291, 0.33062384, 0.4317143 ,-0.10167656,-0.04342274,-0.12364221, -0.23535387,-0.15131314;
 
-		l1.htn1 << 0.,0.,0.,0.,0.,0.,0.,0.;
-		l1.ctn1 << 0.,0.,0.,0.,0.,0.,0.,0.;
-
 		f.A << -0.58490056, 0.3934466 , 0.5603576 ,-0.19798665,-0.21453834, 0.35058376, -0.16160354, 0.01151741;
 		f.b << 0.21333344;
 	}
-
-	void apply_model(T* x, T* y) {
-		l0.apply_layer(*x);
-		l1.apply_layer(l0.ht);
-		*y=f.apply_layer(l1.ht);
-	}
 };
\ No newline at end of file
@@ -7,23 +7,19 @@
 */
 
 #pragma once
-#include "layers.h"
+#include "Model.h"
 
 template<typename T>
-class Lstm_8_4
+class Lstm_8_4 : public Model<T, Lstm<8>, Lstm<8>, Lstm<8>, Lstm<8>, Dense<1>>
 {
 public:
-	const static int h = 8;
-	const static int d = 1;
-	const static int layers = 4;
-
-	FccLayer<T, h, d> f;
-	LstmLayer<T, h, d> l0;
-	LstmLayer<T, h, h> l1;
-	LstmLayer<T, h, h> l2;
-	LstmLayer<T, h, h> l3;
-
 	Lstm_8_4() {
+		auto& f = this->f;
+		auto& l0 = GetLayer<0>(*this);
+		auto& l1 = GetLayer<1>(*this);
+		auto& l2 = GetLayer<2>(*this);
+		auto& l3 = GetLayer<3>(*this);
+
 		l0.Wii << -0.38429657,-0.17487486,-0.20550725, 1.1757642 ,-2.0758295 , 0.38563475, -0.17344895,-0.13423929;
 		l0.Wif << -0.12520264,-0.4223648 , 0.27263474, 0.7883433 ,-2.8188717 ,-0.40251482,  0.45335484, 0.17962618;
 		l0.Wig << -0.14760739,-0.06180638,-0.05814695,-0.2416779 ,-1.0315058 ,-0.71857   ,  0.43350264,-0.22672103;
@@ -44,9 +40,6 @@ public:
 		l0.bhg <<  0.13955635,-0.23308355,-0.13479748,-0.3654984 ,-0.13286828, 0.16613127, -0.07925875, 0.05101851;
 		l0.bho << -0.02785569, 0.07184891, 0.477335  , 0.04165528, 1.6744242 , 0.45239317, -0.02484583,-0.205942  ;
 
-		l0.htn1 << 0.,0.,0.,0.,0.,0.,0.,0.;
-		l0.ctn1 << 0.,0.,0.,0.,0.,0.,0.,0.;
-
 		l1.Wii <<  0.23128332, 0.25041896, 0.23940752, 0.15801786, 0.8372768 , 0.35968578, -0.39036524, 0.0553843 , 0.49528775,-0.00673163,-0.24128823,-0.14496247,  1.1387783 , 0.30699512, 0.45216545, 0.10688055, 0.2952685 , 0.09696707, -0.2920019 , 0.09703421, 1.6062156 ,-0.54520214, 0.19762763,-0.5900427 ,  0.02281271, 0.09544834,-0.22371991,-0.12590724, 0.36761913, 0.08200999,  0.2879749 ,-0.22080092, 0.55601966, 0.2682185 ,-0.1772612 ,-0.01100725, -0.5539274 , 0.22114453,-0.01346957,-0.34010994, 0.27287278, 0.5358471 , -0.15798223,-0.42660987, 0.40370983, 0.09997478,-0.08938481,-0.33472243,  0.29381716, 0.0426012 ,-0.09480708, 0.00547418,-0.9461911 , 0.0690555 , -0.03808311,-0.3534262 , 0.31036368, 0.13291995, 0.20615968, 0.0603768 ,  0.2062833 , 0.18591584, 0.15431844,-0.25026459;
 		l1.Wif << -0.19380544, 0.3138466 ,-0.03682677,-0.15769972, 0.15848446, 0.49557242, -0.49534747, 0.07084291, 0.08536224, 0.07123781, 0.04566243,-0.15593174,  0.9129891 , 0.3299613 ,-0.21840337, 0.18152632, 0.18245527, 0.24593589, -0.312097  , 0.27651983,-0.15812416,-0.04135728,-0.34920305,-0.33331642,  0.01752151, 0.2874146 ,-0.5175441 ,-0.17618863, 0.15413757,-0.20981595, -0.19013591,-0.06906663,-0.33115438, 0.0845717 , 0.05754725,-0.06344541, -0.5074858 , 0.5683266 ,-0.4582832 ,-0.11930039, 0.44306508, 0.22929727,  0.17375991,-0.18449146, 0.6581276 ,-0.17325033,-0.07802976, 0.02927498, -0.28389254,-0.39625788, 0.4253654 , 0.06622984, 0.9307677 , 0.25162244, -0.24602242,-0.14728639, 0.10065349,-0.07292043,-0.37789553,-0.27861026,  0.5956725 , 0.32228702, 0.20419964,-0.52038497;
 		l1.Wig <<  0.28954402, 0.02460872, 0.01724225,-0.00447497,-0.168747  ,-0.28103763,  0.44515947, 0.26982749,-0.34203398,-0.25765607, 0.24932732,-0.02028427,  0.8143547 , 0.3852131 , 0.12273289,-0.33948165,-0.44998303, 0.3155314 ,  0.15866399, 0.13415161, 0.51694447, 0.27866367,-0.13408534,-0.20873956,  0.22044663, 0.20198536,-0.319559  ,-0.00120767,-0.13430901,-0.06428128,  0.1467343 , 0.0962792 , 0.17447887, 0.39617193, 0.24318625, 0.33403245,  0.17097849, 0.3565763 ,-0.06562725,-0.44322416,-0.05827864,-0.46302003,  0.25627795,-0.33229652,-0.44773704,-0.5680055 , 0.33009753, 0.05516959,  0.21015391,-0.5100382 , 0.16718931,-0.2628803 ,-0.9546125 ,-0.61217064,  0.2710382 ,-0.12920903, 0.2784699 ,-0.00787001,-0.10533871,-0.11261466, -0.289563  , 0.09905819, 0.13836603,-0.58563465;
@@ -67,9 +60,6 @@ public:
 		l1.bhg << -0.08637088,-0.10950504, 0.12263454, 0.2994351 , 0.40422288,-0.18429253,  0.31298137, 0.74748296;
 		l1.bho << -0.0075063 ,-0.22315921, 0.41395622, 0.23718838, 0.17279114,-0.12368211,  0.4808787 ,-0.0805261 ;
 
-		l1.htn1 << 0.,0.,0.,0.,0.,0.,0.,0.;
-		l1.ctn1 << 0.,0.,0.,0.,0.,0.,0.,0.;
-
 		l2.Wii <<  0.32542837, 0.14256257,-0.40180132,-0.09573839,-0.00831286,-0.35489225, -0.25226486,-0.00802942,-0.00908879, 0.28536806, 0.35587117, 0.04566712,  0.42678228,-0.35585123,-0.01401748, 0.26241976,-0.17621046, 0.14587246,  0.02894494, 0.04066828, 0.39315444, 0.01786318,-0.37740934, 0.5721384 ,  0.05721021,-0.06016346,-0.5785478 , 0.34100133,-0.48348367,-0.4530782 ,  0.15985553, 0.13897385,-0.9819734 , 0.26803613,-0.939225  , 0.00374653,  0.67541456,-0.15660731, 0.13775113, 0.08523008, 0.0189547 , 0.14543822,  0.30724493, 0.30440444,-0.12591457, 0.22123224,-0.23118544, 0.28344974, -0.1487402 , 0.10101257,-0.5937596 ,-0.05685786, 0.59829664,-0.28509116, -0.07703293, 0.30419046,-0.04782531,-0.4495215 , 0.06951294, 0.08076383, -0.6296931 , 0.03346706, 0.754154  ,-0.14518647;
 		l2.Wif << -0.27809605,-0.22737198,-0.11090465, 0.1115358 , 0.34329912,-0.20474735, -0.643339  , 0.2514407 , 0.03067736,-0.248605  , 0.26636603, 0.17088258,  0.28319743, 0.26644066,-0.22721352,-0.1656125 ,-0.5010498 , 0.4183465 , -0.40189528,-0.16134608, 0.39596596,-0.38562533, 0.09293266, 0.03211715,  0.36882067,-0.08794197,-0.5353776 , 0.36937532,-0.35546815,-0.32933566, -0.03618552, 0.38001043, 0.07637043, 0.6729626 , 0.08518475,-0.19583748,  0.462757  ,-0.12210069,-1.1432126 ,-0.4338566 , 0.09276424, 0.18739714,  0.35848752, 0.4508933 , 0.47018725, 0.08909441,-0.00788027, 0.21742299, -0.23787512, 0.3517556 ,-0.08888181,-0.09369914, 1.1796036 , 0.2880144 , -0.46085992, 0.39648595,-0.06626081,-0.3859589 ,-0.08802026,-0.11198425, -0.24634199,-0.2866952 , 0.76978093, 0.32443506;
 		l2.Wig << -0.42104268,-0.25541186,-0.2976415 , 0.02341124,-0.18276033, 0.40661094,  0.68168306,-0.40854648, 0.10930482, 0.06849508,-0.46290526, 0.17368755,  0.12703393,-0.00518072, 0.13120176, 0.08579271, 0.04013427, 0.07916641,  0.11633424,-0.14004658,-0.5826218 ,-0.00622126, 0.37316972, 0.09078766, -0.43200326,-0.08666503, 0.44149563,-0.01786517, 0.11270957, 0.1274843 ,  0.07267758,-0.09517428, 0.33560804,-0.69434273,-0.50349724, 0.01632339, -0.8235106 , 0.24658248, 0.50456303,-0.09993699,-0.3386012 , 0.06564581, -0.34465918,-0.21346962,-0.2938073 ,-0.22385757, 0.37475318, 0.30483145, -0.2931094 ,-0.16273075, 0.08616584, 0.1568792 , 0.2525969 ,-0.39973152, -0.3408871 ,-0.24746887,-0.05765468, 0.04538818,-0.14090675, 0.3353883 , -0.04525339, 0.06316026, 0.4736833 , 0.11455787;
@@ -90,9 +80,6 @@ public:
 		l2.bhg << -0.39053422,-0.3730248 , 0.29032937,-0.36759582,-0.24321836,-0.3019288 ,  0.18803959, 0.25820756;
 		l2.bho <<  0.40316188, 0.12796617, 0.2681761 , 0.3567505 , 0.12724929, 0.26605895, -0.14915586, 0.12615329;
 
-		l2.htn1 << 0.,0.,0.,0.,0.,0.,0.,0.;
-		l2.ctn1 << 0.,0.,0.,0.,0.,0.,0.,0.;
-
 		l3.Wii <<  0.38235927,-0.0060038 ,-0.1208154 ,-0.03484703,-0.01696853, 0.00280739,  0.08939729, 0.17180757,-0.02040191, 0.2125383 ,-0.23516178, 0.04791203, -0.57204086, 0.17364295,-0.05469269, 0.09134148,-0.47543252,-0.44048244, -0.3872969 , 0.10812031, 0.04506926, 0.03866417, 0.29906914, 0.05355055, -0.21681876,-0.29612625,-0.30206582,-0.5100463 , 0.7623977 , 0.06888187,  0.4458607 ,-0.16360219, 0.05384133,-0.1125508 ,-0.1179746 , 0.03333397, -0.69464606,-0.31211385, 0.00451866,-0.06048703,-0.48896348, 0.0913836 ,  0.24430941, 0.10685848, 0.07267562,-0.6092549 , 0.15238798, 0.08277231,  0.01250638,-0.41685387,-0.34597257, 0.00169228,-0.44866505,-0.15449512,  0.12196407,-0.04347206,-0.02923043,-0.11610486,-1.2697507 ,-0.07040267, -0.7630015 ,-0.03585327, 0.10101426, 0.41671807;
 		l3.Wif << -4.61876005e-01, 1.82067141e-01, 7.97652602e-02,-4.32235181e-01, -4.94407237e-01,-3.27038586e-01,-2.89483070e-01,-3.56533118e-02,  3.47706042e-02, 3.24636549e-02,-7.35367164e-02, 3.16393912e-01, -3.60694647e-01,-1.21014364e-01, 9.42967180e-03, 4.96727936e-02,  3.72511327e-01, 7.27821514e-02, 8.48204866e-02, 4.77242112e-01,  7.40401400e-03, 3.23951274e-01,-5.05451024e-01,-4.33876127e-01, -3.00790101e-01,-2.93884724e-01,-1.34532139e-01,-2.91883737e-01,  7.67135203e-01,-8.17756280e-02,-3.28407377e-01,-3.44961882e-01, -5.89944795e-02, 1.94361597e-01,-9.20249224e-02, 4.70660746e-01, -5.15046835e-01, 1.90861642e-01, 1.87259600e-01, 1.08944684e-01,  5.42186163e-02,-7.51285851e-02, 2.37868860e-01,-6.77991509e-01,  2.61914283e-01,-2.62268990e-01, 1.69502214e-01, 2.29081251e-02, -2.81800419e-01,-4.44903463e-01, 5.75835072e-02,-2.38961443e-01, -5.69127679e-01,-3.54996234e-01, 2.98358977e-01,-2.32278898e-01, -1.69223393e-04,-1.31114915e-01,-4.34368283e-01, 2.09733501e-01,  4.16830540e-01,-1.35604041e-02,-1.27502754e-01, 2.57563800e-01;
 		l3.Wig << -0.31600323,-0.12036321,-0.27409375,-0.16945559, 0.3172136 ,-0.21623725,  0.03911376, 0.25780046, 0.4163996 , 0.35570443, 0.23415567, 0.11573986, -0.1680181 , 0.15595762,-0.13100094,-0.38493726, 0.12111614,-0.38035616, -0.08507621, 0.3627916 ,-0.5818526 ,-0.34265578,-0.09831513,-0.14793256, -0.24385238, 0.12629487, 0.09520749,-0.15995027, 0.6471901 ,-0.09017329, -0.06335149, 0.21218206, 0.19988936,-0.42332855, 0.06229989,-0.11040641,  0.14036733, 0.24926306, 0.29012802, 0.10647985,-0.3551574 ,-0.2519124 ,  0.1344502 , 0.00251087, 0.0195465 ,-0.5305383 ,-0.27009717,-0.09613294, -0.06155932, 0.2637481 ,-0.13217631,-0.2079913 , 0.6874836 , 0.42377916, -0.30645782,-0.11132588,-0.24749085,-0.09366364, 0.22517592,-0.3525629 ,  0.85397506, 0.287216  ,-0.09509724, 0.2904212 ;
@@ -113,18 +100,7 @@ public:
 		l3.bhg << -0.3227401 , 0.14247076, 0.03405275, 0.19445048, 0.2577399 , 0.33726272, -0.16960217,-0.28496093;
 		l3.bho <<  0.19671209, 0.3066901 , 0.29646423,-0.07003342, 0.3589346 , 0.40533826,  0.35311413, 0.17584121;
 
-		l3.htn1 << 0.,0.,0.,0.,0.,0.,0.,0.;
-		l3.ctn1 << 0.,0.,0.,0.,0.,0.,0.,0.;
-
 		f.A <<  0.06948926,-0.32727367, 0.30543414,-0.29240057, 0.1465039 ,-0.01848466, -0.15163748,-0.5964457 ;
 		f.b << -0.14181264;
 	}
-
-	void apply_model(T* x, T* y) {
-		l0.apply_layer(*x);
-		l1.apply_layer(l0.ht);
-		l2.apply_layer(l1.ht);
-		l3.apply_layer(l2.ht);
-		*y=f.apply_layer(l3.ht);
-	}
 };
\ No newline at end of file
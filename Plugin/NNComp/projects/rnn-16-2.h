@@ -7,21 +7,17 @@
 */
 
 #pragma once
-#include "layers.h"
+#include "Model.h"
 
 template<typename T>
-class Rnn_16_2
+class Rnn_16_2 : public Model<T, Rnn<16>, Rnn<16>, Dense<1>>
 {
 public:
-	const static int h = 16;
-	const static int d = 1;
-	const static int layers = 2;
-
-	FccLayer<T, h, d> f;
-	RnnLayer<T, h, d> l0;
-	RnnLayer<T, h, h> l1;
-
 	Rnn_16_2() {
+		auto& f = this->f;
+		auto& l0 = GetLayer<0>(*this);
+		auto& l1 = GetLayer<1>(*this);
+
 		l0.Wih <<  0.16126221,-1.2520856 ,-0.7862244 ,-0.12684667, 0.00302424, 0.32773292, -0.35501656,-0.06678154, 0.08854584, 0.09419783,-0.62033594,-0.40507954,  0.04068311,-0.15739268,-1.0673083 , 0.14712034;
 
 		l0.Whh <<  0.2508725 , 0.0201106 , 0.00785007,-0.03399282,-0.15221205,-0.03791109,  0.2128995 , 0.11693423,-0.17187653, 0.20549606,-0.14998162, 0.16595095,  0.08566836,-0.1410933 , 0.07974321, 0.08441871,-0.14277627,-0.3503139 ,  0.05800478, 0.1813308 , 0.0375848 , 0.02904348, 0.12903237,-0.17456982, -0.0371433 ,-0.10885578,-0.181784  , 0.22960983,-0.08344947, 0.0741125 , -0.07562587, 0.0826368 ,-0.01790906, 0.15676756,-0.00528873, 0.4119855 , -0.14590572, 0.20719346,-0.24605349, 0.12989493, 0.14391528, 0.04790725, -0.00077166, 0.10958306, 0.19054677,-0.07516105, 0.16872573,-0.0160536 ,  0.02361786, 0.09855255, 0.2453107 ,-0.17414825, 0.15241243,-0.04164198, -0.16044591,-0.20765509,-0.10847609,-0.01973405,-0.00544487, 0.22294724, -0.00568427,-0.04835344, 0.13582954,-0.2718295 ,-0.07221662, 0.12477405,  0.11097325, 0.27897274, 0.16900758, 0.19481608, 0.06125855, 0.07306492,  0.06348467, 0.1981484 , 0.27331084,-0.11509833,-0.09875771,-0.1395829 , -0.02739539,-0.07581635,-0.20672342,-0.17464265, 0.08663138, 0.01622197,  0.20124125,-0.22305498,-0.11662475,-0.28367668,-0.09155302,-0.20514318,  0.27626622, 0.19729847, 0.09355676, 0.14287163,-0.08986538,-0.08906186,  0.10407657, 0.01699765,-0.14080852,-0.00547125,-0.1318547 ,-0.20560783,  0.19111001, 0.07190076,-0.02618509,-0.00298031,-0.24255586,-0.23522915, -0.15199888, 0.05201844,-0.15088275, 0.0604577 , 0.04823846,-0.04745524,  0.11178571,-0.16659607,-0.17209147,-0.1403037 , 0.10325663, 0.0554953 , -0.06056873, 0.1268327 , 0.01380883, 0.21428965,-0.10654373, 0.16145383,  0.16738313, 0.30518112, 0.13877594,-0.07237239, 0.11006154, 0.05908611,  0.01638724, 0.08711871,-0.03430449,-0.28125948,-0.38171396,-0.17279258,  0.1054117 ,-0.20151518, 0.1403366 ,-0.1726823 ,-0.06108188,-0.09825381,  0.23298293, 0.06963592, 0.04464132,-0.1599942 ,-0.02541896, 0.0182177 ,  0.19408168, 0.12522955,-0.13661289,-0.02623683,-0.3420821 ,-0.1474242 ,  0.22656158, 0.01911447, 0.12440889,-0.09843612,-0.14314902,-0.13462086, -0.303964  ,-0.12197737,-0.11264682, 0.36169633,-0.02966516,-0.23496425, -0.02468296, 0.03399982,-0.12889335, 0.01354374, 0.10945973,-0.10878171, -0.24999572,-0.2738109 ,-0.08928251,-0.07196561, 0.18144739,-0.13516547,  0.2730314 ,-0.05686495,-0.28556436,-0.15783902,-0.20604642,-0.20614918, -0.29699177,-0.17035557,-0.02798525, 0.09040707, 0.11334602, 0.30176032, -0.06275791,-0.0600875 , 0.33943   , 0.2499049 , 0.02390789,-0.12781037,  0.01429808, 0.07665433,-0.07147917,-0.17888144,-0.03829508, 0.00413469,  0.09819018,-0.1455139 , 0.23450828,-0.16228884, 0.4745646 ,-0.00757582,  0.05505583, 0.11644025, 0.1349427 , 0.22931829, 0.01118887,-0.09806214,  0.07296129, 0.22579806,-0.3406879 ,-0.3711658 , 0.08079795,-0.47144282, -0.42911488, 0.3392631 ,-0.02212187,-0.18334568,-0.20701309,-0.0677593 , -0.03223439,-0.19569355, 0.11374319, 0.13006617,-0.10939006, 0.12377018,  0.06839676, 0.00342792,-0.41421202, 0.10630296, 0.31152618, 0.16676706,  0.28677574,-0.09835114, 0.01405191, 0.11062301, 0.11577344, 0.07327738,  0.04315146, 0.36418775, 0.02408723,-0.19059794,-0.25287703,-0.19848081,  0.06950632, 0.15970823,-0.01811617, 0.03275971;
@@ -30,8 +26,6 @@ public:
 
 		l0.bhh << -0.10666201, 0.11975614,-0.16342355, 0.03522471,-0.22581546,-0.02019228,  0.10361985,-0.2156527 , 0.16325589, 0.20033574, 0.17962815, 0.23120993, -0.09054133, 0.17950168, 0.07727406, 0.19419421;
 
-		l0.htn1 << 0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.;
-
 		l1.Wih << -0.16649581,-0.09972446, 0.04427899,-0.10892356,-0.15538016,-0.18536933,  0.32088658,-0.0358228 , 0.01047032,-0.0409422 , 0.0173732 , 0.1870294 ,  0.00130436,-0.04416835,-0.14870062,-0.13315977,-0.35598886, 0.08968484, -0.12484698,-0.16024373, 0.20776415,-0.00225749,-0.08908195,-0.12752907,  0.16256334, 0.23700747,-0.04040205, 0.07162482,-0.04269596, 0.22376522,  0.31075323, 0.01602742, 0.15815406, 0.01830669,-0.20533513, 0.13658608, -0.24704903, 0.05597099,-0.17568082, 0.13152982, 0.16497253,-0.0349512 , -0.16537024, 0.02215364, 0.21977583, 0.04931753,-0.08916672,-0.01442336,  0.02954631, 0.13153248,-0.01922252, 0.11842366,-0.14906694,-0.01121889,  0.16878739,-0.0337193 ,-0.15141986,-0.14601727,-0.02672812,-0.06756286, -0.09729862, 0.12941599, 0.10126581, 0.22986428,-0.02447405,-0.3992526 , -0.00526294,-0.28933272,-0.1405621 , 0.07834219, 0.19793911, 0.03935089, -0.24715093,-0.17738338, 0.257196  , 0.10613982,-0.05235623,-0.08610391, -0.0703907 , 0.17943923,-0.16289876, 0.07636557, 0.02858619, 0.08715386, -0.06306445,-0.20518741, 0.15204993, 0.02833475,-0.26695   , 0.07800594, -0.04065631, 0.16677724,-0.00944413, 0.15028992, 0.31301126, 0.20641519, -0.1384026 ,-0.7097189 ,-0.8754755 ,-0.19937481,-0.23728776,-0.21906357,  0.04705415, 0.44450754, 0.06249201, 0.33161512,-0.0919723 ,-0.05775708,  0.05828402,-0.08004116,-0.38471252,-0.02252841, 0.03996471, 0.0017119 ,  0.00799882,-0.25504062,-0.14925581,-0.07255225,-0.13089369, 0.24086823,  0.1719118 , 0.20600358, 0.08999475, 0.17061426,-0.02324508, 0.125289  , -0.027494  ,-0.04655026, 0.01137944,-0.09768245,-0.2321669 ,-0.2636348 , -0.0439774 ,-0.1403165 , 0.14225498, 0.06118795,-0.267576  ,-0.00217911,  0.16739833,-0.16193081, 0.13787787, 0.00634858, 0.37536857,-0.0459056 , -0.2664538 , 0.06875037,-0.18186246,-0.10978707, 0.16507861,-0.2869068 , -0.19772504, 0.09020972,-0.09771246, 0.2799957 ,-0.19271214,-0.10702374, -0.2529109 , 0.13455959,-0.03676084, 0.08053894, 0.20211105, 0.01249575,  0.13436337,-0.17283484, 0.14333203, 0.15421045,-0.18574013, 0.02695686, -0.10552145,-0.0778824 ,-0.393751  ,-0.11612377,-0.28873816,-0.12442886,  0.32632685, 0.0179508 , 0.09652861, 0.03274695,-0.00922415, 0.13618195, -0.23238379, 0.13084485,-0.0447114 ,-0.02869823,-0.20993364, 0.01195773, -0.23835585,-0.06220616, 0.44090453,-0.4052806 ,-0.1809109 ,-0.04741426,  0.3883023 ,-0.7919853 ,-0.443879  ,-0.25367755, 0.04331309, 0.3071329 ,  0.05852622, 0.18176843,-0.21895505,-0.15038338,-0.71527773,-0.43980387,  0.01821478,-0.02366925,-0.7484081 , 0.10920687,-0.2001364 , 0.30493945,  0.12382404, 0.25467452,-0.07983857,-0.16358246, 0.07817069,-0.11027163, -0.28303933,-0.21773602, 0.1737794 , 0.39611334,-0.35462984,-0.1143238 ,  0.6541697 ,-0.19204177,-0.07137612,-0.03502845, 0.39345437,-0.0371936 ,  0.1502356 ,-0.2603754 ,-0.16739438,-0.04252495, 0.0402041 ,-0.24470896,  0.2973009 , 0.32235235,-0.04151732,-0.05709606, 0.5257402 ,-0.17505506,  0.08516449,-0.18212728, 0.04080114, 0.15795791,-0.01713282, 0.09366174, -0.21454686,-0.11578351,-0.23549138,-0.16521059,-0.47099283,-0.12445963,  0.10608983,-0.19849166,-0.13458528,-0.1170942 ;
 
 		l1.Whh <<  0.35976157,-0.14329998, 0.05601992,-0.16244918, 0.22145075, 0.16798829, -0.16614906,-0.27796116, 0.10084213, 0.14938815,-0.03798388,-0.10262247, -0.14006568,-0.17043857, 0.19602989,-0.07198891,-0.20313638, 0.57679766,  0.3187861 , 0.24869189,-0.10956021, 0.07165276,-0.31033987,-0.5963806 , -0.10936937, 0.2655014 , 0.2626203 ,-0.2134717 ,-0.101499  ,-0.1758876 ,  0.19960089, 0.11841673, 0.23957741, 0.41948152, 0.3315331 , 0.20260426, -0.0333855 ,-0.03841683, 0.17836389,-0.06210596,-0.14841224,-0.13789701,  0.01859144,-0.0890327 , 0.11165234,-0.06112023, 0.06050923, 0.00392295, -0.08361974, 0.09930134, 0.25995484,-0.04212784,-0.20397602,-0.10192994,  0.14718145,-0.41563803,-0.03519998, 0.12251659, 0.2113363 ,-0.1600275 ,  0.08504166, 0.1795556 , 0.16560496, 0.14475347, 0.13215259, 0.21124808,  0.16140354,-0.18627085,-0.06938598,-0.17977935,-0.17868763, 0.14883392,  0.29979664,-0.14700715, 0.03070688,-0.03015966, 0.0642257 ,-0.06135581, -0.18884   ,-0.00657842, 0.18423896, 0.06300452,-0.09127878,-0.08059975, -0.00312891,-0.03455685,-0.06876045, 0.35485318,-0.20462182,-0.0193958 , -0.17478174,-0.15015851,-0.2822022 , 0.03046999, 0.22676899, 0.03140102,  0.17074513, 0.24557722, 0.4733373 ,-0.17030868,-0.17835127,-0.202244  ,  0.22372173,-0.4136243 , 0.08843589,-0.09422065,-0.38818452,-0.00555076, -0.2837402 , 0.26473862, 0.236994  ,-0.1287903 ,-0.14672919,-0.16720562, -0.14119127,-0.136424  ,-0.18030085,-0.14544597,-0.25380835, 0.06318101, -0.26539034,-0.09023349, 0.05026429,-0.29352966, 0.0246778 , 0.2185911 ,  0.019098  ,-0.0810892 , 0.13815974,-0.08595885,-0.04065286, 0.08079626, -0.05067642, 0.08739863,-0.20679964,-0.05349285,-0.3367124 , 0.22275132,  0.1565556 , 0.2949451 , 0.00188381,-0.01857303, 0.08291407, 0.04704199,  0.13161838, 0.21178289, 0.02520559,-0.26771006, 0.01588223,-0.2672059 , -0.14387546,-0.14028147, 0.12079121, 0.257359  ,-0.09103024,-0.0387434 , -0.16127038, 0.12234456, 0.01075194,-0.29633486,-0.12428235,-0.3894178 ,  0.07538996, 0.18876088, 0.11624835,-0.01900955,-0.3193981 ,-0.2778426 ,  0.05599356, 0.10199457, 0.01056394, 0.10081951, 0.22717519,-0.2011352 , -0.39645514,-0.13808694,-0.18464655, 0.40428334,-0.03070046, 0.16891125,  0.09058022, 0.04864467, 0.30451208,-0.4328202 , 0.11804879, 0.11793129, -0.03656499, 0.3686404 ,-0.10672168,-0.12343944, 0.04428392, 0.08902405, -0.3779369 ,-0.5323171 ,-0.67158026,-0.52858996, 0.04631312, 0.18928139, -0.60801846, 0.29326206, 0.1983416 ,-0.01925782, 0.0533819 ,-0.26075298,  0.24318957,-0.17986792,-0.27405968, 0.25057203, 0.21692969, 0.47349483, -0.16068022, 0.30916795,-0.26443648, 0.4013592 ,-0.18742439, 0.465438  ,  0.15041673, 0.32819682,-0.00935566,-0.01325951,-0.27145377, 0.15086746,  0.04004265, 0.01708368,-0.02092637, 0.03275063, 0.18403542, 0.12696518,  0.12561248,-0.12269074,-0.10428834,-0.36300552, 0.13930556,-0.14946844, -0.28859594, 0.30120245,-0.16644926, 0.11557259, 0.15060057, 0.25639632, -0.23852062, 0.11326063,-0.3800801 ,-0.02371553,-0.26067916, 0.20403227, -0.48982078, 0.29732808,-0.02040041,-0.01038379,-0.11750075, 0.15884417,  0.16973136, 0.25959703, 0.26277384, 0.20750692;
@@ -40,15 +34,7 @@ public:
 
 		l1.bhh << -0.14132558,-0.02860604, 0.18019423,-0.13576715, 0.01730952,-0.23274277,  0.21602139,-0.06706499, 0.01077801,-0.07558651, 0.1397626 , 0.01887508, -0.23034804, 0.14437799,-0.02310893, 0.05513478;
 
-		l1.htn1 << 0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.,0.;
-
 		f.A <<  0.11547656,-0.02689054, 0.09411177, 0.01372231, 0.22085127, 0.20603293,  0.1605302 , 0.18615663, 0.22617738,-0.17323811,-0.23885974, 0.1283862 ,  0.10690152, 0.00278911,-0.09840163, 0.14853129;
 		f.b << -0.0246215;
 	}
-
-	void apply_model(T* x, T* y) {
-		l0.apply_layer(*x);
-		l1.apply_layer(l0.ht);
-		*y=f.apply_layer(l1.ht);
-	}
 };
\ No newline at end of file
@@ -7,23 +7,19 @@
 */
 
 #pragma once
-#include "layers.h"
+#include "Model.h"
 
 template<typename T>
-class Rnn_2_4
+class Rnn_2_4 : public Model<T, Rnn<2>, Rnn<2>, Rnn<2>, Rnn<2>, Dense<1>>
 {
 public:
-	const static int h = 2;
-	const static int d = 1;
-	const static int layers = 4;
-
-	FccLayer<T, h, d> f;
-	RnnLayer<T, h, d> l0;
-	RnnLayer<T, h, h> l1;
-	RnnLayer<T, h, h> l2;
-	RnnLayer<T, h, h> l3;
-
 	Rnn_2_4() {
+		auto& f = this->f;
+		auto& l0 = GetLayer<0>(*this);
+		auto& l1 = GetLayer<1>(*this);
+		auto& l2 = GetLayer<2>(*this);
+		auto& l3 = GetLayer<3>(*this);
+
 		l0.Wih << -2.729341 ,-2.0342002;
 
 		l0.Whh <<  0.17036283, 0.22163755,-0.6127797 ,-0.92778975;
@@ -32,8 +28,6 @@ public:
 
 		l0.bhh << -0.09538452,-0.69105047;
 
-		l0.htn1 << 0.,0.;
-
 		l1.Wih << -0.17657861,-1.5796613 , 1.8669199 , 5.1016483 ;
 
 		l1.Whh <<  0.17998615,-0.8947482 , 0.16628672,-0.11702587;
@@ -42,8 +36,6 @@ public:
 
 		l1.bhh << 0.00801696,0.41186023;
 
-		l1.htn1 << 0.,0.;
-
 		l2.Wih << -0.10098406,-0.5625597 , 1.195943  ,-0.76536983;
 
 		l2.Whh <<  0.5601913 ,-0.1288622 ,-1.5549568 ,-0.02015822;
@@ -52,8 +44,6 @@ public:
 
 		l2.bhh <<  0.0897334 ,-0.49221122;
 
-		l2.htn1 << 0.,0.;
-
 		l3.Wih <<  0.06845319,-0.11383019,-0.16757894, 0.31667355;
 
 		l3.Whh << -0.02625313, 0.49640965, 0.1726651 , 0.15925215;
@@ -62,17 +52,7 @@ public:
 
 		l3.bhh <<  0.00806533,-0.13443708;
 
-		l3.htn1 << 0.,0.;
-
 		f.A << 0.5618275 ,0.45957944;
 		f.b << -0.3761936;
 	}
-
-	void apply_model(T* x, T* y) {
-		l0.apply_layer(*x);
-		l1.apply_layer(l0.ht);
-		l2.apply_layer(l1.ht);
-		l3.apply_layer(l2.ht);
-		*y=f.apply_layer(l3.ht);
-	}
 };
\ No newline at end of file
@@ -0,0 +1,255 @@
+#pragma once
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <string>
+#include <vector>
+#include "Eigen/Dense"
+#include "dsp.h"
+#include "Resampler.h"
+#include "WavFile.h"
+#include "Wavefront.h"
+
+/**
+ * Shared pieces of the model rewriting tools (nncomp_compress, nncomp_prune,
+ * nncomp_optimize): stacked access to the gate weights of a layer, test audio, output error
+ * and header writing in the layout of Training/create_header.py.
+ */
+
+using Eigen::MatrixXd;
+using Eigen::VectorXd;
+
+/**
+ * Stacked biases of a layer as written to a header
+ */
+struct Bias
+{
+  const char* name;
+  VectorXd b;
+};
+
+/**
+ * Read the gate weights of a layer stacked (i, f, g, o for lstm, r, z, n for gru) and its
+ * biases, folded where the gate equations allow it
+ */
+template<typename T, int h, int d>
+void GetStacked(const LstmLayer<T, h, d>& l, MatrixXd& Wx, MatrixXd& Wh, std::vector<Bias>& biases)
+{
+  Wx.resize(4 * h, d);
+  Wh.resize(4 * h, h);
+  VectorXd b(4 * h);
+  Wx << l.Wii, l.Wif, l.Wig, l.Wio;
+  Wh << l.Whi, l.Whf, l.Whg, l.Who;
+  b << l.bii + l.bhi, l.bif + l.bhf, l.big + l.bhg, l.bio + l.bho;
+  biases = {{"b", b}};
+}
+
+template<typename T, int h, int d>
+void GetStacked(const GruLayer<T, h, d>& l, MatrixXd& Wx, MatrixXd& Wh, std::vector<Bias>& biases)
+{
+  Wx.resize(3 * h, d);
+  Wh.resize(3 * h, h);
+  VectorXd bi(3 * h), bh(3 * h);
+  Wx << l.Wir, l.Wiz, l.Win;
+  Wh << l.Whr, l.Whz, l.Whn;
+  bi << l.bir, l.biz, l.bin;
+  bh << l.bhr, l.bhz, l.bhn;
+  biases = {{"bi", bi}, {"bh", bh}};
+}
+
+template<typename T, int h, int d>
+void GetStacked(const RnnLayer<T, h, d>& l, MatrixXd& Wx, MatrixXd& Wh, std::vector<Bias>& biases)
+{
+  Wx = l.Wih;
+  Wh = l.Whh;
+  biases = {{"b", l.bih + l.bhh}};
+}
+
+/**
+ * Write stacked gate weights back to a layer
+ */
+template<typename T, int h, int d>
+void SetStacked(LstmLayer<T, h, d>& l, const MatrixXd& Wx, const MatrixXd& Wh)
+{
+  l.Wii = Wx.middleRows(0, h); l.Wif = Wx.middleRows(h, h); l.Wig = Wx.middleRows(2 * h, h); l.Wio = Wx.middleRows(3 * h, h);
+  l.Whi = Wh.middleRows(0, h); l.Whf = Wh.middleRows(h, h); l.Whg = Wh.middleRows(2 * h, h); l.Who = Wh.middleRows(3 * h, h);
+}
+
+template<typename T, int h, int d>
+void SetStacked(GruLayer<T, h, d>& l, const MatrixXd& Wx, const MatrixXd& Wh)
+{
+  l.Wir = Wx.middleRows(0, h); l.Wiz = Wx.middleRows(h, h); l.Win = Wx.middleRows(2 * h, h);
+  l.Whr = Wh.middleRows(0, h); l.Whz = Wh.middleRows(h, h); l.Whn = Wh.middleRows(2 * h, h);
+}
+
+template<typename T, int h, int d>
+void SetStacked(RnnLayer<T, h, d>& l, const MatrixXd& Wx, const MatrixXd& Wh)
+{
+  l.Wih = Wx;
+  l.Whh = Wh;
+}
+
+template<typename T, int h, int d> const char* LayerTypeName(const LstmLayer<T, h, d>&) { return "Lstm"; }
+template<typename T, int h, int d> const char* LayerTypeName(const GruLayer<T, h, d>&) { return "Gru"; }
+template<typename T, int h, int d> const char* LayerTypeName(const RnnLayer<T, h, d>&) { return "Rnn"; }
+template<typename T, int h, int d> bool IsLstm(const LstmLayer<T, h, d>&) { return true; }
+template<typename L> bool IsLstm(const L&) { return false; }
+
+/**
+ * Read up to seconds of a file as mono at the 48 kHz of the models
+ */
+inline bool ReadTestAudio(const std::string& path, double seconds, double gain, std::vector<double>& x, std::string& error)
+{
+  WavReader reader;
+  if(!reader.Open(path, error)) return false;
+
+  const int nChans = reader.GetNumChannels();
+  const long nFrames = static_cast<long>(std::min<double>(reader.GetFrames(), seconds * reader.GetSampleRate()));
+  std::vector<std::vector<double>> chans(nChans, std::vector<double>(std::max(1L, nFrames)));
+  std::vector<double*> ptrs(nChans);
+  for(int c = 0; c < nChans; c++) ptrs[c] = chans[c].data();
+  const long n = reader.Read(ptrs.data(), nFrames);
+  if(n <= 0)
+  {
+    error = path + ": no audio";
+    return false;
+  }
+
+  std::vector<double> mono(n, 0.);
+  for(int c = 0; c < nChans; c++)
+  {
+    for(long s = 0; s < n; s++) mono[s] += chans[c][s] * gain / nChans;
+  }
+
+  const int rate = RateAdapter<double>::kModelRate;
+  if(reader.GetSampleRate() == rate)
+  {
+    x = std::move(mono);
+    return true;
+  }
+  Resampler<double> resampler;
+  resampler.Setup(reader.GetSampleRate(), rate);
+  x.resize(resampler.GetMaxOutput(static_cast<int>(n)));
+  x.resize(resampler.Process(mono.data(), static_cast<int>(n), x.data()));
+  return true;
+}
+
+/**
+ * Model output error relative to the reference in dB, -inf when identical
+ */
+inline double ErrorDb(const std::vector<double>& y, const std::vector<double>& ref)
+{
+  double e = 0., p = 0.;
+  for(size_t s = 0; s < y.size(); s++)
+  {
+    e += (y[s] - ref[s]) * (y[s] - ref[s]);
+    p += ref[s] * ref[s];
+  }
+  if(e == 0.) return -INFINITY;
+  return 10. * std::log10(e / std::max(p, 1e-300));
+}
+
+/**
+ * Run a model from its initial state over x
+ */
+template<typename M>
+void RunModel(M& m, const std::vector<double>& x, std::vector<double>& y)
+{
+  y.resize(x.size());
+  ResetState(m);
+  ApplyModelWavefront(m, x.data(), y.data(), static_cast<int>(x.size()));
+}
+
+/**
+ * Comma separated coefficients in row-major order, as expected by Eigen's << initialiser
+ */
+inline void PrintValues(FILE* file, const MatrixXd& m)
+{
+  for(int r = 0; r < m.rows(); r++)
+  {
+    for(int c = 0; c < m.cols(); c++)
+    {
+      fprintf(file, "%s%.9g", r + c > 0 ? "," : "", m(r, c));
+    }
+  }
+}
+
+inline void PrintMatrix(FILE* file, int layer, const char* name, const MatrixXd& m)
+{
+  fprintf(file, "\t\tl%d.%s << ", layer, name);
+  PrintValues(file, m);
+  fprintf(file, ";\n");
+}
+
+/**
+ * Class name of a rewritten model, eg. lstm-32-1 + lr -> Lstm_32_1_lr
+ */
+inline std::string ClassName(std::string name, const char* suffix)
+{
+  name[0] = static_cast<char>(std::toupper(name[0]));
+  std::replace(name.begin(), name.end(), '-', '_');
+  return name + "_" + suffix;
+}
+
+/**
+ * Header comment, class declaration, constants and output layer. Layer declarations follow.
+ * outWidth - width of the layer feeding the output layer, if it differs from h
+ */
+inline void WriteHeaderBegin(FILE* file, const char* kind, const std::string& modelName, const std::string& className,
+                             const char* include, const char* tool, double errorDb, int h, int layers, int outWidth)
+{
+  char date[64];
+  const std::time_t now = std::time(nullptr);
+  std::strftime(date, sizeof(date), "%d/%m/%Y at: %H:%M", std::localtime(&now));
+  fprintf(file, "/**\n * %s header file for %s\n * neural network model parameters.\n * \n * Created on: %s\n"
+                " * Generated Using: %s, %.1f dB output error\n*/\n\n", kind, modelName.c_str(), date, tool, errorDb);
+  fprintf(file, "#pragma once\n#include \"%s\"\n\ntemplate<typename T>\nclass %s\n{\npublic:\n", include, className.c_str());
+  fprintf(file, "\tconst static int h = %d;\n\tconst static int d = 1;\n\tconst static int layers = %d;\n\n", h, layers);
+  if(outWidth == h) fprintf(file, "\tFccLayer<T, h, d> f;\n");
+  else fprintf(file, "\tFccLayer<T, %d, d> f;\n", outWidth);
+}
+
+template<typename M>
+void WriteHeaderBegin(FILE* file, const char* kind, const std::string& modelName, const std::string& className,
+                      const char* include, const char* tool, double errorDb)
+{
+  WriteHeaderBegin(file, kind, modelName, className, include, tool, errorDb, M::h, M::layers, M::h);
+}
+
+/**
+ * Initial state of layer j with width h, for lstm layers also the cell state
+ */
+inline void WriteLayerState(FILE* file, int j, int h, bool lstm)
+{
+  PrintMatrix(file, j, "htn1", VectorXd::Zero(h).transpose());
+  if(lstm) PrintMatrix(file, j, "ctn1", VectorXd::Zero(h).transpose());
+  fprintf(file, "\n");
+}
+
+template<typename M, typename L>
+void WriteLayerState(FILE* file, int j, const L& l)
+{
+  WriteLayerState(file, j, M::h, IsLstm(l));
+}
+
+/**
+ * Output layer weights, end of the constructor and apply_model
+ */
+inline void WriteHeaderEnd(FILE* file, const VectorXd& A, double b, int layers)
+{
+  fprintf(file, "\t\tf.A << ");
+  for(int i = 0; i < A.size(); i++) fprintf(file, "%s%.9g", i > 0 ? "," : "", A(i));
+  fprintf(file, ";\n\t\tf.b << %.9g;\n\t}\n\n", b);
+
+  fprintf(file, "\tvoid apply_model(T* x, T* y) {\n\t\tl0.apply_layer(*x);\n");
+  for(int j = 1; j < layers; j++) fprintf(file, "\t\tl%d.apply_layer(l%d.ht);\n", j, j - 1);
+  fprintf(file, "\t\t*y=f.apply_layer(l%d.ht);\n\t}\n};", layers - 1);
+}
+
+template<typename M>
+void WriteHeaderEnd(FILE* file, const M& model)
+{
+  WriteHeaderEnd(file, model.f.A.col(0).template cast<double>(), double(model.f.b(0)), M::layers);
+}
@@ -0,0 +1,232 @@
+/**
+ * Packed weight arena report.
+ * Runs the NNComp models as generated and as PackedModel (see WeightArena.h), with all
+ * weights in one 64 byte aligned block, on a piece of audio. Prints whether the outputs are
+ * bit-identical and the speed of the packed layout against the generated one:
+ * - single: one instance processing the whole piece
+ * - warm: N instances, each with its own stream, processing a block in turn
+ * - evicted: the same with enough memory streamed through the cache between blocks to evict
+ *   the weights, the case the arena is meant for
+ * Speeds above 1 mean the packed layout is faster.
+ *
+ * Usage: nncomp_arena [options] <file.wav> [model]...
+ */
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Denormals.h"
+#include "ModelTools.h"
+#include "WeightArena.h"
+
+struct ArenaOptions
+{
+  std::vector<int> models;
+  int instances = 16;
+  int block = 128;
+  double seconds = 10.;
+  double inGain = 1.;
+  std::string input;
+};
+
+static constexpr size_t kEvictBytes = 8 << 20;
+
+static void PrintUsage()
+{
+  printf("Usage: nncomp_arena [options] <file.wav> [model]...\n"
+         "  -n, --instances <n>  Number of model instances in the warm and evicted runs (default 16)\n"
+         "  -b, --block <n>      Block size in the warm and evicted runs (default 128)\n"
+         "  -s, --seconds <s>    Length of audio to measure on (default 10)\n"
+         "  -i, --ingain <dB>    Input gain (default 0)\n"
+         "  -l, --list           List models\n");
+}
+
+/**
+ * Input of instance i, the audio rotated by i / n of its length
+ */
+static std::vector<std::vector<float>> MakeStreams(const std::vector<double>& x, int n)
+{
+  std::vector<std::vector<float>> streams(n, std::vector<float>(x.size()));
+  for(int i = 0; i < n; i++)
+  {
+    const size_t offset = x.size() * i / n;
+    for(size_t s = 0; s < x.size(); s++) streams[i][s] = static_cast<float>(x[(s + offset) % x.size()]);
+  }
+  return streams;
+}
+
+/**
+ * Writes a buffer larger than the caches, so the next block starts with cold weights
+ */
+class CacheEvictor
+{
+public:
+  CacheEvictor() : buffer(kEvictBytes / sizeof(long)) {}
+
+  void Evict()
+  {
+    //One write per cache line is enough to take it over
+    pass++;
+    for(size_t i = 0; i < buffer.size(); i += kLine) buffer[i] += pass;
+    sink += buffer[pass % buffer.size()];
+  }
+
+  long sink = 0;
+
+private:
+  static constexpr size_t kLine = 64 / sizeof(long);
+  std::vector<long> buffer;
+  long pass = 0;
+};
+
+/**
+ * n instances of a model, each running its own stream a block at a time in turn. Returns the
+ * seconds spent in the models, the output of every instance in y.
+ */
+template<typename M>
+static double RunInstances(std::vector<std::unique_ptr<M>>& m, const std::vector<std::vector<float>>& x,
+                           std::vector<std::vector<float>>& y, int block, CacheEvictor* evictor)
+{
+  const int n = static_cast<int>(m.size());
+  const long nFrames = static_cast<long>(x[0].size());
+  double seconds = 0.;
+  ScopedDenormalGuard denormalGuard;
+  for(long t = 0; t < nFrames; t += block)
+  {
+    const int b = static_cast<int>(std::min<long>(block, nFrames - t));
+    for(int i = 0; i < n; i++)
+    {
+      if(evictor) evictor->Evict();
+      const auto start = std::chrono::steady_clock::now();
+      ApplyModelWavefront(*m[i], x[i].data() + t, y[i].data() + t, b);
+      seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+  }
+  return seconds;
+}
+
+/**
+ * Class template of a generated model, eg. Lstm_32_1 from Lstm_32_1<float>
+ */
+template<template<typename> class C>
+static void ReportModel(const C<float>&, const char* name, const std::vector<std::vector<float>>& x, int block)
+{
+  using Generated = C<float>;
+  using Packed = PackedModel<Generated>;
+  const int n = static_cast<int>(x.size());
+  const long nFrames = static_cast<long>(x[0].size());
+  bool identical = true;
+
+  //Single instance over the whole piece
+  auto model = std::make_unique<Generated>();
+  auto packed = std::make_unique<Packed>(*model);
+  std::vector<float> y(nFrames), yPacked(nFrames);
+  double tGenerated, tPacked;
+  {
+    ScopedDenormalGuard denormalGuard;
+    auto start = std::chrono::steady_clock::now();
+    for(long t = 0; t < nFrames; t++) model->apply_model(const_cast<float*>(&x[0][t]), &y[t]);
+    tGenerated = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    start = std::chrono::steady_clock::now();
+    for(long t = 0; t < nFrames; t++) packed->apply_model(const_cast<float*>(&x[0][t]), &yPacked[t]);
+    tPacked = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+  identical = identical && y == yPacked;
+
+  //Instances copied from the first ones, so the packed copies get their own arena
+  std::vector<std::unique_ptr<Generated>> models(n);
+  std::vector<std::unique_ptr<Packed>> packedModels(n);
+  for(int i = 0; i < n; i++)
+  {
+    ResetState(*model);
+    models[i] = std::make_unique<Generated>(*model);
+    packedModels[i] = std::make_unique<Packed>(*packed);
+    ResetState(*packedModels[i]);
+  }
+
+  std::vector<std::vector<float>> ys(n, std::vector<float>(nFrames)), ysPacked(n, std::vector<float>(nFrames));
+  const double tWarm = RunInstances(models, x, ys, block, nullptr);
+  const double tWarmPacked = RunInstances(packedModels, x, ysPacked, block, nullptr);
+  identical = identical && ys == ysPacked;
+
+  for(int i = 0; i < n; i++)
+  {
+    ResetState(*models[i]);
+    ResetState(*packedModels[i]);
+  }
+  CacheEvictor evictor;
+  const double tEvicted = RunInstances(models, x, ys, block, &evictor);
+  const double tEvictedPacked = RunInstances(packedModels, x, ysPacked, block, &evictor);
+  identical = identical && ys == ysPacked;
+
+  printf("%-10s %6ld %9s %7.2fx %7.2fx %7.2fx\n", name, static_cast<long>(sizeof(float)) * Packed::kArenaSize,
+         identical ? "yes" : "NO", tGenerated / tPacked, tWarm / tWarmPacked, tEvicted / tEvictedPacked);
+}
+
+int main(int argc, char* argv[])
+{
+  ArenaOptions options;
+
+  //Parse arguments
+  for(int i = 1; i < argc; i++)
+  {
+    const std::string arg = argv[i];
+    const bool hasValue = i + 1 < argc;
+    if((arg == "-n" || arg == "--instances") && hasValue) options.instances = std::max(1, std::atoi(argv[++i]));
+    else if((arg == "-b" || arg == "--block") && hasValue) options.block = std::max(1, std::atoi(argv[++i]));
+    else if((arg == "-s" || arg == "--seconds") && hasValue) options.seconds = std::strtod(argv[++i], nullptr);
+    else if((arg == "-i" || arg == "--ingain") && hasValue) options.inGain = std::pow(10., std::strtod(argv[++i], nullptr) / 20.);
+    else if(arg == "-l" || arg == "--list")
+    {
+      for(int m = 0; m < NN<float>::kNumModels; m++) printf("%s\n", NN<float>::GetModelName(m));
+      return 0;
+    }
+    else if(arg == "-h" || arg == "--help")
+    {
+      PrintUsage();
+      return 0;
+    }
+    else if(options.input.empty()) options.input = arg;
+    else
+    {
+      const int model = NN<float>::FindModel(arg.c_str());
+      if(model < 0)
+      {
+        fprintf(stderr, "error: unknown model %s, use --list\n", arg.c_str());
+        return 1;
+      }
+      options.models.push_back(model);
+    }
+  }
+
+  if(options.input.empty())
+  {
+    PrintUsage();
+    return 1;
+  }
+  if(options.models.empty())
+  {
+    for(int m = 0; m < NN<float>::kNumModels; m++) options.models.push_back(m);
+  }
+
+  std::string error;
+  std::vector<double> x;
+  if(!ReadTestAudio(options.input, options.seconds, options.inGain, x, error))
+  {
+    fprintf(stderr, "error: %s\n", error.c_str());
+    return 1;
+  }
+  const auto streams = MakeStreams(x, options.instances);
+
+  //Arena size in bytes, speed of the packed layout over the generated one
+  printf("%-10s %6s %9s %8s %8s %8s\n", "model", "arena", "identical", "single", "warm", "evicted");
+  auto nn = std::make_unique<NN<float>>();
+  for(int m : options.models)
+  {
+    nn->WithModel(m, [&](auto& model) { ReportModel(model, NN<float>::GetModelName(m), streams, options.block); });
+  }
+  return 0;
+}
@@ -0,0 +1,296 @@
+/**
+ * Batched inference report.
+ * Runs N streams of a piece of audio, each starting at a different offset, through the NNComp
+ * models with a BatchEngine (see BatchEngine.h) and with one model instance per stream running
+ * apply_model, and prints the output error of the engine against the per-stream models and the
+ * speed of both.
+ *
+ * A second run adds, removes and resets streams between blocks, so removed columns are filled
+ * by moving the last one and freed ids are reused. Every stream is compared against its own
+ * model instance started from the zero state when the stream was added or reset.
+ *
+ * Usage: nncomp_batch [options] <file.wav> [model]...
+ */
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+#include "BatchEngine.h"
+#include "Denormals.h"
+#include "ModelTools.h"
+
+struct BatchOptions
+{
+  std::vector<int> models;
+  int streams = 16;
+  double seconds = 10.;
+  double inGain = 1.;
+  std::string input;
+};
+
+static constexpr int kBlock = 512;
+static constexpr int kChurnInterval = 8; //Blocks between stream changes in the churn run
+
+static void PrintUsage()
+{
+  printf("Usage: nncomp_batch [options] <file.wav> [model]...\n"
+         "  -n, --streams <n>    Number of streams (default 16)\n"
+         "  -s, --seconds <s>    Length of audio to measure on (default 10)\n"
+         "  -i, --ingain <dB>    Input gain (default 0)\n"
+         "  -l, --list           List models\n");
+}
+
+/**
+ * Error power and reference power of a stream, to combine into dB like ErrorDb
+ */
+struct ErrorSum
+{
+  double e = 0.;
+  double p = 0.;
+
+  void Add(const float* y, const float* ref, int n)
+  {
+    for(int s = 0; s < n; s++)
+    {
+      e += (double(y[s]) - ref[s]) * (double(y[s]) - ref[s]);
+      p += double(ref[s]) * ref[s];
+    }
+  }
+
+  double Db() const { return e == 0. ? -INFINITY : 10. * std::log10(e / std::max(p, 1e-300)); }
+};
+
+/**
+ * Input of stream i, the audio rotated by i / n of its length
+ */
+static std::vector<std::vector<float>> MakeStreams(const std::vector<double>& x, int n)
+{
+  std::vector<std::vector<float>> streams(n, std::vector<float>(x.size()));
+  for(int i = 0; i < n; i++)
+  {
+    const size_t offset = x.size() * i / n;
+    for(size_t s = 0; s < x.size(); s++) streams[i][s] = static_cast<float>(x[(s + offset) % x.size()]);
+  }
+  return streams;
+}
+
+/**
+ * All streams from start to end, against one model instance per stream
+ */
+template<typename M>
+static void ReportSteady(const M& model, const char* name, const std::vector<std::vector<float>>& x)
+{
+  const int n = static_cast<int>(x.size());
+  const long nFrames = static_cast<long>(x[0].size());
+  std::vector<std::vector<float>> ref(n, std::vector<float>(nFrames)), y(n, std::vector<float>(nFrames));
+
+  //Per stream
+  auto m = std::make_unique<M>(model);
+  auto start = std::chrono::steady_clock::now();
+  {
+    ScopedDenormalGuard denormalGuard;
+    for(int i = 0; i < n; i++)
+    {
+      *m = model;
+      ResetState(*m);
+      for(long t = 0; t < nFrames; t++) m->apply_model(const_cast<float*>(&x[i][t]), &ref[i][t]);
+    }
+  }
+  const double tStream = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  //Batched
+  auto engine = std::make_unique<BatchEngine<M>>(model, n);
+  for(int i = 0; i < n; i++) engine->AddStream();
+  std::vector<const float*> in(n);
+  std::vector<float*> out(n);
+  start = std::chrono::steady_clock::now();
+  for(long t = 0; t < nFrames; t += kBlock)
+  {
+    for(int i = 0; i < n; i++)
+    {
+      in[i] = x[i].data() + t;
+      out[i] = y[i].data() + t;
+    }
+    engine->Process(in.data(), out.data(), static_cast<int>(std::min<long>(kBlock, nFrames - t)));
+  }
+  const double tBatch = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  double worst = -INFINITY;
+  for(int i = 0; i < n; i++)
+  {
+    ErrorSum e;
+    e.Add(y[i].data(), ref[i].data(), static_cast<int>(nFrames));
+    worst = std::max(worst, e.Db());
+  }
+
+  const double duration = double(nFrames) * n / 48000.;
+  printf("%-10s %7d %7.1f %9.1fx %9.1fx %6.2fx", name, n, worst, duration / tStream, duration / tBatch, tStream / tBatch);
+}
+
+/**
+ * Streams added, removed and reset between blocks, against one model instance per stream id
+ */
+template<typename M>
+static void ReportChurn(const M& model, const std::vector<std::vector<float>>& x)
+{
+  const int n = static_cast<int>(x.size());
+  const long length = static_cast<long>(x[0].size());
+  auto engine = std::make_unique<BatchEngine<M>>(model, n);
+  std::vector<std::unique_ptr<M>> ref(n);
+  std::vector<bool> active(n, false);
+  std::vector<long> position(n, 0); //Frames of its input each stream has processed
+  std::vector<std::vector<float>> y(n, std::vector<float>(kBlock)), yRef(n, std::vector<float>(kBlock));
+  std::vector<const float*> in(n);
+  std::vector<float*> out(n);
+
+  //A stream starts, or restarts, from the zero state at the start of its input
+  auto restart = [&](int id) {
+    if(!ref[id]) ref[id] = std::make_unique<M>(model);
+    ResetState(*ref[id]);
+    position[id] = 0;
+  };
+  auto add = [&]() {
+    const int id = engine->AddStream();
+    if(id < 0) return false;
+    active[id] = true;
+    restart(id);
+    return true;
+  };
+
+  //Start with three quarters of the streams, leaving room to add
+  for(int i = 0; i < std::max(1, 3 * n / 4); i++) add();
+
+  ScopedDenormalGuard denormalGuard;
+  ErrorSum e;
+  int removed = 0, added = 0, resets = 0;
+  for(long t = 0, round = 0; t < length; t += kBlock)
+  {
+    const int nFrames = static_cast<int>(std::min<long>(kBlock, length - t));
+    if(t > 0 && (t / kBlock) % kChurnInterval == 0)
+    {
+      //Remove every third stream, so columns are moved from the end, then add one more
+      //than was removed while there is room, reusing the freed ids
+      round++;
+      int nRemoved = 0;
+      for(int id = static_cast<int>(round % 3); id < n; id += 3)
+      {
+        if(active[id] && engine->RemoveStream(id))
+        {
+          active[id] = false;
+          nRemoved++;
+        }
+      }
+      removed += nRemoved;
+      for(int k = 0; k <= nRemoved && add(); k++) added++;
+
+      //Return one stream to the zero state
+      const int id = static_cast<int>(round % n);
+      if(active[id] && engine->ResetStream(id))
+      {
+        restart(id);
+        resets++;
+      }
+    }
+
+    for(int id = 0; id < n; id++)
+    {
+      in[id] = active[id] ? x[id].data() + position[id] % (length - kBlock) : nullptr;
+      out[id] = active[id] ? y[id].data() : nullptr;
+    }
+    engine->Process(in.data(), out.data(), nFrames);
+
+    for(int id = 0; id < n; id++)
+    {
+      if(!active[id]) continue;
+      for(int s = 0; s < nFrames; s++) ref[id]->apply_model(const_cast<float*>(in[id] + s), &yRef[id][s]);
+      e.Add(y[id].data(), yRef[id].data(), nFrames);
+      position[id] += nFrames;
+    }
+  }
+
+  printf(" %8.1f  (%d removed, %d added, %d reset)\n", e.Db(), removed, added, resets);
+}
+
+/**
+ * Class template of a generated model, eg. Lstm_32_1 from Lstm_32_1<float>
+ */
+template<template<typename> class C>
+static void ReportModel(const C<float>&, const char* name, const std::vector<std::vector<float>>& x)
+{
+  auto model = std::make_unique<C<float>>();
+  ReportSteady(*model, name, x);
+  ReportChurn(*model, x);
+}
+
+int main(int argc, char* argv[])
+{
+  BatchOptions options;
+
+  //Parse arguments
+  for(int i = 1; i < argc; i++)
+  {
+    const std::string arg = argv[i];
+    const bool hasValue = i + 1 < argc;
+    if((arg == "-n" || arg == "--streams") && hasValue) options.streams = std::max(1, std::atoi(argv[++i]));
+    else if((arg == "-s" || arg == "--seconds") && hasValue) options.seconds = std::strtod(argv[++i], nullptr);
+    else if((arg == "-i" || arg == "--ingain") && hasValue) options.inGain = std::pow(10., std::strtod(argv[++i], nullptr) / 20.);
+    else if(arg == "-l" || arg == "--list")
+    {
+      for(int m = 0; m < NN<float>::kNumModels; m++) printf("%s\n", NN<float>::GetModelName(m));
+      return 0;
+    }
+    else if(arg == "-h" || arg == "--help")
+    {
+      PrintUsage();
+      return 0;
+    }
+    else if(options.input.empty()) options.input = arg;
+    else
+    {
+      const int model = NN<float>::FindModel(arg.c_str());
+      if(model < 0)
+      {
+        fprintf(stderr, "error: unknown model %s, use --list\n", arg.c_str());
+        return 1;
+      }
+      options.models.push_back(model);
+    }
+  }
+
+  if(options.input.empty())
+  {
+    PrintUsage();
+    return 1;
+  }
+  if(options.models.empty())
+  {
+    for(int m = 0; m < NN<float>::kNumModels; m++) options.models.push_back(m);
+  }
+
+  std::string error;
+  std::vector<double> x;
+  if(!ReadTestAudio(options.input, options.seconds, options.inGain, x, error))
+  {
+    fprintf(stderr, "error: %s\n", error.c_str());
+    return 1;
+  }
+  if(x.size() < static_cast<size_t>(2 * kBlock))
+  {
+    fprintf(stderr, "error: %s is too short\n", options.input.c_str());
+    return 1;
+  }
+  const auto streams = MakeStreams(x, options.streams);
+
+  //Errors in dB against one float model per stream, speed in seconds of audio per second
+  //over all streams
+  printf("%-10s %7s %7s %10s %10s %7s %8s\n", "model", "streams", "error", "per-stream", "batched", "speed", "churn");
+  auto nn = std::make_unique<NN<float>>();
+  for(int m : options.models)
+  {
+    nn->WithModel(m, [&](auto& model) { ReportModel(model, NN<float>::GetModelName(m), streams); });
+  }
+  return 0;
+}
@@ -0,0 +1,113 @@
+/**
+ * Quantization calibration.
+ * Runs one of the NNComp models on representative audio in a calibration build (see
+ * Calibration.h) and writes the per-unit ranges and histograms of the layer activations, hidden
+ * and cell states and outputs as JSON, for a quantizer to pick its scales from.
+ *
+ * Usage: nncomp_calibrate [options] <model> <file.wav>...
+ */
+#define NNCOMP_CALIBRATION 1
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+#include "ModelTools.h"
+#include "Calibration.h"
+
+struct CalibrateOptions
+{
+  int model = -1;
+  int bins = CalibrationRecorder::kDefaultBins;
+  double seconds = 60.;
+  double inGain = 1.;
+  std::vector<std::string> inputs;
+  std::string output;
+};
+
+static void PrintUsage()
+{
+  printf("Usage: nncomp_calibrate [options] <model> <file.wav>...\n"
+         "  -b, --bins <n>       Histogram bins per unit (default 128)\n"
+         "  -s, --seconds <s>    Length of audio used from every file (default 60)\n"
+         "  -i, --ingain <dB>    Input gain (default 0)\n"
+         "  -o, --out <file>     Output file (default ./<model>-calibration.json)\n"
+         "  -l, --list           List models\n");
+}
+
+int main(int argc, char* argv[])
+{
+  CalibrateOptions options;
+
+  //Parse arguments
+  for(int i = 1; i < argc; i++)
+  {
+    const std::string arg = argv[i];
+    const bool hasValue = i + 1 < argc;
+    if((arg == "-b" || arg == "--bins") && hasValue) options.bins = std::atoi(argv[++i]);
+    else if((arg == "-s" || arg == "--seconds") && hasValue) options.seconds = std::strtod(argv[++i], nullptr);
+    else if((arg == "-i" || arg == "--ingain") && hasValue) options.inGain = std::pow(10., std::strtod(argv[++i], nullptr) / 20.);
+    else if((arg == "-o" || arg == "--out") && hasValue) options.output = argv[++i];
+    else if(arg == "-l" || arg == "--list")
+    {
+      for(int m = 0; m < NN<float>::kNumModels; m++) printf("%s\n", NN<float>::GetModelName(m));
+      return 0;
+    }
+    else if(arg == "-h" || arg == "--help")
+    {
+      PrintUsage();
+      return 0;
+    }
+    else if(options.model < 0)
+    {
+      options.model = NN<float>::FindModel(arg.c_str());
+      if(options.model < 0)
+      {
+        fprintf(stderr, "error: unknown model %s, use --list\n", arg.c_str());
+        return 1;
+      }
+    }
+    else options.inputs.push_back(arg);
+  }
+
+  if(options.model < 0 || options.inputs.empty())
+  {
+    PrintUsage();
+    return 1;
+  }
+  const std::string modelName = NN<float>::GetModelName(options.model);
+  if(options.output.empty()) options.output = modelName + "-calibration.json";
+
+  //Files are run back to back
+  std::string error;
+  std::vector<float> x;
+  for(const std::string& input : options.inputs)
+  {
+    std::vector<double> file;
+    if(!ReadTestAudio(input, options.seconds, options.inGain, file, error))
+    {
+      fprintf(stderr, "error: %s\n", error.c_str());
+      return 1;
+    }
+    x.insert(x.end(), file.begin(), file.end());
+  }
+
+  auto nn = std::make_unique<NN<float>>();
+  CalibrationRecorder recorder(options.bins);
+  nn->WithModel(options.model, [&](auto& m) { recorder.Run(m, x.data(), static_cast<int>(x.size())); });
+
+  for(const CalibrationTensor& t : recorder.GetTensors())
+  {
+    printf("%-6s %-7s %3d units  %9.4f .. %-9.4f\n", t.layer < 0 ? "input" : ("l" + std::to_string(t.layer)).c_str(),
+           t.name.c_str(), static_cast<int>(t.min.size()), t.min.minCoeff(), t.max.maxCoeff());
+  }
+
+  if(!recorder.Write(options.output, modelName, error))
+  {
+    fprintf(stderr, "error: %s\n", error.c_str());
+    return 1;
+  }
+  printf("wrote %s (%zu samples)\n", options.output.c_str(), x.size());
+  return 0;
+}
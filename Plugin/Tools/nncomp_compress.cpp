@@ -0,0 +1,249 @@
+/**
+ * Low-rank model compression.
+ * Factors the stacked input and recurrent weights of one of the NNComp models with a
+ * truncated SVD and picks the rank of every matrix so the model output on a piece of audio
+ * stays within an error target. Writes a header with the compressed model class, built from
+ * the layers in LowRankLayers.h.
+ *
+ * Ranks are chosen one matrix at a time, keeping the ranks already chosen. Every rank that
+ * saves multiplies, up to (rows * cols - 1) / (rows + cols), is measured and the lowest one
+ * within the target kept, the error need not fall steadily as the rank rises. Matrix k of n may
+ * use the share sqrt((k + 1) / n) of the target, errors of independent matrices add in power,
+ * so the last one ends at the target. Every accepted rank is measured with all the others in
+ * place, so the reported error is that of the written model. Matrices that no rank saving
+ * multiplies keeps within the target stay dense. If none is factored no header is written.
+ *
+ * Usage: nncomp_compress [options] <model> <file.wav>
+ */
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+#include "ModelTools.h"
+
+struct CompressOptions
+{
+  int model = -1;
+  double targetDb = -40.;
+  double seconds = 10.;
+  double inGain = 1.;
+  std::string input;
+  std::string output;
+};
+
+/**
+ * Truncated SVD of one stacked weight matrix
+ */
+struct Factor
+{
+  int layer = 0;
+  bool recurrent = false;
+  MatrixXd W;
+  MatrixXd U; //Left singular vectors scaled by the singular values
+  MatrixXd V; //Right singular vectors, transposed
+  int rank = 0;
+
+  int MaxRank() const { return static_cast<int>((W.size() - 1) / (W.rows() + W.cols())); }
+  bool IsDense() const { return rank == W.cols(); }
+  long Cost() const { return IsDense() ? static_cast<long>(W.size()) : static_cast<long>(rank) * (W.rows() + W.cols()); }
+  MatrixXd Approx() const { return IsDense() ? W : MatrixXd(U.leftCols(rank) * V.topRows(rank)); }
+};
+
+static void PrintUsage()
+{
+  printf("Usage: nncomp_compress [options] <model> <file.wav>\n"
+         "  -e, --error <dB>     Output error target relative to the output level (default -40)\n"
+         "  -s, --seconds <s>    Length of audio to measure on (default 10)\n"
+         "  -i, --ingain <dB>    Input gain (default 0)\n"
+         "  -o, --out <file.h>   Output header (default ./<model>-lr.h)\n"
+         "  -l, --list           List models\n");
+}
+
+template<typename M>
+static bool Compress(const M& model, const std::vector<double>& x, const CompressOptions& options, std::string& error)
+{
+  std::vector<double> ref, y;
+  auto work = std::make_unique<M>(model);
+  RunModel(*work, x, ref);
+
+  //Factor every stacked matrix
+  std::vector<Factor> factors;
+  std::vector<std::vector<Bias>> biases;
+  ForEachLayer(*work, [&](auto& l) {
+    Factor fx, fh;
+    biases.emplace_back();
+    GetStacked(l, fx.W, fh.W, biases.back());
+    fx.layer = fh.layer = static_cast<int>(biases.size()) - 1;
+    fh.recurrent = true;
+    for(Factor* f : {&fx, &fh})
+    {
+      Eigen::JacobiSVD<MatrixXd> svd(f->W, Eigen::ComputeThinU | Eigen::ComputeThinV);
+      f->U = svd.matrixU() * svd.singularValues().asDiagonal();
+      f->V = svd.matrixV().transpose();
+      f->rank = static_cast<int>(f->W.cols());
+      factors.push_back(*f);
+    }
+  });
+
+  auto measure = [&]() {
+    *work = model;
+    int k = 0;
+    ForEachLayer(*work, [&](auto& l) {
+      SetStacked(l, factors[k].Approx(), factors[k + 1].Approx());
+      k += 2;
+    });
+    RunModel(*work, x, y);
+    return ErrorDb(y, ref);
+  };
+
+  //Pick ranks, see the top of the file
+  std::vector<Factor*> candidates;
+  for(Factor& f : factors)
+  {
+    if(f.MaxRank() >= 1) candidates.push_back(&f);
+  }
+  std::vector<double> lowestDb(factors.size(), INFINITY); //Lowest error of any factored rank
+  for(size_t k = 0; k < candidates.size(); k++)
+  {
+    Factor& f = *candidates[k];
+    const double target = options.targetDb + 10. * std::log10(double(k + 1) / candidates.size());
+    const int dense = f.rank;
+    int best = dense;
+    for(int rank = f.MaxRank(); rank >= 1; rank--)
+    {
+      f.rank = rank;
+      const double e = measure();
+      lowestDb[&f - factors.data()] = std::min(lowestDb[&f - factors.data()], e);
+      if(e <= target) best = rank;
+    }
+    f.rank = best;
+  }
+  const double errorDb = measure();
+
+  //Report
+  long before = 0, after = 0;
+  for(const Factor& f : factors)
+  {
+    before += f.W.size();
+    after += f.Cost();
+    printf("l%d %-9s %3dx%-3d  rank %-3d %s %5ld of %5ld multiplies", f.layer, f.recurrent ? "recurrent" : "input",
+           static_cast<int>(f.W.rows()), static_cast<int>(f.W.cols()), f.rank, f.IsDense() ? "dense" : "     ", f.Cost(), static_cast<long>(f.W.size()));
+    if(f.IsDense() && f.MaxRank() >= 1)
+    {
+      printf(", ranks 1-%d reach %.1f dB at best", f.MaxRank(), lowestDb[&f - factors.data()]);
+    }
+    printf("\n");
+  }
+  if(after == before)
+  {
+    error = "no matrix compressed within the error target (model unchanged), no header written";
+    return false;
+  }
+  printf("%ld of %ld multiplies per sample (%.0f%%), output error %.1f dB\n", after, before, 100. * after / before, errorDb);
+
+  //Header in the layout of Training/create_header.py
+  const std::string modelName = NN<double>::GetModelName(options.model);
+  const std::string className = ClassName(modelName, "lr");
+  FILE* file = fopen(options.output.c_str(), "w");
+  if(!file)
+  {
+    error = "cannot open " + options.output;
+    return false;
+  }
+
+  WriteHeaderBegin<M>(file, "Low-rank", modelName, className, "LowRankLayers.h", "nncomp_compress", errorDb);
+  int k = 0;
+  ForEachLayer(*work, [&](auto& l) {
+    fprintf(file, "\tLowRank%sLayer<T, h, %s, %d, %d> l%d;\n", LayerTypeName(l), k == 0 ? "d" : "h", factors[k].rank, factors[k + 1].rank, k / 2);
+    k += 2;
+  });
+
+  fprintf(file, "\n\t%s() {\n", className.c_str());
+  k = 0;
+  ForEachLayer(*work, [&](auto& l) {
+    const int j = k / 2;
+    const Factor& fx = factors[k];
+    const Factor& fh = factors[k + 1];
+    PrintMatrix(file, j, "Ui", fx.IsDense() ? fx.W : MatrixXd(fx.U.leftCols(fx.rank)));
+    if(!fx.IsDense()) PrintMatrix(file, j, "Vi", fx.V.topRows(fx.rank));
+    PrintMatrix(file, j, "Uh", fh.IsDense() ? fh.W : MatrixXd(fh.U.leftCols(fh.rank)));
+    if(!fh.IsDense()) PrintMatrix(file, j, "Vh", fh.V.topRows(fh.rank));
+    fprintf(file, "\n");
+    for(const Bias& b : biases[j]) PrintMatrix(file, j, b.name, b.b.transpose());
+    fprintf(file, "\n");
+    WriteLayerState<M>(file, j, l);
+    k += 2;
+  });
+  WriteHeaderEnd(file, model);
+
+  if(fclose(file) != 0)
+  {
+    error = "failed writing " + options.output;
+    return false;
+  }
+  printf("wrote %s (%s)\n", options.output.c_str(), className.c_str());
+  return true;
+}
+
+int main(int argc, char* argv[])
+{
+  CompressOptions options;
+
+  //Parse arguments
+  for(int i = 1; i < argc; i++)
+  {
+    const std::string arg = argv[i];
+    const bool hasValue = i + 1 < argc;
+    if((arg == "-e" || arg == "--error") && hasValue) options.targetDb = std::strtod(argv[++i], nullptr);
+    else if((arg == "-s" || arg == "--seconds") && hasValue) options.seconds = std::strtod(argv[++i], nullptr);
+    else if((arg == "-i" || arg == "--ingain") && hasValue) options.inGain = std::pow(10., std::strtod(argv[++i], nullptr) / 20.);
+    else if((arg == "-o" || arg == "--out") && hasValue) options.output = argv[++i];
+    else if(arg == "-l" || arg == "--list")
+    {
+      for(int m = 0; m < NN<double>::kNumModels; m++) printf("%s\n", NN<double>::GetModelName(m));
+      return 0;
+    }
+    else if(arg == "-h" || arg == "--help")
+    {
+      PrintUsage();
+      return 0;
+    }
+    else if(options.model < 0)
+    {
+      options.model = NN<double>::FindModel(arg.c_str());
+      if(options.model < 0)
+      {
+        fprintf(stderr, "error: unknown model %s, use --list\n", arg.c_str());
+        return 1;
+      }
+    }
+    else options.input = arg;
+  }
+
+  if(options.model < 0 || options.input.empty())
+  {
+    PrintUsage();
+    return 1;
+  }
+  if(options.output.empty()) options.output = std::string(NN<double>::GetModelName(options.model)) + "-lr.h";
+
+  std::string error;
+  std::vector<double> x;
+  if(!ReadTestAudio(options.input, options.seconds, options.inGain, x, error))
+  {
+    fprintf(stderr, "error: %s\n", error.c_str());
+    return 1;
+  }
+
+  auto nn = std::make_unique<NN<double>>();
+  bool ok = false;
+  nn->WithModel(options.model, [&](auto& m) { ok = Compress(m, x, options, error); });
+  if(!ok)
+  {
+    fprintf(stderr, "error: %s\n", error.c_str());
+    return 1;
+  }
+  return 0;
+}
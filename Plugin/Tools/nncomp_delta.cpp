@@ -0,0 +1,161 @@
+/**
+ * Delta network report.
+ * Runs the NNComp models as delta networks (see DeltaNetwork.h) on a piece of audio at a range
+ * of thresholds and prints, for each, the output error against the double precision model,
+ * the fraction of weight columns applied and the speed against the float model.
+ *
+ * Usage: nncomp_delta [options] <file.wav> [model]...
+ */
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Denormals.h"
+#include "ModelTools.h"
+
+struct DeltaOptions
+{
+  std::vector<int> models;
+  std::vector<double> thresholds = {0.001, 0.003, 0.01, 0.03};
+  double seconds = 10.;
+  double inGain = 1.;
+  std::string input;
+};
+
+static void PrintUsage()
+{
+  printf("Usage: nncomp_delta [options] <file.wav> [model]...\n"
+         "  -s, --seconds <s>    Length of audio to measure on (default 10)\n"
+         "  -i, --ingain <dB>    Input gain (default 0)\n"
+         "  -t, --thresholds <t,...>  Thresholds to run (default 0.001,0.003,0.01,0.03)\n"
+         "  -l, --list           List models\n");
+}
+
+/**
+ * Run m over x in plugin sized blocks with f(m, x, y, nFrames), returning the seconds taken
+ */
+template<typename M, typename F>
+static double Time(M& m, const std::vector<float>& x, std::vector<float>& y, F&& f)
+{
+  constexpr int kBlock = 512;
+  ScopedDenormalGuard denormalGuard;
+  y.resize(x.size());
+  ResetState(m);
+  const auto start = std::chrono::steady_clock::now();
+  for(size_t s = 0; s < x.size(); s += kBlock)
+  {
+    f(m, x.data() + s, y.data() + s, static_cast<int>(std::min<size_t>(kBlock, x.size() - s)));
+  }
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+template<template<typename> class C>
+static void Report(const char* name, const std::vector<double>& x, const DeltaOptions& options)
+{
+  std::vector<double> ref;
+  auto reference = std::make_unique<C<double>>();
+  RunModel(*reference, x, ref);
+
+  auto model = std::make_unique<C<float>>();
+  const std::vector<float> xf(x.begin(), x.end());
+  std::vector<float> y;
+  const double tf = Time(*model, xf, y, [](auto& m, const float* in, float* out, int n) { ApplyModelWavefront(m, in, out, n); });
+  printf("%-10s %9s %7.1f %6s %6.2fx\n", name, "-", ErrorDb(std::vector<double>(y.begin(), y.end()), ref), "1.00", 1.);
+
+  auto delta = std::make_unique<DeltaNetwork<float>>();
+  delta->SetEnabled(true);
+  for(double threshold : options.thresholds)
+  {
+    delta->Set(static_cast<float>(threshold));
+    delta->ResetStats();
+    const double t = Time(*model, xf, y, [&](auto& m, const float* in, float* out, int n) { delta->Process(m, in, out, n); });
+    printf("%-10s %9g %7.1f %6.2f %6.2fx\n", name, threshold, ErrorDb(std::vector<double>(y.begin(), y.end()), ref),
+           delta->GetUpdateRatio(), tf / t);
+  }
+}
+
+/**
+ * Class template of a generated model, eg. Lstm_32_1 from Lstm_32_1<float>
+ */
+template<template<typename> class C>
+static void ReportModel(const C<float>&, const char* name, const std::vector<double>& x, const DeltaOptions& options)
+{
+  Report<C>(name, x, options);
+}
+
+int main(int argc, char* argv[])
+{
+  DeltaOptions options;
+
+  //Parse arguments
+  for(int i = 1; i < argc; i++)
+  {
+    const std::string arg = argv[i];
+    const bool hasValue = i + 1 < argc;
+    if((arg == "-s" || arg == "--seconds") && hasValue) options.seconds = std::strtod(argv[++i], nullptr);
+    else if((arg == "-i" || arg == "--ingain") && hasValue) options.inGain = std::pow(10., std::strtod(argv[++i], nullptr) / 20.);
+    else if((arg == "-t" || arg == "--thresholds") && hasValue)
+    {
+      const std::string list = argv[++i];
+      options.thresholds.clear();
+      for(size_t begin = 0; begin < list.size();)
+      {
+        const size_t end = std::min(list.find(',', begin), list.size());
+        options.thresholds.push_back(std::strtod(list.substr(begin, end - begin).c_str(), nullptr));
+        begin = end + 1;
+      }
+    }
+    else if(arg == "-l" || arg == "--list")
+    {
+      for(int m = 0; m < NN<float>::kNumModels; m++) printf("%s\n", NN<float>::GetModelName(m));
+      return 0;
+    }
+    else if(arg == "-h" || arg == "--help")
+    {
+      PrintUsage();
+      return 0;
+    }
+    else if(options.input.empty()) options.input = arg;
+    else
+    {
+      const int model = NN<float>::FindModel(arg.c_str());
+      if(model < 0)
+      {
+        fprintf(stderr, "error: unknown model %s, use --list\n", arg.c_str());
+        return 1;
+      }
+      options.models.push_back(model);
+    }
+  }
+
+  if(options.input.empty())
+  {
+    PrintUsage();
+    return 1;
+  }
+  if(options.models.empty())
+  {
+    for(int m = 0; m < NN<float>::kNumModels; m++) options.models.push_back(m);
+  }
+
+  std::string error;
+  std::vector<double> x;
+  if(!ReadTestAudio(options.input, options.seconds, options.inGain, x, error))
+  {
+    fprintf(stderr, "error: %s\n", error.c_str());
+    return 1;
+  }
+
+  //Errors in dB against the double model, speed against the float model, the first row of
+  //every model is the float model itself
+  printf("%-10s %9s %7s %6s %7s\n", "model", "threshold", "error", "cols", "speed");
+  auto nn = std::make_unique<NN<float>>();
+  for(int m : options.models)
+  {
+    nn->WithModel(m, [&](auto& model) { ReportModel(model, NN<float>::GetModelName(m), x, options); });
+  }
+  return 0;
+}
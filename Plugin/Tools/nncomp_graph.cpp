@@ -0,0 +1,230 @@
+/**
+ * Inference graph report.
+ * Builds graphs (see GraphDesc.h and Graph.h) from the NNComp models, runs them on a piece of
+ * audio and prints the output error against the double precision compiled models and the
+ * speed against the float compiled models, with the plan of every graph. Models joined with
+ * '+' run as parallel branches that are averaged, --dry adds the input as a residual path.
+ * Can also export the graphs as .nncg files and run .nncg files.
+ *
+ * Usage: nncomp_graph [options] <file.wav> [model[+model...] | file.nncg]...
+ */
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Denormals.h"
+#include "ModelTools.h"
+#include "Graph.h"
+
+struct GraphOptions
+{
+  std::vector<std::vector<int>> graphs; //models of each graph
+  std::vector<std::string> files;
+  double seconds = 10.;
+  double inGain = 1.;
+  double dry = 0.;
+  int blockSize = 512;
+  bool plan = false;
+  std::string input;
+  std::string exportDir;
+};
+
+static void PrintUsage()
+{
+  printf("Usage: nncomp_graph [options] <file.wav> [model[+model...] | file.nncg]...\n"
+         "  -s, --seconds <s>    Length of audio to measure on (default 10)\n"
+         "  -i, --ingain <dB>    Input gain (default 0)\n"
+         "  -d, --dry <dB>       Add the input to the output at this gain (default off)\n"
+         "  -b, --block <n>      Block size (default 512)\n"
+         "  -p, --plan           Print the plan of every graph\n"
+         "  -e, --export <dir>   Write the graphs as <dir>/<name>.nncg\n"
+         "  -l, --list           List models\n");
+}
+
+/**
+ * A model as a run-time model, with its double precision output and float run time
+ */
+struct Branch
+{
+  RuntimeModelDesc desc;
+  std::vector<double> ref;
+  double seconds = 0.;
+};
+
+template<template<typename> class C>
+static void Reference(const std::vector<double>& x, Branch& branch)
+{
+  auto reference = std::make_unique<C<double>>();
+  RunModel(*reference, x, branch.ref);
+
+  auto model = std::make_unique<C<float>>();
+  const std::vector<float> xf(x.begin(), x.end());
+  std::vector<float> y(x.size());
+  ResetState(*model);
+  const auto start = std::chrono::steady_clock::now();
+  ApplyModelWavefront(*model, xf.data(), y.data(), static_cast<int>(xf.size()));
+  branch.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  branch.desc = DescribeModel(*model);
+}
+
+/**
+ * Class template of a generated model, eg. Lstm_32_1 from Lstm_32_1<float>
+ */
+template<template<typename> class C>
+static void ReferenceModel(const C<float>&, const std::vector<double>& x, Branch& branch)
+{
+  Reference<C>(x, branch);
+}
+
+/**
+ * Run a graph and print its error against ref (none if null) and speed against tRef (none
+ * if 0). False if the graph is invalid.
+ */
+static bool Report(const std::string& name, const GraphDesc& desc, const std::vector<float>& x, const std::vector<double>* ref, double tRef, const GraphOptions& options)
+{
+  std::string error;
+  auto graph = std::make_unique<GraphModel>();
+  if(!graph->Init(desc, options.blockSize, error))
+  {
+    fprintf(stderr, "error: %s: %s\n", name.c_str(), error.c_str());
+    return false;
+  }
+  if(ref && !options.exportDir.empty() && !desc.Save(options.exportDir + "/" + name + ".nncg", error))
+  {
+    fprintf(stderr, "error: %s\n", error.c_str());
+    return false;
+  }
+
+  std::vector<float> y(x.size());
+  const auto start = std::chrono::steady_clock::now();
+  graph->ProcessBlock(x.data(), y.data(), static_cast<int>(x.size()));
+  const double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  printf("%-24s %6zu %6d %6d %8zu", name.c_str(), desc.nodes.size(), graph->GetNumSteps(), graph->GetNumBuffers(), graph->GetArenaSize());
+  if(ref) printf(" %8.1f", ErrorDb(std::vector<double>(y.begin(), y.end()), *ref));
+  else printf(" %8s", "-");
+  if(tRef > 0.) printf("   %6.2fx\n", tRef / t);
+  else printf("   %7s\n", "-");
+  if(options.plan) printf("%s\n", graph->DescribePlan().c_str());
+  return true;
+}
+
+int main(int argc, char* argv[])
+{
+  GraphOptions options;
+
+  //Parse arguments
+  for(int i = 1; i < argc; i++)
+  {
+    const std::string arg = argv[i];
+    const bool hasValue = i + 1 < argc;
+    if((arg == "-s" || arg == "--seconds") && hasValue) options.seconds = std::strtod(argv[++i], nullptr);
+    else if((arg == "-i" || arg == "--ingain") && hasValue) options.inGain = std::pow(10., std::strtod(argv[++i], nullptr) / 20.);
+    else if((arg == "-d" || arg == "--dry") && hasValue) options.dry = std::pow(10., std::strtod(argv[++i], nullptr) / 20.);
+    else if((arg == "-b" || arg == "--block") && hasValue) options.blockSize = std::max(1, std::atoi(argv[++i]));
+    else if((arg == "-e" || arg == "--export") && hasValue) options.exportDir = argv[++i];
+    else if(arg == "-p" || arg == "--plan") options.plan = true;
+    else if(arg == "-l" || arg == "--list")
+    {
+      for(int m = 0; m < NN<float>::kNumModels; m++) printf("%s\n", NN<float>::GetModelName(m));
+      return 0;
+    }
+    else if(arg == "-h" || arg == "--help")
+    {
+      PrintUsage();
+      return 0;
+    }
+    else if(options.input.empty()) options.input = arg;
+    else if(arg.size() > 5 && arg.compare(arg.size() - 5, 5, ".nncg") == 0) options.files.push_back(arg);
+    else
+    {
+      std::vector<int> models;
+      for(size_t begin = 0; begin <= arg.size();)
+      {
+        const size_t end = std::min(arg.find('+', begin), arg.size());
+        const std::string name = arg.substr(begin, end - begin);
+        const int model = NN<float>::FindModel(name.c_str());
+        if(model < 0)
+        {
+          fprintf(stderr, "error: unknown model %s, use --list\n", name.c_str());
+          return 1;
+        }
+        models.push_back(model);
+        begin = end + 1;
+      }
+      options.graphs.push_back(models);
+    }
+  }
+
+  if(options.input.empty())
+  {
+    PrintUsage();
+    return 1;
+  }
+  if(options.graphs.empty() && options.files.empty())
+  {
+    for(int m = 0; m < NN<float>::kNumModels; m++) options.graphs.push_back({m});
+  }
+
+  std::string error;
+  std::vector<double> x;
+  if(!ReadTestAudio(options.input, options.seconds, options.inGain, x, error))
+  {
+    fprintf(stderr, "error: %s\n", error.c_str());
+    return 1;
+  }
+  const std::vector<float> xf(x.begin(), x.end());
+
+  ScopedDenormalGuard denormalGuard;
+
+  //Errors in dB against the double models, speed against the float models run one after the
+  //other
+  printf("%-24s %6s %6s %6s %8s %8s   %7s\n", "graph", "nodes", "steps", "bufs", "floats", "error", "speed");
+  bool ok = true;
+  auto nn = std::make_unique<NN<float>>();
+  for(const std::vector<int>& models : options.graphs)
+  {
+    GraphDesc desc;
+    const int in = desc.AddInput();
+    std::vector<int> terms;
+    std::vector<double> ref(x.size(), 0.);
+    std::string name;
+    double tRef = 0.;
+    const double weight = 1. / models.size();
+    for(int m : models)
+    {
+      Branch branch;
+      nn->WithModel(m, [&](auto& model) { ReferenceModel(model, x, branch); });
+      const int y = AddModel(desc, in, branch.desc);
+      terms.push_back(models.size() > 1 ? desc.AddGain(y, static_cast<float>(weight)) : y);
+      for(size_t s = 0; s < x.size(); s++) ref[s] += weight * branch.ref[s];
+      tRef += branch.seconds;
+      name += (name.empty() ? "" : "+") + std::string(NN<float>::GetModelName(m));
+    }
+    if(options.dry > 0.)
+    {
+      terms.push_back(desc.AddGain(in, static_cast<float>(options.dry)));
+      for(size_t s = 0; s < x.size(); s++) ref[s] += options.dry * x[s];
+      name += "+dry";
+    }
+    desc.output = terms.size() > 1 ? desc.AddSum(terms) : terms[0];
+    ok = Report(name, desc, xf, &ref, tRef, options) && ok;
+  }
+
+  for(const std::string& file : options.files)
+  {
+    GraphDesc desc;
+    if(!desc.Load(file, error))
+    {
+      fprintf(stderr, "error: %s\n", error.c_str());
+      ok = false;
+      continue;
+    }
+    const size_t slash = file.find_last_of("/\\");
+    ok = Report(file.substr(slash == std::string::npos ? 0 : slash + 1), desc, xf, nullptr, 0., options) && ok;
+  }
+  return ok ? 0 : 1;
+}
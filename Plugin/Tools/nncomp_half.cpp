@@ -0,0 +1,145 @@
+/**
+ * Half precision weight report.
+ * Runs the NNComp models with their recurrent weights stored as fp16 and as bf16 (see
+ * HalfLayers.h) on a piece of audio and prints the output error of each against the double
+ * precision model, next to that of the float model, with the weight size and speed of each.
+ *
+ * Usage: nncomp_half [options] <file.wav> [model]...
+ */
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+#include "HalfLayers.h"
+#include "ModelTools.h"
+
+struct HalfOptions
+{
+  std::vector<int> models;
+  double seconds = 10.;
+  double inGain = 1.;
+  std::string input;
+};
+
+static void PrintUsage()
+{
+  printf("Usage: nncomp_half [options] <file.wav> [model]...\n"
+         "  -s, --seconds <s>    Length of audio to measure on (default 10)\n"
+         "  -i, --ingain <dB>    Input gain (default 0)\n"
+         "  -l, --list           List models\n");
+}
+
+/**
+ * Output error against the reference and seconds taken
+ */
+template<typename M>
+static double Measure(M& m, const std::vector<double>& x, const std::vector<double>& ref, double& seconds)
+{
+  std::vector<double> y;
+  const auto start = std::chrono::steady_clock::now();
+  RunModel(m, x, y);
+  seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  return ErrorDb(y, ref);
+}
+
+template<template<typename> class C>
+static void Report(const char* name, const std::vector<double>& x)
+{
+  std::vector<double> ref;
+  auto reference = std::make_unique<C<double>>();
+  RunModel(*reference, x, ref);
+
+  auto model = std::make_unique<C<float>>();
+  auto fp16 = std::make_unique<HalfModel<C<float>, HalfFormat::Fp16>>(*model);
+  auto bf16 = std::make_unique<HalfModel<C<float>, HalfFormat::Bf16>>(*model);
+
+  long bytes = 0;
+  ForEachLayer(*reference, [&](auto& l) {
+    std::vector<Bias> biases;
+    MatrixXd Wx, Wh;
+    GetStacked(l, Wx, Wh, biases);
+    bytes += static_cast<long>(Wx.size() + Wh.size()) * sizeof(float);
+  });
+  long halfBytes = 0;
+  ForEachLayer(*fp16, [&](auto& l) { halfBytes += static_cast<long>(sizeof(l.Wi.data) + sizeof(l.Wh.data)); });
+
+  double tf, t16, tb16;
+  const double ef = Measure(*model, x, ref, tf);
+  const double e16 = Measure(*fp16, x, ref, t16);
+  const double eb16 = Measure(*bf16, x, ref, tb16);
+  printf("%-10s %7ld %7ld   %7.1f %7.1f %7.1f   %5.2fx %5.2fx\n", name, bytes, halfBytes, ef, e16, eb16, tf / t16, tf / tb16);
+}
+
+/**
+ * Class template of a generated model, eg. Lstm_32_1 from Lstm_32_1<float>
+ */
+template<template<typename> class C>
+static void ReportModel(const C<float>&, const char* name, const std::vector<double>& x)
+{
+  Report<C>(name, x);
+}
+
+int main(int argc, char* argv[])
+{
+  HalfOptions options;
+
+  //Parse arguments
+  for(int i = 1; i < argc; i++)
+  {
+    const std::string arg = argv[i];
+    const bool hasValue = i + 1 < argc;
+    if((arg == "-s" || arg == "--seconds") && hasValue) options.seconds = std::strtod(argv[++i], nullptr);
+    else if((arg == "-i" || arg == "--ingain") && hasValue) options.inGain = std::pow(10., std::strtod(argv[++i], nullptr) / 20.);
+    else if(arg == "-l" || arg == "--list")
+    {
+      for(int m = 0; m < NN<float>::kNumModels; m++) printf("%s\n", NN<float>::GetModelName(m));
+      return 0;
+    }
+    else if(arg == "-h" || arg == "--help")
+    {
+      PrintUsage();
+      return 0;
+    }
+    else if(options.input.empty()) options.input = arg;
+    else
+    {
+      const int model = NN<float>::FindModel(arg.c_str());
+      if(model < 0)
+      {
+        fprintf(stderr, "error: unknown model %s, use --list\n", arg.c_str());
+        return 1;
+      }
+      options.models.push_back(model);
+    }
+  }
+
+  if(options.input.empty())
+  {
+    PrintUsage();
+    return 1;
+  }
+  if(options.models.empty())
+  {
+    for(int m = 0; m < NN<float>::kNumModels; m++) options.models.push_back(m);
+  }
+
+  std::string error;
+  std::vector<double> x;
+  if(!ReadTestAudio(options.input, options.seconds, options.inGain, x, error))
+  {
+    fprintf(stderr, "error: %s\n", error.c_str());
+    return 1;
+  }
+
+  //Errors in dB against the double model, speed against the float model
+  printf("%-10s %7s %7s   %7s %7s %7s   %6s %6s\n", "model", "bytes", "half", "float", "fp16", "bf16", "fp16", "bf16");
+  auto nn = std::make_unique<NN<float>>();
+  for(int m : options.models)
+  {
+    nn->WithModel(m, [&](auto& model) { ReportModel(model, NN<float>::GetModelName(m), x); });
+  }
+  return 0;
+}
@@ -0,0 +1,196 @@
+/**
+ * Run-time model report.
+ * Runs the NNComp models as run-time models (see RuntimeModel.h), interpreted and as generated
+ * code, on a piece of audio and prints the output error of each against the double precision
+ * compiled model, with their speed against the float compiled model. Can also export the
+ * models as .nncm files and run .nncm files, compared against the interpreter.
+ *
+ * Usage: nncomp_jit [options] <file.wav> [model | file.nncm]...
+ */
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Denormals.h"
+#include "ModelTools.h"
+#include "RuntimeModel.h"
+
+struct JitOptions
+{
+  std::vector<int> models;
+  std::vector<std::string> files;
+  double seconds = 10.;
+  double inGain = 1.;
+  std::string input;
+  std::string exportDir;
+};
+
+static void PrintUsage()
+{
+  printf("Usage: nncomp_jit [options] <file.wav> [model | file.nncm]...\n"
+         "  -s, --seconds <s>    Length of audio to measure on (default 10)\n"
+         "  -i, --ingain <dB>    Input gain (default 0)\n"
+         "  -e, --export <dir>   Write the models as <dir>/<model>.nncm\n"
+         "  -l, --list           List models\n");
+}
+
+/**
+ * Output of a run-time model from its initial state and seconds taken
+ */
+static std::vector<double> Run(RuntimeModel& m, const std::vector<float>& x, double& seconds)
+{
+  std::vector<float> y(x.size());
+  m.Reset();
+  const auto start = std::chrono::steady_clock::now();
+  m.ProcessBlock(x.data(), y.data(), static_cast<int>(x.size()));
+  seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  return std::vector<double>(y.begin(), y.end());
+}
+
+/**
+ * Interpreted and generated runs of desc, errors against ref. False if the model is invalid.
+ */
+static bool Compare(const char* name, const RuntimeModelDesc& desc, const std::vector<float>& x, const std::vector<double>* ref, double tRef)
+{
+  std::string error;
+  RuntimeModel interpreted, jit;
+  if(!interpreted.Init(desc, false, error) || !jit.Init(desc, true, error))
+  {
+    fprintf(stderr, "error: %s: %s\n", name, error.c_str());
+    return false;
+  }
+
+  double ti, tj;
+  const std::vector<double> yi = Run(interpreted, x, ti);
+  const std::vector<double> yj = Run(jit, x, tj);
+  char interpretedError[16] = "ref";
+  if(ref) snprintf(interpretedError, sizeof(interpretedError), "%.1f", ErrorDb(yi, *ref));
+  if(!ref) ref = &yi;
+  if(tRef <= 0.) tRef = ti;
+  printf("%-14s %8s %8.1f   %6.2fx %6.2fx   %7zu\n", name, interpretedError, jit.IsJit() ? ErrorDb(yj, *ref) : NAN, tRef / ti, jit.IsJit() ? tRef / tj : NAN, jit.GetJitBytes());
+  return true;
+}
+
+template<template<typename> class C>
+static bool Report(const char* name, const std::vector<double>& x, const std::string& exportDir)
+{
+  std::vector<double> ref;
+  auto reference = std::make_unique<C<double>>();
+  RunModel(*reference, x, ref);
+
+  //Compiled float model for speed
+  auto model = std::make_unique<C<float>>();
+  const std::vector<float> xf(x.begin(), x.end());
+  std::vector<float> y(x.size());
+  ResetState(*model);
+  const auto start = std::chrono::steady_clock::now();
+  ApplyModelWavefront(*model, xf.data(), y.data(), static_cast<int>(xf.size()));
+  const double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  const RuntimeModelDesc desc = DescribeModel(*model);
+  if(!exportDir.empty())
+  {
+    std::string error;
+    if(!desc.Save(exportDir + "/" + name + ".nncm", error))
+    {
+      fprintf(stderr, "error: %s\n", error.c_str());
+      return false;
+    }
+  }
+  return Compare(name, desc, xf, &ref, t);
+}
+
+/**
+ * Class template of a generated model, eg. Lstm_32_1 from Lstm_32_1<float>
+ */
+template<template<typename> class C>
+static bool ReportModel(const C<float>&, const char* name, const std::vector<double>& x, const std::string& exportDir)
+{
+  return Report<C>(name, x, exportDir);
+}
+
+int main(int argc, char* argv[])
+{
+  JitOptions options;
+
+  //Parse arguments
+  for(int i = 1; i < argc; i++)
+  {
+    const std::string arg = argv[i];
+    const bool hasValue = i + 1 < argc;
+    if((arg == "-s" || arg == "--seconds") && hasValue) options.seconds = std::strtod(argv[++i], nullptr);
+    else if((arg == "-i" || arg == "--ingain") && hasValue) options.inGain = std::pow(10., std::strtod(argv[++i], nullptr) / 20.);
+    else if((arg == "-e" || arg == "--export") && hasValue) options.exportDir = argv[++i];
+    else if(arg == "-l" || arg == "--list")
+    {
+      for(int m = 0; m < NN<float>::kNumModels; m++) printf("%s\n", NN<float>::GetModelName(m));
+      return 0;
+    }
+    else if(arg == "-h" || arg == "--help")
+    {
+      PrintUsage();
+      return 0;
+    }
+    else if(options.input.empty()) options.input = arg;
+    else if(arg.size() > 5 && arg.compare(arg.size() - 5, 5, ".nncm") == 0) options.files.push_back(arg);
+    else
+    {
+      const int model = NN<float>::FindModel(arg.c_str());
+      if(model < 0)
+      {
+        fprintf(stderr, "error: unknown model %s, use --list\n", arg.c_str());
+        return 1;
+      }
+      options.models.push_back(model);
+    }
+  }
+
+  if(options.input.empty())
+  {
+    PrintUsage();
+    return 1;
+  }
+  if(options.models.empty() && options.files.empty())
+  {
+    for(int m = 0; m < NN<float>::kNumModels; m++) options.models.push_back(m);
+  }
+
+  std::string error;
+  std::vector<double> x;
+  if(!ReadTestAudio(options.input, options.seconds, options.inGain, x, error))
+  {
+    fprintf(stderr, "error: %s\n", error.c_str());
+    return 1;
+  }
+
+  ScopedDenormalGuard denormalGuard;
+  if(!JitModelKernel::IsSupported()) printf("code generation not supported on this build or CPU, interpreting\n");
+
+  //Errors in dB against the double model (the interpreter for .nncm files), speed against the
+  //float model (the interpreter)
+  printf("%-14s %8s %8s   %7s %7s   %7s\n", "model", "interp", "jit", "interp", "jit", "bytes");
+  bool ok = true;
+  auto nn = std::make_unique<NN<float>>();
+  for(int m : options.models)
+  {
+    nn->WithModel(m, [&](auto& model) { ok = ReportModel(model, NN<float>::GetModelName(m), x, options.exportDir) && ok; });
+  }
+
+  const std::vector<float> xf(x.begin(), x.end());
+  for(const std::string& file : options.files)
+  {
+    RuntimeModelDesc desc;
+    if(!desc.Load(file, error))
+    {
+      fprintf(stderr, "error: %s\n", error.c_str());
+      ok = false;
+      continue;
+    }
+    const size_t slash = file.find_last_of("/\\");
+    ok = Compare(file.substr(slash == std::string::npos ? 0 : slash + 1).c_str(), desc, xf, nullptr, 0.) && ok;
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,406 @@
+/**
+ * Offline model optimizer.
+ * Rewrites one of the NNComp models into an equivalent model built from the layers in
+ * StackedLayers.h and checks its output against the original on a piece of audio:
+ *  - the gate weights of every layer are stacked and the input and recurrent bias pairs folded
+ *  - hidden units that do not contribute are removed. A unit whose output stays constant on
+ *    the audio, or whose outgoing weights are zero, is replaced by its constant output folded
+ *    into the biases of the units it feeds
+ *  - layer widths stay multiples of the alignment, so the products keep whole SIMD packets
+ *
+ * Units are tried per layer in order of their largest possible effect on the layers they feed,
+ * range of the output times outgoing weight, and the largest count whose output error stays
+ * within the target is removed.
+ *
+ * Usage: nncomp_optimize [options] <model> <file.wav>
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <vector>
+#include "ModelTools.h"
+
+struct OptimizeOptions
+{
+  int model = -1;
+  double targetDb = -60.;
+  int alignment = 4;
+  double seconds = 10.;
+  double inGain = 1.;
+  std::string input;
+  std::string output;
+};
+
+/**
+ * One layer in stacked form with a variable width. bx holds the folded biases, bh the
+ * biases scaled by the gru reset gate (zero for lstm and rnn).
+ */
+struct OptLayer
+{
+  const char* type = "";
+  int gates = 1;
+  MatrixXd Wx;
+  MatrixXd Wh;
+  VectorXd bx;
+  VectorXd bh;
+  VectorXd ht;
+  VectorXd ct;
+  VectorXd lo; //Range of ht on the audio
+  VectorXd hi;
+
+  int Width() const { return static_cast<int>(Wh.cols()); }
+  bool IsLstm() const { return gates == 4; }
+  bool IsGru() const { return gates == 3; }
+
+  void Reset()
+  {
+    ht.setZero(Width());
+    ct.setZero(Width());
+  }
+
+  void Step(const VectorXd& x)
+  {
+    const int h = Width();
+    VectorXd gi = Wx * x + bx;
+    const VectorXd gh = Wh * ht + bh;
+    auto sigmoid = [](const VectorXd& v) { return VectorXd((1. + (-v).array().exp()).inverse()); };
+    if(IsLstm())
+    {
+      gi += gh;
+      ct = sigmoid(gi.segment(h, h)).cwiseProduct(ct) + sigmoid(gi.segment(0, h)).cwiseProduct(gi.segment(2 * h, h).array().tanh().matrix());
+      ht = sigmoid(gi.segment(3 * h, h)).cwiseProduct(ct.array().tanh().matrix());
+    }
+    else if(IsGru())
+    {
+      const VectorXd r = sigmoid(gi.segment(0, h) + gh.segment(0, h));
+      const VectorXd z = sigmoid(gi.segment(h, h) + gh.segment(h, h));
+      const VectorXd n = (gi.segment(2 * h, h) + r.cwiseProduct(gh.segment(2 * h, h))).array().tanh().matrix();
+      ht = (VectorXd::Ones(h) - z).cwiseProduct(n) + z.cwiseProduct(ht);
+    }
+    else
+    {
+      ht = (gi + gh).array().tanh().matrix();
+    }
+  }
+
+  /**
+   * Keep the units in keep, in order
+   */
+  void KeepUnits(const std::vector<int>& keep)
+  {
+    std::vector<int> rows;
+    for(int g = 0; g < gates; g++)
+    {
+      for(int k : keep) rows.push_back(g * Width() + k);
+    }
+    Wx = MatrixXd(Wx(rows, Eigen::placeholders::all));
+    Wh = MatrixXd(Wh(rows, keep));
+    bx = VectorXd(bx(rows));
+    bh = VectorXd(bh(rows));
+    Reset();
+  }
+};
+
+struct OptModel
+{
+  std::vector<OptLayer> layers;
+  VectorXd A;
+  double b = 0.;
+
+  /**
+   * Run over x from the initial state, recording the range of every unit if record is set
+   */
+  void Run(const std::vector<double>& x, std::vector<double>& y, bool record = false)
+  {
+    for(OptLayer& l : layers)
+    {
+      l.Reset();
+      l.lo.setConstant(l.Width(), HUGE_VAL);
+      l.hi.setConstant(l.Width(), -HUGE_VAL);
+    }
+    y.resize(x.size());
+    VectorXd in(1);
+    for(size_t s = 0; s < x.size(); s++)
+    {
+      in(0) = x[s];
+      const VectorXd* v = &in;
+      for(OptLayer& l : layers)
+      {
+        l.Step(*v);
+        if(record)
+        {
+          l.lo = l.lo.cwiseMin(l.ht);
+          l.hi = l.hi.cwiseMax(l.ht);
+        }
+        v = &l.ht;
+      }
+      y[s] = std::tanh(A.dot(*v) + b);
+    }
+  }
+
+  /**
+   * Replace unit k of layer j by the constant c and remove it
+   */
+  void RemoveUnit(int j, int k, double c)
+  {
+    OptLayer& l = layers[j];
+    l.bh += l.Wh.col(k) * c;
+    if(j + 1 < static_cast<int>(layers.size())) layers[j + 1].bx += layers[j + 1].Wx.col(k) * c;
+    else b += A(k) * c;
+
+    std::vector<int> keep;
+    for(int u = 0; u < l.Width(); u++)
+    {
+      if(u != k) keep.push_back(u);
+    }
+    l.KeepUnits(keep);
+    if(j + 1 < static_cast<int>(layers.size())) layers[j + 1].Wx = MatrixXd(layers[j + 1].Wx(Eigen::placeholders::all, keep));
+    else A = VectorXd(A(keep));
+  }
+
+  /**
+   * Largest weight from unit k of layer j to the units it feeds
+   */
+  double Outgoing(int j, int k) const
+  {
+    const double recurrent = layers[j].Wh.col(k).cwiseAbs().maxCoeff();
+    if(j + 1 < static_cast<int>(layers.size())) return std::max(recurrent, layers[j + 1].Wx.col(k).cwiseAbs().maxCoeff());
+    return std::max(recurrent, std::abs(A(k)));
+  }
+
+  long Multiplies() const
+  {
+    long n = A.size();
+    for(const OptLayer& l : layers) n += l.Wx.size() + l.Wh.size();
+    return n;
+  }
+
+  /**
+   * Bias adds per sample once folded: one per gate row, plus the gru new gate recurrent bias
+   */
+  long BiasAdds() const
+  {
+    long n = 1;
+    for(const OptLayer& l : layers) n += (l.gates + (l.IsGru() ? 1 : 0)) * l.Width();
+    return n;
+  }
+};
+
+template<typename L>
+static OptLayer MakeLayer(const L& l)
+{
+  OptLayer o;
+  std::vector<Bias> biases;
+  GetStacked(l, o.Wx, o.Wh, biases);
+  o.type = LayerTypeName(l);
+  o.gates = static_cast<int>(o.Wx.rows() / o.Wh.cols());
+  o.bx = biases[0].b;
+  o.bh = biases.size() > 1 ? biases[1].b : VectorXd::Zero(o.bx.size());
+  o.Reset();
+  return o;
+}
+
+static void PrintUsage()
+{
+  printf("Usage: nncomp_optimize [options] <model> <file.wav>\n"
+         "  -e, --error <dB>     Output error target relative to the output level (default -60)\n"
+         "  -a, --align <n>      Keep layer widths a multiple of n (default 4)\n"
+         "  -s, --seconds <s>    Length of audio to measure on (default 10)\n"
+         "  -i, --ingain <dB>    Input gain (default 0)\n"
+         "  -o, --out <file.h>   Output header (default ./<model>-opt.h)\n"
+         "  -l, --list           List models\n");
+}
+
+static void WriteLayer(FILE* file, int j, const OptLayer& l)
+{
+  const int h = l.Width();
+  PrintMatrix(file, j, "Wi", l.Wx);
+  PrintMatrix(file, j, "Wh", l.Wh);
+  if(l.IsGru())
+  {
+    PrintMatrix(file, j, "b", (l.bx.head(2 * h) + l.bh.head(2 * h)).transpose());
+    PrintMatrix(file, j, "bin", l.bx.tail(h).transpose());
+    PrintMatrix(file, j, "bhn", l.bh.tail(h).transpose());
+  }
+  else
+  {
+    PrintMatrix(file, j, "b", (l.bx + l.bh).transpose());
+  }
+  fprintf(file, "\n");
+  WriteLayerState(file, j, h, l.IsLstm());
+}
+
+template<typename M>
+static bool Optimize(const M& model, const std::vector<double>& x, const OptimizeOptions& options, std::string& error)
+{
+  std::vector<double> ref, y;
+  auto work = std::make_unique<M>(model);
+  RunModel(*work, x, ref);
+
+  OptModel opt;
+  ForEachLayer(*work, [&](auto& l) { opt.layers.push_back(MakeLayer(l)); });
+  opt.A = model.f.A.col(0).template cast<double>();
+  opt.b = double(model.f.b(0));
+  const long multipliesBefore = opt.Multiplies();
+  const long biasAddsBefore = [&] {
+    long n = 1;
+    for(const OptLayer& l : opt.layers) n += 2 * l.gates * l.Width();
+    return n;
+  }();
+
+  opt.Run(x, y);
+  printf("stacked and folded, output error %.1f dB\n", ErrorDb(y, ref));
+
+  //Remove units layer by layer, the error of every count is measured with the earlier layers already reduced
+  std::vector<int> removed(opt.layers.size(), 0);
+  for(int j = 0; j < static_cast<int>(opt.layers.size()); j++)
+  {
+    opt.Run(x, y, true);
+    const OptLayer& l = opt.layers[j];
+    const int h = l.Width();
+    const int align = std::min(options.alignment, h);
+
+    std::vector<double> score(h), value(h);
+    for(int k = 0; k < h; k++)
+    {
+      score[k] = (l.hi(k) - l.lo(k)) * opt.Outgoing(j, k);
+      value[k] = 0.5 * (l.hi(k) + l.lo(k));
+    }
+    std::vector<int> order(h);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return score[a] < score[b]; });
+
+    auto removeFirst = [&](const OptModel& from, int n) {
+      OptModel m = from;
+      std::vector<int> units(order.begin(), order.begin() + n);
+      std::sort(units.rbegin(), units.rend()); //Highest index first, so the others keep theirs
+      for(int k : units) m.RemoveUnit(j, k, value[k]);
+      return m;
+    };
+
+    //Largest aligned count within the target, the error grows with the count
+    int lo = 0, hi = (h - 1) / align;
+    while(lo < hi)
+    {
+      const int mid = (lo + hi + 1) / 2;
+      OptModel m = removeFirst(opt, mid * align);
+      m.Run(x, y);
+      if(ErrorDb(y, ref) <= options.targetDb) lo = mid;
+      else hi = mid - 1;
+    }
+    removed[j] = lo * align;
+    opt = removeFirst(opt, removed[j]);
+  }
+
+  opt.Run(x, y);
+  const double errorDb = ErrorDb(y, ref);
+  for(size_t j = 0; j < opt.layers.size(); j++)
+  {
+    printf("l%zu %s %d -> %d units\n", j, opt.layers[j].type, opt.layers[j].Width() + removed[j], opt.layers[j].Width());
+  }
+  printf("%ld -> %ld multiplies, %ld -> %ld bias adds per sample, output error %.1f dB\n", multipliesBefore, opt.Multiplies(),
+         biasAddsBefore, opt.BiasAdds(), errorDb);
+  if(errorDb > options.targetDb)
+  {
+    error = "optimized model misses the error target";
+    return false;
+  }
+
+  //Header in the layout of Training/create_header.py
+  const std::string modelName = NN<double>::GetModelName(options.model);
+  const std::string className = ClassName(modelName, "opt");
+  FILE* file = fopen(options.output.c_str(), "w");
+  if(!file)
+  {
+    error = "cannot open " + options.output;
+    return false;
+  }
+
+  const int layers = static_cast<int>(opt.layers.size());
+  auto width = [&](int w) { return w == M::h ? std::string("h") : std::to_string(w); };
+  WriteHeaderBegin(file, "Optimized", modelName, className, "StackedLayers.h", "nncomp_optimize", errorDb, M::h, layers,
+                   opt.layers.back().Width());
+  for(int j = 0; j < layers; j++)
+  {
+    fprintf(file, "\tStacked%sLayer<T, %s, %s> l%d;\n", opt.layers[j].type, width(opt.layers[j].Width()).c_str(),
+            j == 0 ? "d" : width(opt.layers[j - 1].Width()).c_str(), j);
+  }
+
+  fprintf(file, "\n\t%s() {\n", className.c_str());
+  for(int j = 0; j < layers; j++) WriteLayer(file, j, opt.layers[j]);
+  WriteHeaderEnd(file, opt.A, opt.b, layers);
+
+  if(fclose(file) != 0)
+  {
+    error = "failed writing " + options.output;
+    return false;
+  }
+  printf("wrote %s (%s)\n", options.output.c_str(), className.c_str());
+  return true;
+}
+
+int main(int argc, char* argv[])
+{
+  OptimizeOptions options;
+
+  //Parse arguments
+  for(int i = 1; i < argc; i++)
+  {
+    const std::string arg = argv[i];
+    const bool hasValue = i + 1 < argc;
+    if((arg == "-e" || arg == "--error") && hasValue) options.targetDb = std::strtod(argv[++i], nullptr);
+    else if((arg == "-a" || arg == "--align") && hasValue) options.alignment = std::max(1, std::atoi(argv[++i]));
+    else if((arg == "-s" || arg == "--seconds") && hasValue) options.seconds = std::strtod(argv[++i], nullptr);
+    else if((arg == "-i" || arg == "--ingain") && hasValue) options.inGain = std::pow(10., std::strtod(argv[++i], nullptr) / 20.);
+    else if((arg == "-o" || arg == "--out") && hasValue) options.output = argv[++i];
+    else if(arg == "-l" || arg == "--list")
+    {
+      for(int m = 0; m < NN<double>::kNumModels; m++) printf("%s\n", NN<double>::GetModelName(m));
+      return 0;
+    }
+    else if(arg == "-h" || arg == "--help")
+    {
+      PrintUsage();
+      return 0;
+    }
+    else if(options.model < 0)
+    {
+      options.model = NN<double>::FindModel(arg.c_str());
+      if(options.model < 0)
+      {
+        fprintf(stderr, "error: unknown model %s, use --list\n", arg.c_str());
+        return 1;
+      }
+    }
+    else options.input = arg;
+  }
+
+  if(options.model < 0 || options.input.empty())
+  {
+    PrintUsage();
+    return 1;
+  }
+  if(options.output.empty()) options.output = std::string(NN<double>::GetModelName(options.model)) + "-opt.h";
+
+  std::string error;
+  std::vector<double> x;
+  if(!ReadTestAudio(options.input, options.seconds, options.inGain, x, error))
+  {
+    fprintf(stderr, "error: %s\n", error.c_str());
+    return 1;
+  }
+
+  auto nn = std::make_unique<NN<double>>();
+  bool ok = false;
+  nn->WithModel(options.model, [&](auto& m) { ok = Optimize(m, x, options, error); });
+  if(!ok)
+  {
+    fprintf(stderr, "error: %s\n", error.c_str());
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,283 @@
+/**
+ * Block magnitude pruning.
+ * Zeroes the weakest blocks of the stacked input and recurrent weights of one of the NNComp
+ * models, reports the output error on a piece of audio and writes a header with the pruned
+ * model class, built from the layers in SparseLayers.h. Blocks follow the layout of
+ * BlockSparseMatrix, so every pruned block is skipped at run time.
+ *
+ * The same fraction of blocks, those with the smallest Frobenius norm, is pruned in every
+ * matrix. The fraction is given, or found by bisection as the largest one whose output error
+ * stays within the target. A given fraction is held to the target only if one was given, but
+ * never writes a model whose error is above 0 dB, ie. louder than the signal.
+ *
+ * Usage: nncomp_prune [options] <model> <file.wav>
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+#include "ModelTools.h"
+#include "SparseLayers.h"
+
+struct PruneOptions
+{
+  int model = -1;
+  double targetDb = -40.;
+  bool targetSet = false; //--error given, a given --sparsity must meet it
+  double sparsity = -1.; //Fraction of blocks to prune, < 0 to search
+  double seconds = 10.;
+  double inGain = 1.;
+  std::string input;
+  std::string output;
+};
+
+/**
+ * One stacked weight matrix and its blocks, weakest first
+ */
+struct PrunedMatrix
+{
+  int layer = 0;
+  bool recurrent = false;
+  MatrixXd W;
+  MatrixXd pruned;
+  std::vector<std::pair<int, int>> blocks; //Top left corners
+
+  int BlockCols() const { return SparseBlockCols(static_cast<int>(W.cols())); }
+
+  auto Block(MatrixXd& m, const std::pair<int, int>& b) const
+  {
+    return m.block(b.first, b.second, std::min<int>(kSparseBlockRows, static_cast<int>(W.rows()) - b.first), BlockCols());
+  }
+
+  void Init()
+  {
+    for(int r = 0; r < W.rows(); r += kSparseBlockRows)
+    {
+      for(int c = 0; c < W.cols(); c += BlockCols()) blocks.push_back({r, c});
+    }
+    std::stable_sort(blocks.begin(), blocks.end(), [this](const auto& a, const auto& b) {
+      return Block(W, a).norm() < Block(W, b).norm();
+    });
+    pruned = W;
+  }
+
+  void Prune(double fraction)
+  {
+    pruned = W;
+    const size_t n = static_cast<size_t>(std::floor(fraction * blocks.size()));
+    for(size_t i = 0; i < n; i++) Block(pruned, blocks[i]).setZero();
+  }
+
+  int GetNumBlocks() const { return CountSparseBlocks(pruned); }
+  long Cost() const { return static_cast<long>(GetNumBlocks()) * kSparseBlockRows * BlockCols(); }
+};
+
+static void PrintUsage()
+{
+  printf("Usage: nncomp_prune [options] <model> <file.wav>\n"
+         "  -e, --error <dB>     Output error target relative to the output level (default -40, 0 with -p)\n"
+         "  -p, --sparsity <f>   Fraction of blocks to prune, 0-1 (default: largest within the error target)\n"
+         "  -s, --seconds <s>    Length of audio to measure on (default 10)\n"
+         "  -i, --ingain <dB>    Input gain (default 0)\n"
+         "  -o, --out <file.h>   Output header (default ./<model>-sp.h)\n"
+         "  -l, --list           List models\n");
+}
+
+template<typename M>
+static bool Prune(const M& model, const std::vector<double>& x, const PruneOptions& options, std::string& error)
+{
+  std::vector<double> ref, y;
+  auto work = std::make_unique<M>(model);
+  RunModel(*work, x, ref);
+
+  std::vector<PrunedMatrix> matrices;
+  std::vector<std::vector<Bias>> biases;
+  ForEachLayer(*work, [&](auto& l) {
+    PrunedMatrix mx, mh;
+    biases.emplace_back();
+    GetStacked(l, mx.W, mh.W, biases.back());
+    mx.layer = mh.layer = static_cast<int>(biases.size()) - 1;
+    mh.recurrent = true;
+    mx.Init();
+    mh.Init();
+    matrices.push_back(mx);
+    matrices.push_back(mh);
+  });
+
+  auto measure = [&](double fraction) {
+    *work = model;
+    int k = 0;
+    ForEachLayer(*work, [&](auto& l) {
+      matrices[k].Prune(fraction);
+      matrices[k + 1].Prune(fraction);
+      SetStacked(l, matrices[k].pruned, matrices[k + 1].pruned);
+      k += 2;
+    });
+    RunModel(*work, x, y);
+    return ErrorDb(y, ref);
+  };
+
+  double sparsity = std::clamp(options.sparsity, 0., 1.);
+  if(options.sparsity < 0.)
+  {
+    //Largest fraction within the target, to 1/256
+    double lo = 0., hi = 1.;
+    sparsity = 0.;
+    while(hi - lo > 1. / 256.)
+    {
+      const double mid = 0.5 * (lo + hi);
+      if(measure(mid) <= options.targetDb)
+      {
+        sparsity = mid;
+        lo = mid;
+      }
+      else hi = mid;
+    }
+  }
+  const double errorDb = measure(sparsity);
+
+  //Report
+  long before = 0, after = 0, blocks = 0, kept = 0;
+  for(const PrunedMatrix& m : matrices)
+  {
+    const double peak = m.W.cwiseAbs().maxCoeff();
+    const long small = static_cast<long>((m.W.array().abs() < 0.01 * peak).count());
+    before += m.W.size();
+    after += m.Cost();
+    blocks += static_cast<long>(m.blocks.size());
+    kept += m.GetNumBlocks();
+    printf("l%d %-9s %3dx%-3d  %3d of %3zu blocks  %5ld of %5ld multiplies  (%ld weights under 1%% of peak)\n", m.layer,
+           m.recurrent ? "recurrent" : "input", static_cast<int>(m.W.rows()), static_cast<int>(m.W.cols()), m.GetNumBlocks(),
+           m.blocks.size(), m.Cost(), static_cast<long>(m.W.size()), small);
+  }
+  printf("%ld of %ld blocks pruned, %ld of %ld multiplies per sample (%.0f%%), output error %.1f dB\n", blocks - kept, blocks,
+         after, before, 100. * after / before, errorDb);
+
+  const double limitDb = options.sparsity < 0. || options.targetSet ? options.targetDb : 0.;
+  if(kept == blocks)
+  {
+    error = "no block pruned within the error target (model unchanged), no header written";
+    return false;
+  }
+  if(errorDb > limitDb)
+  {
+    char message[128];
+    snprintf(message, sizeof(message), "output error %.1f dB is above %.1f dB, no header written", errorDb, limitDb);
+    error = message;
+    return false;
+  }
+
+  //Header in the layout of Training/create_header.py
+  const std::string modelName = NN<double>::GetModelName(options.model);
+  const std::string className = ClassName(modelName, "sp");
+  FILE* file = fopen(options.output.c_str(), "w");
+  if(!file)
+  {
+    error = "cannot open " + options.output;
+    return false;
+  }
+
+  WriteHeaderBegin<M>(file, "Pruned", modelName, className, "SparseLayers.h", "nncomp_prune", errorDb);
+  int k = 0;
+  ForEachLayer(*work, [&](auto& l) {
+    fprintf(file, "\tSparse%sLayer<T, h, %s, %d, %d> l%d;\n", LayerTypeName(l), k == 0 ? "d" : "h", matrices[k].GetNumBlocks(),
+            matrices[k + 1].GetNumBlocks(), k / 2);
+    k += 2;
+  });
+
+  fprintf(file, "\n\t%s() {\n", className.c_str());
+  k = 0;
+  ForEachLayer(*work, [&](auto& l) {
+    const int j = k / 2;
+    for(const PrunedMatrix* m : {&matrices[k], &matrices[k + 1]})
+    {
+      fprintf(file, "\t\tl%d.%s.Set((Eigen::Matrix<T, %d, %d>() << ", j, m->recurrent ? "Wh" : "Wi", static_cast<int>(m->W.rows()),
+              static_cast<int>(m->W.cols()));
+      PrintValues(file, m->pruned);
+      fprintf(file, ").finished());\n");
+    }
+    fprintf(file, "\n");
+    for(const Bias& b : biases[j]) PrintMatrix(file, j, b.name, b.b.transpose());
+    fprintf(file, "\n");
+    WriteLayerState<M>(file, j, l);
+    k += 2;
+  });
+  WriteHeaderEnd(file, model);
+
+  if(fclose(file) != 0)
+  {
+    error = "failed writing " + options.output;
+    return false;
+  }
+  printf("wrote %s (%s)\n", options.output.c_str(), className.c_str());
+  return true;
+}
+
+int main(int argc, char* argv[])
+{
+  PruneOptions options;
+
+  //Parse arguments
+  for(int i = 1; i < argc; i++)
+  {
+    const std::string arg = argv[i];
+    const bool hasValue = i + 1 < argc;
+    if((arg == "-e" || arg == "--error") && hasValue)
+    {
+      options.targetDb = std::strtod(argv[++i], nullptr);
+      options.targetSet = true;
+    }
+    else if((arg == "-p" || arg == "--sparsity") && hasValue) options.sparsity = std::strtod(argv[++i], nullptr);
+    else if((arg == "-s" || arg == "--seconds") && hasValue) options.seconds = std::strtod(argv[++i], nullptr);
+    else if((arg == "-i" || arg == "--ingain") && hasValue) options.inGain = std::pow(10., std::strtod(argv[++i], nullptr) / 20.);
+    else if((arg == "-o" || arg == "--out") && hasValue) options.output = argv[++i];
+    else if(arg == "-l" || arg == "--list")
+    {
+      for(int m = 0; m < NN<double>::kNumModels; m++) printf("%s\n", NN<double>::GetModelName(m));
+      return 0;
+    }
+    else if(arg == "-h" || arg == "--help")
+    {
+      PrintUsage();
+      return 0;
+    }
+    else if(options.model < 0)
+    {
+      options.model = NN<double>::FindModel(arg.c_str());
+      if(options.model < 0)
+      {
+        fprintf(stderr, "error: unknown model %s, use --list\n", arg.c_str());
+        return 1;
+      }
+    }
+    else options.input = arg;
+  }
+
+  if(options.model < 0 || options.input.empty())
+  {
+    PrintUsage();
+    return 1;
+  }
+  if(options.output.empty()) options.output = std::string(NN<double>::GetModelName(options.model)) + "-sp.h";
+
+  std::string error;
+  std::vector<double> x;
+  if(!ReadTestAudio(options.input, options.seconds, options.inGain, x, error))
+  {
+    fprintf(stderr, "error: %s\n", error.c_str());
+    return 1;
+  }
+
+  auto nn = std::make_unique<NN<double>>();
+  bool ok = false;
+  nn->WithModel(options.model, [&](auto& m) { ok = Prune(m, x, options, error); });
+  if(!ok)
+  {
+    fprintf(stderr, "error: %s\n", error.c_str());
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,469 @@
+/**
+ * Headless batch renderer.
+ * Streams WAV/RF64 files through one of the NNComp models with input and output gain, using
+ * the same NNProcessor as the plugin. Files at other rates than 48 kHz are resampled around
+ * the model and delay compensated. Files are processed concurrently on a work-stealing pool
+ * and the real-time factor is reported per file. Memory use does not depend on file length.
+ * With --pipeline every layer of a stacked model runs on its own thread (see Pipeline.h) over
+ * whole files. With --chunks whole files are split into chunks rendered in parallel after a
+ * warm-up (see ChunkRenderer.h), one file at a time. --verify checks both against a serial
+ * render: pipelined output must match apply_model, for chunks the error at the seams is reported.
+ *
+ * Usage: nncomp_render [options] <model> <file.wav|directory>...
+ */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "ChunkRenderer.h"
+#include "NNProcessor.h"
+#include "Pipeline.h"
+#include "Resampler.h"
+#include "WavFile.h"
+#include "WorkStealingPool.h"
+
+namespace fs = std::filesystem;
+
+struct RenderOptions
+{
+  int model = -1;
+  float inGain = 1.f;
+  float outGain = 1.f;
+  int nThreads = 0;
+  int blockSize = 4096;
+  float delta = -1.f; //Delta network threshold, < 0 for standard execution
+  bool pipeline = false;
+  bool verify = false; //Check --pipeline and --chunks against a serial render
+  double chunk = 0.;   //Chunk length in seconds, 0 for serial rendering
+  double warmup = 1.;  //Warm-up before every chunk in seconds
+  wav::Encoding encoding = wav::Encoding::Float32;
+  fs::path outDir = ".";
+};
+
+static std::mutex printMutex;
+
+/**
+ * One channel of a file, resampled to the 48 kHz of the models
+ */
+struct RenderChannel
+{
+  NNProcessor<float, 1> processor;
+  RateAdapter<float, 1> adapter {processor};
+};
+
+static void PrintUsage()
+{
+  printf("Usage: nncomp_render [options] <model> <file.wav|directory>...\n"
+         "  -i, --ingain <dB>    Input gain (default 0)\n"
+         "  -g, --outgain <dB>   Output gain (default 0)\n"
+         "  -o, --out <dir>      Output directory (default .)\n"
+         "  -f, --format <fmt>   Output format: f32, 24 or 16 (default f32)\n"
+         "  -j, --threads <n>    Worker threads (default all cores)\n"
+         "  -d, --delta <t>      Run as a delta network with threshold t, 0 is exact (default off)\n"
+         "  -p, --pipeline       Run every layer on its own thread over whole files\n"
+         "  -v, --verify         Check --pipeline and --chunks output against a serial render\n"
+         "  -c, --chunks <s>     Render whole files in parallel chunks of s seconds (default off)\n"
+         "  -w, --warmup <s>     Warm-up before every chunk (default 1)\n"
+         "  -l, --list           List models\n");
+}
+
+static float DBToAmp(float dB)
+{
+  return std::pow(10.f, dB / 20.f);
+}
+
+/**
+ * Stream one file through the model, block by block, with one processor per channel. False
+ * if the file could not be rendered.
+ */
+static bool RenderFile(const fs::path& inPath, const fs::path& outPath, const RenderOptions& options)
+{
+  const auto start = std::chrono::steady_clock::now();
+  std::string error;
+
+  WavReader reader;
+  WavWriter writer;
+  if(!reader.Open(inPath.string(), error) ||
+     !writer.Open(outPath.string(), reader.GetNumChannels(), reader.GetSampleRate(), options.encoding, error))
+  {
+    std::lock_guard<std::mutex> lock(printMutex);
+    fprintf(stderr, "error: %s\n", error.c_str());
+    return false;
+  }
+
+  const int nChans = reader.GetNumChannels();
+  std::vector<std::unique_ptr<RenderChannel>> channels;
+  std::vector<CustomAudioBuffer<float, 2>> buffers(nChans);
+  std::vector<float*> in(nChans), out(nChans), outOffset(nChans);
+  for(int c = 0; c < nChans; c++)
+  {
+    auto channel = std::make_unique<RenderChannel>();
+    channel->adapter.Prepare(reader.GetSampleRate(), options.blockSize);
+    channel->processor.SetModel(options.model);
+    channel->processor.SetInputGain(options.inGain);
+    channel->processor.SetOutputGain(options.outGain);
+    if(options.delta >= 0.f) channel->processor.SetDeltaNetwork(true, options.delta);
+    channels.push_back(std::move(channel));
+
+    buffers[c].SetFrameLength(options.blockSize);
+    in[c] = buffers[c].GetBuffer()[0];
+    out[c] = buffers[c].GetBuffer()[1];
+  }
+
+  //Drop the resampling delay at the start and flush it with silence at the end
+  long skip = channels.empty() ? 0 : channels[0]->adapter.GetLatency();
+  long flush = skip;
+  bool ok = true;
+  while(ok)
+  {
+    long n = reader.Read(in.data(), options.blockSize);
+    if(n <= 0)
+    {
+      n = std::min<long>(flush, options.blockSize);
+      flush -= n;
+      if(n <= 0) break;
+      for(int c = 0; c < nChans; c++) std::fill(in[c], in[c] + n, 0.f);
+    }
+
+    for(int c = 0; c < nChans; c++)
+    {
+      const float* x[1] = {in[c]};
+      float* y[1] = {out[c]};
+      channels[c]->adapter.Process(x, y, 1, static_cast<int>(n));
+    }
+
+    const long skipped = std::min(skip, n);
+    skip -= skipped;
+    for(int c = 0; c < nChans; c++) outOffset[c] = out[c] + skipped;
+    ok = writer.Write(outOffset.data(), n - skipped);
+  }
+  ok = writer.Close(error) && ok;
+
+  const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  const double duration = reader.GetSampleRate() > 0 ? double(reader.GetFrames()) / reader.GetSampleRate() : 0.;
+
+  std::lock_guard<std::mutex> lock(printMutex);
+  if(ok)
+  {
+    printf("%s -> %s  %.1fs audio in %.2fs (%.1fx realtime)", inPath.string().c_str(), outPath.string().c_str(),
+           duration, seconds, seconds > 0. ? duration / seconds : 0.);
+    if(options.delta >= 0.f && !channels.empty())
+    {
+      printf(", %.0f%% of weights applied", 100. * channels[0]->processor.GetDeltaUpdateRatio(0));
+    }
+    printf("\n");
+  }
+  else
+  {
+    fprintf(stderr, "error: failed writing %s\n", outPath.string().c_str());
+  }
+  return ok;
+}
+
+/**
+ * Render one file as a whole: every channel is read into memory, resampled to 48 kHz, run
+ * through the model in one call of render(m, x, y, nFrames) and written back at the file rate.
+ * render returns false, after printing why, if its output is wrong. False if the file could not
+ * be rendered.
+ */
+template<typename F>
+static bool RenderWholeFile(const fs::path& inPath, const fs::path& outPath, const RenderOptions& options, F&& render)
+{
+  const auto start = std::chrono::steady_clock::now();
+  std::string error;
+
+  WavReader reader;
+  WavWriter writer;
+  if(!reader.Open(inPath.string(), error) ||
+     !writer.Open(outPath.string(), reader.GetNumChannels(), reader.GetSampleRate(), options.encoding, error))
+  {
+    std::lock_guard<std::mutex> lock(printMutex);
+    fprintf(stderr, "error: %s\n", error.c_str());
+    return false;
+  }
+
+  const int nChans = reader.GetNumChannels();
+  const int rate = reader.GetSampleRate();
+  const long nFrames = static_cast<long>(reader.GetFrames());
+  std::vector<std::vector<float>> audio(nChans, std::vector<float>(nFrames, 0.f));
+  std::vector<float*> chans(nChans);
+  for(long t = 0; t < nFrames;)
+  {
+    for(int c = 0; c < nChans; c++) chans[c] = audio[c].data() + t;
+    const long n = reader.Read(chans.data(), std::min<long>(options.blockSize, nFrames - t));
+    if(n <= 0) break;
+    t += n;
+  }
+
+  //Same resampling as RateAdapter, the input padded with its delay and the delay dropped
+  const bool resample = rate != RateAdapter<float, 1>::kModelRate;
+  auto nn = std::make_unique<NN<float>>();
+  bool ok = true;
+  for(int c = 0; c < nChans && ok; c++)
+  {
+    Resampler<float> up, down;
+    up.Setup(rate, RateAdapter<float, 1>::kModelRate);
+    down.Setup(RateAdapter<float, 1>::kModelRate, rate);
+    const long latency = resample ? std::lround((up.GetDelay() + down.GetDelay()) * rate) : 0;
+
+    std::vector<float> x(nFrames + latency, 0.f);
+    std::transform(audio[c].begin(), audio[c].end(), x.begin(), [&](float v) { return v * options.inGain; });
+    if(resample)
+    {
+      std::vector<float> x48(up.GetMaxOutput(static_cast<int>(x.size())));
+      x48.resize(up.Process(x.data(), static_cast<int>(x.size()), x48.data()));
+      x.swap(x48);
+    }
+
+    std::vector<float> y(x.size());
+    nn->WithModel(options.model, [&](auto& m) {
+      ResetState(m);
+      ok = render(m, x.data(), y.data(), static_cast<long>(x.size()));
+    });
+
+    if(resample)
+    {
+      std::vector<float> y48(down.GetMaxOutput(static_cast<int>(y.size())));
+      y48.resize(down.Process(y.data(), static_cast<int>(y.size()), y48.data()));
+      y.assign(nFrames, 0.f);
+      if(static_cast<long>(y48.size()) > latency) std::copy(y48.begin() + latency, y48.begin() + std::min<long>(y48.size(), latency + nFrames), y.begin());
+    }
+    std::transform(y.begin(), y.begin() + nFrames, audio[c].begin(), [&](float v) { return v * options.outGain; });
+  }
+
+  for(long t = 0; t < nFrames && ok; t += options.blockSize)
+  {
+    for(int c = 0; c < nChans; c++) chans[c] = audio[c].data() + t;
+    ok = writer.Write(chans.data(), std::min<long>(options.blockSize, nFrames - t));
+  }
+  const bool written = writer.Close(error) && ok;
+
+  const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  const double duration = rate > 0 ? double(nFrames) / rate : 0.;
+
+  std::lock_guard<std::mutex> lock(printMutex);
+  if(written)
+  {
+    printf("%s -> %s  %.1fs audio in %.2fs (%.1fx realtime)\n", inPath.string().c_str(), outPath.string().c_str(),
+           duration, seconds, seconds > 0. ? duration / seconds : 0.);
+  }
+  else if(ok)
+  {
+    fprintf(stderr, "error: failed writing %s\n", outPath.string().c_str());
+  }
+  return written;
+}
+
+/**
+ * Run the layers of m on their own threads. With verify, then apply_model one sample at a time
+ * from the same state, and check both give the same output.
+ */
+template<typename M>
+static bool RenderPipelined(M& m, float* x, float* y, long nFrames, const fs::path& inPath, bool verify)
+{
+  auto initial = verify ? std::make_unique<M>(m) : nullptr;
+  auto start = std::chrono::steady_clock::now();
+  ApplyModelPipelined(m, x, y, nFrames);
+  const double tPipelined = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  if(!verify)
+  {
+    std::lock_guard<std::mutex> lock(printMutex);
+    printf("%s: %d layers pipelined in %.2fs\n", inPath.string().c_str(), M::layers, tPipelined);
+    return true;
+  }
+
+  std::vector<float> ref(nFrames);
+  start = std::chrono::steady_clock::now();
+  {
+    ScopedDenormalGuard denormalGuard;
+    for(long t = 0; t < nFrames; t++) initial->apply_model(x + t, ref.data() + t);
+  }
+  const double tSerial = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  long mismatch = 0;
+  double maxError = 0.;
+  for(long t = 0; t < nFrames; t++)
+  {
+    if(y[t] == ref[t]) continue;
+    mismatch++;
+    maxError = std::max(maxError, std::abs(static_cast<double>(y[t]) - ref[t]));
+  }
+
+  std::lock_guard<std::mutex> lock(printMutex);
+  if(mismatch)
+  {
+    fprintf(stderr, "error: %s: pipelined output differs from apply_model in %ld samples, by up to %g\n",
+            inPath.string().c_str(), mismatch, maxError);
+    return false;
+  }
+  printf("%s: %d layers pipelined in %.2fs, apply_model %.2fs, output identical\n", inPath.string().c_str(),
+         M::layers, tPipelined, tSerial);
+  return true;
+}
+
+/**
+ * Render m over x in parallel chunks. With verify, also serially to report the error at the seams.
+ */
+template<typename M>
+static bool RenderChunks(M& m, float* x, float* y, long nFrames, const fs::path& inPath, const RenderOptions& options)
+{
+  ChunkRenderSettings settings;
+  settings.chunkSize = std::max(1L, std::lround(options.chunk * RateAdapter<float, 1>::kModelRate));
+  settings.warmup = std::lround(options.warmup * RateAdapter<float, 1>::kModelRate);
+  settings.nThreads = options.nThreads;
+  if(!options.verify)
+  {
+    const int nChunks = RenderChunked(m, x, y, nFrames, settings);
+    std::lock_guard<std::mutex> lock(printMutex);
+    printf("%s: %d chunks\n", inPath.string().c_str(), nChunks);
+    return true;
+  }
+
+  const ChunkRenderReport report = CompareChunkedToSerial(m, x, y, nFrames, settings);
+
+  double seamError = 0.;
+  for(double e : report.seamError) seamError = std::max(seamError, e);
+  auto dB = [](double e) { return 20. * std::log10(e); }; //-inf when identical
+
+  std::lock_guard<std::mutex> lock(printMutex);
+  printf("%s: %d chunks, seam error against serial %.1f dB max, %.1f dB rms\n", inPath.string().c_str(),
+         report.nChunks, dB(seamError), dB(report.rmsError));
+  return true;
+}
+
+int main(int argc, char* argv[])
+{
+  RenderOptions options;
+  std::vector<fs::path> inputs;
+
+  //Parse arguments
+  for(int i = 1; i < argc; i++)
+  {
+    const std::string arg = argv[i];
+    const bool hasValue = i + 1 < argc;
+    if((arg == "-i" || arg == "--ingain") && hasValue) options.inGain = DBToAmp(std::strtof(argv[++i], nullptr));
+    else if((arg == "-g" || arg == "--outgain") && hasValue) options.outGain = DBToAmp(std::strtof(argv[++i], nullptr));
+    else if((arg == "-o" || arg == "--out") && hasValue) options.outDir = argv[++i];
+    else if((arg == "-j" || arg == "--threads") && hasValue) options.nThreads = std::atoi(argv[++i]);
+    else if((arg == "-d" || arg == "--delta") && hasValue) options.delta = std::strtof(argv[++i], nullptr);
+    else if(arg == "-p" || arg == "--pipeline") options.pipeline = true;
+    else if(arg == "-v" || arg == "--verify") options.verify = true;
+    else if((arg == "-c" || arg == "--chunks") && hasValue) options.chunk = std::strtod(argv[++i], nullptr);
+    else if((arg == "-w" || arg == "--warmup") && hasValue) options.warmup = std::max(0., std::strtod(argv[++i], nullptr));
+    else if((arg == "-f" || arg == "--format") && hasValue)
+    {
+      const std::string format = argv[++i];
+      if(format == "16") options.encoding = wav::Encoding::Pcm16;
+      else if(format == "24") options.encoding = wav::Encoding::Pcm24;
+      else if(format == "f32") options.encoding = wav::Encoding::Float32;
+      else
+      {
+        fprintf(stderr, "error: unknown format %s\n", format.c_str());
+        PrintUsage();
+        return 1;
+      }
+    }
+    else if(arg == "-l" || arg == "--list")
+    {
+      for(int m = 0; m < NN<float>::kNumModels; m++) printf("%s\n", NN<float>::GetModelName(m));
+      return 0;
+    }
+    else if(arg == "-h" || arg == "--help")
+    {
+      PrintUsage();
+      return 0;
+    }
+    else if(arg.size() > 1 && arg[0] == '-')
+    {
+      fprintf(stderr, "error: unknown option %s\n", arg.c_str());
+      PrintUsage();
+      return 1;
+    }
+    else if(options.model < 0)
+    {
+      options.model = NN<float>::FindModel(arg.c_str());
+      if(options.model < 0)
+      {
+        fprintf(stderr, "error: unknown model %s, use --list\n", arg.c_str());
+        return 1;
+      }
+    }
+    else inputs.push_back(arg);
+  }
+
+  if(options.model < 0 || inputs.empty())
+  {
+    PrintUsage();
+    return 1;
+  }
+  if((options.pipeline || options.chunk > 0.) && options.delta >= 0.f)
+  {
+    fprintf(stderr, "error: --pipeline and --chunks run the standard model, they cannot be combined with --delta\n");
+    return 1;
+  }
+  if(options.pipeline && options.chunk > 0.)
+  {
+    fprintf(stderr, "error: --pipeline and --chunks cannot be combined\n");
+    return 1;
+  }
+
+  //Expand directories
+  std::vector<fs::path> files;
+  for(const auto& path : inputs)
+  {
+    if(fs::is_directory(path))
+    {
+      for(const auto& entry : fs::directory_iterator(path))
+      {
+        if(entry.is_regular_file() && entry.path().extension() == ".wav") files.push_back(entry.path());
+      }
+    }
+    else files.push_back(path);
+  }
+
+  std::error_code ec;
+  fs::create_directories(options.outDir, ec);
+
+  const auto start = std::chrono::steady_clock::now();
+  std::atomic<int> nFailed {0};
+  {
+    WorkStealingPool pool(options.nThreads);
+    for(const auto& file : files)
+    {
+      const fs::path outPath = options.outDir / (file.stem().string() + "_" + NN<float>::GetModelName(options.model) + ".wav");
+      if(options.pipeline)
+      {
+        pool.Submit([file, outPath, &options, &nFailed]() {
+          nFailed += !RenderWholeFile(file, outPath, options, [&](auto& m, float* x, float* y, long nFrames) {
+            return RenderPipelined(m, x, y, nFrames, file, options.verify);
+          });
+        });
+      }
+      else if(options.chunk > 0.)
+      {
+        //The chunks of a file already use every thread, so files take turns
+        nFailed += !RenderWholeFile(file, outPath, options, [&](auto& m, float* x, float* y, long nFrames) {
+          return RenderChunks(m, x, y, nFrames, file, options);
+        });
+      }
+      else pool.Submit([file, outPath, &options, &nFailed]() { nFailed += !RenderFile(file, outPath, options); });
+    }
+    pool.Wait();
+  }
+  const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  printf("%zu files in %.2fs\n", files.size(), seconds);
+  if(nFailed > 0)
+  {
+    fprintf(stderr, "error: %d of %zu files failed\n", nFailed.load(), files.size());
+    return 1;
+  }
+  return 0;
+}
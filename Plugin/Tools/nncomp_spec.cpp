@@ -0,0 +1,151 @@
+/**
+ * Weight-specialized model report.
+ * Runs the weight-specialized models written by Training/specialized_header.py next to the
+ * Eigen models they were converted from on a piece of audio and prints the output error of
+ * both against the double precision Eigen model and the speed of the specialized model.
+ * The specialized headers are compiled in from the directory they were written to, which
+ * holds the spec_models.h listing them.
+ *
+ * Usage: nncomp_spec [options] <file.wav> [model]...
+ */
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Denormals.h"
+#include "ModelTools.h"
+#include "spec_models.h"
+
+struct SpecOptions
+{
+  std::vector<std::string> models;
+  double seconds = 10.;
+  double inGain = 1.;
+  int runs = 3;
+  std::string input;
+};
+
+static void PrintUsage()
+{
+  printf("Usage: nncomp_spec [options] <file.wav> [model]...\n"
+         "  -s, --seconds <s>    Length of audio to measure on (default 10)\n"
+         "  -i, --ingain <dB>    Input gain (default 0)\n"
+         "  -r, --runs <n>       Timed runs, the fastest is reported (default 3)\n"
+         "  -l, --list           List the specialized models compiled in\n");
+}
+
+/**
+ * Fastest of runs calls of f, in seconds
+ */
+template<typename F>
+static double Time(int runs, F&& f)
+{
+  double best = 1e30;
+  for(int r = 0; r < runs; r++)
+  {
+    const auto start = std::chrono::steady_clock::now();
+    f();
+    best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+  }
+  return best;
+}
+
+/**
+ * Report the specialized model S against the Eigen model E it was converted from
+ */
+template<template<typename> class E, template<typename> class S>
+static void Report(const char* name, const std::vector<double>& x, const SpecOptions& options)
+{
+  std::vector<double> ref;
+  auto reference = std::make_unique<E<double>>();
+  RunModel(*reference, x, ref);
+
+  const std::vector<float> xf(x.begin(), x.end());
+  std::vector<float> y(x.size());
+  const int n = static_cast<int>(x.size());
+  ScopedDenormalGuard denormalGuard;
+
+  auto model = std::make_unique<E<float>>();
+  const double te = Time(options.runs, [&] {
+    ResetState(*model);
+    ApplyModelWavefront(*model, xf.data(), y.data(), n);
+  });
+  const double ee = ErrorDb(std::vector<double>(y.begin(), y.end()), ref);
+
+  auto spec = std::make_unique<S<float>>();
+  const double ts = Time(options.runs, [&] {
+    spec->Reset();
+    spec->ProcessBlock(xf.data(), y.data(), n);
+  });
+  const double es = ErrorDb(std::vector<double>(y.begin(), y.end()), ref);
+
+  printf("%-10s %7.1f %7.1f   %6.2fx\n", name, ee, es, te / ts);
+}
+
+static bool Selected(const SpecOptions& options, const char* name)
+{
+  return options.models.empty() || std::find(options.models.begin(), options.models.end(), name) != options.models.end();
+}
+
+#define NNCOMP_SPEC_NAME(C, name) name,
+#define NNCOMP_SPEC_REPORT(C, name) if(Selected(options, name)) Report<C, C##_spec>(name, x, options);
+
+int main(int argc, char* argv[])
+{
+  SpecOptions options;
+  const std::vector<std::string> names = {NNCOMP_SPEC_MODELS(NNCOMP_SPEC_NAME)};
+
+  //Parse arguments
+  for(int i = 1; i < argc; i++)
+  {
+    const std::string arg = argv[i];
+    const bool hasValue = i + 1 < argc;
+    if((arg == "-s" || arg == "--seconds") && hasValue) options.seconds = std::strtod(argv[++i], nullptr);
+    else if((arg == "-i" || arg == "--ingain") && hasValue) options.inGain = std::pow(10., std::strtod(argv[++i], nullptr) / 20.);
+    else if((arg == "-r" || arg == "--runs") && hasValue) options.runs = std::max(1, std::atoi(argv[++i]));
+    else if(arg == "-l" || arg == "--list")
+    {
+      for(const std::string& name : names) printf("%s\n", name.c_str());
+      return 0;
+    }
+    else if(arg == "-h" || arg == "--help")
+    {
+      PrintUsage();
+      return 0;
+    }
+    else if(options.input.empty()) options.input = arg;
+    else
+    {
+      if(std::find(names.begin(), names.end(), arg) == names.end())
+      {
+        fprintf(stderr, "error: no specialized model %s, use --list\n", arg.c_str());
+        return 1;
+      }
+      options.models.push_back(arg);
+    }
+  }
+
+  if(options.input.empty())
+  {
+    PrintUsage();
+    return 1;
+  }
+
+  std::string error;
+  std::vector<double> x;
+  if(!ReadTestAudio(options.input, options.seconds, options.inGain, x, error))
+  {
+    fprintf(stderr, "error: %s\n", error.c_str());
+    return 1;
+  }
+
+  //Errors in dB against the double Eigen model, speed of the specialized model against the
+  //float Eigen model run as a wavefront
+  printf("%-10s %7s %7s   %7s\n", "model", "eigen", "spec", "speed");
+  NNCOMP_SPEC_MODELS(NNCOMP_SPEC_REPORT)
+  return 0;
+}
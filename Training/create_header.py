@@ -5,6 +5,7 @@ import os
 from datetime import datetime
 import argparse
 import sys
+from specialized_header import write_specialized
 
 
 def extract(tensor):
@@ -17,6 +18,7 @@ def extract(tensor):
 #Parse input arguments
 parser = argparse.ArgumentParser()
 parser.add_argument('Path', help="Path to model to convert to .h file", type=str)
+parser.add_argument('--backend', '-b', help="eigen: layers.h classes, specialized: code generated for the exact shape", choices=['eigen', 'specialized'], default='eigen')
 args = parser.parse_args()
 path = args.Path
 
@@ -48,6 +50,16 @@ else:
 in_size = 1
 print("Hidden size: {}, Num Layers: {}".format(hidden_size, num_layers))
 
+#Weight-specialized backend, see specialized_header.py
+if args.backend == 'specialized':
+    params = {}
+    for name, param in model.named_parameters():
+        key = name if name.startswith('linear') else name.split('.', 1)[1]
+        params[key] = param.detach().cpu().numpy().tolist()
+    write_path = 'headers/' + model_type + '-{}-{}-spec.h'.format(hidden_size, num_layers)
+    print("Class: ", write_specialized(write_path, model_type, hidden_size, num_layers, params, os.path.basename(path)))
+    sys.exit(0)
+
 #output file
 write_path = 'headers/' + model_type + '-{}-{}.h'.format(hidden_size, num_layers)
 
@@ -62,25 +74,18 @@ header = open(write_path, 'a')
 #Write header header (comments)
 header.write("/**\n * Autogenerated header file for {}-{}-{}\n * neural network model parameters.\n * \n * Created on: {}\n * Generated Using: https://github.com/michaelholmes4/NNComp \n*/\n\n".format(model_type, hidden_size, num_layers, datetime.now().strftime("%d/%m/%Y at: %H:%M")))
 
-#Start of file
-header.write("#pragma once\n#include \"layers.h\"\n\ntemplate<typename T>\nclass {}_{}_{}\n{{\npublic:\n".format(model_type.capitalize(), hidden_size, num_layers))
-
-#define constants
-header.write("\tconst static int h = {};\n".format(hidden_size))
-header.write("\tconst static int d = {};\n".format(in_size))
-header.write("\tconst static int layers = {};\n".format(num_layers))
-
-#define layers
-header.write("\n")
-header.write("\tFccLayer<T, h, d> f;\n")
-header.write("\t{}Layer<T, h, d> l0;\n".format(model_type.capitalize()))
-for i in range(1, num_layers):
-    header.write("\t{}Layer<T, h, h> l{};\n".format(model_type.capitalize(), i))
+#Start of file, the layers are composed by Model.h
+spec = "{}<{}>".format(model_type.capitalize(), hidden_size)
+header.write("#pragma once\n#include \"Model.h\"\n\ntemplate<typename T>\nclass {}_{}_{} : public Model<T, {}, Dense<1>>\n{{\npublic:\n".format(model_type.capitalize(), hidden_size, num_layers, ", ".join([spec] * num_layers)))
 
 
 #Initialise model parameters
 header.write("\n")
 header.write("\t{}_{}_{}() {{\n".format(model_type.capitalize(), hidden_size, num_layers))
+header.write("\t\tauto& f = this->f;\n")
+for i in range(num_layers):
+    header.write("\t\tauto& l{0} = GetLayer<{0}>(*this);\n".format(i))
+header.write("\n")
 
 for name, param in model.named_parameters():
     first = name.split('.')
@@ -124,10 +129,6 @@ for name, param in model.named_parameters():
             header.write("\t\tl{}.bhg << {};\n".format(layer_num, extract(param[2*hidden_size:3*hidden_size])))
             header.write("\t\tl{}.bho << {};\n".format(layer_num, extract(param[3*hidden_size:4*hidden_size])))
             header.write("\n")
-            #initiliase time reccurent
-            header.write("\t\tl{}.htn1 << {};\n".format(layer_num, np.array2string(np.zeros(hidden_size).reshape((1,-1)).squeeze(), separator=',', floatmode='maxprec').strip("[]").replace('\n', '')))
-            header.write("\t\tl{}.ctn1 << {};\n".format(layer_num, np.array2string(np.zeros(hidden_size).reshape((1,-1)).squeeze(), separator=',', floatmode='maxprec').strip("[]").replace('\n', '')))
-            header.write("\n")  
         
     #Process GRU
     elif layer_type == 'gru':
@@ -159,9 +160,6 @@ for name, param in model.named_parameters():
             header.write("\t\tl{}.bhz << {};\n".format(layer_num, extract(param[hidden_size:2*hidden_size])))
             header.write("\t\tl{}.bhn << {};\n".format(layer_num, extract(param[2*hidden_size:3*hidden_size])))
             header.write("\n")
-            #initiliase time reccurent
-            header.write("\t\tl{}.htn1 << {};\n".format(layer_num, np.array2string(np.zeros(hidden_size).reshape((1,-1)).squeeze(), separator=',', floatmode='maxprec').strip("[]").replace('\n', '')))
-            header.write("\n")
         
     #Process GRU
     elif layer_type == 'rnn':
@@ -185,9 +183,6 @@ for name, param in model.named_parameters():
         elif param_type == 'bias' and param_subscript == 'hh':
             header.write("\t\tl{}.bhh << {};\n".format(layer_num, extract(param[:hidden_size])))
             header.write("\n")
-            #initiliase time reccurent
-            header.write("\t\tl{}.htn1 << {};\n".format(layer_num, np.array2string(np.zeros(hidden_size).reshape((1,-1)).squeeze(), separator=',', floatmode='maxprec').strip("[]").replace('\n', '')))
-            header.write("\n")
 
     #Process Linear
     elif layer_type == 'linear':
@@ -197,16 +192,7 @@ for name, param in model.named_parameters():
             header.write("\t\tf.b << {};\n".format(extract(param)))
 
 #Finish constructor
-header.write("\t}\n\n")
-
-#Create apply model function
-
-if num_layers == 1:
-    header.write("\tvoid apply_model(T* x, T* y) {\n\t\tl0.apply_layer(*x);\n\t\t*y=f.apply_layer(l0.ht);\n\t}\n")
-elif num_layers == 2:
-    header.write("\tvoid apply_model(T* x, T* y) {\n\t\tl0.apply_layer(*x);\n\t\tl1.apply_layer(l0.ht);\n\t\t*y=f.apply_layer(l1.ht);\n\t}\n")
-elif num_layers == 4:
-    header.write("\tvoid apply_model(T* x, T* y) {\n\t\tl0.apply_layer(*x);\n\t\tl1.apply_layer(l0.ht);\n\t\tl2.apply_layer(l1.ht);\n\t\tl3.apply_layer(l2.ht);\n\t\t*y=f.apply_layer(l3.ht);\n\t}\n")
+header.write("\t}\n")
 
 header.write("};")
 header.close()
\ No newline at end of file
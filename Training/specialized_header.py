@@ -0,0 +1,320 @@
+"""
+Weight-specialized C++ backend for create_header.py.
+
+Writes a model class whose weights are aligned static constants and whose layers are
+generated for their exact shape, instead of the Eigen layers of layers.h. The rows of the
+stacked gate weights are interleaved in blocks of up to 8 hidden units (column, unit block,
+gate, unit). A layer step is unrolled to one line per column, adding a contiguous run of
+constants times one input to accumulators held in fixed size Eigen arrays, followed by the
+activations and state update of one block of units at a time, whose gates are then adjacent.
+Hidden sizes above 8 that are not a multiple of 8 are padded with zero units. Any number of
+layers is supported.
+
+Can also be run on its own to convert an existing Eigen header, see the bottom of the file.
+"""
+import argparse
+import os
+import re
+from datetime import datetime
+
+GATES = {"lstm": 4, "gru": 3, "rnn": 1}
+
+
+def values(v):
+    """
+    Comma separated literals of a flat list
+    """
+    return ", ".join("{:.9g}".format(float(x)) for x in v)
+
+
+def interleave(W, gates, hidden_size, block):
+    """
+    Reorders a stacked (gates * hidden, cols) row-major weight matrix to [col][block][gate][unit]
+    """
+    out = []
+    for c in range(len(W[0])):
+        out += interleave_bias([row[c] for row in W], gates, hidden_size, block)
+    return out
+
+
+def interleave_bias(b, gates, hidden_size, block):
+    """
+    Reorders a stacked bias to [block][gate][unit]
+    """
+    out = []
+    for k in range(hidden_size // block):
+        for g in range(gates):
+            for u in range(block):
+                out.append(b[g * hidden_size + k * block + u])
+    return out
+
+
+def pad_units(params, model_type, num_layers, hidden_size, padded):
+    """
+    Pads every layer from hidden_size to padded units with zero weights and biases. A zero unit
+    stays at zero (lstm c = 0.5 * c + 0.5 * tanh(0), gru h = 0.5 * tanh(0) + 0.5 * h, rnn
+    tanh(0)) and its zero columns add nothing to the other units, so the output is unchanged
+    """
+    G = GATES[model_type]
+    H = hidden_size
+    P = padded
+
+    def rows(v, zero):
+        return [r for g in range(G) for r in v[g * H:(g + 1) * H] + [zero() for _ in range(P - H)]]
+
+    out = dict(params)
+    for j in range(num_layers):
+        W_ih = params["weight_ih_l{}".format(j)]
+        if j > 0:
+            W_ih = [r + [0.0] * (P - H) for r in W_ih]
+        D = len(W_ih[0])
+        out["weight_ih_l{}".format(j)] = rows(W_ih, lambda: [0.0] * D)
+        out["weight_hh_l{}".format(j)] = rows([r + [0.0] * (P - H) for r in params["weight_hh_l{}".format(j)]], lambda: [0.0] * P)
+        out["bias_ih_l{}".format(j)] = rows(params["bias_ih_l{}".format(j)], lambda: 0.0)
+        out["bias_hh_l{}".format(j)] = rows(params["bias_hh_l{}".format(j)], lambda: 0.0)
+    A = params["linear.weight"]
+    A = A[0] if isinstance(A[0], list) else A
+    out["linear.weight"] = [A + [0.0] * (P - H)]
+    return out
+
+
+def write_product(header, g, w, x, cols, rows):
+    """
+    Writes g += w * x for a column-major constant matrix, one line per column. Short products
+    rotate over up to four accumulators to shorten the dependency chains.
+    """
+    n = min(cols, 4 if rows <= 32 else 2 if rows <= 64 else 1)
+    acc = [g] + ["a{}".format(k) for k in range(1, n)]
+    indent = "\t\t\t" if n > 1 else "\t\t"
+    if n > 1:
+        header.write("\t\t{\n")
+    for k in range(1, n):
+        header.write("{}Vec<{}> {} = Vec<{}>::Zero();\n".format(indent, rows, acc[k], rows))
+    for c in range(cols):
+        header.write("{}{} += W<{}>({} + {}) * {}[{}];\n".format(indent, acc[c % n], rows, w, c * rows, x, c))
+    if n > 1:
+        header.write("{}{} += {};\n\t\t}}\n".format(indent, g, " + ".join(acc[1:])))
+
+
+def write_layer(header, model_type, j, in_size, hidden_size, block, p):
+    """
+    Writes the constants and step function of recurrent layer j
+    """
+    G = GATES[model_type]
+    H = hidden_size
+    D = in_size
+    B = block
+    NB = H // B
+    R = G * H
+    W_ih = p["weight_ih_l{}".format(j)]
+    W_hh = p["weight_hh_l{}".format(j)]
+    b_ih = p["bias_ih_l{}".format(j)]
+    b_hh = p["bias_hh_l{}".format(j)]
+
+    #Fold the bias pairs, the gru new gate keeps bhn apart since the reset gate scales it
+    if model_type == "gru":
+        bi = [b_ih[r] + b_hh[r] if r < 2 * H else b_ih[r] for r in range(R)]
+        bh = [0.0] * (2 * H) + b_hh[2 * H:]
+    else:
+        bi = [b_ih[r] + b_hh[r] for r in range(R)]
+        bh = None
+
+    header.write("\t//Layer {}: {} units, {} inputs\n".format(j, H, D))
+    header.write("\talignas(64) static constexpr T wi{}[{}] = {{{}}};\n".format(j, D * R, values(interleave(W_ih, G, H, B))))
+    header.write("\talignas(64) static constexpr T wh{}[{}] = {{{}}};\n".format(j, H * R, values(interleave(W_hh, G, H, B))))
+    header.write("\talignas(64) static constexpr T bi{}[{}] = {{{}}};\n".format(j, R, values(interleave_bias(bi, G, H, B))))
+    if bh is not None:
+        header.write("\talignas(64) static constexpr T bh{}[{}] = {{{}}};\n".format(j, R, values(interleave_bias(bh, G, H, B))))
+    header.write("\n")
+
+    header.write("\tvoid Layer{}(const T* x) {{\n".format(j))
+    if model_type == "gru":
+        header.write("\t\tVec<{}> gi = W<{}>(bi{});\n".format(R, R, j))
+        header.write("\t\tVec<{}> gh = W<{}>(bh{});\n".format(R, R, j))
+        write_product(header, "gi", "wi{}".format(j), "x", D, R)
+        write_product(header, "gh", "wh{}".format(j), "h{}".format(j), H, R)
+    else:
+        header.write("\t\tVec<{}> g = W<{}>(bi{});\n".format(R, R, j))
+        write_product(header, "g", "wi{}".format(j), "x", D, R)
+        write_product(header, "g", "wh{}".format(j), "h{}".format(j), H, R)
+
+    #Activations and state update, one block of units at a time
+    header.write("\t\tfor(int k = 0; k < {}; k++) {{\n".format(NB))
+    if model_type == "gru":
+        header.write("\t\t\tconst T* ri = gi.data() + k * {};\n".format(G * B))
+        header.write("\t\t\tconst T* rh = gh.data() + k * {};\n".format(G * B))
+        header.write("\t\t\talignas(64) T r[{}], z[{}], n[{}];\n".format(B, B, B))
+        header.write("\t\t\tfor(int u = 0; u < {}; u++) {{\n".format(B))
+        header.write("\t\t\t\tr[u] = Sigmoid<T>(ri[u] + rh[u]);\n")
+        header.write("\t\t\t\tz[u] = Sigmoid<T>(ri[{} + u] + rh[{} + u]);\n".format(B, B))
+        header.write("\t\t\t\tn[u] = ri[{} + u] + r[u] * rh[{} + u];\n".format(2 * B, 2 * B))
+        header.write("\t\t\t}\n")
+        header.write("\t\t\tTanh<{}>(n);\n".format(B))
+        header.write("\t\t\tT* ht = h{} + k * {};\n".format(j, B))
+        header.write("\t\t\tfor(int u = 0; u < {}; u++) ht[u] = (T(1) - z[u]) * n[u] + z[u] * ht[u];\n".format(B))
+    elif model_type == "lstm":
+        header.write("\t\t\tT* gk = g.data() + k * {};\n".format(G * B))
+        header.write("\t\t\tfor(int u = 0; u < {}; u++) {{\n".format(B))
+        header.write("\t\t\t\tgk[u] = Sigmoid<T>(gk[u]);\n")
+        header.write("\t\t\t\tgk[{} + u] = Sigmoid<T>(gk[{} + u]);\n".format(B, B))
+        header.write("\t\t\t\tgk[{} + u] = Sigmoid<T>(gk[{} + u]);\n".format(3 * B, 3 * B))
+        header.write("\t\t\t}\n")
+        header.write("\t\t\tTanh<{}>(gk + {});\n".format(B, 2 * B))
+        header.write("\t\t\tT* ct = c{} + k * {};\n".format(j, B))
+        header.write("\t\t\tT* ht = h{} + k * {};\n".format(j, B))
+        header.write("\t\t\tfor(int u = 0; u < {}; u++) ct[u] = gk[{} + u] * ct[u] + gk[u] * gk[{} + u];\n".format(B, B, 2 * B))
+        header.write("\t\t\tfor(int u = 0; u < {}; u++) ht[u] = ct[u];\n".format(B))
+        header.write("\t\t\tTanh<{}>(ht);\n".format(B))
+        header.write("\t\t\tfor(int u = 0; u < {}; u++) ht[u] *= gk[{} + u];\n".format(B, 3 * B))
+    else:
+        header.write("\t\t\tTanh<{}>(g.data() + k * {});\n".format(B, B))
+        header.write("\t\t\tfor(int u = 0; u < {}; u++) h{}[k * {} + u] = g[k * {} + u];\n".format(B, j, B, B))
+    header.write("\t\t}\n")
+    header.write("\t}\n\n")
+
+
+def write_specialized(write_path, model_type, hidden_size, num_layers, params, source=""):
+    """
+    Writes a weight-specialized header for a model.
+    params maps the torch parameter names without the layer prefix (weight_ih_l0, ...,
+    linear.weight, linear.bias) to nested lists
+    """
+    B = min(hidden_size, 8)
+    H = (hidden_size + B - 1) // B * B
+    if H != hidden_size:
+        params = pad_units(params, model_type, num_layers, hidden_size, H)
+    class_name = "{}_{}_{}_spec".format(model_type.capitalize(), hidden_size, num_layers)
+
+    header = open(write_path, 'w')
+    header.write("/**\n * Autogenerated weight-specialized header file for {}-{}-{}\n * neural network model parameters.\n * \n * Created on: {}\n{} * Generated Using: https://github.com/michaelholmes4/NNComp \n*/\n\n".format(
+        model_type, hidden_size, num_layers, datetime.now().strftime("%d/%m/%Y at: %H:%M"), " * From: {}\n".format(source) if source else ""))
+    header.write("#pragma once\n#include <cmath>\n#include \"Eigen/Dense\"\n#include \"layers.h\"\n\n")
+    header.write("template<typename T>\nclass {}\n{{\npublic:\n".format(class_name))
+    header.write("\tconst static int h = {};\n".format(hidden_size))
+    header.write("\tconst static int d = 1;\n")
+    header.write("\tconst static int layers = {};\n\n".format(num_layers))
+
+    header.write("\t{}() {{\n\t\tReset();\n\t}}\n\n".format(class_name))
+    header.write("\tvoid Reset() {\n")
+    for j in range(num_layers):
+        header.write("\t\tfor(int u = 0; u < {}; u++) h{}[u] = T(0);\n".format(H, j))
+        if model_type == "lstm":
+            header.write("\t\tfor(int u = 0; u < {}; u++) c{}[u] = T(0);\n".format(H, j))
+    header.write("\t}\n\n")
+
+    header.write("\tvoid apply_model(T* x, T* y) {\n\t\t*y = Step(*x);\n\t}\n\n")
+    header.write("\tvoid ProcessBlock(const T* x, T* y, int nFrames) {\n")
+    if num_layers == 1:
+        header.write("\t\tfor(int s = 0; s < nFrames; s++) y[s] = Step(x[s]);\n")
+    else:
+        #Wavefront as in Wavefront.h: layer j runs frame k - j, top layer first so it reads the
+        #output of the layer below before that moves on, and the layers' dependency chains overlap
+        L = num_layers
+        header.write("\t\tfor(int k = 0; k < nFrames + {}; k++) {{\n".format(L - 1))
+        header.write("\t\t\tif(k >= {} && k < nFrames + {}) {{\n\t\t\t\tLayer{}(h{});\n\t\t\t\ty[k - {}] = Output();\n\t\t\t}}\n".format(L - 1, L - 1, L - 1, L - 2, L - 1))
+        for j in range(L - 2, 0, -1):
+            header.write("\t\t\tif(k >= {} && k < nFrames + {}) Layer{}(h{});\n".format(j, j, j, j - 1))
+        header.write("\t\t\tif(k < nFrames) Layer0(x + k);\n")
+        header.write("\t\t}\n")
+    header.write("\t}\n\n")
+
+    #State
+    for j in range(num_layers):
+        header.write("\talignas(64) T h{}[{}];\n".format(j, H))
+        if model_type == "lstm":
+            header.write("\talignas(64) T c{}[{}];\n".format(j, H))
+    header.write("\nprivate:\n")
+
+    #Fixed size Eigen arrays as portable SIMD vectors. Plain loops over the columns get
+    #vectorised across the columns by some compilers, which turns every row into a reduction.
+    header.write("\ttemplate<int n>\n\tusing Vec = Eigen::Array<T, n, 1>;\n\n")
+    header.write("\ttemplate<int n>\n\tstatic Eigen::Map<const Vec<n>> W(const T* w) {\n\t\treturn Eigen::Map<const Vec<n>>(w);\n\t}\n\n")
+    header.write("\ttemplate<int n>\n\tstatic void Tanh(T* v) {\n\t\tEigen::Map<Eigen::Array<T, n, 1>> a(v);\n\t\ta = a.tanh();\n\t}\n\n")
+
+    for j in range(num_layers):
+        write_layer(header, model_type, j, 1 if j == 0 else H, H, B, params)
+
+    A = params["linear.weight"]
+    A = A[0] if isinstance(A[0], list) else A
+    bias = params["linear.bias"]
+    bias = bias[0] if isinstance(bias, list) else bias
+    header.write("\t//Output layer\n")
+    header.write("\talignas(64) static constexpr T A[{}] = {{{}}};\n\n".format(H, values(A)))
+    header.write("\tT Output() const {\n")
+    header.write("\t\treturn std::tanh((W<{}>(A) * W<{}>(h{})).sum() + T({:.9g}));\n".format(H, H, num_layers - 1, float(bias)))
+    header.write("\t}\n\n")
+    header.write("\tT Step(T x) {\n")
+    header.write("\t\tLayer0(&x);\n")
+    for j in range(1, num_layers):
+        header.write("\t\tLayer{}(h{});\n".format(j, j - 1))
+    header.write("\t\treturn Output();\n")
+    header.write("\t}\n")
+    header.write("};\n")
+    header.close()
+    return class_name
+
+
+def read_eigen_header(path):
+    """
+    Reads the model type, size and parameters back from a header written by create_header.py
+    """
+    text = open(path).read()
+    m = re.search(r"class (Lstm|Gru|Rnn)_(\d+)_(\d+)", text)
+    if not m:
+        raise ValueError("{} is not a generated model header".format(path))
+    model_type = m.group(1).lower()
+    H = int(m.group(2))
+    L = int(m.group(3))
+    v = {}
+    for name, data in re.findall(r"(\w+(?:\.\w+)?)\s*<<\s*([^;]*);", text):
+        v[name] = [float(x) for x in data.split(",")]
+
+    gates = {"lstm": ["i", "f", "g", "o"], "gru": ["r", "z", "n"], "rnn": [""]}[model_type]
+    params = {}
+    for j in range(L):
+        D = 1 if j == 0 else H
+        if model_type == "rnn":
+            names = [("Wih", "Whh", "bih", "bhh")]
+        else:
+            names = [("Wi" + g, "Wh" + g, "bi" + g, "bh" + g) for g in gates]
+        W_ih, W_hh, b_ih, b_hh = [], [], [], []
+        for wi, wh, bi, bh in names:
+            wi = v["l{}.{}".format(j, wi)]
+            wh = v["l{}.{}".format(j, wh)]
+            W_ih += [wi[r * D:(r + 1) * D] for r in range(H)]
+            W_hh += [wh[r * H:(r + 1) * H] for r in range(H)]
+            b_ih += v["l{}.{}".format(j, bi)]
+            b_hh += v["l{}.{}".format(j, bh)]
+        params["weight_ih_l{}".format(j)] = W_ih
+        params["weight_hh_l{}".format(j)] = W_hh
+        params["bias_ih_l{}".format(j)] = b_ih
+        params["bias_hh_l{}".format(j)] = b_hh
+    params["linear.weight"] = [v["f.A"]]
+    params["linear.bias"] = v["f.b"]
+    return model_type, H, L, params
+
+
+if __name__ == "__main__":
+    #Convert existing headers, eg. the shipped models, without the .pth files
+    parser = argparse.ArgumentParser()
+    parser.add_argument('Headers', help="Headers written by create_header.py", type=str, nargs='+')
+    parser.add_argument('--out', '-o', help="Output directory", type=str, default='headers/')
+    args = parser.parse_args()
+    os.makedirs(args.out, exist_ok=True)
+    models = []
+    for path in args.Headers:
+        model_type, H, L, params = read_eigen_header(path)
+        name = "{}-{}-{}".format(model_type, H, L)
+        out = os.path.join(args.out, name + "-spec.h")
+        print("{} -> {} ({})".format(path, out, write_specialized(out, model_type, H, L, params, os.path.basename(path))))
+        models.append(("{}_{}_{}".format(model_type.capitalize(), H, L), name))
+
+    #List of the converted models for Plugin/Tools/nncomp_spec
+    header = open(os.path.join(args.out, "spec_models.h"), 'w')
+    header.write("/**\n * Autogenerated list of weight-specialized models for nncomp_spec\n*/\n\n#pragma once\n")
+    for _, name in models:
+        header.write("#include \"{}-spec.h\"\n".format(name))
+    header.write("\n#define NNCOMP_SPEC_MODELS(X) \\\n")
+    header.write(" \\\n".join("\tX({}, \"{}\")".format(c, name) for c, name in models))
+    header.write("\n")
+    header.close()